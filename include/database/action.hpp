@@ -236,6 +236,19 @@ public:
     : obj_(o)
   {}
 
+  /**
+   * Creates an update_action for an object
+   * of the given type. Used for objects which
+   * aren't part of an object_store.
+   * 
+   * @param t The type of the updated object.
+   * @param o The updated object.
+   */
+  update_action(const std::string &t, object *o)
+    : type_(t)
+    , obj_(o)
+  {}
+
   virtual ~update_action() {}
   
   virtual void accept(action_visitor *av)
@@ -243,6 +256,14 @@ public:
     av->visit(this);
   }
 
+  /**
+   * Return the object type
+   * of the action.
+   * 
+   * @return The object type of the action.
+   */
+  std::string type() const;
+
   /**
    * The object of the action.
    */
@@ -254,6 +275,7 @@ public:
   const object* obj() const;
 
 private:
+  std::string type_;
   object *obj_;
 };
 
@@ -0,0 +1,114 @@
+/*
+ * This file is part of OpenObjectStore OOS.
+ *
+ * OpenObjectStore OOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenObjectStore OOS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenObjectStore OOS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BLOB_STREAM_HPP
+#define BLOB_STREAM_HPP
+
+#ifdef WIN32
+  #ifdef oos_EXPORTS
+    #define OOS_API __declspec(dllexport)
+    #define EXPIMP_TEMPLATE
+  #else
+    #define OOS_API __declspec(dllimport)
+    #define EXPIMP_TEMPLATE extern
+  #endif
+  #pragma warning(disable: 4251)
+#else
+  #define OOS_API
+#endif
+
+namespace oos {
+
+/**
+ * @class blob_stream
+ * @brief Incremental access to a blob or text column
+ *
+ * A blob_stream gives access to the value of a
+ * large blob or text column of one row without
+ * reading or writing the whole value at once.
+ * Only the requested parts of the value are
+ * transferred, so a payload which is never
+ * read is never loaded.
+ *
+ * The size of the value can't be changed
+ * through the stream. Use database::create_blob()
+ * to reserve a value of the needed size before
+ * writing it.
+ *
+ * The stream works directly on the database.
+ * Objects already loaded into the object store
+ * aren't updated.
+ *
+ * Streams are created by the database backend
+ * (see database::open_blob()) and must be deleted
+ * by the caller before the database is closed.
+ */
+class OOS_API blob_stream
+{
+private:
+  blob_stream(const blob_stream&);
+  blob_stream& operator=(const blob_stream&);
+
+public:
+  typedef unsigned long size_type;
+
+protected:
+  blob_stream();
+
+public:
+  virtual ~blob_stream();
+
+  /**
+   * Returns the size of the value in bytes.
+   *
+   * @return The size of the value.
+   */
+  virtual size_type size() const = 0;
+
+  /**
+   * Reads size bytes of the value starting
+   * at offset into the given buffer.
+   *
+   * @param offset The offset to start reading.
+   * @param buf The buffer to read into.
+   * @param size The number of bytes to read.
+   */
+  virtual void read(size_type offset, char *buf, size_type size) = 0;
+
+  /**
+   * Writes size bytes of the given buffer
+   * into the value starting at offset.
+   *
+   * @param offset The offset to start writing.
+   * @param buf The buffer to write.
+   * @param size The number of bytes to write.
+   */
+  virtual void write(size_type offset, const char *buf, size_type size) = 0;
+
+  /**
+   * Moves the stream to the same column of
+   * another row. This is cheaper than opening
+   * a new stream.
+   *
+   * @param id The id of the row.
+   */
+  virtual void reopen(long id) = 0;
+};
+
+}
+
+#endif /* BLOB_STREAM_HPP */
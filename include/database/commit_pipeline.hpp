@@ -0,0 +1,178 @@
+/*
+ * This file is part of OpenObjectStore OOS.
+ *
+ * OpenObjectStore OOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenObjectStore OOS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenObjectStore OOS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef COMMIT_PIPELINE_HPP
+#define COMMIT_PIPELINE_HPP
+
+#ifdef WIN32
+  #ifdef oos_EXPORTS
+    #define OOS_API __declspec(dllexport)
+    #define EXPIMP_TEMPLATE
+  #else
+    #define OOS_API __declspec(dllimport)
+    #define EXPIMP_TEMPLATE extern
+  #endif
+  #pragma warning(disable: 4251)
+#else
+  #define OOS_API
+#endif
+
+#include <list>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <future>
+#include <exception>
+
+namespace oos {
+
+class database;
+class action;
+class object;
+class replication_writer;
+
+/**
+ * @class commit_pipeline
+ * @brief Writes committed transactions in the background
+ *
+ * The pipeline owns a writer thread. Committed
+ * action lists are queued with push() and the
+ * writer thread executes them on the database.
+ * All transactions queued at the time the writer
+ * wakes up (up to a maximum batch size) are written
+ * within one database transaction.
+ *
+ * The actions must not refer to objects of the
+ * object store. They are given with the objects
+ * they refer to, which are deleted once the
+ * actions are written.
+ *
+ * A transaction given with a replication_writer
+ * is shipped after its batch is committed, a
+ * failed batch isn't shipped. If shipping fails
+ * the next flush() rethrows the error.
+ *
+ * Any other use of the database must hold
+ * the database mutex given to the pipeline.
+ */
+class OOS_API commit_pipeline
+{
+private:
+  commit_pipeline(const commit_pipeline&);
+  commit_pipeline& operator=(const commit_pipeline&);
+
+public:
+  typedef std::shared_future<void> future_type;
+  typedef std::list<action*> action_list_t;
+  typedef std::list<object*> object_list_t;
+
+public:
+  /**
+   * Creates a pipeline writing to the given
+   * database and starts the writer thread.
+   *
+   * @param db The database to write to.
+   * @param db_mutex The mutex guarding the database.
+   * @param max_batch The maximum number of transactions per batch.
+   */
+  commit_pipeline(database &db, std::mutex &db_mutex, unsigned int max_batch = 64);
+
+  /**
+   * Writes all queued transactions
+   * and stops the writer thread.
+   */
+  ~commit_pipeline();
+
+  /**
+   * @brief Queues a committed transaction
+   *
+   * The actions and objects are moved
+   * into the pipeline. The returned future
+   * becomes ready once the transaction is
+   * written, or holds the error if writing
+   * failed.
+   *
+   * Once a batch failed or couldn't be shipped
+   * no further transaction is written until
+   * flush() has reported the error. Transactions
+   * already queued fail with the same error and
+   * push() throws a database_exception.
+   *
+   * @param actions The actions of the transaction.
+   * @param objects The objects the actions refer to.
+   * @param replication The writer to ship the transaction to or null.
+   * @return The future of the written transaction.
+   */
+  future_type push(action_list_t &actions, object_list_t &objects, replication_writer *replication = 0);
+
+  /**
+   * @brief Waits until all queued transactions are written
+   *
+   * If a batch failed or couldn't be shipped
+   * since the last flush the error is rethrown.
+   */
+  void flush();
+
+  /**
+   * Returns the number of written transactions.
+   *
+   * @return The number of written transactions.
+   */
+  unsigned long commits() const;
+
+  /**
+   * Returns the number of written batches.
+   *
+   * @return The number of written batches.
+   */
+  unsigned long batches() const;
+
+private:
+  struct entry
+  {
+    action_list_t actions;
+    object_list_t objects;
+    replication_writer *replication;
+    std::promise<void> promise;
+  };
+  typedef std::list<entry*> entry_list_t;
+
+  void run();
+  void write(entry_list_t &batch);
+
+private:
+  database &db_;
+  std::mutex &db_mutex_;
+  unsigned int max_batch_;
+
+  entry_list_t queue_;
+  unsigned long pending_;
+  unsigned long commits_;
+  unsigned long batches_;
+  bool stop_;
+  std::exception_ptr error_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable queued_;
+  std::condition_variable written_;
+
+  std::thread writer_;
+};
+
+}
+
+#endif /* COMMIT_PIPELINE_HPP */
@@ -0,0 +1,195 @@
+/*
+ * This file is part of OpenObjectStore OOS.
+ *
+ * OpenObjectStore OOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenObjectStore OOS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenObjectStore OOS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CONNECTION_POOL_HPP
+#define CONNECTION_POOL_HPP
+
+#ifdef WIN32
+  #ifdef oos_EXPORTS
+    #define OOS_API __declspec(dllexport)
+    #define EXPIMP_TEMPLATE
+  #else
+    #define OOS_API __declspec(dllimport)
+    #define EXPIMP_TEMPLATE extern
+  #endif
+  #pragma warning(disable: 4251)
+#else
+  #define OOS_API
+#endif
+
+#include <vector>
+#include <mutex>
+#include <condition_variable>
+
+namespace oos {
+
+class database;
+
+/**
+ * @class connection_pool
+ * @brief A thread safe pool of reader connections
+ *
+ * The pool holds a number of open database
+ * connections used for reading. A connection
+ * is checked out with acquire() and must be
+ * given back with release(). If all connections
+ * are in use acquire() blocks until one is
+ * released. The time spent waiting is recorded
+ * in the pool statistics.
+ *
+ * The pool doesn't own the connections.
+ */
+class OOS_API connection_pool
+{
+private:
+  connection_pool(const connection_pool&);
+  connection_pool& operator=(const connection_pool&);
+
+public:
+  typedef std::vector<database*>::size_type size_type;
+
+  /**
+   * @brief Wait time statistics of the pool
+   */
+  struct statistics
+  {
+    statistics() : acquired(0), waited(0), total_wait_ms(0), max_wait_ms(0) {}
+    unsigned long acquired; /**< Number of checkouts. */
+    unsigned long waited;   /**< Number of checkouts which had to wait. */
+    double total_wait_ms;   /**< Accumulated wait time in milliseconds. */
+    double max_wait_ms;     /**< Longest wait time in milliseconds. */
+  };
+
+  /**
+   * @class lease
+   * @brief Holds an acquired connection
+   *
+   * Acquires a connection on construction
+   * and releases it on destruction.
+   */
+  class OOS_API lease
+  {
+  private:
+    lease(const lease&);
+    lease& operator=(const lease&);
+
+  public:
+    explicit lease(connection_pool &pool);
+    ~lease();
+
+    database* operator->() const;
+    database& operator*() const;
+    database* get() const;
+
+  private:
+    connection_pool &pool_;
+    database *db_;
+  };
+
+public:
+  connection_pool();
+  ~connection_pool();
+
+  /**
+   * Adds a connection to the pool.
+   *
+   * @param db The connection to add.
+   */
+  void add(database *db);
+
+  /**
+   * @brief Removes all connections from the pool
+   *
+   * Waits until all leased connections are
+   * released. Threads waiting in acquire()
+   * meanwhile get an exception. The calling
+   * thread must not hold a connection itself.
+   */
+  void clear();
+
+  /**
+   * @brief Checks out a connection
+   *
+   * Returns an idle connection. If there
+   * is none the call blocks until another
+   * thread releases a connection.
+   *
+   * @return The acquired connection.
+   */
+  database* acquire();
+
+  /**
+   * Gives back an acquired connection.
+   *
+   * @param db The connection to release.
+   */
+  void release(database *db);
+
+  /**
+   * Returns the number of connections.
+   *
+   * @return The number of connections.
+   */
+  size_type size() const;
+
+  /**
+   * Returns true if the pool has
+   * no connections.
+   *
+   * @return True if the pool is empty.
+   */
+  bool empty() const;
+
+  /**
+   * Returns the number of idle connections.
+   *
+   * @return The number of idle connections.
+   */
+  size_type available() const;
+
+  /**
+   * Returns the wait time statistics.
+   *
+   * @return The statistics of the pool.
+   */
+  statistics stats() const;
+
+  /**
+   * Resets the wait time statistics.
+   */
+  void reset_stats();
+
+  /**
+   * Returns all connections of the pool.
+   *
+   * @return All connections.
+   */
+  const std::vector<database*>& connections() const;
+
+private:
+  std::vector<database*> connections_;
+  std::vector<database*> idle_;
+  statistics stats_;
+  bool clearing_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable released_;
+};
+
+}
+
+#endif /* CONNECTION_POOL_HPP */
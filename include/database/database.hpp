@@ -56,6 +56,8 @@ class statement;
 class table;
 class result;
 class database_sequencer;
+class blob_stream;
+class sql_clause;
 struct prototype_node;
 
 /// @cond OOS_DEV
@@ -80,6 +82,20 @@ public:
   typedef std::tr1::shared_ptr<table> table_ptr;
   typedef std::tr1::shared_ptr<database_sequencer> database_sequencer_ptr;
 
+  /**
+   * @brief The strategy used to load the items of a relation
+   *
+   * FETCH_LAZY collects the items while their table is
+   * loaded and attaches them once the container table
+   * is loaded. FETCH_EAGER loads the items right after
+   * the container table with one ordered select and
+   * appends them to their containers in a single pass.
+   */
+  enum fetch_strategy_t {
+    FETCH_LAZY,
+    FETCH_EAGER
+  };
+
   struct table_info_t
   {
     table_info_t(const prototype_node *n) : is_loaded(false), node(n) {}
@@ -101,6 +117,19 @@ public:
    */
   void open(const std::string &connection);
 
+  /**
+   * @brief Open the database as reader
+   *
+   * Opens the database like open() but
+   * the sequencer of the object store isn't
+   * exchanged. A reader is used for loading
+   * and queries only, all modifications are
+   * written by the main database of the session.
+   *
+   * @param connection The database connection string.
+   */
+  void open_reader(const std::string &connection);
+
   /**
    * Close the database
    */
@@ -162,6 +191,27 @@ public:
    */
   void load(const prototype_node &node);
 
+  /**
+   * load all rows of a specific table
+   * matching the given where clause. The
+   * table isn't marked as loaded.
+   *
+   * @param node The node representing the table to read
+   * @param clause The sql where clause.
+   */
+  void load(const prototype_node &node, const std::string &clause);
+
+  /**
+   * load all rows of a specific table
+   * matching the given where clause with
+   * bound values. The table isn't marked
+   * as loaded.
+   *
+   * @param node The node representing the table to read
+   * @param clause The sql where clause.
+   */
+  void load(const prototype_node &node, const sql_clause &clause);
+
   /**
    * Checks if a specific table was loaded.
    * 
@@ -170,6 +220,15 @@ public:
    */
   bool is_loaded(const std::string &name) const;
 
+  /**
+   * Returns the number of batches the
+   * table was read in by its last load.
+   *
+   * @param name Name of the table.
+   * @return The number of batches read.
+   */
+  unsigned long loaded_batches(const std::string &name) const;
+
   /**
    * Execute a sql statement and return a result
    * implementation via pointer.
@@ -179,6 +238,108 @@ public:
    */
   result* execute(const std::string &sql);
 
+  /**
+   * Returns the query plan of the given
+   * sql statement as reported by the
+   * database backend. This helps to verify
+   * that a query uses the expected indexes.
+   *
+   * @param sql The sql statement to explain.
+   * @return The query plan.
+   */
+  std::string explain(const std::string &sql);
+
+  /**
+   * Returns the clause restricting a select
+   * to the given number of rows. The clause
+   * follows the ORDER BY clause of the select.
+   *
+   * @param rows The maximum number of rows.
+   * @return The row limiting clause.
+   */
+  std::string limit(int rows) const;
+
+  /**
+   * @brief Opens a stream on a blob or text value
+   *
+   * Opens a stream on the value of the given
+   * column of the row with the given id. The
+   * value is read and written incrementally.
+   * The caller takes the ownership of the
+   * returned stream.
+   *
+   * @param table The name of the table.
+   * @param column The name of the column.
+   * @param id The id of the row.
+   * @param writable True if the stream should be writable.
+   * @return The blob stream.
+   */
+  blob_stream* open_blob(const std::string &table, const std::string &column, long id, bool writable = false);
+
+  /**
+   * @brief Reserves a blob value and opens a stream on it
+   *
+   * Replaces the value of the given column of
+   * the row with the given id with a zero filled
+   * blob of the given size and opens a writable
+   * stream on it. The caller takes the ownership
+   * of the returned stream.
+   *
+   * @param table The name of the table.
+   * @param column The name of the column.
+   * @param id The id of the row.
+   * @param size The size of the blob in bytes.
+   * @return The writable blob stream.
+   */
+  blob_stream* create_blob(const std::string &table, const std::string &column, long id, unsigned long size);
+
+  /**
+   * @brief Sets the number of rows fetched per load batch
+   *
+   * When loading a table the rows are read in
+   * chunks of the given size ordered by their
+   * id (keyset pagination). Backends supporting
+   * server side cursors use the size as prefetch
+   * row count. A size of zero (default) loads
+   * the whole table with one statement.
+   *
+   * @param size The number of rows per batch.
+   */
+  void batch_size(unsigned long size);
+
+  /**
+   * Returns the number of rows fetched
+   * per load batch. Zero means unbounded.
+   *
+   * @return The number of rows per batch.
+   */
+  unsigned long batch_size() const;
+
+  /**
+   * @brief Sets the fetch strategy of a relation
+   *
+   * The relation is identified by the type name
+   * of the prototype containing it and the name
+   * of the container field (e.g. "album" and
+   * "tracks"). All relations are loaded lazy by
+   * default.
+   *
+   * @param type The type name of the prototype.
+   * @param relation The name of the relation.
+   * @param strategy The fetch strategy to use.
+   */
+  void fetch_strategy(const std::string &type, const std::string &relation, fetch_strategy_t strategy);
+
+  /**
+   * Returns the fetch strategy of the
+   * given relation of a prototype.
+   *
+   * @param type The type name of the prototype.
+   * @param relation The name of the relation.
+   * @return The fetch strategy of the relation.
+   */
+  fetch_strategy_t fetch_strategy(const std::string &type, const std::string &relation) const;
+
   /**
    * The interface for the create table action.
    */
@@ -258,6 +419,17 @@ public:
    */
   void rollback();
 
+  /**
+   * @brief Rolls back only the database transaction
+   *
+   * The current transaction is rolled back on
+   * the database. In contrast to rollback()
+   * the sequencer isn't rewound because the
+   * object store may have handed out further
+   * ids meanwhile.
+   */
+  void discard();
+
   virtual const char* type_string(data_type_t type) const = 0;
 
   database_sequencer_ptr seq() const;
@@ -273,19 +445,34 @@ protected:
   virtual void on_begin() = 0;
   virtual void on_commit() = 0;
   virtual void on_rollback() = 0;
+  virtual std::string on_explain(const std::string &sql);
+  virtual std::string on_limit(int rows) const;
+  virtual blob_stream* on_open_blob(const std::string &table, const std::string &column, long id, bool writable);
+  virtual void on_reserve_blob(const std::string &table, const std::string &column, long id, unsigned long size);
 
 
 private:
   friend class database_factory;
+  friend class session;
   friend class table;
   friend class query;
 
+  void open(const std::string &connection, bool reader);
+
+  // take over the load settings of another database
+  void copy_settings(const database &db);
+
+private:
   session *db_;
   bool commiting_;
+  unsigned long batch_size_;
 
   typedef std::map<std::string, table_ptr> table_map_t;
+  // keyed by prototype type and field name
+  typedef std::map<std::pair<std::string, std::string>, fetch_strategy_t> fetch_strategy_map_t;
   
   table_map_t table_map_;
+  fetch_strategy_map_t fetch_strategy_map_;
 
   database_sequencer_ptr sequencer_;
   sequencer_impl_ptr sequencer_backup_;
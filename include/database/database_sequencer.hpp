@@ -65,8 +65,18 @@ public:
   virtual void begin();
   virtual void commit();
   virtual void rollback();
+  virtual void discard();
   virtual void drop();
   virtual void destroy();
+
+  /*
+   * ids are reserved in blocks of the
+   * given size. the sequence table is
+   * only written when a block is exhausted
+   */
+  void block_size(long size);
+  long block_size() const;
+  long reserved() const;
   
 protected:
   long backup_sequence() const;
@@ -75,7 +85,12 @@ protected:
 private:
   database &db_;
   long backup_;
-  long sequence_;
+  // handed out by the object store while a
+  // background commit may read it
+  std::atomic<long> sequence_;
+  long reserved_;
+  long reserved_backup_;
+  long block_size_;
   oos::varchar<64> name_;
   statement *update_;
 };
@@ -83,13 +83,41 @@ public:
 
   SQLHANDLE operator()();
 
+  /**
+   * Returns the number of parameter sets sent
+   * and the number of rows fetched per round
+   * trip. One (default) disables array binding.
+   *
+   * The value can be set with the option array
+   * in the connection string, e.g.
+   * mssql://user@host/db?array=500 (SQL Server)
+   *
+   * @return The array size.
+   */
+  unsigned long array_size() const;
+
 protected:
+  /**
+   * Opens the connection. The connection is
+   * either given as
+   * user[:passwd]@host/instance[/database][?options] (driver)
+   * or as a raw odbc connection string or dsn,
+   * e.g. DSN=name;UID=user;PWD=secret. A raw
+   * string takes no options.
+   *
+   * @param db The connection string.
+   */
   virtual void on_open(const std::string &db);
   virtual void on_close();
   virtual result* on_execute(const std::string &sql);
   virtual void on_begin();
   virtual void on_commit();
   virtual void on_rollback();
+  virtual std::string on_limit(int rows) const;
+
+private:
+  std::string odbc_connection_string(const std::string &connection);
+  void apply_option(const std::string &key, const std::string &value);
 
 private:
   SQLHANDLE odbc_;
@@ -98,6 +126,8 @@ private:
   bool is_open_;
   
   int retries_;
+
+  unsigned long array_size_;
 };
 
 }
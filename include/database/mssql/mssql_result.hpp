@@ -34,6 +34,7 @@
 #include <sql.h>
 
 #include <vector>
+#include <cstring>
 
 namespace oos {
 
@@ -52,7 +53,17 @@ public:
   typedef result::size_type size_type;
 
 public:
-  mssql_result(SQLHANDLE stmt, bool free);
+  /**
+   * Creates a result of an executed statement. If
+   * the row array size is greater than one, the
+   * rows are fetched in blocks of this size into
+   * column wise bound buffers.
+   *
+   * @param stmt The executed statement.
+   * @param free If true the statement is freed with the result.
+   * @param row_array_size The number of rows per fetch.
+   */
+  mssql_result(SQLHANDLE stmt, bool free, SQLULEN row_array_size = 1);
   virtual ~mssql_result();
   
   const char* column(size_type c) const;
@@ -89,6 +100,13 @@ protected:
   {
     SQLLEN info = 0;
     int type = mssql_statement::type2int(type_traits<T>::data_type());
+    if (row_array_size_ > 1) {
+      const char *data = column(type, sizeof(T), info);
+      if (data) {
+        memcpy(&val, data, sizeof(T));
+      }
+      return;
+    }
     SQLRETURN ret = SQLGetData(stmt_, result_index++, type, &val, sizeof(T), &info);
     if (ret == SQL_SUCCESS) {
       return;
@@ -101,6 +119,16 @@ protected:
   void read_column(const char *, std::string &/*val*/);
   void read_column(const char *, varchar_base &/*val*/);
 
+private:
+  /*
+   * while binding the type and width of the next
+   * column is recorded, otherwise the value of the
+   * next column in the current row of the rowset
+   * is returned. null is returned for a null value.
+   */
+  const char* column(int ctype, SQLLEN width, SQLLEN &len);
+  bool fetch_rowset(object *o);
+
 private:
   size_type affected_rows_;
   size_type rows;
@@ -109,8 +137,26 @@ private:
   bool free_;
   
   enum { NUMERIC_LEN = 21 };
+  enum { TEXT_LEN = 1024 };
 
   SQLHANDLE stmt_;
+
+  /*
+   * column wise buffer of a bound result column
+   * holding the values of all rows of the rowset
+   */
+  struct column_t {
+    int ctype;
+    SQLLEN width;
+    std::vector<char> data;
+    std::vector<SQLLEN> len;
+  };
+  std::vector<column_t> columns_;
+
+  SQLULEN row_array_size_;
+  SQLULEN rows_fetched_;
+  SQLULEN row_;
+  bool binding_;
 };
 
 }
@@ -60,6 +60,9 @@ public:
   virtual result* execute();
   virtual void prepare(const sql &s);
   virtual void reset();
+
+  virtual void add_batch();
+  virtual void execute_batch();
   
 //  virtual int column_count() const;
 //  virtual const char* column_name(int i) const;
@@ -91,30 +94,47 @@ protected:
   template < class T >
   void bind_value(T val, int index)
   {
-    value_t *v = new value_t;
-    v->data = new char[sizeof(T)];
-    *static_cast<T*>(v->data) = val;
-    host_data_.push_back(v);
-    
     int ctype = mssql_statement::type2int(type_traits<T>::data_type());
     int type = mssql_statement::type2sql(type_traits<T>::data_type());
-    SQLRETURN ret = SQLBindParameter(stmt_, index, SQL_PARAM_INPUT, ctype, type, 0, 0, v->data, 0, &v->len);
-    throw_error(ret, SQL_HANDLE_STMT, stmt_, "mssql", "couldn't bind parameter");
+    value_t &v = host_value(index, ctype, type, sizeof(T));
+    *reinterpret_cast<T*>(v.at(rows_)) = val;
+    v.len[rows_] = 0;
   }
   void bind_value(unsigned long val, int index);
   void bind_value(const char *val, int size, int index);
 
 private:
-  mssql_database &db_;
-  
+  /*
+   * column wise buffer of one host parameter. it
+   * holds the value of each parameter set of the
+   * array in a slot of the same width
+   */
   struct value_t {
-    explicit value_t(bool fxd = true, SQLLEN l = 0) : fixed(fxd), len(l), data(0) {}
-    ~value_t() { delete [] static_cast<char*>(data); }
-    bool fixed;
-    SQLLEN len;
-    void *data;
+    value_t() : ctype(0), type(0), size(0), width(0) {}
+    char* at(SQLULEN row) { return &data[row * width]; }
+    void resize(SQLLEN w, SQLULEN rows);
+    int ctype;
+    int type;
+    SQLULEN size;
+    SQLLEN width;
+    std::vector<char> data;
+    std::vector<SQLLEN> len;
   };
-  std::vector<value_t*> host_data_;
+
+  value_t& host_value(int index, int ctype, int type, SQLLEN width);
+  void bind_parameters(SQLULEN rows);
+
+private:
+  mssql_database &db_;
+  
+  std::vector<value_t> host_data_;
+
+  // maximum and current number of parameter sets
+  SQLULEN array_size_;
+  SQLULEN rows_;
+  SQLULEN processed_;
+  // parameters must be rebound after a resize
+  bool bound_;
 
   enum { NUMERIC_LEN = 21 };
 
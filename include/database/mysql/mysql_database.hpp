@@ -90,6 +90,19 @@ public:
    */
   MYSQL* operator()();
 
+  /**
+   * Returns the number of rows a server side
+   * cursor fetches per round trip. Zero means
+   * the batch size of the database is used.
+   *
+   * The value can be set with the option
+   * prefetch in the connection string, e.g.
+   * mysql://user@host/db?prefetch=500
+   *
+   * @return The number of prefetched rows.
+   */
+  unsigned long prefetch_rows() const;
+
 protected:
   virtual void on_open(const std::string &db);
   virtual void on_close();
@@ -97,10 +110,15 @@ protected:
   virtual void on_begin();
   virtual void on_commit();
   virtual void on_rollback();
+  virtual std::string on_explain(const std::string &sql);
+
+private:
+  void apply_option(const std::string &key, const std::string &value);
 
 private:
   MYSQL mysql_;
   bool is_open_;
+  unsigned long prefetch_rows_;
 };
 
 }
@@ -28,8 +28,27 @@ private:
 public:
   typedef result::size_type size_type;
 
+  struct result_info {
+    unsigned long length;
+    my_bool is_null;
+    my_bool error;
+    char *buffer;
+    unsigned long buffer_length;
+  };
+
 public:
-  mysql_prepared_result(MYSQL_STMT *s, int rs);
+  /**
+   * Creates a result of an executed statement.
+   * The bind and info arrays of size rs are
+   * owned by the statement and reused by each
+   * of its results.
+   *
+   * @param s The executed statement.
+   * @param rs The number of result columns.
+   * @param bind The result bind array.
+   * @param info The result info array.
+   */
+  mysql_prepared_result(MYSQL_STMT *s, int rs, MYSQL_BIND *bind, result_info *info);
   ~mysql_prepared_result();
   
   const char* column(size_type c) const;
@@ -63,14 +82,6 @@ protected:
   virtual void read(const char *id, object_base_ptr &x);
   virtual void read(const char *id, object_container &x);
 
-public:
-  struct result_info {
-    unsigned long length;
-    my_bool is_null;
-    my_bool error;
-    char *buffer;
-    unsigned long buffer_length;
-  };
 
 private:
   template < class T >
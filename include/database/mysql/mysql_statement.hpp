@@ -20,6 +20,7 @@
 
 #include "database/statement.hpp"
 #include "database/sql.hpp"
+#include "database/mysql/mysql_prepared_result.hpp"
 
 #ifdef WIN32
 #include <winsock2.h>
@@ -88,11 +89,7 @@ private:
   template < class T >
   void bind_value(MYSQL_BIND &bind, enum_field_types type, T value, int /*index*/)
   {
-    if (bind.buffer == 0) {
-      // allocating memory
-      bind.buffer = new char[sizeof(T)];
-    }
-    *static_cast<T*>(bind.buffer) = value;
+    *static_cast<T*>(host_buffer(bind, sizeof(T))) = value;
     bind.buffer_type = type;
     bind.is_null = 0;
   }
@@ -100,6 +97,12 @@ private:
   void bind_value(MYSQL_BIND &bind, enum_field_types type, const char *value, int size, int index);
   void bind_value(MYSQL_BIND &bind, enum_field_types type, const object_base_ptr &value, int index);
 
+  /*
+   * returns the buffer of the host bind, it
+   * is only reallocated if it is too small
+   */
+  static void* host_buffer(MYSQL_BIND &bind, unsigned long size);
+
   static enum_field_types type_enum(data_type_t type);
 
 private:
@@ -109,6 +112,10 @@ private:
   std::vector<unsigned long> length_vector;
   MYSQL_STMT *stmt;
   MYSQL_BIND *host_array;
+  // result binds are reused by each execution
+  MYSQL_BIND *result_array;
+  mysql_prepared_result::result_info *info_array;
+  bool cursor_;
 };
 
 }
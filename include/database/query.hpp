@@ -50,6 +50,7 @@ class database;
 class object;
 struct prototype_node;
 class condition;
+class sql_clause;
 class object_atomizable;
 
 /**
@@ -103,6 +104,7 @@ private:
     QUERY_OR,
     QUERY_ORDERBY,
     QUERY_GROUPBY,
+    QUERY_LIMIT,
     QUERY_EXECUTED,
     QUERY_PREPARED,
     QUERY_BOUND
@@ -155,6 +157,18 @@ public:
    */
   query& drop(const prototype_node &node);
 
+  /**
+   * Creates a create index statement
+   * for the given column of the given
+   * table. The index is named
+   * <table>_<column>_idx.
+   * 
+   * @param table The name of the table.
+   * @param column The name of the column to index.
+   * @return A reference to the query.
+   */
+  query& create_index(const std::string &table, const std::string &column);
+
   /**
    * Creates a drop statement based
    * on the given table name.
@@ -271,6 +285,17 @@ public:
    */
   query& where(const condition &c);
 
+  /**
+   * Adds a where clause with bound values to
+   * the select or update statement. The values
+   * must be bound to the prepared statement
+   * (see sql_clause::bind()).
+   * 
+   * @param clause The where clause.
+   * @return A reference to the query.
+   */
+  query& where(const sql_clause &clause);
+
   /**
    * Adds an and clause condition to the where
    * clause.
@@ -0,0 +1,232 @@
+/*
+ * This file is part of OpenObjectStore OOS.
+ *
+ * OpenObjectStore OOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenObjectStore OOS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenObjectStore OOS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef REPLICATION_HPP
+#define REPLICATION_HPP
+
+#ifdef WIN32
+  #ifdef oos_EXPORTS
+    #define OOS_API __declspec(dllexport)
+    #define EXPIMP_TEMPLATE
+  #else
+    #define OOS_API __declspec(dllimport)
+    #define EXPIMP_TEMPLATE extern
+  #endif
+  #pragma warning(disable: 4251)
+#else
+  #define OOS_API
+#endif
+
+#include "object/object_serializer.hpp"
+
+#include "tools/byte_buffer.hpp"
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <list>
+#include <mutex>
+
+namespace oos {
+
+class object;
+class object_store;
+class action;
+
+/**
+ * @class replication_writer
+ * @brief Ships committed transactions to followers
+ *
+ * A session given a replication_writer (see
+ * session::replicate()) appends the actions of
+ * each committed transaction as one batch to
+ * the writers file. Inserted and updated
+ * objects are shipped as their serialized
+ * image, deleted objects by type and id.
+ *
+ * Each batch starts with a header of a magic
+ * number, the sequence number of the batch and
+ * the length of its records and is flushed once
+ * written. The numbers are written in host byte
+ * order, leader and followers must run on the
+ * same kind of machine.
+ *
+ * If a batch couldn't be written completely
+ * the log ends with a partial batch and the
+ * writer refuses all further batches.
+ */
+class OOS_API replication_writer
+{
+private:
+  replication_writer(const replication_writer&);
+  replication_writer& operator=(const replication_writer&);
+
+public:
+  typedef std::list<action*> action_list_t;
+
+  /**
+   * Opens the given log file for appending.
+   * If the file already holds batches the
+   * sequence continues after the last
+   * complete one.
+   *
+   * @param path The path of the log file.
+   */
+  explicit replication_writer(const std::string &path);
+
+  /**
+   * Writes to an already opened file, i.e.
+   * a pipe or a socket. The file isn't
+   * closed by the writer.
+   *
+   * @param file The file to write to.
+   */
+  explicit replication_writer(std::FILE *file);
+
+  ~replication_writer();
+
+  /**
+   * @brief Writes the actions of a transaction
+   *
+   * Appends the given actions as the
+   * next batch. The objects of the actions
+   * are serialized, so they must be alive.
+   * Throws a database_exception if the batch
+   * couldn't be written or an earlier batch
+   * failed.
+   *
+   * @param actions The committed actions.
+   * @return The sequence number of the batch.
+   */
+  unsigned long long write(const action_list_t &actions);
+
+  /**
+   * Returns the sequence number of
+   * the last written batch.
+   *
+   * @return The last sequence number.
+   */
+  unsigned long long sequence() const;
+
+private:
+  friend class record_writer;
+
+  void resume();
+  void append(const void *bytes, std::size_t size);
+  void append_record(unsigned char op, const char *type, long id, const object *o);
+
+private:
+  std::FILE *file_;
+  bool owner_;
+  bool broken_;
+  unsigned long long sequence_;
+
+  byte_buffer payload_;
+  byte_buffer image_;
+  object_serializer serializer_;
+
+  std::mutex mutex_;
+};
+
+/**
+ * @class replication_follower
+ * @brief Applies shipped transactions to an object_store
+ *
+ * The follower tails a log written by a
+ * replication_writer and applies each complete
+ * batch to its object_store: shipped objects
+ * are created or updated and deleted objects
+ * removed. Observers of the store are notified
+ * as if the changes were made locally.
+ *
+ * The store must know the same prototypes as
+ * the store of the leader and must not be
+ * changed by anyone else.
+ */
+class OOS_API replication_follower
+{
+private:
+  replication_follower(const replication_follower&);
+  replication_follower& operator=(const replication_follower&);
+
+public:
+  /**
+   * Creates a follower reading the given
+   * log file from its beginning.
+   *
+   * @param ostore The object_store to apply to.
+   * @param path The path of the log file.
+   */
+  replication_follower(object_store &ostore, const std::string &path);
+
+  /**
+   * Creates a follower reading the given
+   * opened file. The file isn't closed by
+   * the follower.
+   *
+   * @param ostore The object_store to apply to.
+   * @param file The file to read from.
+   */
+  replication_follower(object_store &ostore, std::FILE *file);
+
+  ~replication_follower();
+
+  /**
+   * @brief Applies all complete batches
+   *
+   * Reads everything written to the log
+   * since the last call and applies the
+   * complete batches. An incomplete batch
+   * at the end is kept until the next call.
+   * Batches already applied are skipped.
+   *
+   * A batch is read completely before it is
+   * applied. If applying a record fails the
+   * error is thrown and the next call continues
+   * with the record after the applied ones.
+   *
+   * @return The number of applied batches.
+   */
+  unsigned long poll();
+
+  /**
+   * Returns the sequence number of
+   * the last applied batch.
+   *
+   * @return The last applied sequence number.
+   */
+  unsigned long long sequence() const;
+
+private:
+  void apply(const char *first, const char *last);
+
+private:
+  object_store &ostore_;
+  std::FILE *file_;
+  bool owner_;
+  unsigned long long sequence_;
+  // applied records of the next batch
+  std::size_t applied_;
+
+  std::vector<char> pending_;
+  byte_buffer image_;
+  object_serializer serializer_;
+};
+
+}
+
+#endif /* REPLICATION_HPP */
@@ -37,11 +37,18 @@
 #include "tools/library.hpp"
 
 #include "database/transaction.hpp"
+#include "database/sql_expression.hpp"
+#include "database/connection_pool.hpp"
+#include "database/commit_pipeline.hpp"
 
 #include <string>
+#include <stdexcept>
 #include <stack>
 #include <map>
 #include <memory>
+#include <exception>
+#include <list>
+#include <utility>
 
 namespace oos {
 
@@ -49,6 +56,8 @@ class object_store;
 class result;
 class statement;
 class database;
+class replication_writer;
+struct version_batch;
 
 /**
  * @class session
@@ -151,6 +160,38 @@ public:
   }
   /// @endcond
 
+  /**
+   * @brief Load all objects matching the given expression.
+   *
+   * Loads all objects of the given type matching the
+   * given object expression from the database. If the
+   * expression can be translated into a sql where clause
+   * (see make_sql_expression()) only the matching rows
+   * are fetched and true is returned.
+   *
+   * Otherwise the whole table is loaded and false is
+   * returned. In this case the expression must be
+   * evaluated in memory, i.e. with object_view::find_if()
+   * or object_view::for_each_if().
+   *
+   * @tparam T The type of the objects.
+   * @tparam E The type of the expression.
+   * @param expr The expression the objects must match.
+   * @return True if the expression was evaluated by the database.
+   */
+  template < class T, class E >
+  bool load(const E &expr)
+  {
+    prototype_iterator node = ostore_.find_prototype<T>();
+    if (!node.get()) {
+      throw std::logic_error("session load: unknown type");
+    }
+    sql_clause clause;
+    bool translated = make_sql_expression(expr, clause);
+    load(*node, clause);
+    return translated;
+  }
+
   /**
    * @brief Load all objects from the database.
    *
@@ -250,6 +291,113 @@ public:
    */
   database& db();
 
+  /**
+   * @brief Sets the number of reader connections
+   *
+   * Creates the given number of additional
+   * connections to the database. They are used
+   * to load objects and may be checked out
+   * thread safe via readers() to run queries
+   * concurrently. Modifications are always
+   * written by the main connection. A size of
+   * zero (default) loads via the main connection.
+   *
+   * Changing the size or destroying the
+   * session waits until all leased readers
+   * are released.
+   *
+   * @param size The number of reader connections.
+   */
+  void reader_pool_size(unsigned int size);
+
+  /**
+   * Returns the pool of reader connections.
+   *
+   * @return The reader connection pool.
+   */
+  connection_pool& readers();
+
+  /**
+   * @brief Enables or disables asynchronous commits
+   *
+   * With asynchronous commits a transaction
+   * commit changes the object store immediately
+   * but only snapshots the changed objects. A
+   * background thread writes the snapshots to
+   * the database, several transactions within
+   * one database transaction. Use the future
+   * returned by transaction::commit() or flush()
+   * to wait until the changes are written.
+   *
+   * Loading, executing statements, dropping and
+   * closing flush the pending commits first.
+   * Disabling flushes all pending commits and
+   * rethrows an error flush() hasn't reported
+   * yet. After a failed commit further commits
+   * throw until flush() has reported the error.
+   *
+   * If the object store keeps versions, readers
+   * see an asynchronous commit once it is written
+   * and the session publishes it with the next
+   * commit or flush. A failed commit is never
+   * published.
+   *
+   * @param enable True to commit asynchronous.
+   * @param max_batch The maximum number of transactions per batch.
+   */
+  void async_commit(bool enable, unsigned int max_batch = 64);
+
+  /**
+   * Returns true if transactions are
+   * committed asynchronous.
+   *
+   * @return True on asynchronous commits.
+   */
+  bool async_commit() const;
+
+  /**
+   * @brief Waits until all committed transactions are written
+   *
+   * If writing or shipping a transaction
+   * failed since the last flush, the error
+   * is rethrown.
+   */
+  void flush();
+
+  /**
+   * Returns the background writer or null
+   * if transactions are committed synchronous.
+   *
+   * @return The background writer.
+   */
+  const commit_pipeline* pipeline() const;
+
+  /**
+   * @brief Ships committed transactions to followers
+   *
+   * Each transaction committed from now on is
+   * appended to the given replication_writer
+   * as one batch once it is written to the
+   * database. A failed commit isn't shipped.
+   * If shipping fails the transaction stays
+   * committed and the next flush() rethrows
+   * the error.
+   * Pending asynchronous commits are flushed
+   * first. The writer isn't owned by the
+   * session. Null stops the shipping.
+   *
+   * @param writer The writer to ship to.
+   */
+  void replicate(replication_writer *writer);
+
+  /**
+   * Returns the replication writer or null
+   * if transactions aren't shipped.
+   *
+   * @return The replication writer.
+   */
+  replication_writer* replication() const;
+
 private:
   friend class transaction;
   friend class statement;
@@ -259,11 +407,21 @@ private:
   void pop_transaction();
 
   object* load(const std::string &type, int id = 0);
+  void load(const prototype_node &node, const sql_clause &clause);
+  void load(database &db);
+  void load(database &db, const prototype_node &node, const sql_clause &clause);
+
+  void destroy_readers();
 
   void begin(transaction &tr);
-  void commit(transaction &tr);
+  commit_pipeline::future_type commit(transaction &tr);
   void rollback();
 
+  void publish_versions(bool wait);
+
+  typedef std::unique_lock<std::mutex> db_lock_t;
+  db_lock_t db_lock();
+
   /**
    * Create a statement implementation
    *
@@ -277,9 +435,23 @@ private:
 
   database *impl_;
 
+  connection_pool readers_;
+
+  // asynchronous commits
+  commit_pipeline *pipeline_;
+  // log shipping
+  replication_writer *replication_;
+  std::exception_ptr replication_error_;
+  // versions of asynchronous commits not written yet
+  typedef std::list<std::pair<commit_pipeline::future_type, version_batch*> > t_staged_list;
+  t_staged_list staged_;
+  std::mutex db_mutex_;
+
   object_store &ostore_;
 
   std::stack<transaction*> transaction_stack_;
+  // transactions registered as observer
+  std::stack<transaction*> observer_stack_;
 };
 
 }
@@ -0,0 +1,182 @@
+/*
+ * This file is part of OpenObjectStore OOS.
+ *
+ * OpenObjectStore OOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenObjectStore OOS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenObjectStore OOS. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef SQL_CLAUSE_HPP
+#define SQL_CLAUSE_HPP
+
+#ifdef WIN32
+  #ifdef oos_EXPORTS
+    #define OOS_API __declspec(dllexport)
+    #define EXPIMP_TEMPLATE
+  #else
+    #define OOS_API __declspec(dllimport)
+    #define EXPIMP_TEMPLATE extern
+  #endif
+  #pragma warning(disable: 4251)
+#else
+  #define OOS_API
+#endif
+
+#include "database/types.hpp"
+#include "database/statement.hpp"
+
+#ifdef WIN32
+#include <memory>
+#else
+#include <tr1/memory>
+#endif
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+namespace oos {
+
+class sql;
+
+/**
+ * @class sql_clause
+ * @brief A sql where clause with bound values
+ *
+ * The clause consists of sql text and values.
+ * Each value is written as a placeholder into
+ * the statement and bound when the statement
+ * is executed. So the values are never part
+ * of the sql text and the statement can't be
+ * altered by them.
+ */
+class OOS_API sql_clause
+{
+public:
+  /**
+   * Creates an empty clause.
+   */
+  sql_clause();
+
+  /**
+   * Creates a clause of the given
+   * sql text without values.
+   *
+   * @param str The sql text.
+   */
+  explicit sql_clause(const std::string &str);
+
+  ~sql_clause();
+
+  /**
+   * Appends sql text to the clause.
+   *
+   * @param str The sql text to append.
+   */
+  void append(const std::string &str);
+
+  /**
+   * Appends a value compared with the
+   * given column as placeholder.
+   *
+   * @tparam T The type of the value.
+   * @param column The column the value is compared with.
+   * @param val The value.
+   */
+  template < class T >
+  void append(const std::string &column, const T &val)
+  {
+    parts_.push_back(part(parameter_ptr(new value_parameter<T>(column, val))));
+  }
+
+  /**
+   * Returns the sql text of the clause
+   * with a placeholder for each value.
+   *
+   * @return The sql text.
+   */
+  std::string str() const;
+
+  /**
+   * Returns the number of values.
+   *
+   * @return The number of values.
+   */
+  std::size_t size() const;
+
+  /**
+   * Returns true if the clause
+   * contains neither text nor values.
+   *
+   * @return True if the clause is empty.
+   */
+  bool empty() const;
+
+  /// @cond OOS_DEV
+
+  /*
+   * appends the clause to a sql statement
+   * declaring each value as host field
+   */
+  void apply(sql &s) const;
+
+  /*
+   * binds the values to the prepared
+   * statement in order of their placeholders
+   */
+  int bind(statement &stmt) const;
+
+  /// @endcond
+
+private:
+  struct parameter
+  {
+    parameter(const std::string &c, data_type_t t) : column(c), type(t) {}
+    virtual ~parameter() {}
+
+    virtual int bind(statement &stmt, int index) const = 0;
+
+    std::string column;
+    data_type_t type;
+  };
+
+  typedef std::tr1::shared_ptr<parameter> parameter_ptr;
+
+  template < class T >
+  struct value_parameter : public parameter
+  {
+    value_parameter(const std::string &c, const T &val)
+      : parameter(c, type_traits<T>::data_type()), value(val)
+    {}
+
+    virtual int bind(statement &stmt, int index) const
+    {
+      return stmt.bind(index, value);
+    }
+
+    T value;
+  };
+
+  struct part
+  {
+    explicit part(const std::string &s) : text(s) {}
+    explicit part(const parameter_ptr &p) : param(p) {}
+
+    std::string text;
+    parameter_ptr param;
+  };
+
+  std::vector<part> parts_;
+};
+
+}
+
+#endif /* SQL_CLAUSE_HPP */
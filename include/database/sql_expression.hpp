@@ -0,0 +1,244 @@
+/*
+ * This file is part of OpenObjectStore OOS.
+ *
+ * OpenObjectStore OOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenObjectStore OOS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenObjectStore OOS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SQL_EXPRESSION_HPP
+#define SQL_EXPRESSION_HPP
+
+#include "object/object_expression.hpp"
+#include "object/object_ptr.hpp"
+
+#include "database/sql_clause.hpp"
+
+#include <string>
+#include <functional>
+
+namespace oos {
+
+/// @cond OOS_DEV
+
+/*
+ * maps the functor of an expression
+ * to its sql operator. unknown operators
+ * return null and are not translatable
+ */
+template < class OP >
+struct sql_operator
+{
+  static const char* str() { return 0; }
+};
+
+template < class T >
+struct sql_operator<std::greater<T> >
+{
+  static const char* str() { return " > "; }
+};
+
+template < class T >
+struct sql_operator<std::greater_equal<T> >
+{
+  static const char* str() { return " >= "; }
+};
+
+template < class T >
+struct sql_operator<std::less<T> >
+{
+  static const char* str() { return " < "; }
+};
+
+template < class T >
+struct sql_operator<std::less_equal<T> >
+{
+  static const char* str() { return " <= "; }
+};
+
+template < class T >
+struct sql_operator<std::equal_to<T> >
+{
+  static const char* str() { return " = "; }
+};
+
+template < class T >
+struct sql_operator<std::not_equal_to<T> >
+{
+  static const char* str() { return " <> "; }
+};
+
+template <>
+struct sql_operator<std::logical_and<bool> >
+{
+  static const char* str() { return " AND "; }
+};
+
+template <>
+struct sql_operator<std::logical_or<bool> >
+{
+  static const char* str() { return " OR "; }
+};
+
+/*
+ * append a constant value of an
+ * expression as bound value
+ */
+template < class T >
+void sql_value(sql_clause &clause, const std::string &column, const T &val)
+{
+  clause.append(column, val);
+}
+
+template < class T >
+void sql_value(sql_clause &clause, const std::string &column, const object_ptr<T> &val)
+{
+  clause.append(column, val.id());
+}
+
+template < class T >
+void sql_value(sql_clause &clause, const std::string &column, const object_ref<T> &val)
+{
+  clause.append(column, val.id());
+}
+
+/*
+ * default: the expression can't
+ * be translated into sql
+ */
+template < class E >
+struct sql_expression
+{
+  static bool translate(const E&, sql_clause&)
+  {
+    return false;
+  }
+};
+
+/*
+ * variable op constant
+ */
+template < class T, class OP >
+struct sql_expression<binary_expression<variable<T>, T, OP> >
+{
+  static bool translate(const binary_expression<variable<T>, T, OP> &expr, sql_clause &out)
+  {
+    if (expr.left().column().empty() || !sql_operator<OP>::str()) {
+      return false;
+    }
+    out.append(expr.left().column() + sql_operator<OP>::str());
+    sql_value(out, expr.left().column(), expr.right().value());
+    return true;
+  }
+};
+
+/*
+ * constant op variable
+ */
+template < class T, class OP >
+struct sql_expression<binary_expression<T, variable<T>, OP> >
+{
+  static bool translate(const binary_expression<T, variable<T>, OP> &expr, sql_clause &out)
+  {
+    if (expr.right().column().empty() || !sql_operator<OP>::str()) {
+      return false;
+    }
+    sql_value(out, expr.right().column(), expr.left().value());
+    out.append(sql_operator<OP>::str() + expr.right().column());
+    return true;
+  }
+};
+
+/*
+ * expression and/or expression
+ */
+template < class L1, class R1, class OP1, class L2, class R2, class OP2, class OP >
+struct sql_expression<binary_expression<binary_expression<L1, R1, OP1>, binary_expression<L2, R2, OP2>, OP> >
+{
+  typedef binary_expression<L1, R1, OP1> left_type;
+  typedef binary_expression<L2, R2, OP2> right_type;
+
+  static bool translate(const binary_expression<left_type, right_type, OP> &expr, sql_clause &out)
+  {
+    if (!sql_operator<OP>::str()) {
+      return false;
+    }
+    out.append("(");
+    if (!sql_expression<left_type>::translate(expr.left(), out)) {
+      return false;
+    }
+    out.append(std::string(")") + sql_operator<OP>::str() + "(");
+    if (!sql_expression<right_type>::translate(expr.right(), out)) {
+      return false;
+    }
+    out.append(")");
+    return true;
+  }
+};
+
+/*
+ * not expression
+ */
+template < class L, class R, class OP >
+struct sql_expression<unary_expression<binary_expression<L, R, OP>, std::logical_not<bool> > >
+{
+  typedef binary_expression<L, R, OP> left_type;
+
+  static bool translate(const unary_expression<left_type, std::logical_not<bool> > &expr, sql_clause &out)
+  {
+    out.append("NOT (");
+    if (!sql_expression<left_type>::translate(expr.left(), out)) {
+      return false;
+    }
+    out.append(")");
+    return true;
+  }
+};
+
+/// @endcond
+
+/**
+ * @brief Translates an object expression into a sql where clause
+ *
+ * Tries to translate the given object expression into
+ * a sql where clause. This succeeds if all variables of
+ * the expression were created with a column name (see
+ * make_var()) and only comparison and logical operators
+ * are used. Nested variables can't be translated.
+ *
+ * The constant values of the expression aren't written
+ * into the clause, they are bound to placeholders when
+ * the statement is executed.
+ *
+ * If the expression couldn't be translated false is
+ * returned and the clause is left untouched. In this
+ * case the expression must be evaluated in memory.
+ *
+ * @tparam E The type of the expression.
+ * @param expr The expression to translate.
+ * @param clause The resulting where clause.
+ * @return True if the expression could be translated.
+ */
+template < class E >
+bool make_sql_expression(const E &expr, sql_clause &clause)
+{
+  sql_clause out;
+  if (!sql_expression<E>::translate(expr, out)) {
+    return false;
+  }
+  clause = out;
+  return true;
+}
+
+}
+
+#endif /* SQL_EXPRESSION_HPP */
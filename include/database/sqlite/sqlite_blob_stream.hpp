@@ -0,0 +1,66 @@
+/*
+ * This file is part of OpenObjectStore OOS.
+ *
+ * OpenObjectStore OOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenObjectStore OOS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenObjectStore OOS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SQLITE_BLOB_STREAM_HPP
+#define SQLITE_BLOB_STREAM_HPP
+
+#include "database/blob_stream.hpp"
+
+#include <string>
+
+struct sqlite3_blob;
+
+namespace oos {
+
+namespace sqlite {
+
+class sqlite_database;
+
+/// @cond OOS_DEV
+
+/**
+ * @class sqlite_blob_stream
+ * @brief Incremental blob i/o for the sqlite backend
+ *
+ * Wraps a sqlite3_blob handle. The value is
+ * transferred with sqlite3_blob_read() and
+ * sqlite3_blob_write() in the requested parts
+ * only.
+ */
+class sqlite_blob_stream : public blob_stream
+{
+public:
+  sqlite_blob_stream(sqlite_database &db, const std::string &table, const std::string &column, long id, bool writable);
+  virtual ~sqlite_blob_stream();
+
+  virtual size_type size() const;
+  virtual void read(size_type offset, char *buf, size_type size);
+  virtual void write(size_type offset, const char *buf, size_type size);
+  virtual void reopen(long id);
+
+private:
+  sqlite_database &db_;
+  sqlite3_blob *blob_;
+};
+
+/// @endcond
+
+}
+
+}
+
+#endif /* SQLITE_BLOB_STREAM_HPP */
@@ -47,6 +47,22 @@ class sqlite_statement;
  * 
  * This class is the sqlite database backend
  * class. It provides the sqlite version 3
+ *
+ * The connection string may contain options
+ * which are applied when the database is
+ * opened. They are appended to the file name
+ * like an url query:
+ *
+ * sqlite://file.db?journal=wal&sync=normal&mmap=1G&cache=-200000&busy=5000
+ *
+ * - journal: the journal mode (delete, truncate, persist, memory, wal, off)
+ * - sync: the synchronous mode (off, normal, full, extra)
+ * - mmap: the maximum size of the memory map (suffix K, M or G allowed)
+ * - cache: the page cache size (negative values are KiB)
+ * - busy: the busy timeout in milliseconds
+ *
+ * Any other option or value throws a
+ * database_exception.
  */
 class OOS_SQLITE_API sqlite_database : public database
 {
@@ -86,8 +102,15 @@ protected:
   virtual void on_begin();
   virtual void on_commit();
   virtual void on_rollback();
+  virtual std::string on_explain(const std::string &sql);
+  virtual blob_stream* on_open_blob(const std::string &table, const std::string &column, long id, bool writable);
+  virtual void on_reserve_blob(const std::string &table, const std::string &column, long id, unsigned long size);
 
 private:
+  void apply_option(const std::string &key, const std::string &value);
+  static const char* keyword(const std::string &key, const std::string &value, const char **keywords);
+  static std::string quote_identifier(const std::string &name);
+
   static int parse_result(void* param, int column_count, char** values, char** columns);
 
 private:
@@ -55,6 +55,19 @@ public:
   virtual result* execute() = 0;
 
   virtual void reset() = 0;
+
+  /*
+   * adds the currently bound parameter set to
+   * the batch of the statement. backends without
+   * array binding execute the statement at once
+   */
+  virtual void add_batch();
+
+  /*
+   * executes all parameter sets added to the
+   * batch since the last execution
+   */
+  virtual void execute_batch();
   
   int bind(object_atomizable *o);
 
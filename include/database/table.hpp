@@ -49,10 +49,13 @@
 
 #include <map>
 #include <list>
+#include <set>
 
 namespace oos {
 
 class statement;
+class sql_clause;
+class result;
 class object;
 class object_container;
 class object_base_ptr;
@@ -78,13 +81,17 @@ public:
   virtual void prepare();
   void create();
   void load(object_store &ostore);
+  void load(object_store &ostore, const sql_clause &clause);
+  void load_relation(object_store &ostore, const prototype_node &parent, const std::string &field);
   void insert(object *obj);
+  void insert(object_list_t::const_iterator first, object_list_t::const_iterator last);
   void update(object *obj);
   void remove(object *obj);
   void remove(long id);
   void drop();
 
   bool is_loaded() const;
+  unsigned long loaded_batches() const;
 
   template < class T >
   void read_value(const char *, T &) {}
@@ -98,6 +105,12 @@ protected:
   virtual database& db() { return db_; }
   virtual const database& db() const { return db_; }
 
+private:
+  void prepare_select();
+  unsigned long read(result *res, long &last_id);
+  void fill_relations();
+  void load_eager_relations(object_store &ostore);
+
 private:
   friend class relation_filler;
 
@@ -109,6 +122,9 @@ private:
   statement *update_;
   statement *delete_;
   statement *select_;
+  unsigned long select_batch_size_;
+  // batches read by the last load
+  unsigned long loaded_batches_;
   
   // temp data while loading
   object *object_;
@@ -117,7 +133,12 @@ private:
   bool prepared_;
 
   bool is_loaded_;
+  bool loaded_by_relation_;
   relation_data_t relation_data;
+
+  // reference column while loading a relation eager
+  std::string relation_column_;
+  long relation_id_;
 };
 
 ///@endcond
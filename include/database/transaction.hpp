@@ -32,8 +32,9 @@
 #endif
 
 #include "object/object_observer.hpp"
+#include "object/undo_log.hpp"
 
-#include "tools/byte_buffer.hpp"
+#include "database/commit_pipeline.hpp"
 
 #ifdef WIN32
 #include <unordered_map>
@@ -42,6 +43,7 @@
 #endif
 
 #include <memory>
+#include <atomic>
 #include <list>
 #include <set>
 #include <map>
@@ -50,7 +52,6 @@ namespace oos {
 
 class session;
 class object_store;
-class byte_buffer;
 class action;
 
 /**
@@ -64,6 +65,11 @@ class action;
  * behaviour of the database. On rollback it restores
  * the stored data to the objects modified within
  * the transaction.
+ *
+ * Only the old values of the fields changed by
+ * object::modify() are kept. Objects modified in
+ * another way and deleted objects are kept as a
+ * whole.
  */
 class OOS_API transaction : public object_observer
 {
@@ -72,6 +78,37 @@ public:
   typedef action_list_t::iterator iterator;             /**< Shortcut for the action list iterator. */
   typedef action_list_t::const_iterator const_iterator; /**< Shortcut for the action list const iterator. */
 
+  /**
+   * @brief The modes of a transaction
+   *
+   * The mode decides which undo information
+   * a transaction keeps. Bulk loads should
+   * not pay for undo information they will
+   * never use.
+   */
+  enum mode_t {
+    /**
+     * All insertions, modifications and deletions
+     * are recorded and can be rolled back (default).
+     */
+    read_write,
+    /**
+     * Nothing is recorded and the sequence isn't backed
+     * up. Changes made while a read only transaction
+     * is current belong to the enclosing transaction.
+     * Without an enclosing transaction changes throw
+     * an object_exception.
+     */
+    read_only,
+    /**
+     * Only insertions are allowed and no object is
+     * backed up. A rollback removes the inserted
+     * objects and rolls back the database. Modifying
+     * or deleting an object throws an object_exception.
+     */
+    insert_only
+  };
+
 public:
   /**
    * @brief Create a transaction
@@ -81,8 +118,9 @@ public:
    * start must be called.
    *
    * @param db The underlaying database.
+   * @param mode The mode of the transaction.
    */
-  transaction(session &db);
+  transaction(session &db, mode_t mode = read_write);
 
   ~transaction();
   
@@ -93,6 +131,13 @@ public:
    */
   long id() const;
 
+  /**
+   * Return the mode of the transaction.
+   *
+   * @return The transaction mode.
+   */
+  mode_t mode() const;
+
   /**
    * @brief Start the transaction.
    *
@@ -107,8 +152,16 @@ public:
    * Commit the started transaction. All object
    * insertions, modifications and deletions are
    * written to the database.
+   *
+   * If the session commits asynchronous the
+   * changes are handed to the background writer
+   * and the returned future becomes ready once
+   * they are written. Otherwise the returned
+   * future is always ready.
+   *
+   * @return The future of the written transaction.
    */
-  void commit();
+  commit_pipeline::future_type commit();
 
   /**
    * @brief Abort and rollback the started transaction.
@@ -144,22 +197,24 @@ private:
   friend class object_store;
   friend class session;
   
-  void backup(action *a, const object *o);
-  void restore(action *a);
+  void append(action *a, const object *o);
+  void reject(const char *change) const;
+  void backup(const object *o);
 
   void cleanup();
 
 private:
-  static long id_counter;
+  static std::atomic<long> id_counter;
 
 private:
   session &db_;
   long id_;
+  mode_t mode_;
   
   id_iterator_map_t id_map_;
   action_list_t action_list_;
 
-  byte_buffer object_buffer_;
+  undo_log undo_log_;
 };
 
 }
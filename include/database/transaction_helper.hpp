@@ -18,13 +18,9 @@
 #ifndef TRANSACTION_HELPER_HPP
 #define TRANSACTION_HELPER_HPP
 
-#include "object/object_serializer.hpp"
-
 #include "database/action.hpp"
 #include "database/transaction.hpp"
 
-#include "tools/byte_buffer.hpp"
-
 #ifdef WIN32
 #include <unordered_map>
 #else
@@ -40,52 +36,6 @@ namespace oos {
 
 /// @cond OOS_DEV
 
-class backup_visitor : public action_visitor
-{
-public:
-  backup_visitor()
-    : buffer_(0)
-    , object_(0)
-  {}
-  virtual ~backup_visitor() {}
-
-  bool backup(action *act, const object *o, byte_buffer *buffer);
-
-  virtual void visit(create_action *) {}
-  virtual void visit(insert_action *a);
-  virtual void visit(update_action *a);
-  virtual void visit(delete_action *a);  
-  virtual void visit(drop_action *) {}
-
-private:
-  byte_buffer *buffer_;
-  const object *object_;
-  object_serializer serializer_;
-};
-
-class restore_visitor : public action_visitor
-{
-public:
-  restore_visitor()
-    : buffer_(NULL)
-    , ostore_(NULL)
-  {}
-  virtual ~restore_visitor() {}
-
-  bool restore(action *act, byte_buffer *buffer, object_store *ostore);
-
-  virtual void visit(create_action *) {}
-  virtual void visit(insert_action *a);
-  virtual void visit(update_action *a);
-  virtual void visit(delete_action *a);
-  virtual void visit(drop_action *) {}
-
-private:
-  byte_buffer *buffer_;
-  object_store *ostore_;
-  object_serializer serializer_;
-};
-
 class action_inserter : public action_visitor
 {
 public:
@@ -116,9 +66,14 @@ public:
   action_remover(transaction::action_list_t &action_list)
     : action_list_(action_list)
     , id_(0)
+    , replaced_(false)
   {}
   virtual ~action_remover() {}
 
+  /*
+   * returns true if an update action
+   * was replaced by a delete action
+   */
   bool remove(transaction::iterator i, object *o);
 
   virtual void visit(create_action*) {}
@@ -132,6 +87,7 @@ private:
   transaction::iterator iter_;
   object *obj_;
   long id_;
+  bool replaced_;
 };
 /// @endcond
 
@@ -18,6 +18,8 @@
 #ifndef GENERIC_JSON_PARSER_HPP
 #define GENERIC_JSON_PARSER_HPP
 
+#include "json/json_exception.hpp"
+
 #include <stdexcept>
 #include <iostream>
 
@@ -66,6 +68,8 @@ private:
   void parse_json_object(std::istream &in);
   void parse_json_array(std::istream &in);
   std::string parse_json_string(std::istream &in);
+  unsigned long parse_json_hex(std::istream &in);
+  void append_utf8(std::string &value, unsigned long cp);
   double parse_json_number(std::istream &in);
   bool parse_json_bool(std::istream &in);
   void parse_json_null(std::istream &in);
@@ -159,6 +163,8 @@ generic_json_parser<T>::parse_json_object(std::istream &in)
     // empty object
     return;
   }
+  // not empty, c is the first key character
+  in.putback(c);
   
   // skip white
   in >> std::ws;
@@ -223,6 +229,8 @@ generic_json_parser<T>::parse_json_array(std::istream &in)
     // empty array
     return;
   }
+  // not empty, c is the first value character
+  in.putback(c);
   
   // skip white
   in >> std::ws;
@@ -301,17 +309,21 @@ generic_json_parser<T>::parse_json_string(std::istream &in)
           value.push_back('\t');
           break;
         case 'u':
-          // read four more hex digits
-          value.push_back('\\');
-          value.push_back('u');
-          for (int i = 0; i < 4; ++i) {
-            c = in.get();
-            if (isxdigit(c)) {
-              value.push_back(c);
-            } else {
-              // TODO: throw json_error instead
-              throw std::logic_error("invalid json character");
+          {
+            // read four more hex digits
+            unsigned long cp = parse_json_hex(in);
+            if (cp >= 0xd800 && cp <= 0xdbff) {
+              // high surrogate, the low one must follow
+              if (in.get() != '\\' || in.get() != 'u') {
+                throw json_error("missing low surrogate");
+              }
+              unsigned long low = parse_json_hex(in);
+              if (low < 0xdc00 || low > 0xdfff) {
+                throw json_error("invalid low surrogate");
+              }
+              cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
             }
+            append_utf8(value, cp);
           }
           break;
         default:
@@ -325,6 +337,47 @@ generic_json_parser<T>::parse_json_string(std::istream &in)
   return value;
 }
 
+template < class T >
+unsigned long
+generic_json_parser<T>::parse_json_hex(std::istream &in)
+{
+  unsigned long cp = 0;
+  for (int i = 0; i < 4; ++i) {
+    char c = in.get();
+    if (c >= '0' && c <= '9') {
+      cp = (cp << 4) | (c - '0');
+    } else if (c >= 'a' && c <= 'f') {
+      cp = (cp << 4) | (c - 'a' + 10);
+    } else if (c >= 'A' && c <= 'F') {
+      cp = (cp << 4) | (c - 'A' + 10);
+    } else {
+      throw json_error("invalid hex digit");
+    }
+  }
+  return cp;
+}
+
+template < class T >
+void
+generic_json_parser<T>::append_utf8(std::string &value, unsigned long cp)
+{
+  if (cp < 0x80) {
+    value.push_back((char)cp);
+  } else if (cp < 0x800) {
+    value.push_back((char)(0xc0 | (cp >> 6)));
+    value.push_back((char)(0x80 | (cp & 0x3f)));
+  } else if (cp < 0x10000) {
+    value.push_back((char)(0xe0 | (cp >> 12)));
+    value.push_back((char)(0x80 | ((cp >> 6) & 0x3f)));
+    value.push_back((char)(0x80 | (cp & 0x3f)));
+  } else {
+    value.push_back((char)(0xf0 | (cp >> 18)));
+    value.push_back((char)(0x80 | ((cp >> 12) & 0x3f)));
+    value.push_back((char)(0x80 | ((cp >> 6) & 0x3f)));
+    value.push_back((char)(0x80 | (cp & 0x3f)));
+  }
+}
+
 template < class T >
 double
 generic_json_parser<T>::parse_json_number(std::istream &in)
@@ -0,0 +1,60 @@
+/*
+ * This file is part of OpenObjectStore OOS.
+ *
+ * OpenObjectStore OOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenObjectStore OOS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenObjectStore OOS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef JSON_EXCEPTION_HPP
+#define JSON_EXCEPTION_HPP
+
+#ifdef WIN32
+  #ifdef oos_EXPORTS
+    #define OOS_API __declspec(dllexport)
+    #define EXPIMP_TEMPLATE
+  #else
+    #define OOS_API __declspec(dllimport)
+    #define EXPIMP_TEMPLATE extern
+  #endif
+  #pragma warning(disable: 4251)
+#else
+  #define OOS_API
+#endif
+
+#include <stdexcept>
+
+namespace oos {
+
+/**
+ * @class json_error
+ * @brief A json exception class
+ *
+ * This kind of exception is thrown, when
+ * a json parser reads invalid input.
+ */
+class OOS_API json_error : public std::logic_error
+{
+public:
+  /**
+   * Creates a json_error
+   *
+   * @param what The message of the exception.
+   */
+  explicit json_error(const char *what);
+
+  virtual ~json_error() throw();
+};
+
+}
+
+#endif /* JSON_EXCEPTION_HPP */
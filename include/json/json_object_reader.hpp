@@ -0,0 +1,172 @@
+/*
+ * This file is part of OpenObjectStore OOS.
+ *
+ * OpenObjectStore OOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenObjectStore OOS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenObjectStore OOS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef JSON_OBJECT_READER_HPP
+#define JSON_OBJECT_READER_HPP
+
+#ifdef WIN32
+  #ifdef oos_EXPORTS
+    #define OOS_API __declspec(dllexport)
+    #define EXPIMP_TEMPLATE
+  #else
+    #define OOS_API __declspec(dllimport)
+    #define EXPIMP_TEMPLATE extern
+  #endif
+  #pragma warning(disable: 4355)
+#else
+  #define OOS_API
+#endif
+
+#include "json/generic_json_parser.hpp"
+#include "object/object_atomizer.hpp"
+
+#ifdef WIN32
+#include <unordered_map>
+#else
+#include <tr1/unordered_map>
+#endif
+
+#include <istream>
+#include <string>
+#include <vector>
+#include <cstddef>
+
+namespace oos {
+
+class object_store;
+class object_base_ptr;
+class object_container;
+class varchar_base;
+
+/**
+ * @class json_object_reader
+ * @brief Reads objects written by the json_object_writer
+ *
+ * The reader parses the json stream through the
+ * callbacks of the generic_json_parser. The fields
+ * of the current object are kept until the object
+ * is complete, then the object is created by the
+ * producer of its prototype and inserted into the
+ * store. No json_value is built, so the memory
+ * needed doesn't grow with the size of the stream.
+ *
+ * If an object with the same id already exists
+ * it is updated instead. Object pointers to
+ * objects which aren't read yet are resolved
+ * once the object is read.
+ *
+ * Numbers are read as double by the json parser;
+ * integers beyond 2^53 lose precision.
+ */
+class OOS_API json_object_reader
+  : public generic_json_parser<json_object_reader>
+  , public generic_object_reader<json_object_reader>
+{
+public:
+  /**
+   * Creates a json_object_reader inserting
+   * the objects into the given store.
+   *
+   * @param ostore The object_store to fill.
+   */
+  explicit json_object_reader(object_store &ostore);
+  virtual ~json_object_reader();
+
+  /**
+   * Reads all objects of the stream into the
+   * store. The objects read before an error
+   * occurred stay in the store.
+   *
+   * @param in The json input stream.
+   * @return The number of objects read.
+   */
+  std::size_t deserialize(std::istream &in);
+
+  /// @cond OOS_DEV
+
+  void on_begin_object();
+  void on_object_key(const std::string &key);
+  void on_end_object();
+
+  void on_begin_array();
+  void on_end_array();
+
+  void on_string(const std::string &value);
+  void on_number(double value);
+  void on_bool(bool value);
+  void on_null();
+
+  template < class T >
+  void read_value(const char *id, T &x)
+  {
+    const field *f = find_field(id);
+    if (f && f->kind == number_field) {
+      x = static_cast<T>(f->number);
+    }
+  }
+
+  void read_value(const char *id, bool &x);
+  void read_value(const char *id, char *x, int s);
+  void read_value(const char *id, std::string &x);
+  void read_value(const char *id, varchar_base &x);
+  void read_value(const char *id, object_base_ptr &x);
+  void read_value(const char *id, object_container &x);
+
+  /// @endcond
+
+private:
+  enum field_kind {
+    null_field,
+    number_field,
+    bool_field,
+    string_field,
+    array_field
+  };
+
+  struct field
+  {
+    field() : kind(null_field), number(0), flag(false) {}
+
+    field_kind kind;
+    double number;
+    bool flag;
+    std::string str;
+    std::vector<long> ids;
+  };
+
+  field& current_field(field_kind kind);
+  const field* find_field(const char *id) const;
+
+  void read_object();
+
+private:
+  typedef std::tr1::unordered_map<std::string, field> t_field_map;
+
+  object_store &ostore_;
+
+  // 1 = document, 2 = prototype array,
+  // 3 = object, 4 = container array
+  int depth_;
+  std::string type_;
+  std::string key_;
+  t_field_map fields_;
+  std::size_t count_;
+};
+
+}
+
+#endif /* JSON_OBJECT_READER_HPP */
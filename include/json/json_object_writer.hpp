@@ -0,0 +1,146 @@
+/*
+ * This file is part of OpenObjectStore OOS.
+ *
+ * OpenObjectStore OOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenObjectStore OOS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenObjectStore OOS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef JSON_OBJECT_WRITER_HPP
+#define JSON_OBJECT_WRITER_HPP
+
+#ifdef WIN32
+  #ifdef oos_EXPORTS
+    #define OOS_API __declspec(dllexport)
+    #define EXPIMP_TEMPLATE
+  #else
+    #define OOS_API __declspec(dllimport)
+    #define EXPIMP_TEMPLATE extern
+  #endif
+  #pragma warning(disable: 4355)
+#else
+  #define OOS_API
+#endif
+
+#include "object/object_atomizer.hpp"
+
+#include <ostream>
+#include <string>
+#include <cstddef>
+
+namespace oos {
+
+class object;
+class object_store;
+class object_base_ptr;
+class object_container;
+class varchar_base;
+class prototype_node;
+
+/**
+ * @class json_object_writer
+ * @brief Writes objects as json to a stream
+ *
+ * The writer serializes objects field by field
+ * straight to an output stream. No json_value
+ * is built, so whole prototypes can be exported
+ * with bounded memory.
+ *
+ * Each object becomes a json object with one key
+ * per field. Object pointers are written as the
+ * id of the object (or null), containers as an
+ * array of the ids of their items. The objects of
+ * a store are grouped by their prototype:
+ *
+ * @code
+ * { "item": [ { "id": 1, "name": "..." }, ... ], ... }
+ * @endcode
+ *
+ * The result can be read back with the
+ * json_object_reader.
+ */
+class OOS_API json_object_writer : public generic_object_writer<json_object_writer>
+{
+public:
+  /**
+   * Creates a json_object_writer
+   * writing to the given stream.
+   *
+   * @param out The stream to write to.
+   */
+  explicit json_object_writer(std::ostream &out);
+  virtual ~json_object_writer();
+
+  /**
+   * Writes one object as json object.
+   *
+   * @param o The object to write.
+   */
+  void serialize(const object *o);
+
+  /**
+   * Writes all objects of the store
+   * grouped by their prototype.
+   *
+   * @param ostore The object_store to write.
+   */
+  void serialize(const object_store &ostore);
+
+  /**
+   * Writes all objects of the given prototype
+   * and its derived prototypes grouped by
+   * their prototype. If the prototype is
+   * unknown an object_exception is thrown.
+   *
+   * @param ostore The object_store to write.
+   * @param type The type of the prototype.
+   */
+  void serialize(const object_store &ostore, const char *type);
+
+  /// @cond OOS_DEV
+
+  template < class T >
+  void write_value(const char *id, const T &x)
+  {
+    write_key(id);
+    out_ << x;
+  }
+
+  void write_value(const char *id, char x);
+  void write_value(const char *id, unsigned char x);
+  void write_value(const char *id, float x);
+  void write_value(const char *id, double x);
+  void write_value(const char *id, bool x);
+  void write_value(const char *id, const char *x, int s);
+  void write_value(const char *id, const std::string &x);
+  void write_value(const char *id, const varchar_base &x);
+  void write_value(const char *id, const object_base_ptr &x);
+  void write_value(const char *id, const object_container &x);
+
+  void write_container_item(const object *o);
+
+  /// @endcond
+
+private:
+  void write_key(const char *id);
+  void write_string(const char *str, std::size_t len);
+  void write_number(double x);
+  void write_prototype(const prototype_node *node, bool &first);
+
+private:
+  std::ostream &out_;
+  bool first_;
+};
+
+}
+
+#endif /* JSON_OBJECT_WRITER_HPP */
@@ -0,0 +1,194 @@
+/*
+ * This file is part of OpenObjectStore OOS.
+ *
+ * OpenObjectStore OOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenObjectStore OOS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenObjectStore OOS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef CHANGE_STREAM_HPP
+#define CHANGE_STREAM_HPP
+
+#ifdef WIN32
+  #ifdef oos_EXPORTS
+    #define OOS_API __declspec(dllexport)
+    #define EXPIMP_TEMPLATE
+  #else
+    #define OOS_API __declspec(dllimport)
+    #define EXPIMP_TEMPLATE extern
+  #endif
+  #pragma warning(disable: 4251)
+#else
+  #define OOS_API
+#endif
+
+#include "object/object_observer.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+namespace oos {
+
+class object;
+
+/**
+ * @brief One captured change of an object.
+ *
+ * A change record tells which object of which
+ * prototype was inserted, updated or deleted. If
+ * the change_stream captures images, the record
+ * also holds the object serialized with the
+ * object_serializer.
+ */
+struct OOS_API change_record
+{
+  /**
+   * The kind of a change.
+   */
+  enum op_t {
+    insert_op = 0, /**< The object was inserted */
+    update_op,     /**< The object was modified */
+    delete_op      /**< The object is about to be deleted */
+  };
+
+  change_record() : sequence(0), type_id(0), object_id(0), op(insert_op) {}
+
+  unsigned long long sequence; /**< The number of the change in the order of the stream */
+  unsigned long type_id;       /**< The id of the prototype of the object */
+  long object_id;              /**< The id of the object */
+  op_t op;                     /**< The kind of change */
+  std::vector<char> image;     /**< The serialized object if images are captured */
+};
+
+/**
+ * @class change_stream
+ * @brief Captures the changes of an object_store.
+ *
+ * The change_stream is an object_observer which turns
+ * each insert, update and delete into a change_record
+ * and appends it to a bounded lock free ring buffer.
+ * One or more consumer threads drain the buffer with
+ * pop(), so cache invalidation, indexing or replication
+ * run off the writing thread.
+ *
+ * Writers never block: if the buffer is full the
+ * change is dropped and counted by dropped(). Each
+ * record is numbered by the slot it claimed, so the
+ * numbers follow the order of the stream.
+ *
+ * Updates are recorded when the store reports them
+ * as done (object::mark_updated(), called by
+ * object::modify()). So a captured image holds the
+ * inserted object on insert, the object after the
+ * change on update and the last state on delete.
+ *
+ * @code
+ * oos::change_stream changes(4096);
+ * ostore.register_observer(&changes);
+ *
+ * // consumer thread
+ * oos::change_record rec;
+ * while (changes.pop(rec)) { ... }
+ * @endcode
+ */
+class OOS_API change_stream : public object_observer
+{
+public:
+  /**
+   * @brief Creates a change stream.
+   *
+   * The capacity is rounded up to
+   * the next power of two.
+   *
+   * @param capacity The number of records the buffer holds.
+   * @param capture_images True if the objects should be serialized.
+   */
+  explicit change_stream(size_t capacity = 1024, bool capture_images = false);
+  virtual ~change_stream();
+
+  virtual void on_insert(object *o);
+  virtual void on_update(object *o);
+  virtual void on_updated(object *o);
+  virtual void on_delete(object *o);
+
+  /**
+   * @brief Takes the oldest record from the buffer.
+   *
+   * Returns false if the buffer is empty.
+   * May be called by many consumer threads.
+   *
+   * @param rec The record to fill.
+   * @return True if a record was taken.
+   */
+  bool pop(change_record &rec);
+
+  /**
+   * Returns the capacity of the buffer.
+   *
+   * @return The capacity of the buffer.
+   */
+  size_t capacity() const;
+
+  /**
+   * Returns the number of changes which were
+   * dropped because the buffer was full.
+   *
+   * @return The number of dropped changes.
+   */
+  unsigned long long dropped() const;
+
+  /**
+   * Returns true if the objects are
+   * serialized into the records.
+   *
+   * @return True if images are captured.
+   */
+  bool capture_images() const;
+
+private:
+  change_stream(const change_stream&);
+  change_stream& operator=(const change_stream&);
+
+  void push(object *o, change_record::op_t op);
+
+private:
+  /*
+   * bounded multi producer multi consumer
+   * queue. the turn of a cell tells if it
+   * is free for the producer of position
+   * pos (turn == pos) or filled for the
+   * consumer of position pos (turn == pos + 1)
+   */
+  struct cell
+  {
+    std::atomic<size_t> turn;
+    change_record record;
+  };
+
+  cell *cells_;
+  size_t mask_;
+  bool capture_images_;
+
+  std::atomic<unsigned long long> dropped_;
+
+  // keep producers and consumers on different cache lines
+  char pad0_[64];
+  std::atomic<size_t> head_;
+  char pad1_[64];
+  std::atomic<size_t> tail_;
+  char pad2_[64];
+};
+
+}
+
+#endif /* CHANGE_STREAM_HPP */
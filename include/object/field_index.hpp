@@ -0,0 +1,332 @@
+/*
+ * This file is part of OpenObjectStore OOS.
+ *
+ * OpenObjectStore OOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenObjectStore OOS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenObjectStore OOS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef FIELD_INDEX_HPP
+#define FIELD_INDEX_HPP
+
+#ifdef WIN32
+  #ifdef oos_EXPORTS
+    #define OOS_API __declspec(dllexport)
+    #define EXPIMP_TEMPLATE
+  #else
+    #define OOS_API __declspec(dllimport)
+    #define EXPIMP_TEMPLATE extern
+  #endif
+  #pragma warning(disable: 4251)
+#else
+  #define OOS_API
+#endif
+
+#include "tools/convert.hpp"
+
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#ifdef WIN32
+#include <unordered_map>
+#else
+#include <tr1/unordered_map>
+#endif
+
+namespace oos {
+
+class object;
+class object_base_ptr;
+class object_container;
+class varchar_base;
+
+/**
+ * @cond OOS_DEV
+ * @class field_index
+ * @brief Directory of the fields of one prototype.
+ *
+ * The field_index is computed once per prototype_node
+ * from the first object accessed by name. It maps each
+ * field name to its ordinal, its type and its offset
+ * inside the object, so object::get and object::set
+ * can access a field directly instead of visiting all
+ * fields through serialize and deserialize.
+ *
+ * A field gets an offset only if it lies inside the
+ * object (according to the size reported by the
+ * object producer). All other fields are still found
+ * by the visitor.
+ */
+class OOS_API field_index
+{
+public:
+  /**
+   * The types of a field.
+   */
+  typedef enum {
+    type_char = 0,
+    type_float,
+    type_double,
+    type_short,
+    type_int,
+    type_long,
+    type_unsigned_char,
+    type_unsigned_short,
+    type_unsigned_int,
+    type_unsigned_long,
+    type_bool,
+    type_char_array,
+    type_string,
+    type_varchar,
+    type_object_ptr,
+    type_object_container
+  } field_type;
+
+  /**
+   * @brief Describes one field.
+   */
+  struct field
+  {
+    std::string name;     /**< The name of the field */
+    unsigned int ordinal; /**< The position in the serialize order */
+    field_type type;      /**< The type of the field */
+    long offset;          /**< The offset relative to the object base */
+    int size;             /**< The size of a character array */
+    bool inside;          /**< True if the field lies inside the object */
+
+    /**
+     * Returns true if the field can be
+     * accessed directly by its offset.
+     *
+     * @return True if the field is addressable.
+     */
+    bool addressable() const { return inside && type != type_object_container; }
+
+    /**
+     * Retrieves the value of this field of
+     * the given object converted into T.
+     *
+     * @tparam T The type of the value.
+     * @param o The object to read from.
+     * @param to The value to assign.
+     * @param precision The precision or -1.
+     */
+    template < class T >
+    void get(const object *o, T &to, int precision = -1) const
+    {
+      const char *addr = reinterpret_cast<const char*>(o) + offset;
+      switch (type) {
+        case type_char:
+          assign(*reinterpret_cast<const char*>(addr), to, precision);
+          break;
+        case type_float:
+          assign(*reinterpret_cast<const float*>(addr), to, precision);
+          break;
+        case type_double:
+          assign(*reinterpret_cast<const double*>(addr), to, precision);
+          break;
+        case type_short:
+          assign(*reinterpret_cast<const short*>(addr), to, precision);
+          break;
+        case type_int:
+          assign(*reinterpret_cast<const int*>(addr), to, precision);
+          break;
+        case type_long:
+          assign(*reinterpret_cast<const long*>(addr), to, precision);
+          break;
+        case type_unsigned_char:
+          assign(*reinterpret_cast<const unsigned char*>(addr), to, precision);
+          break;
+        case type_unsigned_short:
+          assign(*reinterpret_cast<const unsigned short*>(addr), to, precision);
+          break;
+        case type_unsigned_int:
+          assign(*reinterpret_cast<const unsigned int*>(addr), to, precision);
+          break;
+        case type_unsigned_long:
+          assign(*reinterpret_cast<const unsigned long*>(addr), to, precision);
+          break;
+        case type_bool:
+          assign(*reinterpret_cast<const bool*>(addr), to, precision);
+          break;
+        case type_char_array:
+          assign(addr, to, precision);
+          break;
+        case type_string:
+          assign(*reinterpret_cast<const std::string*>(addr), to, precision);
+          break;
+        case type_varchar:
+          assign(*reinterpret_cast<const varchar_base*>(addr), to, precision);
+          break;
+        case type_object_ptr:
+          assign(*reinterpret_cast<const object_base_ptr*>(addr), to, precision);
+          break;
+        default:
+          break;
+      }
+    }
+
+    /**
+     * Sets this field of the given object
+     * to the value converted from T.
+     *
+     * @tparam T The type of the value.
+     * @param o The object to modify.
+     * @param from The value to set.
+     */
+    template < class T >
+    void set(object *o, const T &from) const
+    {
+      char *addr = reinterpret_cast<char*>(o) + offset;
+      switch (type) {
+        case type_char:
+          convert(from, *reinterpret_cast<char*>(addr));
+          break;
+        case type_float:
+          convert(from, *reinterpret_cast<float*>(addr));
+          break;
+        case type_double:
+          convert(from, *reinterpret_cast<double*>(addr));
+          break;
+        case type_short:
+          convert(from, *reinterpret_cast<short*>(addr));
+          break;
+        case type_int:
+          convert(from, *reinterpret_cast<int*>(addr));
+          break;
+        case type_long:
+          convert(from, *reinterpret_cast<long*>(addr));
+          break;
+        case type_unsigned_char:
+          convert(from, *reinterpret_cast<unsigned char*>(addr));
+          break;
+        case type_unsigned_short:
+          convert(from, *reinterpret_cast<unsigned short*>(addr));
+          break;
+        case type_unsigned_int:
+          convert(from, *reinterpret_cast<unsigned int*>(addr));
+          break;
+        case type_unsigned_long:
+          convert(from, *reinterpret_cast<unsigned long*>(addr));
+          break;
+        case type_bool:
+          convert(from, *reinterpret_cast<bool*>(addr));
+          break;
+        case type_char_array:
+          convert(from, addr, size);
+          break;
+        case type_string:
+          convert(from, *reinterpret_cast<std::string*>(addr));
+          break;
+        case type_varchar:
+          convert(from, *reinterpret_cast<varchar_base*>(addr));
+          break;
+        case type_object_ptr:
+          convert(from, *reinterpret_cast<object_base_ptr*>(addr));
+          break;
+        default:
+          break;
+      }
+    }
+
+  private:
+    template < class V, class T >
+    static void assign(const V &from, T &to, int precision)
+    {
+      if (precision < 0) {
+        convert(from, to);
+      } else {
+        convert(from, to, precision);
+      }
+    }
+  };
+
+  typedef std::vector<field> field_vector_t;         /**< Shortcut for the vector of fields. */
+  typedef field_vector_t::const_iterator const_iterator; /**< Shortcut for the field iterator. */
+  typedef field_vector_t::size_type size_type;       /**< Shortcut for the size type. */
+
+  field_index();
+  ~field_index();
+
+  /**
+   * @brief Builds the index once.
+   *
+   * Visits the fields of the given object and
+   * records name, type and offset of each field.
+   * Only the first call builds the index, all
+   * following calls return immediately. The call
+   * is thread safe.
+   *
+   * @param o The object to build the index from.
+   * @param object_size The size of the object or zero if unknown.
+   */
+  void build(object *o, size_t object_size);
+
+  /**
+   * Returns true if the index was built.
+   *
+   * @return True if the index was built.
+   */
+  bool built() const;
+
+  /**
+   * Returns the field with the given name
+   * or NULL if there is no such field.
+   *
+   * @param name The name of the field.
+   * @return The field or NULL.
+   */
+  const field* find(const std::string &name) const;
+
+  /**
+   * Returns the number of fields.
+   *
+   * @return The number of fields.
+   */
+  size_type size() const;
+
+  /**
+   * Returns the begin of the fields
+   * in serialize order.
+   *
+   * @return The begin of the fields.
+   */
+  const_iterator begin() const;
+
+  /**
+   * Returns the end of the fields.
+   *
+   * @return The end of the fields.
+   */
+  const_iterator end() const;
+
+private:
+  field_index(const field_index&);
+  field_index& operator=(const field_index&);
+
+  void collect(object *o, size_t object_size);
+
+private:
+  typedef std::tr1::unordered_map<std::string, size_type> name_map_t;
+
+  field_vector_t fields_;
+  name_map_t name_map_;
+  std::once_flag once_;
+  bool built_;
+};
+/// @endcond
+
+}
+
+#endif /* FIELD_INDEX_HPP */
@@ -653,6 +653,8 @@ public:
 
       item->prev()->next_ = item;
       node->prev_ = item;
+
+      mark_updated(parent_);
     }
   }
 
@@ -32,8 +32,10 @@
 #endif
 
 #include "object/attribute_serializer.hpp"
+#include "object/field_index.hpp"
 #include "object/object_atomizer.hpp"
 #include "object/object_atomizable.hpp"
+#include "object/undo_log.hpp"
 
 #include "tools/enable_if.hpp"
 #include "tools/varchar.hpp"
@@ -106,6 +108,23 @@ public:
     serializer.write("id", id_);
   }
 
+  /**
+   * @brief Describes the fields of the object.
+   *
+   * Passes the name and the member pointer of the
+   * id field to the given functor. Classes with
+   * a static field description call it first
+   * (see object_fields.hpp).
+   *
+   * @tparam F The type of the functor.
+   * @param f The functor called for each field.
+   */
+  template < class F >
+  static void describe(F &f)
+  {
+    f("id", &object::id_);
+  }
+
   /**
    * @brief Returns the classname of the  object
    *
@@ -161,6 +180,11 @@ public:
   template < class T >
   bool set(const std::string &name, const T &val)
   {
+    const field_index::field *f = find_field(name);
+    if (f) {
+      f->set(this, val);
+      return true;
+    }
     attribute_reader<T> reader(name, val);
     deserialize(reader);
     return reader.success();
@@ -179,6 +203,11 @@ public:
   template < class T >
   bool get(const std::string &name, T &val)
   {
+    const field_index::field *f = find_field(name);
+    if (f) {
+      f->get(this, val);
+      return true;
+    }
     attribute_writer<T> writer(name, val);
     serialize(writer);
     return writer.success();
@@ -198,6 +227,11 @@ public:
   template < class T >
   bool get(const std::string &name, T &val, int precision)
   {
+    const field_index::field *f = find_field(name);
+    if (f) {
+      f->get(this, val, precision);
+      return true;
+    }
     attribute_writer<T> writer(name, val, precision);
     serialize(writer);
     return writer.success();
@@ -224,8 +258,10 @@ public:
   template < class T >
   void modify(T &attr, const T &val)
   {
+    log_undo(attr);
     mark_modified();
     attr = val;
+    mark_updated();
   }
 
   /**
@@ -244,12 +280,18 @@ public:
     if (max_size < size) {
       throw std::logic_error("not enough character size");
     }
+    std::ptrdiff_t offset = 0;
+    undo_log *log = undo(attr, max_size, offset);
+    if (log) {
+      log->push(id_, offset, static_cast<const char*>(attr));
+    }
     mark_modified();
 #ifdef WIN32
     strcpy_s(attr, max_size, val);
 #else
     strcpy(attr, val);
 #endif
+    mark_updated();
   }
 
   /**
@@ -263,8 +305,10 @@ public:
   template < class T >
   void modify(oos::object_ref<T> &attr, const oos::object_ptr<T> &val)
   {
+    log_undo(attr);
     mark_modified();
     attr = val;
+    mark_updated();
   }
 
   /**
@@ -276,8 +320,10 @@ public:
    */
   void modify(varchar_base &attr, const std::string &val)
   {
+    log_undo(attr);
     mark_modified();
     attr = val;
+    mark_updated();
   }
 
   /**
@@ -289,8 +335,10 @@ public:
    */
   void modify(varchar_base &attr, const varchar_base &val)
   {
+    log_undo(attr);
     mark_modified();
     attr = val;
+    mark_updated();
   }
 
   /**
@@ -324,8 +372,44 @@ protected:
    */
 	void mark_modified();
 
+  /**
+   * @brief Marks this object as updated in its object_store
+   *
+   * Tells the observers of the object_store that the
+   * changes announced with mark_modified() are done.
+   * The modify() methods call it after the assignment.
+   */
+  void mark_updated();
+
+private:
+  /*
+   * returns the directly addressable field
+   * of the given name from the field index
+   * of the objects prototype or NULL
+   */
+  const field_index::field* find_field(const std::string &name);
+
+  /*
+   * returns the undo_log of the objects store
+   * if the given attribute lies inside the
+   * object and sets its offset, otherwise NULL
+   */
+  undo_log* undo(const void *attr, std::size_t size, std::ptrdiff_t &offset) const;
+
+  // records the old value of the attribute
+  template < class T >
+  void log_undo(const T &attr)
+  {
+    std::ptrdiff_t offset = 0;
+    undo_log *log = undo(&attr, sizeof(T), offset);
+    if (log) {
+      log->push(id_, offset, attr);
+    }
+  }
+
 private:
 	friend class object_store;
+  friend class change_stream;
   friend class object_deleter;
   friend class object_base_ptr;
   friend class object_serializer;
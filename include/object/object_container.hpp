@@ -235,6 +235,8 @@ protected:
   friend class object_creator;
   friend class object_deleter;
   friend class object_serializer;
+  friend class json_object_reader;
+  friend class json_object_writer;
   friend class relation_handler;
   friend class relation_filler;
   friend class table;
@@ -259,6 +261,17 @@ protected:
     o->mark_modified();
   }
 
+  /**
+   * Mark the list containing object as updated
+   * in the object_store.
+   *
+   * @param o The object containig list
+   */
+  void mark_updated(object *o)
+  {
+    o->mark_updated();
+  }
+
   /**
    * @brief Executes the given function object for all elements.
    *
@@ -51,6 +51,11 @@ public:
     return constant_;
   }
 
+  const T& value() const
+  {
+    return constant_;
+  }
+
 private:
   T constant_;
 };
@@ -142,6 +147,21 @@ public:
     : impl_(impl)
   {}
 
+  /**
+   * Initializes a variable with a
+   * pointer to a concrete variable
+   * implemnation and the name of the
+   * database column the value is
+   * stored in.
+   * 
+   * @param impl The concrete variable.
+   * @param column The name of the column.
+   */
+  variable(variable_impl<R> *impl, const std::string &column)
+    : impl_(impl)
+    , column_(column)
+  {}
+
   /**
    * Copies from the given variable.
    * 
@@ -149,6 +169,7 @@ public:
    */
   variable(const variable &x)
     : impl_(x.impl_)
+    , column_(x.column_)
   {}
 
   /**
@@ -160,6 +181,7 @@ public:
   variable& operator=(const variable &x)
   {
     impl_ = x.impl_;
+    column_ = x.column_;
     return *this;
   }
   ~variable() {}
@@ -175,9 +197,23 @@ public:
   {
     return impl_->operator()(optr);
   }
+
+  /**
+   * Returns the name of the column
+   * the value is stored in. If the
+   * column is unknown an empty string
+   * is returned.
+   * 
+   * @return The name of the column.
+   */
+  std::string column() const
+  {
+    return column_;
+  }
   
 private:
   std::tr1::shared_ptr<variable_impl<R> > impl_;
+  std::string column_;
 };
 
 /**
@@ -208,6 +244,27 @@ make_var(R (O::*mem_func)() const)
   return variable<R>(new object_variable_impl<R, O, null_var>(mem_func));
 }
 
+ /**
+  * @tparam R The return value type
+  * @tparam O The object type
+  * @brief Create a variable with depth zero bound to a column
+  * 
+  * Creates a variable with depth zero. Additionally the
+  * name of the column holding the value is given. An
+  * expression built from such variables can be
+  * translated into a sql where clause.
+  * 
+  * @param mem_func A member function of the object_type.
+  * @param column The name of the column.
+  * @return A variable with return type R.
+  */
+template < class R, class O >
+variable<R>
+make_var(R (O::*mem_func)() const, const std::string &column)
+{
+  return variable<R>(new object_variable_impl<R, O, null_var>(mem_func), column);
+}
+
  /**
   * @tparam R The return value type
   * @tparam O The proxy object type
@@ -328,6 +385,8 @@ template < class L, class OP >
 class unary_expression
 {
 public:
+  typedef typename expression_traits<L>::expression_type left_type;
+
   unary_expression(const L &l, OP op = OP())
     : left_(l)
     , op_(op)
@@ -339,6 +398,11 @@ public:
     return op_(left_(optr));
   }
 
+  const left_type& left() const
+  {
+    return left_;
+  }
+
 private:
   typename expression_traits<L>::expression_type left_;
   OP op_;
@@ -348,6 +412,9 @@ template < class L, class R, class OP >
 class binary_expression
 {
 public:
+  typedef typename expression_traits<L>::expression_type left_type;
+  typedef typename expression_traits<R>::expression_type right_type;
+
   binary_expression(const L &l, const R &r, OP op = OP())
     : left_(l)
     , right_(r)
@@ -359,6 +426,16 @@ public:
     return op_(left_(optr), right_(optr));
   }
 
+  const left_type& left() const
+  {
+    return left_;
+  }
+
+  const right_type& right() const
+  {
+    return right_;
+  }
+
 private:
   typename expression_traits<L>::expression_type left_;
   typename expression_traits<R>::expression_type right_;
@@ -0,0 +1,246 @@
+/*
+ * This file is part of OpenObjectStore OOS.
+ *
+ * OpenObjectStore OOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenObjectStore OOS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenObjectStore OOS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OBJECT_FIELDS_HPP
+#define OBJECT_FIELDS_HPP
+
+#include "object/object_atomizer.hpp"
+
+#include <string>
+#include <type_traits>
+
+namespace oos {
+
+class object_base_ptr;
+class object_container;
+class varchar_base;
+class object_reader;
+class object_writer;
+
+/**
+ * @file object_fields.hpp
+ * @brief Static field descriptions of object classes.
+ *
+ * A class may describe its fields once in a static
+ * member function template describe. The function
+ * is called with a functor which takes the name of
+ * the field and a pointer to the member:
+ *
+ * @code
+ * class person : public oos::object
+ * {
+ * public:
+ *   typedef person described_type;
+ *
+ *   template < class F >
+ *   static void describe(F &f)
+ *   {
+ *     oos::object::describe(f);
+ *     f("name", &person::name_);
+ *     f("age", &person::age_);
+ *   }
+ *
+ *   virtual void deserialize(oos::object_reader &r) { oos::read_fields(*this, r); }
+ *   virtual void serialize(oos::object_writer &w) const { oos::write_fields(*this, w); }
+ *   ...
+ * };
+ * @endcode
+ *
+ * read_fields() and write_fields() generate the field
+ * walk from the description at compile time. Called
+ * with a concrete reader or writer (like the
+ * object_serializer) each field goes straight to its
+ * read_value or write_value method without any virtual
+ * call. Called with the object_reader or object_writer
+ * interface they replace the hand written deserialize
+ * and serialize, so both walks can't diverge.
+ *
+ * The described_type typedef tells that the description
+ * is complete for exactly this class. A derived class
+ * inheriting describe but adding fields is therefore
+ * still walked through its virtual serialize methods.
+ */
+
+/// @cond OOS_DEV
+
+/*
+ * maps a field to the type the object_reader
+ * and object_writer interfaces use for it, so
+ * concrete readers and writers with template
+ * catch all methods get the right overload
+ */
+template < class V >
+struct field_value
+{
+  typedef typename std::conditional<std::is_base_of<object_base_ptr, V>::value, object_base_ptr,
+          typename std::conditional<std::is_base_of<varchar_base, V>::value, varchar_base,
+          typename std::conditional<std::is_base_of<object_container, V>::value, object_container,
+          V>::type>::type>::type type;
+};
+
+/*
+ * the object_reader and object_writer interfaces
+ * name their methods read and write, concrete
+ * readers and writers read_value and write_value
+ */
+template < class W, bool Interface = std::is_same<W, object_writer>::value >
+struct field_write
+{
+  template < class V >
+  static void value(W &w, const char *id, const V &x) { w.write_value(id, x); }
+  static void value(W &w, const char *id, const char *x, int s) { w.write_value(id, x, s); }
+};
+
+template < class W >
+struct field_write<W, true>
+{
+  template < class V >
+  static void value(W &w, const char *id, const V &x) { w.write(id, x); }
+  static void value(W &w, const char *id, const char *x, int s) { w.write(id, x, s); }
+};
+
+template < class R, bool Interface = std::is_same<R, object_reader>::value >
+struct field_read
+{
+  template < class V >
+  static void value(R &r, const char *id, V &x) { r.read_value(id, x); }
+  static void value(R &r, const char *id, char *x, int s) { r.read_value(id, x, s); }
+};
+
+template < class R >
+struct field_read<R, true>
+{
+  template < class V >
+  static void value(R &r, const char *id, V &x) { r.read(id, x); }
+  static void value(R &r, const char *id, char *x, int s) { r.read(id, x, s); }
+};
+
+template < class T, class W >
+class field_writer
+{
+public:
+  field_writer(const T &obj, W &writer) : obj_(obj), writer_(writer) {}
+
+  template < class V, class C >
+  void operator()(const char *id, V C::*member)
+  {
+    typedef typename field_value<V>::type value_type;
+    field_write<W>::value(writer_, id, static_cast<const value_type&>(obj_.*member));
+  }
+
+  template < class C, int N >
+  void operator()(const char *id, char (C::*member)[N])
+  {
+    field_write<W>::value(writer_, id, obj_.*member, N);
+  }
+
+private:
+  const T &obj_;
+  W &writer_;
+};
+
+template < class T, class R >
+class field_reader
+{
+public:
+  field_reader(T &obj, R &reader) : obj_(obj), reader_(reader) {}
+
+  template < class V, class C >
+  void operator()(const char *id, V C::*member)
+  {
+    typedef typename field_value<V>::type value_type;
+    field_read<R>::value(reader_, id, static_cast<value_type&>(obj_.*member));
+  }
+
+  template < class C, int N >
+  void operator()(const char *id, char (C::*member)[N])
+  {
+    char *x = obj_.*member;
+    field_read<R>::value(reader_, id, x, N);
+  }
+
+private:
+  T &obj_;
+  R &reader_;
+};
+
+struct field_probe
+{
+  template < class V, class C >
+  void operator()(const char*, V C::*) {}
+};
+
+/// @endcond
+
+/**
+ * @brief Tells if a class has a complete field description.
+ *
+ * The value is true if the class T provides the static
+ * describe function and the described_type typedef
+ * naming T itself.
+ *
+ * @tparam T The class to check.
+ */
+template < class T >
+struct has_fields
+{
+private:
+  template < class U >
+  static std::true_type test(typename std::enable_if<std::is_same<typename U::described_type, U>::value>::type*,
+                             decltype(U::describe(std::declval<field_probe&>()))* = 0);
+  template < class U >
+  static std::false_type test(...);
+
+public:
+  enum { value = decltype(test<T>(0))::value };
+};
+
+/**
+ * Writes all described fields of the given
+ * object to the writer.
+ *
+ * @tparam T The type of the object.
+ * @tparam W The type of the writer.
+ * @param obj The object to write.
+ * @param writer The writer to write to.
+ */
+template < class T, class W >
+void write_fields(const T &obj, W &writer)
+{
+  field_writer<T, W> f(obj, writer);
+  T::describe(f);
+}
+
+/**
+ * Reads all described fields of the given
+ * object from the reader.
+ *
+ * @tparam T The type of the object.
+ * @tparam R The type of the reader.
+ * @param obj The object to read into.
+ * @param reader The reader to read from.
+ */
+template < class T, class R >
+void read_fields(T &obj, R &reader)
+{
+  field_reader<T, R> f(obj, reader);
+  T::describe(f);
+}
+
+}
+
+#endif /* OBJECT_FIELDS_HPP */
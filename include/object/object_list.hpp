@@ -408,6 +408,7 @@ public:
       this->mark_modified(x.get());
       // set back ref to parent
       setter_(*x.get(), parent_ref(this->parent()));
+      this->mark_updated(x.get());
       // insert new item object
       return this->list().insert(pos, x);
     }
@@ -422,6 +423,7 @@ public:
       this->mark_modified((*i).get());
       // set back ref to zero
       setter_(*(*i).get(), parent_ref());
+      this->mark_updated((*i).get());
       // erase element from list
       return this->list().erase(i);
     }
@@ -485,7 +487,9 @@ public:
       // mark list object as modified
       this->mark_modified(this->parent());
       // insert new item object
-      return this->list().insert(pos, item);
+      iterator i = this->list().insert(pos, item);
+      this->mark_updated(this->parent());
+      return i;
     }
   }
 
@@ -497,7 +501,9 @@ public:
       item_ptr item = *i;
       this->mark_modified(this->parent());
       this->ostore()->remove(item);
-      return this->list().erase(i);
+      iterator next = this->list().erase(i);
+      this->mark_updated(this->parent());
+      return next;
     }
   }
 
@@ -55,6 +55,17 @@ public:
    * @param o The updated object.
    */
   virtual void on_update(object *o) = 0;
+
+  /**
+   * @brief Called after an object update.
+   *
+   * Called when the changes announced with
+   * on_update() are assigned. The default
+   * implementation does nothing.
+   *
+   * @param o The updated object.
+   */
+  virtual void on_updated(object * /*o*/) {}
   
   /**
    * @brief Called on object deletion.
@@ -35,6 +35,7 @@
 #include <set>
 #include <list>
 #include <map>
+#include <atomic>
 
 #ifdef WIN32
 #include <memory>
@@ -48,6 +49,7 @@ class object;
 class object_store;
 class object_base_ptr;
 struct prototype_node;
+struct version_record;
 
 /**
  * @cond OOS_DEV
@@ -117,8 +119,6 @@ struct object_proxy {
    * When an object_proxy is unlinked it
    * is removed from the object_proxy list
    * contained by the object_store.
-   *
-   * Maybe the markers are adjusted.
    */
   void unlink();
 
@@ -203,8 +203,17 @@ struct object_proxy {
    */
   bool valid() const;
 
-  object_proxy *prev;      /**< The previous object_proxy in the list. */
-  object_proxy *next;      /**< The next object_proxy in the list. */
+  /**
+   * Returns true if the proxy is one of the
+   * markers of a prototype_node. A marker
+   * never holds an object.
+   *
+   * @return True if the proxy is a marker.
+   */
+  bool marker() const;
+
+  std::atomic<object_proxy*> prev; /**< The previous object_proxy in the list. */
+  std::atomic<object_proxy*> next; /**< The next object_proxy in the list. */
 
   object *obj;             /**< The concrete object. */
   unsigned long id;        /**< The id of the concrete or expected object. */
@@ -215,6 +224,8 @@ struct object_proxy {
   object_store *ostore;    /**< The object_store to which the object_proxy belongs. */
   prototype_node *node;    /**< The prototype_node containing the type of the object. */
 
+  std::atomic<version_record*> version; /**< The committed versions of the object if the store keeps versions. */
+
   typedef std::set<object_base_ptr*> ptr_set_t; /**< Shortcut to the object_base_ptr_set. */
   ptr_set_t ptr_set_;      /**< This set contains every object_base_ptr pointing to this object_proxy. */
   
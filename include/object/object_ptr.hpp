@@ -217,6 +217,7 @@ private:
 	friend class object_writer;
   friend class object_creator;
   friend class object_serializer;
+  friend class json_object_reader;
   friend struct object_proxy;
 
   template < class T > friend class object_ref;
@@ -35,9 +35,11 @@
 #include "object/object_atomizer.hpp"
 
 #include <string>
+#include <type_traits>
 
 namespace oos {
 
+struct object_proxy;
 class object;
 class object_base_ptr;
 class object_store;
@@ -57,20 +59,42 @@ class object_container;
  * of the correctness of the object and the current
  * memory the buffer points to.
  * The application is responsible for this correctness.
+ *
+ * Each serialized object starts with one byte
+ * holding the version of its encoding. The
+ * fixed encoding writes integers with their
+ * native width and object references with
+ * their type name. The compact encoding (default)
+ * writes integers as LEB128 varints (signed
+ * values zig-zag encoded), lengths as varints
+ * and object references with the id of their
+ * prototype.
  */
 class OOS_API object_serializer
   : public generic_object_reader<object_serializer>
   , public generic_object_writer<object_serializer>
 {
 public:
+  /**
+   * The versions of the encoding
+   */
+  enum version_t {
+    fixed = 1,  /**< Native width integers and type names. */
+    compact = 2 /**< Varints and prototype ids. */
+  };
+
   /**
    * Creates an object_serializer
+   *
+   * @param version The encoding used to serialize.
    */
-  object_serializer()
+  explicit object_serializer(version_t version = compact)
     : generic_object_reader<object_serializer>(this)
     , generic_object_writer<object_serializer>(this)
     , ostore_(NULL)
     , buffer_(NULL)
+    , version_(version)
+    , encoding_(version)
   {}
 
   virtual ~object_serializer();
@@ -89,16 +113,34 @@ public:
    *
    * @param o The object to deserialize.
    * @param buffer The byte_buffer to deserialize from.
+   * If no object_store is given, the object is
+   * deserialized detached: object pointers only
+   * get their id and containers stay empty.
+   *
+   * The encoding is read from the buffer, so
+   * objects of both versions can be deserialized.
+   *
    * @param ostore The object_store where the object resides.
    * @return True on success.
    */
   bool deserialize(object *o, byte_buffer &buffer, object_store *ostore);
 
+  /**
+   * Returns the encoding used to serialize.
+   *
+   * @return The encoding version.
+   */
+  version_t version() const;
+
 public:
   template < class T >
   void write_value(const char*, const T &x)
   {
-    buffer_->append(&x, sizeof(x));
+    if (encoding_ == fixed) {
+      buffer_->append(&x, sizeof(x));
+    } else {
+      write_compact(x, is_varint<T>());
+    }
   }
 
 	void write_value(const char* id, const char *c, int s);
@@ -110,7 +152,11 @@ public:
   template < class T >
   void read_value(const char*, T &x)
   {
-    buffer_->release(&x, sizeof(x));
+    if (encoding_ == fixed) {
+      buffer_->release(&x, sizeof(x));
+    } else {
+      read_compact(x, is_varint<T>());
+    }
   }
 
 	void read_value(const char* id, char *&c, int s);
@@ -123,9 +169,75 @@ public:
   void write_object_container_item(const object *o);
   void write_object_vector_item(const object *o, unsigned int &index);
 
+private:
+  /*
+   * integers wider than one byte are
+   * written as varints, everything else
+   * with its native representation
+   */
+  template < class T >
+  struct is_varint : public std::integral_constant<bool, std::is_integral<T>::value && (sizeof(T) > 1)>
+  {};
+
+  template < class T >
+  void write_compact(const T &x, std::false_type)
+  {
+    buffer_->append(&x, sizeof(x));
+  }
+
+  template < class T >
+  void write_compact(const T &x, std::true_type)
+  {
+    if (std::is_signed<T>::value) {
+      write_varint(zigzag((long long)x));
+    } else {
+      write_varint((unsigned long long)x);
+    }
+  }
+
+  template < class T >
+  void read_compact(T &x, std::false_type)
+  {
+    buffer_->release(&x, sizeof(x));
+  }
+
+  template < class T >
+  void read_compact(T &x, std::true_type)
+  {
+    if (std::is_signed<T>::value) {
+      x = (T)unzigzag(read_varint());
+    } else {
+      x = (T)read_varint();
+    }
+  }
+
+  static unsigned long long zigzag(long long x)
+  {
+    return ((unsigned long long)x << 1) ^ (unsigned long long)(x >> 63);
+  }
+
+  static long long unzigzag(unsigned long long x)
+  {
+    return (long long)(x >> 1) ^ -(long long)(x & 1);
+  }
+
+  void write_varint(unsigned long long x);
+  unsigned long long read_varint();
+
+  void read_string(std::string &s, size_t len);
+
+  void write_length(size_t len);
+  size_t read_length();
+
+  void write_reference(long id, const object_proxy *proxy, const char *type);
+  long read_reference();
+
 private:
   object_store *ostore_;
   byte_buffer *buffer_;
+  version_t version_;
+  // encoding of the current (de)serialization
+  version_t encoding_;
 };
 /// @endcond
 }
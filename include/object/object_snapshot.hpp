@@ -0,0 +1,249 @@
+/*
+ * This file is part of OpenObjectStore OOS.
+ *
+ * OpenObjectStore OOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenObjectStore OOS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenObjectStore OOS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OBJECT_SNAPSHOT_HPP
+#define OBJECT_SNAPSHOT_HPP
+
+#ifdef WIN32
+  #ifdef oos_EXPORTS
+    #define OOS_API __declspec(dllexport)
+    #define EXPIMP_TEMPLATE
+  #else
+    #define OOS_API __declspec(dllimport)
+    #define EXPIMP_TEMPLATE extern
+  #endif
+  #pragma warning(disable: 4251)
+#else
+  #define OOS_API
+#endif
+
+#include "object/object.hpp"
+#include "object/object_observer.hpp"
+#include "object/object_serializer.hpp"
+#include "object/object_exception.hpp"
+
+#include "tools/byte_buffer.hpp"
+
+#ifdef WIN32
+#include <memory>
+#else
+#include <tr1/memory>
+#endif
+
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <cstddef>
+
+namespace oos {
+
+struct object_proxy;
+struct prototype_node;
+class snapshot_keeper;
+
+/**
+ * @class object_snapshot
+ * @brief A point in time view of an object_store
+ *
+ * A snapshot is taken with object_store::snapshot()
+ * and shows all objects as they were at that time.
+ * Taking it only records the objects of the store.
+ * Objects are copied on write: the first time an
+ * object is modified or deleted afterwards its old
+ * state is serialized with the object_serializer
+ * (the same way a transaction backs up objects)
+ * and the snapshot shows the restored copy from
+ * then on. Objects inserted afterwards aren't shown.
+ *
+ * Many threads may read a snapshot while one thread
+ * keeps modifying the objects through object::modify()
+ * and inserts or removes objects. An object is read
+ * within the callback given to find() or for_each();
+ * while the callback runs the writer can't preserve
+ * this object or any other object sharing its lock
+ * (the objects are spread over a few locks by their
+ * id), so the callback should be short. The object
+ * must not be kept beyond the callback. Object
+ * pointers of a restored copy hold only the id of the
+ * object they point to; use find() to follow them.
+ *
+ * The snapshot is released when the last snapshot_ptr
+ * is dropped. Clearing the object_store, removing a
+ * prototype or destroying the store invalidates all
+ * its snapshots; afterwards find() and for_each()
+ * throw an object_exception. The invalidation waits
+ * for running callbacks.
+ */
+class OOS_API object_snapshot
+{
+private:
+  object_snapshot(const object_snapshot&);
+  object_snapshot& operator=(const object_snapshot&);
+
+public:
+  typedef std::size_t size_type;
+
+  ~object_snapshot();
+
+  /**
+   * Returns the number of objects
+   * visible in the snapshot.
+   *
+   * @return The number of objects.
+   */
+  size_type size() const;
+
+  /**
+   * Returns the number of objects whose
+   * old state is kept by the snapshot.
+   *
+   * @return The number of preserved objects.
+   */
+  size_type preserved() const;
+
+  /**
+   * @brief Reads one object of the snapshot
+   *
+   * Calls the given function with the object
+   * of the given id as it was when the snapshot
+   * was taken.
+   *
+   * @tparam F The type of the function.
+   * @param id The id of the object to read.
+   * @param f The function called with a const object reference.
+   * @return True if the object is visible in the snapshot.
+   */
+  template < class F >
+  bool find(long id, F f) const
+  {
+    const entry *e = lookup(id);
+    if (!e) {
+      return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex_of(e->id));
+    f(*read(*e));
+    return true;
+  }
+
+  /**
+   * @brief Reads all objects of a type
+   *
+   * Calls the given function with each object
+   * of type T (or derived from T) visible in
+   * the snapshot in the order of their ids.
+   *
+   * @tparam T The type of the objects.
+   * @tparam F The type of the function.
+   * @param f The function called with a const T reference.
+   */
+  template < class T, class F >
+  void for_each(F f) const
+  {
+    for (std::vector<entry>::const_iterator i = entries_.begin(); i != entries_.end(); ++i) {
+      std::lock_guard<std::mutex> lock(mutex_of(i->id));
+      const T *o = dynamic_cast<const T*>(read(*i));
+      if (o) {
+        f(*o);
+      }
+    }
+  }
+
+private:
+  friend class object_store;
+  friend class snapshot_keeper;
+
+  object_snapshot(const std::tr1::shared_ptr<snapshot_keeper> &keeper, object_proxy *first, object_proxy *last);
+
+  struct image
+  {
+    explicit image(const prototype_node *n) : node(n), copy(0) {}
+
+    const prototype_node *node;
+    byte_buffer buffer;
+    object *copy;
+  };
+
+  struct entry
+  {
+    entry(long i, object_proxy *p) : id(i), proxy(p), img(0) {}
+    bool operator<(const entry &x) const { return id < x.id; }
+
+    long id;
+    object_proxy *proxy;
+    // set by the writer under the lock of the id
+    image *img;
+  };
+
+  enum { MUTEX_COUNT = 16 };
+
+  std::mutex& mutex_of(long id) const;
+
+  const entry* lookup(long id) const;
+  // the lock of the entry must be held, throws if invalidated
+  const object* read(const entry &e) const;
+
+  void preserve(object *o);
+  void invalidate();
+
+private:
+  std::tr1::shared_ptr<snapshot_keeper> keeper_;
+
+  // sorted by id, only the images change
+  std::vector<entry> entries_;
+
+  std::atomic<size_type> preserved_;
+  object_serializer serializer_;
+
+  // changed under all locks
+  bool valid_;
+  mutable std::mutex mutexes_[MUTEX_COUNT];
+};
+
+/// @cond OOS_DEV
+
+/*
+ * the observer preserving the
+ * objects of all snapshots of
+ * an object_store
+ */
+class snapshot_keeper : public object_observer
+{
+public:
+  snapshot_keeper();
+  virtual ~snapshot_keeper() {}
+
+  virtual void on_insert(object *) {}
+  virtual void on_update(object *o);
+  virtual void on_delete(object *o);
+
+  void attach(object_snapshot *s);
+  void detach(object_snapshot *s);
+
+  // the snapshots mustn't read the objects anymore
+  void invalidate();
+
+private:
+  std::vector<object_snapshot*> snapshots_;
+  std::atomic<std::size_t> count_;
+  std::mutex mutex_;
+};
+
+/// @endcond
+
+}
+
+#endif /* OBJECT_SNAPSHOT_HPP */
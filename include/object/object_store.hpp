@@ -19,20 +19,28 @@
 #define OBJECT_STORE_HPP
 
 #include "object/object_ptr.hpp"
+#include "object/object_fields.hpp"
+#include "object/object_serializer.hpp"
 
 #include "tools/sequencer.hpp"
 
 #ifdef WIN32
 #include <memory>
 #include <unordered_map>
+#include <unordered_set>
 #else
 #include <tr1/memory>
 #include <tr1/unordered_map>
+#include <tr1/unordered_set>
 #endif
 
 #include <string>
 #include <ostream>
 #include <list>
+#include <vector>
+#include <set>
+#include <mutex>
+#include <atomic>
 
 #ifdef WIN32
   #ifdef oos_EXPORTS
@@ -56,6 +64,11 @@ class object_deleter;
 struct prototype_node;
 class object_observer;
 class object_container;
+class object_snapshot;
+class snapshot_keeper;
+struct version_record;
+struct version_batch;
+class undo_log;
 /**
  * @class object_base_producer
  * @brief Base class for object producer classes
@@ -87,6 +100,50 @@ public:
    * @return The classname of the object.
    */
   virtual const char *classname() const = 0;
+
+  /**
+   * Returns the size of the produced
+   * object or zero if it is unknown.
+   * 
+   * @return The size of the object.
+   */
+  virtual size_t object_size() const { return 0; }
+
+  /**
+   * @brief Serializes an object without virtual field access.
+   *
+   * If the produced class has a static field
+   * description the fields of the given object
+   * are written directly to the serializer and
+   * true is returned. Otherwise false is returned
+   * and nothing is written.
+   * 
+   * @param o The object to serialize.
+   * @param serializer The serializer to write to.
+   * @return True if the object was serialized.
+   */
+  virtual bool serialize(const object *o, object_serializer &serializer) const
+  {
+    (void)o;
+    (void)serializer;
+    return false;
+  }
+
+  /**
+   * @brief Deserializes an object without virtual field access.
+   *
+   * The counterpart of serialize().
+   * 
+   * @param o The object to deserialize.
+   * @param serializer The serializer to read from.
+   * @return True if the object was deserialized.
+   */
+  virtual bool deserialize(object *o, object_serializer &serializer) const
+  {
+    (void)o;
+    (void)serializer;
+    return false;
+  }
 };
 
 /**
@@ -249,6 +306,48 @@ public:
   virtual const char *classname() const {
     return typeid(T).name();
   }
+  /**
+   * Returns the size of the produced object
+   * 
+   * @return the size of type T
+   */
+  virtual size_t object_size() const {
+    return sizeof(T);
+  }
+  /**
+   * Serializes the object through the static
+   * field description of T if there is one
+   * 
+   * @param o The object to serialize.
+   * @param serializer The serializer to write to.
+   * @return True if T has a field description.
+   */
+  virtual bool serialize(const object *o, object_serializer &serializer) const {
+    return serialize(o, serializer, std::integral_constant<bool, has_fields<T>::value>());
+  }
+  /**
+   * Deserializes the object through the static
+   * field description of T if there is one
+   * 
+   * @param o The object to deserialize.
+   * @param serializer The serializer to read from.
+   * @return True if T has a field description.
+   */
+  virtual bool deserialize(object *o, object_serializer &serializer) const {
+    return deserialize(o, serializer, std::integral_constant<bool, has_fields<T>::value>());
+  }
+
+private:
+  bool serialize(const object *, object_serializer &, std::false_type) const { return false; }
+  bool serialize(const object *o, object_serializer &serializer, std::true_type) const {
+    write_fields(*static_cast<const T*>(o), serializer);
+    return true;
+  }
+  bool deserialize(object *, object_serializer &, std::false_type) const { return false; }
+  bool deserialize(object *o, object_serializer &serializer, std::true_type) const {
+    read_fields(*static_cast<T*>(o), serializer);
+    return true;
+  }
 };
 
 /**
@@ -263,7 +362,50 @@ public:
  * hierarchy representation including a producer class
  * object of all known types.
  *
- * 
+ * By default the store isn't synchronized at all. If
+ * concurrent(true) is set, many threads may iterate
+ * views and dereference object pointers while one
+ * thread inserts or removes objects:
+ *
+ * - Readers must wrap all access in a read_guard.
+ *   Entering and leaving the guard never blocks, but
+ *   copying or releasing an object pointer briefly
+ *   takes one of a fixed set of locks, shared by all
+ *   stores of the process and chosen by the proxy.
+ *   Object pointers obtained inside a guard must be
+ *   released before the guard ends.
+ * - The views of a reader are bounded by markers of
+ *   the prototype nodes which are never unlinked, so
+ *   removing objects never moves the end of a view.
+ * - Inserts and removes are serialized by a writer lock.
+ * - Removed objects are unlinked immediately but deleted
+ *   only when no reader can see them any more (epoch
+ *   based reclamation).
+ * - Finding a proxy by id takes the writer lock.
+ * - Modifying the fields of an object isn't synchronized.
+ *   Objects which are read concurrently must not be
+ *   changed in place.
+ *
+ * If sharded(true) is set additionally many threads may
+ * insert objects at once. Each subtree below the root
+ * prototype is a shard with its own block of ids, the
+ * object id map is split into independently locked
+ * parts and only the short linking of a new proxy into
+ * the object list is serialized. Inserting threads must
+ * work on unrelated objects and observers must be thread
+ * safe. Removes are still serialized by the writer lock.
+ *
+ * If versioning(true) is set the store keeps committed
+ * versions of the objects for readers (multi version
+ * concurrency). Readers take a read_token and see all
+ * objects as of the last commit before the token was
+ * taken, while the writer changes the objects in place.
+ * commit_versions() installs a copy of each changed
+ * object as a new version, old versions are dropped
+ * once no token can see them any more. A commit may
+ * be split into stage_versions() copying the changes
+ * and commit_versions(version_batch*) publishing them
+ * later, i.e. once they are written to a database.
  */
 class OOS_API object_store
 {
@@ -353,6 +495,37 @@ public:
    */
   bool remove_prototype(const char *type);
 
+  /**
+   * @brief Declares an index for a prototype.
+   *
+   * Declares an index on the given column of the
+   * prototype identified by the given name or
+   * classname. The index is created along with the
+   * table of the prototype. Columns referencing other
+   * objects are always indexed.
+   *
+   * @param type Name or class name of the prototype
+   * @param column The name of the column to index.
+   * @return Returns true if the type was found.
+   */
+  bool insert_index(const char *type, const std::string &column);
+
+  /**
+   * @brief Declares an index for a prototype by template type.
+   * @tparam Template type.
+   *
+   * Declares an index on the given column of the
+   * prototype identified by the given template typeid.
+   *
+   * @param column The name of the column to index.
+   * @return Returns true if the type was found.
+   */
+  template < class T >
+  bool insert_index(const std::string &column)
+  {
+    return insert_index(typeid(T).name(), column);
+  }
+
   /**
    * @brief Finds prototype node.
    *
@@ -401,6 +574,298 @@ public:
    */
   void clear(bool full = false);
 
+  typedef std::tr1::shared_ptr<const object_snapshot> snapshot_ptr; /**< Shortcut for a shared snapshot */
+
+  /**
+   * @brief Takes a snapshot of all objects
+   *
+   * Returns a read only point in time view of
+   * all objects of the store. Objects changed
+   * afterwards are preserved by the snapshot
+   * until it is released (see object_snapshot).
+   * The snapshot must be taken by the thread
+   * changing the store but may be read by other
+   * threads while the objects are changed.
+   * Clearing the store or removing a prototype
+   * invalidates the snapshot.
+   *
+   * @return The snapshot.
+   */
+  snapshot_ptr snapshot();
+
+  /**
+   * @class read_guard
+   * @brief Marks a read section of a concurrent object_store
+   *
+   * While a guard exists no object visible at its
+   * creation is deleted. Creating and destroying
+   * a guard never blocks.
+   */
+  class OOS_API read_guard
+  {
+  private:
+    read_guard(const read_guard&);
+    read_guard& operator=(const read_guard&);
+
+  public:
+    explicit read_guard(const object_store &ostore);
+    ~read_guard();
+
+  private:
+    const object_store &ostore_;
+    unsigned long epoch_;
+  };
+
+  /**
+   * @brief Enables or disables the concurrency mode
+   *
+   * Must be called while no other thread
+   * accesses the store. Disabling the mode
+   * deletes all removed objects at once and
+   * disables the sharded mode.
+   *
+   * @param enable True to enable the concurrency mode.
+   */
+  void concurrent(bool enable);
+
+  /**
+   * Returns true if the concurrency
+   * mode is enabled.
+   *
+   * @return True if the concurrency mode is enabled.
+   */
+  bool concurrent() const;
+
+  /**
+   * @brief Enables or disables the sharded mode
+   *
+   * In sharded mode objects may be inserted
+   * by several threads at once. Enabling it
+   * enables the concurrency mode as well.
+   * Each subtree below the root prototype
+   * becomes a shard reserving its ids in blocks
+   * of the given size. Linking the objects into
+   * the object list is still serialized by one
+   * store wide lock.
+   *
+   * Must be called while no other thread
+   * accesses the store. Prototypes must not
+   * be inserted or removed while the mode
+   * is enabled.
+   *
+   * @param enable True to enable the sharded mode.
+   * @param block_size The count of ids reserved per shard at once.
+   */
+  void sharded(bool enable, long block_size = 1000);
+
+  /**
+   * Returns true if the sharded
+   * mode is enabled.
+   *
+   * @return True if the sharded mode is enabled.
+   */
+  bool sharded() const;
+
+  /**
+   * @class read_token
+   * @brief Reads the committed versions of a versioning object_store
+   *
+   * A token shows each object in the version of the
+   * last commit before the token was taken. Changes,
+   * insertions and removals committed later aren't
+   * visible. Many threads may hold tokens while one
+   * thread changes the objects and commits.
+   *
+   * The objects shown are copies which never change
+   * while the token exists. Object pointers of the
+   * copies hold only the id of the object they point
+   * to; use find() to follow them. Versions visible
+   * to a token are kept until the token is destroyed.
+   */
+  class OOS_API read_token
+  {
+  private:
+    read_token(const read_token&);
+    read_token& operator=(const read_token&);
+
+  public:
+    /**
+     * Takes a token for the last commit
+     * of the given versioning store.
+     *
+     * @param ostore The object_store to read.
+     */
+    explicit read_token(const object_store &ostore);
+    ~read_token();
+
+    /**
+     * Returns the commit sequence
+     * number the token reads.
+     *
+     * @return The commit sequence number.
+     */
+    unsigned long long sequence() const;
+
+    /**
+     * Returns the object of the given id
+     * visible to the token or null.
+     *
+     * @param id The id of the object.
+     * @return The visible object.
+     */
+    const object* find(long id) const;
+
+    /**
+     * Returns the object of the given id
+     * and type visible to the token or null.
+     *
+     * @tparam T The type of the object.
+     * @param id The id of the object.
+     * @return The visible object.
+     */
+    template < class T >
+    const T* find(long id) const
+    {
+      return dynamic_cast<const T*>(find(id));
+    }
+
+    /**
+     * Calls the given function with each
+     * object of type T (or derived from T)
+     * visible to the token.
+     *
+     * @tparam T The type of the objects.
+     * @tparam F The type of the function.
+     * @param f The function called with a const T reference.
+     */
+    template < class T, class F >
+    void for_each(F f) const
+    {
+      for (const version_record *r = first(); r; r = next(r)) {
+        const T *o = dynamic_cast<const T*>(visible(r));
+        if (o) {
+          f(*o);
+        }
+      }
+    }
+
+  private:
+    const version_record* first() const;
+    const version_record* next(const version_record *r) const;
+    const object* visible(const version_record *r) const;
+
+  private:
+    const object_store &ostore_;
+    read_guard guard_;
+    unsigned long long sequence_;
+    unsigned long long ticket_;
+  };
+
+  /**
+   * @brief Enables or disables keeping object versions
+   *
+   * Enabling the versions enables the concurrency
+   * mode as well and commits the current state of
+   * all objects as the first version. Disabling
+   * drops all versions.
+   *
+   * Must be called while no other thread accesses
+   * the store and no read_token exists. Clearing
+   * the store drops all versions as well, it must
+   * not be done while a read_token exists.
+   *
+   * @param enable True to keep object versions.
+   */
+  void versioning(bool enable);
+
+  /**
+   * Returns true if the store keeps
+   * object versions.
+   *
+   * @return True if object versions are kept.
+   */
+  bool versioning() const;
+
+  /**
+   * @brief Commits all changes as a new version
+   *
+   * Installs a copy of each object inserted or
+   * modified (see object::modify()) since the last
+   * commit as its new version and makes removals
+   * visible. Tokens taken afterwards see the new
+   * versions. Versions no token can see any more
+   * are dropped. Must be called by the thread
+   * changing the store.
+   *
+   * @return The new commit sequence number.
+   */
+  unsigned long long commit_versions();
+
+  /**
+   * @brief Copies all changes for a later commit
+   *
+   * Copies each object inserted or modified since
+   * the last commit or stage and takes the removals.
+   * Tokens don't see the changes until the returned
+   * batch is committed with commit_versions(version_batch*).
+   * Batches must be committed or discarded in the
+   * order they were staged. Must be called by the
+   * thread changing the store.
+   *
+   * @return The staged changes or null if no versions are kept.
+   */
+  version_batch* stage_versions();
+
+  /**
+   * @brief Commits staged changes as a new version
+   *
+   * Installs the copies of the batch as new
+   * versions and makes its removals visible.
+   * The batch is deleted.
+   *
+   * @param batch The staged changes.
+   * @return The new commit sequence number.
+   */
+  unsigned long long commit_versions(version_batch *batch);
+
+  /**
+   * @brief Drops staged changes
+   *
+   * Tokens keep seeing the committed versions.
+   * A removal is undone if the object is back in
+   * the store (i.e. the removal was rolled back),
+   * otherwise it becomes visible with the next
+   * commit. The batch is deleted.
+   *
+   * @param batch The staged changes.
+   */
+  void discard_versions(version_batch *batch);
+
+  /**
+   * @brief Drops all changes since the last commit
+   *
+   * Like discard_versions(version_batch*) for the
+   * changes not staged yet, i.e. after a database
+   * commit failed or the changes were rolled back.
+   */
+  void discard_versions();
+
+  /**
+   * Returns the sequence number
+   * of the last commit.
+   *
+   * @return The last commit sequence number.
+   */
+  unsigned long long committed_version() const;
+
+  /**
+   * Returns the number of object versions
+   * kept by the store.
+   *
+   * @return The number of kept versions.
+   */
+  std::size_t version_count() const;
+
   /**
    * Returns true if the object_store
    * conatins no elements (objects)
@@ -434,6 +899,8 @@ public:
   /**
    * Inserts an object of a specfic type. On successfull insertion
    * an object_ptr element with the inserted object is returned.
+   * If an observer rejects the object it is removed and deleted
+   * again and the exception of the observer is rethrown.
    * 
    * @param o Object to be inserted.
    * @return Inserted object contained by an object_ptr on success.
@@ -506,6 +973,25 @@ public:
    */
   void unregister_observer(object_observer *observer);
 
+  /**
+   * @brief Sets the log of the changed fields
+   *
+   * While a log is set object::modify() records
+   * the old value of each changed field in it.
+   * Pass NULL to stop recording.
+   *
+   * @param log The undo_log to record into.
+   */
+  void undo(undo_log *log);
+
+  /**
+   * Returns the log of the changed fields
+   * or NULL if no log is set.
+   *
+   * @return The current undo_log.
+   */
+  undo_log* undo() const;
+
   /**
    * @brief Creates and inserts an object proxy object.
    * 
@@ -577,12 +1063,15 @@ private:
   friend class object_creator;
   friend class object_deleter;
   friend class object_serializer;
-  friend class restore_visitor;
+  friend class undo_log;
+  friend class replication_follower;
+  friend class json_object_reader;
   friend class object_container;
   friend class object;
 
 private:
   void mark_modified(object_proxy *oproxy);
+  void mark_updated(object_proxy *oproxy);
 
   void remove(object *o);
 	object* insert_object(object *o, bool notify);
@@ -593,6 +1082,32 @@ private:
 
   prototype_node* get_prototype(const char *type) const;
 
+  unsigned long enter_epoch() const;
+  void leave_epoch(unsigned long epoch) const;
+  void retire_proxy(object_proxy *oproxy);
+  void reclaim_proxies(bool all);
+
+  void invalidate_snapshots();
+
+  void pend_version(object_proxy *oproxy);
+  void remove_version(object_proxy *oproxy);
+  void restore_removals(std::vector<version_record*> &removals);
+  void collect_versions(unsigned long long oldest, unsigned long long ticket);
+  void drop_versions();
+
+  typedef std::unique_lock<std::recursive_mutex> write_lock_t;
+  write_lock_t write_lock() const;
+  write_lock_t insert_lock() const;
+
+  typedef std::unique_lock<std::mutex> lock_t;
+  lock_t concurrent_lock(std::mutex &m) const;
+
+  struct proxy_map;
+  proxy_map& proxy_map_of(long id) const;
+
+  long next_id(const prototype_node *node);
+  void update_id(long id);
+
 private:
   prototype_node *root_;
 
@@ -603,7 +1118,20 @@ private:
   typedef std::map<std::string, t_prototype_map> t_typeid_prototype_map;
   t_typeid_prototype_map typeid_prototype_map_;
 
-  t_object_proxy_map object_map_;
+  // id of the last inserted prototype
+  unsigned long last_prototype_id_;
+
+  /*
+   * the object id map is split into
+   * parts each with its own lock
+   */
+  struct proxy_map
+  {
+    std::mutex mutex;
+    t_object_proxy_map proxies;
+  };
+  enum { PROXY_MAP_COUNT = 16 };
+  mutable proxy_map object_map_[PROXY_MAP_COUNT];
 
   sequencer seq_;
 //  long id_;
@@ -615,6 +1143,68 @@ private:
   object_proxy *last_;
   
   object_deleter *object_deleter_;
+
+  // records the fields changed by object::modify()
+  undo_log *undo_log_;
+
+  // preserves the objects of all snapshots,
+  // shared with the snapshots outliving the store
+  std::tr1::shared_ptr<snapshot_keeper> snapshot_keeper_;
+
+  // concurrency mode
+  bool concurrent_;
+  mutable std::recursive_mutex write_mutex_;
+  mutable std::atomic<unsigned long> epoch_;
+  mutable std::atomic<long> readers_[3];
+  std::vector<object_proxy*> retired_[3];
+
+  // sharded mode
+  struct shard
+  {
+    shard() : serial(0), next_id(1), last_id(0) {}
+    std::mutex mutex;
+    unsigned long serial;
+    long next_id;
+    long last_id;
+  };
+  typedef std::tr1::unordered_map<const prototype_node*, shard*> t_shard_map;
+
+  bool sharded_;
+  long shard_block_size_;
+  t_shard_map shard_map_;
+  // a changed serial invalidates the blocks of all shards
+  std::atomic<unsigned long> shard_serial_;
+  // ids up to here aren't within a valid block
+  long shard_reserved_;
+  std::mutex seq_mutex_;
+  // guards the links of the object list
+  mutable std::mutex list_mutex_;
+
+  // multi version mode
+  typedef std::tr1::unordered_set<object_proxy*> t_proxy_set;
+  typedef std::tr1::unordered_set<version_record*> t_record_set;
+  typedef std::tr1::unordered_multimap<long, version_record*> t_record_map;
+
+  bool versioning_;
+  std::atomic<unsigned long long> committed_;
+  // the sequences and tickets of the read tokens
+  mutable std::mutex version_mutex_;
+  mutable unsigned long long next_ticket_;
+  mutable std::multiset<unsigned long long> token_sequences_;
+  mutable std::multiset<unsigned long long> token_tickets_;
+  // changed since the last stage
+  t_proxy_set pending_;
+  // records of objects removed since the last stage
+  std::vector<version_record*> pending_removals_;
+  // records with more than one version
+  t_record_set versioned_;
+  // records of removed objects by id
+  t_record_map removed_records_;
+  // unlinked records freed when no token may see them
+  std::vector<version_record*> retired_records_;
+  version_record *records_;
+  version_record *last_record_;
+  std::size_t version_count_;
 };
 
 }
@@ -532,6 +532,7 @@ public:
       iterator first = pos;
       // adjust index
       this->adjust_index(first);
+      this->mark_updated(this->parent());
       return pos;
     }
   }
@@ -547,10 +548,12 @@ public:
       this->mark_modified((*i).get());
       // set back ref to zero
       ref_setter(*(*i).get(), parent_ref());
+      this->mark_updated((*i).get());
       // erase element from list
       i = this->vector().erase(i);
       // update index values of all successor elements
       this->adjust_index(i);
+      this->mark_updated(this->parent());
       // return iterator
       return i;
     }
@@ -565,13 +568,15 @@ public:
       // mark item object as modified
       this->mark_modified((*i).get());
       // set back ref to zero
-      ref_setter(*(*i++).get(), parent_ref());
+      ref_setter(*(*i).get(), parent_ref());
+      this->mark_updated((*i++).get());
     }
 
     i = this->vector().erase(first, last);
 
     // adjust index
     this->adjust_index(i);
+    this->mark_updated(this->parent());
 
     return i;
   }
@@ -594,7 +599,8 @@ protected:
     while (i != this->vector().end()) {
       // mark item object as modified
       this->mark_modified(i->get());
-      int_setter(*(*i++).get(), start++);
+      int_setter(*(*i).get(), start++);
+      this->mark_updated((i++)->get());
     }
   }
 
@@ -688,6 +694,7 @@ public:
       while (++first != last) {
         (*first)->index(++index);
       }
+      this->mark_updated(this->parent());
       return pos;
     }
   }
@@ -701,6 +708,7 @@ public:
     iterator ret = this->vector().erase(i);
     // update index values of all successor elements
     this->adjust_index(ret);
+    this->mark_updated(this->parent());
 
     return ret;
   }
@@ -717,6 +725,7 @@ public:
     i = this->vector().erase(first, last);
     // adjust index
     this->adjust_index(i);
+    this->mark_updated(this->parent());
 
     return i;
   }
@@ -737,7 +746,8 @@ protected:
     while (i != this->vector().end()) {
       // mark parent object as modified
       this->mark_modified(i->get());
-      (*i++)->index(start++);
+      (*i)->index(start++);
+      this->mark_updated((i++)->get());
     }
   }
 
@@ -0,0 +1,110 @@
+/*
+ * This file is part of OpenObjectStore OOS.
+ *
+ * OpenObjectStore OOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenObjectStore OOS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenObjectStore OOS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef OBJECT_VERSION_HPP
+#define OBJECT_VERSION_HPP
+
+#ifdef WIN32
+  #ifdef oos_EXPORTS
+    #define OOS_API __declspec(dllexport)
+    #define EXPIMP_TEMPLATE
+  #else
+    #define OOS_API __declspec(dllimport)
+    #define EXPIMP_TEMPLATE extern
+  #endif
+  #pragma warning(disable: 4251)
+#else
+  #define OOS_API
+#endif
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace oos {
+
+class object;
+
+/// @cond OOS_DEV
+
+/*
+ * one committed state of an object. the
+ * copy is never changed once installed
+ */
+struct object_version
+{
+  object_version(unsigned long long b, object *c)
+    : begin(b), copy(c), next(0)
+  {}
+  ~object_version();
+
+  unsigned long long begin; // first commit seeing this version
+  object *copy;
+  object_version *next;     // the older version
+};
+
+/*
+ * the version chain of one object, newest
+ * version first. the records of all objects
+ * form a list readers walk without locks
+ */
+struct version_record
+{
+  explicit version_record(long i);
+  ~version_record();
+
+  // version visible to a reader started at seq
+  const object* visible(unsigned long long seq) const;
+
+  void install(unsigned long long seq, object *copy);
+
+  // drops the versions no reader started
+  // at oldest or later can see
+  void prune(unsigned long long oldest);
+
+  long id;
+  std::atomic<object_version*> versions;
+  // commit removing the object
+  std::atomic<unsigned long long> removed;
+  std::atomic<version_record*> next;
+  // only used by the writer
+  version_record *prev;
+  unsigned long long retired;
+  std::size_t count;
+};
+
+/*
+ * the copies of one commit, installed as
+ * new versions once the commit is published
+ */
+struct version_batch
+{
+  ~version_batch();
+
+  typedef std::vector<std::pair<version_record*, object*> > t_version_vector;
+
+  t_version_vector versions;
+  // records of the removed objects
+  std::vector<version_record*> removals;
+};
+
+/// @endcond
+
+}
+
+#endif /* OBJECT_VERSION_HPP */
@@ -204,13 +204,18 @@ public:
 
 private:
   void increment() {
+    // skip the markers of the child nodes
     if (current_ != last_) {
-      current_ = current_->next;
+      do {
+        current_ = current_->next;
+      } while (current_ != last_ && current_->marker());
     }
   }
   void decrement() {
     if (current_ != node_->op_first) {
-      current_ = current_->prev;
+      do {
+        current_ = current_->prev;
+      } while (current_ != node_->op_first && current_->marker());
     }
   }
 
@@ -415,13 +420,18 @@ public:
 
 private:
   void increment() {
+    // skip the markers of the child nodes
     if (current_ != last_) {
-      current_ = current_->next;
+      do {
+        current_ = current_->next;
+      } while (current_ != last_ && current_->marker());
     }
   }
   void decrement() {
     if (current_ != node_->op_first) {
-      current_ = current_->prev;
+      do {
+        current_ = current_->prev;
+      } while (current_ != node_->op_first && current_->marker());
     }
   }
 
@@ -556,7 +566,7 @@ public:
    * @return True if object_view is empty.
    */
   bool empty() const {
-    return node_->op_first->next == node_->op_last;
+    return begin() == end();
   }
 
   /**
@@ -741,7 +751,7 @@ public:
    * @return True if object_view is empty.
    */
   bool empty() const {
-    return node_->op_first->next == node_->op_last;
+    return begin() == end();
   }
 
   /**
@@ -798,7 +808,7 @@ public:
    */
   const prototype_node* node() const
   {
-    return node_;
+    return node_.get();
   }
 
 private:
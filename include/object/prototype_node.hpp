@@ -32,10 +32,14 @@
   #define EXPIMP_TEMPLATE
 #endif
 
+#include "object/field_index.hpp"
+
 #include <map>
 #include <list>
+#include <set>
 #include <memory>
 #include <string>
+#include <atomic>
 
 namespace oos {
 
@@ -55,7 +59,11 @@ struct object_proxy;
  * this and all children nodes.
  * This list is defined by three marker: the beginning
  * of the list, the end of the own objects and the end of
- * the last child objects.
+ * the last child objects. The markers are proxies of the
+ * node itself holding no object. They are linked once
+ * with the node and never move, so a reader may keep
+ * them as the bounds of its iteration while objects are
+ * inserted and removed.
  */ 
 struct OOS_API prototype_node
 {
@@ -158,21 +166,13 @@ public:
   bool is_child_of(const prototype_node *parent) const;
 
   /**
-   * Adjusts self and last marker of all predeccessor nodes with given
-   * object proxy.
+   * Creates the three markers of the node and
+   * links them before the given proxy. If no
+   * proxy is given the markers start a new list.
    * 
-   * @param old_proxy The old last marker proxy.
-   * @param new_proxy The new last marker proxy.
+   * @param successor The proxy to link the markers before.
    */
-  void adjust_left_marker(object_proxy *old_proxy, object_proxy *new_proxy);
-  
-  /**
-   * Adjust first marker of all successor nodes with given object proxy.
-   * 
-   * @param old_proxy The old first marker proxy.
-   * @param new_proxy The new first marker proxy.
-   */
-  void adjust_right_marker(object_proxy *old_proxy, object_proxy *new_proxy);
+  void link_markers(object_proxy *successor);
 
   /**
    * Prints the node in graphviz layout to the stream.
@@ -204,14 +204,19 @@ public:
    */
   field_prototype_map_t relations; /**< Map holding relation information for type. */
 
-  object_proxy *op_first;  /**< The marker of the first list node. */
-  object_proxy *op_marker; /**< The marker of the last list node of the own elements. */
-  object_proxy *op_last;   /**< The marker of the last list node of all elements. */
+  std::set<std::string> indexes; /**< Names of additional columns to be indexed. */
+
+  field_index fields; /**< The directory of the fields, built on first access by name. */
+
+  object_proxy *op_first;  /**< The marker before the first own element. */
+  object_proxy *op_marker; /**< The marker behind the own elements. */
+  object_proxy *op_last;   /**< The marker behind the elements of all children. */
   
   unsigned int depth;  /**< The depth of the node inside of the tree. */
-  unsigned long count; /**< The total count of elements. */
+  std::atomic<unsigned long> count; /**< The count of own elements. */
 
   std::string type;	   /**< The type name of the object */
+  unsigned long id;    /**< The id of the prototype inside its store */
   
   bool abstract;       /**< Indicates wether this node holds a producer of an abstract object */
   bool initialized;    /**< Indicates wether this node is complete initialized or not */
@@ -0,0 +1,238 @@
+/*
+ * This file is part of OpenObjectStore OOS.
+ *
+ * OpenObjectStore OOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenObjectStore OOS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenObjectStore OOS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef UNDO_LOG_HPP
+#define UNDO_LOG_HPP
+
+#ifdef WIN32
+  #ifdef oos_EXPORTS
+    #define OOS_API __declspec(dllexport)
+    #define EXPIMP_TEMPLATE
+  #else
+    #define OOS_API __declspec(dllimport)
+    #define EXPIMP_TEMPLATE extern
+  #endif
+  #pragma warning(disable: 4251)
+#else
+  #define OOS_API
+#endif
+
+#ifdef WIN32
+#include <unordered_set>
+#else
+#include <tr1/unordered_set>
+#endif
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <type_traits>
+
+namespace oos {
+
+class object;
+class object_store;
+class object_base_ptr;
+class varchar_base;
+
+/**
+ * @cond OOS_DEV
+ * @class undo_log
+ * @brief Old values of the fields changed by a transaction
+ *
+ * object::modify() records the old value of each
+ * changed field before it is assigned, if the store
+ * of the object has an undo_log. A field is recorded
+ * by the id of its object and its offset inside the
+ * object, so the value can be re-applied even to an
+ * object which was removed and restored meanwhile.
+ *
+ * Objects marked modified without modify() (i.e.
+ * by their containers) are recorded by a serialized
+ * image once, removed objects always. Inserted
+ * objects are recorded by their id.
+ *
+ * rollback() re-applies all records in reverse
+ * order, so each field ends with the value it had
+ * before its first change. Object pointers are
+ * recorded by the id of the object pointed to.
+ */
+class OOS_API undo_log
+{
+private:
+  undo_log(const undo_log&);
+  undo_log& operator=(const undo_log&);
+
+public:
+  undo_log();
+  ~undo_log();
+
+  /**
+   * Records the old value of a field.
+   *
+   * @tparam T The type of the field.
+   * @param id The id of the object.
+   * @param offset The offset of the field inside the object.
+   * @param attr The field before the change.
+   */
+  template < class T >
+  void push(long id, std::ptrdiff_t offset, const T &attr)
+  {
+    if (record(id)) {
+      entries_.push_back(new field_entry<T>(id, offset, attr));
+    }
+  }
+
+  void push(long id, std::ptrdiff_t offset, const char *attr);
+  void push(long id, std::ptrdiff_t offset, const varchar_base &attr);
+
+  /**
+   * Records the serialized image of an object
+   * unless an image of it is already recorded.
+   *
+   * @param o The object before the change.
+   */
+  void push_image(const object *o);
+
+  /**
+   * Records the serialized image of an object
+   * which is removed from the store. On rollback
+   * the object is recreated from this image.
+   *
+   * @param o The object to be removed.
+   */
+  void push_removal(const object *o);
+
+  /**
+   * Records an inserted object. On rollback
+   * the object is removed from the store.
+   *
+   * @param id The id of the inserted object.
+   */
+  void push_insert(long id);
+
+  /**
+   * Returns true if the last change of the
+   * object with the given id was recorded by
+   * one of the push() methods. The answer is
+   * given once for each recorded change.
+   *
+   * @param id The id of the object.
+   * @return True if the change is recorded.
+   */
+  bool recorded(long id);
+
+  /**
+   * Re-applies the records in reverse order
+   * to the objects of the store and clears the
+   * log. Fields of objects which don't exist
+   * any more are skipped.
+   *
+   * @param ostore The object_store of the objects.
+   */
+  void rollback(object_store &ostore);
+
+  /**
+   * Drops all records.
+   */
+  void clear();
+
+  /**
+   * Returns the number of records.
+   *
+   * @return The number of records.
+   */
+  std::size_t size() const;
+
+  /**
+   * Returns true if nothing is recorded.
+   *
+   * @return True if nothing is recorded.
+   */
+  bool empty() const;
+
+private:
+  struct entry
+  {
+    entry(long i, std::ptrdiff_t o) : id(i), offset(o) {}
+    virtual ~entry() {}
+
+    // re-applies the record to the store
+    virtual void undo(object_store &ostore);
+    // re-applies a field record to the field
+    virtual void restore(void *, object_store &) {}
+
+    long id;
+    std::ptrdiff_t offset;
+  };
+
+  template < class T, bool PTR = std::is_base_of<object_base_ptr, T>::value >
+  struct field_entry : public entry
+  {
+    field_entry(long i, std::ptrdiff_t o, const T &attr)
+      : entry(i, o), value(attr)
+    {}
+
+    virtual void restore(void *attr, object_store &)
+    {
+      *static_cast<T*>(attr) = value;
+    }
+
+    T value;
+  };
+
+  // the object pointed to may be restored as well
+  template < class T >
+  struct field_entry<T, true> : public entry
+  {
+    field_entry(long i, std::ptrdiff_t o, const T &attr)
+      : entry(i, o), value(attr.id())
+    {}
+
+    virtual void restore(void *attr, object_store &ostore)
+    {
+      restore_ptr(*static_cast<T*>(attr), value, ostore);
+    }
+
+    long value;
+  };
+
+  struct string_entry;
+  struct varchar_entry;
+  struct image_entry;
+  struct removal_entry;
+  struct insert_entry;
+
+  bool record(long id);
+
+  static void restore_ptr(object_base_ptr &x, long id, object_store &ostore);
+
+private:
+  typedef std::tr1::unordered_set<long> t_id_set;
+
+  std::vector<entry*> entries_;
+  // objects restored as a whole
+  t_id_set imaged_;
+  // object of the last recorded field
+  long pending_;
+};
+
+/// @endcond
+
+}
+
+#endif /* UNDO_LOG_HPP */
@@ -31,13 +31,9 @@
   #define OOS_API
 #endif
 
-#ifdef WIN32
-#include <array>
-#else
-#include <tr1/array>
-#endif
-
-#include <list>
+#include <cstddef>
+#include <cstdio>
+#include <deque>
 
 namespace oos {
 
@@ -49,27 +45,48 @@ namespace oos {
  * This class provide a buffer for bytes. The
  * bytes are added in chunks. Once the current chunk
  * of bytes is full a new empty chunk is added.
- * The bytes are appended and released from the end
- * of the buffer.
+ * The bytes are appended at the end and released
+ * from the front of the buffer.
  * It is used by the object_store to serialize objects.
+ *
+ * The chunks are taken from a per thread cache
+ * backed by a process wide pool and grow in size
+ * classes (256 bytes up to 16 KB), so small
+ * buffers stay small and freed chunks are reused
+ * by the next buffer. An empty buffer owns no
+ * chunk at all.
+ *
+ * The stored bytes can be read without copying
+ * through views() and written to a file descriptor
+ * or a FILE with one gathering call.
  */
 class OOS_API byte_buffer
 {
-private:
-  enum { BUF_SIZE = 1 << 14 };
-  typedef std::tr1::array<char, BUF_SIZE> t_data_array;
-
 public:
   /**
    * The type of the size.
    */
-  typedef t_data_array::size_type size_type;
+  typedef std::size_t size_type;
+
+  /**
+   * @brief A view into the memory of one chunk.
+   *
+   * A view has the same layout as a struct iovec
+   * and points directly into the chunk memory.
+   * It stays valid until the viewed bytes are
+   * released or the buffer is modified.
+   */
+  struct view
+  {
+    const char *data; /**< The first byte of the view */
+    size_type size;   /**< The number of bytes */
+  };
 
   /**
    * @brief Create an empty buffer.
    * 
-   * Create an empty buffer. One empty chunk is
-   * also created.
+   * Create an empty buffer. The first chunk
+   * is taken from the pool with the first append.
    */
   byte_buffer();
   ~byte_buffer();
@@ -95,6 +112,55 @@ public:
    */
   void release(void *bytes, size_type size);
 
+  /**
+   * @brief Discard a number of bytes.
+   *
+   * The bytes are removed from the front of the
+   * buffer without copying them. Use it after
+   * the bytes were consumed through views().
+   *
+   * @param size The number of bytes to discard.
+   */
+  void discard(size_type size);
+
+  /**
+   * @brief Gather views of the next bytes.
+   *
+   * Fills the given array with views of at most
+   * size bytes from the front of the buffer, one
+   * view per chunk. The bytes are not released.
+   *
+   * @param vec The array of views to fill.
+   * @param count The number of elements in vec.
+   * @param size The maximum number of bytes to view.
+   * @return The number of views filled.
+   */
+  size_type views(view *vec, size_type count, size_type size) const;
+
+  /**
+   * @brief Write the whole buffer to a file.
+   *
+   * Writes all bytes chunk by chunk to the given
+   * file. The buffer is left untouched.
+   *
+   * @param file The file to write to.
+   * @return The number of bytes written.
+   */
+  size_type write(std::FILE *file) const;
+
+#ifndef WIN32
+  /**
+   * @brief Write the whole buffer to a file descriptor.
+   *
+   * Writes all bytes with gathering writev
+   * calls. The buffer is left untouched.
+   *
+   * @param fd The file descriptor to write to.
+   * @return The number of bytes written or -1 on error.
+   */
+  long writev(int fd) const;
+#endif
+
   /**
    * Return the size of the buffer.
    */
@@ -105,19 +171,39 @@ public:
    */
   void clear();
 
+  /**
+   * Return the number of chunks currently
+   * held for reuse in the process wide pool
+   * and the cache of the calling thread.
+   */
+  static size_type pooled_chunks();
+
 private:
+  byte_buffer(const byte_buffer&);
+  byte_buffer& operator=(const byte_buffer&);
+
   struct buffer_chunk
   {
-    buffer_chunk() : read_cursor(0), write_cursor(0) {}
-    byte_buffer::size_type available() const { return data.size() - write_cursor; }
-    byte_buffer::size_type used() const { return write_cursor - read_cursor; }
-    byte_buffer::size_type released() const { return read_cursor; }
-    t_data_array data;
-    byte_buffer::size_type read_cursor;
-    byte_buffer::size_type write_cursor;
+    size_type available() const { return capacity - write_cursor; }
+    size_type used() const { return write_cursor - read_cursor; }
+    char* data() { return reinterpret_cast<char*>(this + 1); }
+    const char* data() const { return reinterpret_cast<const char*>(this + 1); }
+    size_type capacity;
+    size_type read_cursor;
+    size_type write_cursor;
   };
-  typedef std::list<buffer_chunk> t_chunk_list;
+
+  void grow();
+  void pop_front();
+
+  static buffer_chunk* acquire(unsigned int size_class);
+  static void recycle(buffer_chunk *chunk);
+
+private:
+  typedef std::deque<buffer_chunk*> t_chunk_list;
   t_chunk_list chunk_list_;
+  size_type size_;
+  unsigned int size_class_;
 };
 /// @endcond
 
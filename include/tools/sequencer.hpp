@@ -37,6 +37,9 @@
 #include <tr1/memory>
 #endif
 
+#include <atomic>
+#include <mutex>
+
 namespace oos {
 
 /**
@@ -125,6 +128,56 @@ private:
 };
 /// @endcond
 
+/**
+ * @cond OOS_DEV
+ * @class atomic_sequencer
+ * @brief Thread safe sequencer implementation
+ *
+ * Hands out ids with an atomic fetch and add,
+ * so many threads may share one sequencer
+ * without a lock.
+ *
+ * If a block size greater than one is given,
+ * each thread reserves a block of ids at once
+ * and serves further ids from its own block.
+ * Threads then only touch the shared counter
+ * once per block. In this case the ids of
+ * different threads interleave and current()
+ * returns the end of the last reserved block.
+ * Each thread keeps its own block per
+ * sequencer. Ids left in a block are skipped
+ * when the sequencer is reset or updated to
+ * an id which may lie within a reserved block.
+ */
+class OOS_API atomic_sequencer : public sequencer_impl
+{
+public:
+  explicit atomic_sequencer(long block_size = 1);
+  virtual ~atomic_sequencer();
+
+  virtual long init();
+
+  virtual long reset(long id);
+
+  virtual long next();
+  virtual long current() const;
+
+  virtual long update(long id);
+
+  long block_size() const;
+
+private:
+  std::atomic<long> number_;
+  std::atomic<unsigned long> serial_;
+  unsigned long identity_;
+  long block_size_;
+  // ids up to here aren't within a valid block
+  long reserved_;
+  // serializes block reservations with reset and update
+  std::mutex mutex_;
+};
+/// @endcond
+
 /**
  * @class sequencer
  * @brief Interface to create and get unique
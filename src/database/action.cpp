@@ -98,6 +98,15 @@ insert_action::iterator insert_action::erase(insert_action::iterator i)
   return object_list_.erase(i);
 }
 
+std::string update_action::type() const
+{
+  if (type_.empty()) {
+    return obj_->classname();
+  } else {
+    return type_;
+  }
+}
+
 object* update_action::obj()
 {
   return obj_;
@@ -0,0 +1,207 @@
+/*
+ * This file is part of OpenObjectStore OOS.
+ *
+ * OpenObjectStore OOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenObjectStore OOS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenObjectStore OOS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "database/commit_pipeline.hpp"
+#include "database/database.hpp"
+#include "database/database_exception.hpp"
+#include "database/action.hpp"
+#include "database/replication.hpp"
+
+#include "object/object.hpp"
+
+namespace oos {
+
+commit_pipeline::commit_pipeline(database &db, std::mutex &db_mutex, unsigned int max_batch)
+  : db_(db)
+  , db_mutex_(db_mutex)
+  , max_batch_(max_batch > 0 ? max_batch : 1)
+  , pending_(0)
+  , commits_(0)
+  , batches_(0)
+  , stop_(false)
+{
+  writer_ = std::thread(&commit_pipeline::run, this);
+}
+
+commit_pipeline::~commit_pipeline()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  queued_.notify_one();
+  writer_.join();
+}
+
+commit_pipeline::future_type commit_pipeline::push(action_list_t &actions, object_list_t &objects, replication_writer *replication)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (error_) {
+      // the failed batch must be reported first
+      throw database_exception("commit_pipeline", "an earlier batch failed, flush first");
+    }
+  }
+  entry *e = new entry;
+  e->actions.splice(e->actions.end(), actions);
+  e->objects.splice(e->objects.end(), objects);
+  e->replication = replication;
+  future_type f(e->promise.get_future());
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queue_.push_back(e);
+    ++pending_;
+  }
+  queued_.notify_one();
+  return f;
+}
+
+void commit_pipeline::flush()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (pending_ > 0) {
+    written_.wait(lock);
+  }
+  if (error_) {
+    std::exception_ptr error = error_;
+    error_ = std::exception_ptr();
+    std::rethrow_exception(error);
+  }
+}
+
+unsigned long commit_pipeline::commits() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return commits_;
+}
+
+unsigned long commit_pipeline::batches() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return batches_;
+}
+
+void commit_pipeline::run()
+{
+  while (true) {
+    entry_list_t batch;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      while (queue_.empty() && !stop_) {
+        queued_.wait(lock);
+      }
+      if (queue_.empty()) {
+        // stopped and nothing left to write
+        return;
+      }
+      // take all queued transactions up to the batch size
+      while (!queue_.empty() && batch.size() < max_batch_) {
+        batch.push_back(queue_.front());
+        queue_.pop_front();
+      }
+    }
+
+    write(batch);
+
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      pending_ -= batch.size();
+    }
+    written_.notify_all();
+
+    while (!batch.empty()) {
+      delete batch.front();
+      batch.pop_front();
+    }
+  }
+}
+
+void commit_pipeline::write(entry_list_t &batch)
+{
+  std::exception_ptr error;
+  {
+    // batches queued after a failed one aren't written
+    std::lock_guard<std::mutex> lock(mutex_);
+    error = error_;
+  }
+  bool committed = false;
+  if (!error) {
+    std::lock_guard<std::mutex> lock(db_mutex_);
+    try {
+      db_.begin();
+      for (entry_list_t::iterator i = batch.begin(); i != batch.end(); ++i) {
+        for (action_list_t::iterator j = (*i)->actions.begin(); j != (*i)->actions.end(); ++j) {
+          (*j)->accept(&db_);
+        }
+      }
+      db_.commit();
+      committed = true;
+    } catch (...) {
+      error = std::current_exception();
+      try {
+        // the object store keeps its ids
+        db_.discard();
+      } catch (...) {
+      }
+    }
+  }
+
+  std::exception_ptr shipping_error;
+  if (committed) {
+    // only committed transactions are shipped
+    try {
+      for (entry_list_t::iterator i = batch.begin(); i != batch.end(); ++i) {
+        if ((*i)->replication) {
+          (*i)->replication->write((*i)->actions);
+        }
+      }
+    } catch (...) {
+      shipping_error = std::current_exception();
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!error_) {
+      error_ = error ? error : shipping_error;
+    }
+    if (committed) {
+      commits_ += batch.size();
+      ++batches_;
+    }
+  }
+
+  // a failed batch fails every transaction of it
+  for (entry_list_t::iterator i = batch.begin(); i != batch.end(); ++i) {
+    entry *e = *i;
+    if (error) {
+      e->promise.set_exception(error);
+    } else {
+      e->promise.set_value();
+    }
+    while (!e->actions.empty()) {
+      delete e->actions.front();
+      e->actions.pop_front();
+    }
+    while (!e->objects.empty()) {
+      delete e->objects.front();
+      e->objects.pop_front();
+    }
+  }
+}
+
+}
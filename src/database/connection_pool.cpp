@@ -0,0 +1,149 @@
+/*
+ * This file is part of OpenObjectStore OOS.
+ *
+ * OpenObjectStore OOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenObjectStore OOS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenObjectStore OOS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "database/connection_pool.hpp"
+
+#include <chrono>
+#include <stdexcept>
+
+namespace oos {
+
+connection_pool::lease::lease(connection_pool &pool)
+  : pool_(pool)
+  , db_(pool.acquire())
+{}
+
+connection_pool::lease::~lease()
+{
+  pool_.release(db_);
+}
+
+database* connection_pool::lease::operator->() const
+{
+  return db_;
+}
+
+database& connection_pool::lease::operator*() const
+{
+  return *db_;
+}
+
+database* connection_pool::lease::get() const
+{
+  return db_;
+}
+
+connection_pool::connection_pool()
+  : clearing_(false)
+{}
+
+connection_pool::~connection_pool()
+{}
+
+void connection_pool::add(database *db)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  connections_.push_back(db);
+  idle_.push_back(db);
+  released_.notify_one();
+}
+
+void connection_pool::clear()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  clearing_ = true;
+  // the leased connections must come back first
+  while (idle_.size() != connections_.size()) {
+    released_.wait(lock);
+  }
+  connections_.clear();
+  idle_.clear();
+  clearing_ = false;
+  released_.notify_all();
+}
+
+database* connection_pool::acquire()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (connections_.empty() || clearing_) {
+    throw std::logic_error("connection pool: no connections");
+  }
+  if (idle_.empty()) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    while (idle_.empty() && !clearing_) {
+      released_.wait(lock);
+    }
+    if (clearing_) {
+      throw std::logic_error("connection pool: pool is cleared");
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    ++stats_.waited;
+    stats_.total_wait_ms += ms;
+    if (ms > stats_.max_wait_ms) {
+      stats_.max_wait_ms = ms;
+    }
+  }
+  ++stats_.acquired;
+  database *db = idle_.back();
+  idle_.pop_back();
+  return db;
+}
+
+void connection_pool::release(database *db)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  idle_.push_back(db);
+  // wakes waiting checkouts and clear()
+  released_.notify_all();
+}
+
+connection_pool::size_type connection_pool::size() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return connections_.size();
+}
+
+bool connection_pool::empty() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return connections_.empty();
+}
+
+connection_pool::size_type connection_pool::available() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return idle_.size();
+}
+
+connection_pool::statistics connection_pool::stats() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+void connection_pool::reset_stats()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  stats_ = statistics();
+}
+
+const std::vector<database*>& connection_pool::connections() const
+{
+  return connections_;
+}
+
+}
@@ -17,6 +17,7 @@
 
 #include "database/session.hpp"
 #include "database/database.hpp"
+#include "database/sql_clause.hpp"
 #include "database/database_exception.hpp"
 #include "database/database_sequencer.hpp"
 #include "database/transaction.hpp"
@@ -28,12 +29,14 @@
 #include "object/prototype_node.hpp"
 
 #include <stdexcept>
+#include <sstream>
 
 namespace oos {
 
 database::database(session *db, database_sequencer *seq)
   : db_(db)
   , commiting_(false)
+  , batch_size_(0)
   , sequencer_(seq)
 {
 }
@@ -42,6 +45,16 @@ database::~database()
 {}
 
 void database::open(const std::string &connection)
+{
+  open(connection, false);
+}
+
+void database::open_reader(const std::string &connection)
+{
+  open(connection, true);
+}
+
+void database::open(const std::string &connection, bool reader)
 {
   if (is_open()) {
     return;
@@ -59,11 +72,19 @@ void database::open(const std::string &connection)
       ++first;
     }
 
-    // setup sequencer
-    sequencer_backup_ = db_->ostore().exchange_sequencer(sequencer_);
+    // setup sequencer (the ids are generated by the writer)
+    if (!reader) {
+      sequencer_backup_ = db_->ostore().exchange_sequencer(sequencer_);
+    }
   }
 }
 
+void database::copy_settings(const database &db)
+{
+  batch_size_ = db.batch_size_;
+  fetch_strategy_map_ = db.fetch_strategy_map_;
+}
+
 void database::close()
 {
   if (!is_open()) {
@@ -140,6 +161,24 @@ void database::load(const prototype_node &node)
   i->second->load(db_->ostore());
 }
 
+void database::load(const prototype_node &node, const std::string &clause)
+{
+  load(node, sql_clause(clause));
+}
+
+void database::load(const prototype_node &node, const sql_clause &clause)
+{
+  table_map_t::iterator i = table_map_.find(node.type);
+  if (i == table_map_.end()) {
+    // create table
+    table_ptr tbl(new table(*this, node));
+    
+    i = table_map_.insert(std::make_pair(node.type, tbl)).first;
+  }
+  
+  i->second->load(db_->ostore(), clause);
+}
+
 bool database::is_loaded(const std::string &name) const
 {
 #ifdef WIN32
@@ -154,11 +193,92 @@ bool database::is_loaded(const std::string &name) const
 #endif
 }
 
+unsigned long database::loaded_batches(const std::string &name) const
+{
+#ifdef WIN32
+  table_map_t::const_iterator i = table_map_.find(name);
+  if (i == table_map_.end()) {
+    throw std::out_of_range("unknown key");
+  } else {
+    return i->second->loaded_batches();
+  }
+#else
+  return table_map_.at(name)->loaded_batches();
+#endif
+}
+
 result* database::execute(const std::string &sql)
 {
   return on_execute(sql);
 }
 
+std::string database::explain(const std::string &sql)
+{
+  return on_explain(sql);
+}
+
+std::string database::on_explain(const std::string &)
+{
+  throw database_exception("db", "explain isn't supported");
+}
+
+std::string database::limit(int rows) const
+{
+  return on_limit(rows);
+}
+
+std::string database::on_limit(int rows) const
+{
+  std::stringstream limval;
+  limval << " LIMIT " << rows;
+  return limval.str();
+}
+
+blob_stream* database::open_blob(const std::string &table, const std::string &column, long id, bool writable)
+{
+  return on_open_blob(table, column, id, writable);
+}
+
+blob_stream* database::create_blob(const std::string &table, const std::string &column, long id, unsigned long size)
+{
+  on_reserve_blob(table, column, id, size);
+  return on_open_blob(table, column, id, true);
+}
+
+blob_stream* database::on_open_blob(const std::string &, const std::string &, long, bool)
+{
+  throw database_exception("db", "blob streams aren't supported");
+}
+
+void database::on_reserve_blob(const std::string &, const std::string &, long, unsigned long)
+{
+  throw database_exception("db", "blob streams aren't supported");
+}
+
+void database::batch_size(unsigned long size)
+{
+  batch_size_ = size;
+}
+
+unsigned long database::batch_size() const
+{
+  return batch_size_;
+}
+
+void database::fetch_strategy(const std::string &type, const std::string &relation, fetch_strategy_t strategy)
+{
+  fetch_strategy_map_[std::make_pair(type, relation)] = strategy;
+}
+
+database::fetch_strategy_t database::fetch_strategy(const std::string &type, const std::string &relation) const
+{
+  fetch_strategy_map_t::const_iterator i = fetch_strategy_map_.find(std::make_pair(type, relation));
+  if (i == fetch_strategy_map_.end()) {
+    return FETCH_LAZY;
+  }
+  return i->second;
+}
+
 void database::drop()
 {
   table_map_t::iterator first = table_map_.begin();
@@ -210,6 +330,16 @@ void database::rollback()
   }
 }
 
+void database::discard()
+{
+  sequencer_->discard();
+
+  if (commiting_) {
+    on_rollback();
+    commiting_ = false;
+  }
+}
+
 database::database_sequencer_ptr database::seq() const
 {
   return sequencer_;
@@ -230,18 +360,12 @@ void database::visit(insert_action *a)
   }
   
   
-  insert_action::const_iterator first = a->begin();
-  insert_action::const_iterator last = a->end();
-  while (first != last) {
-    object *o = (*first++);
-    
-    i->second->insert(o);
-  }
+  i->second->insert(a->begin(), a->end());
 }
 
 void database::visit(update_action *a)
 {
-  table_map_t::iterator i = table_map_.find(a->obj()->classname());
+  table_map_t::iterator i = table_map_.find(a->type());
   if (i == table_map_.end()) {
     throw database_exception("db", "table not found");
   }
@@ -31,6 +31,9 @@ database_sequencer::database_sequencer(database &db)
   : db_(db)
   , backup_(0)
   , sequence_(0)
+  , reserved_(0)
+  , reserved_backup_(0)
+  , block_size_(1000)
   , name_("object")
   , update_(0)
 {
@@ -44,13 +47,14 @@ database_sequencer::~database_sequencer()
 void database_sequencer::deserialize(object_reader &r)
 {
   r.read("name", name_);
-  r.read("number", sequence_);
+  r.read("number", reserved_);
 }
 
 void database_sequencer::serialize(object_writer &w) const
 {
   w.write("name", name_);
-  w.write("number", sequence_);
+  // the table holds the end of the reserved block
+  w.write("number", reserved_);
 }
 
 long database_sequencer::init()
@@ -76,10 +80,13 @@ long database_sequencer::current() const
 
 long database_sequencer::update(long id)
 {
-  if (id > sequence_) {
-    sequence_ = id;
+  long sequence = sequence_.load();
+  while (id > sequence) {
+    if (sequence_.compare_exchange_weak(sequence, id)) {
+      return id;
+    }
   }
-  return sequence_;
+  return sequence;
 }
 
 void database_sequencer::create()
@@ -92,8 +99,9 @@ void database_sequencer::create()
   res = q.reset().select(this).from("oos_sequence").where("name='object'").execute();
 
   if (res->fetch()) {
-    // get sequence number
-    res->get(1, sequence_);
+    // get end of reserved block
+    res->get(1, reserved_);
+    sequence_ = reserved_;
   } else {
     // TODO: check result
     result *res2 = q.reset().insert(this, "oos_sequence").execute();
@@ -110,8 +118,13 @@ void database_sequencer::load()
   result *res = q.reset().select(this).from("oos_sequence").where("name='object'").execute();
 
   if (res->fetch()) {
-    // get sequence number
-    res->get(1, sequence_);
+    /*
+     * get end of reserved block, ids of
+     * the last block not handed out before
+     * are skipped
+     */
+    res->get(1, reserved_);
+    sequence_ = reserved_;
   } else {
     delete res;
     throw database_exception("database::sequencer", "couldn't fetch sequence");
@@ -127,10 +140,23 @@ void database_sequencer::begin()
 {
   // backup current sequence id from object store
   backup_ = current();
+  reserved_backup_ = reserved_;
 }
 
 void database_sequencer::commit()
 {
+  /*
+   * as long as the handed out ids are
+   * inside the reserved block there is
+   * nothing to write
+   */
+  long sequence = sequence_.load();
+  if (sequence <= reserved_) {
+    return;
+  }
+  // reserve next block
+  reserved_ = sequence + block_size_;
+
   update_->bind(this);
   // TODO: check result
   result *res = update_->execute();
@@ -141,6 +167,23 @@ void database_sequencer::commit()
 void database_sequencer::rollback()
 {
   reset(backup_);
+  /*
+   * a block reserved within the rolled back
+   * transaction isn't written, so it must
+   * be reserved again
+   */
+  reserved_ = reserved_backup_;
+}
+
+void database_sequencer::discard()
+{
+  /*
+   * the handed out ids stay valid but a
+   * block written within the discarded
+   * transaction is lost, so the next
+   * commit writes the sequence again
+   */
+  reserved_ = 0;
 }
 
 void database_sequencer::drop()
@@ -151,6 +194,21 @@ void database_sequencer::drop()
   delete res;
 }
 
+void database_sequencer::block_size(long size)
+{
+  block_size_ = size;
+}
+
+long database_sequencer::block_size() const
+{
+  return block_size_;
+}
+
+long database_sequencer::reserved() const
+{
+  return reserved_;
+}
+
 void database_sequencer::destroy()
 {
   if (update_) {
@@ -34,6 +34,7 @@
 
 #include <stdexcept>
 #include <sstream>
+#include <cstdlib>
 
 #include <sql.h>
 #include <sqlext.h>
@@ -56,6 +57,7 @@ mssql_database::mssql_database(session *db)
   , connection_(0)
   , is_open_(false)
   , retries_(1)
+  , array_size_(1)
 {
 }
 
@@ -65,7 +67,7 @@ mssql_database::~mssql_database()
 }
 
 
-void mssql_database::on_open(const std::string &connection)
+std::string mssql_database::odbc_connection_string(const std::string &connection)
 {
   // parse user[:passwd]@host/db ([Drivername])
   std::string con = connection;
@@ -93,6 +95,7 @@ void mssql_database::on_open(const std::string &connection)
   pos = con.find('/');
   std::string host = con.substr(0, pos);
   std::string db = con.substr(pos + 1);
+  std::string database;
 
   // get driver
   pos = db.find('(');
@@ -106,6 +109,54 @@ void mssql_database::on_open(const std::string &connection)
     driver = "SQL Server";
   }
 
+  // parse options [?key=value[&key=value]]
+  pos = db.find('?');
+  if (pos != std::string::npos) {
+    std::string options = db.substr(pos + 1);
+    db = trim(db.substr(0, pos));
+    std::string::size_type first = 0;
+    while (first < options.size()) {
+      std::string::size_type last = options.find('&', first);
+      std::string option = trim(options.substr(first, last == std::string::npos ? std::string::npos : last - first));
+      std::string::size_type eq = option.find('=');
+      if (eq == std::string::npos) {
+        throw_error("mssql:open", "invalid option: " + option);
+      }
+      apply_option(option.substr(0, eq), option.substr(eq + 1));
+      if (last == std::string::npos) {
+        break;
+      }
+      first = last + 1;
+    }
+  }
+
+  // split instance[/database]
+  pos = db.find('/');
+  if (pos != std::string::npos) {
+    database = db.substr(pos + 1);
+    db = db.substr(0, pos);
+  }
+
+  std::string dsn("DRIVER={" + driver + "};SERVER=" + host + "\\" + db + ";");
+  if (!database.empty()) {
+    dsn += "DATABASE=" + database + ";";
+  }
+  return dsn + "UID=" + user + ";PWD=" + passwd + ";";
+}
+
+void mssql_database::on_open(const std::string &connection)
+{
+  array_size_ = 1;
+  std::string dsn;
+  std::string::size_type eq = connection.find('=');
+  std::string::size_type at = connection.find('@');
+  if (eq != std::string::npos && (at == std::string::npos || eq < at)) {
+    // raw odbc connection string, e.g. DSN=name;UID=user;PWD=secret
+    dsn = connection;
+  } else {
+    dsn = odbc_connection_string(connection);
+  }
+
   SQLRETURN ret = SQLAllocHandle(SQL_HANDLE_ENV, SQL_NULL_HANDLE, &odbc_);
   if (ret != SQL_SUCCESS) {
     SQLFreeHandle(SQL_HANDLE_ENV, odbc_);
@@ -126,16 +177,33 @@ void mssql_database::on_open(const std::string &connection)
 
   SQLSetConnectAttr(connection_, SQL_LOGIN_TIMEOUT, (SQLPOINTER *)5, 0);
 
-  std::string dns("DRIVER={" + driver + "};SERVER=" + host + "\\" + db + ";DATABASE=test;UID=" + user + ";PWD=sascha;");
-
   SQLCHAR retconstring[1024];
-  ret = SQLDriverConnect(connection_, 0, (SQLCHAR*)dns.c_str(), SQL_NTS, retconstring, 1024, NULL,SQL_DRIVER_NOPROMPT);
+  ret = SQLDriverConnect(connection_, 0, (SQLCHAR*)dsn.c_str(), SQL_NTS, retconstring, 1024, NULL,SQL_DRIVER_NOPROMPT);
 
   throw_error(ret, SQL_HANDLE_DBC, connection_, "mssql", "error on connect");
 
   is_open_ = true;
 }
 
+void mssql_database::apply_option(const std::string &key, const std::string &value)
+{
+  char *end = 0;
+  unsigned long number = strtoul(value.c_str(), &end, 10);
+  if (key == "array") {
+    if (value.empty() || *end != '\0' || number == 0) {
+      throw_error("mssql:open", "invalid value for option " + key + ": " + value);
+    }
+    array_size_ = number;
+  } else {
+    throw_error("mssql:open", "unknown option: " + key);
+  }
+}
+
+unsigned long mssql_database::array_size() const
+{
+  return array_size_;
+}
+
 bool mssql_database::is_open() const
 {
   return is_open_;
@@ -179,7 +247,7 @@ result* mssql_database::on_execute(const std::string &sqlstr)
 
   throw_error(ret, SQL_HANDLE_STMT, stmt, sqlstr, "error on query execute");
 
-  return new mssql_result(stmt, true);
+  return new mssql_result(stmt, true, array_size_);
 }
 
 result* mssql_database::create_result()
@@ -213,6 +281,14 @@ void mssql_database::on_rollback()
   delete res;
 }
 
+std::string mssql_database::on_limit(int rows) const
+{
+  // sql server has no LIMIT, it pages after the ORDER BY clause
+  std::stringstream limval;
+  limval << " OFFSET 0 ROWS FETCH NEXT " << rows << " ROWS ONLY";
+  return limval.str();
+}
+
 const char* mssql_database::type_string(data_type_t type) const
 {
   switch(type) {
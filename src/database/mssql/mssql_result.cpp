@@ -27,12 +27,16 @@ namespace oos {
 
 namespace mssql {
 
-mssql_result::mssql_result(SQLHANDLE stmt, bool free)
+mssql_result::mssql_result(SQLHANDLE stmt, bool free, SQLULEN row_array_size)
   : affected_rows_(0)
   , rows(0)
   , fields_(0)
   , free_(free)
   , stmt_(stmt)
+  , row_array_size_(row_array_size)
+  , rows_fetched_(0)
+  , row_(0)
+  , binding_(false)
 {
   // get row and column information
   SQLRETURN ret = SQLRowCount(stmt, (SQLLEN*)&rows);
@@ -47,6 +51,14 @@ mssql_result::~mssql_result()
 {
   if (free_) {
     SQLFreeHandle(SQL_HANDLE_STMT, stmt_);
+    return;
+  }
+  // close the cursor so the statement can be executed again
+  SQLFreeStmt(stmt_, SQL_CLOSE);
+  if (!columns_.empty()) {
+    SQLFreeStmt(stmt_, SQL_UNBIND);
+    SQLSetStmtAttr(stmt_, SQL_ATTR_ROW_ARRAY_SIZE, (SQLPOINTER)1, 0);
+    SQLSetStmtAttr(stmt_, SQL_ATTR_ROWS_FETCHED_PTR, 0, 0);
   }
 }
 
@@ -68,6 +80,9 @@ bool mssql_result::fetch()
 
 bool mssql_result::fetch(object *o)
 {
+  if (row_array_size_ > 1) {
+    return fetch_rowset(o);
+  }
   if (!fetch()) {
     return false;
   }
@@ -77,6 +92,71 @@ bool mssql_result::fetch(object *o)
   return true;
 }
 
+bool mssql_result::fetch_rowset(object *o)
+{
+  if (columns_.empty()) {
+    // collect the columns of the object
+    binding_ = true;
+    get(o);
+    binding_ = false;
+
+    // bind a column wise buffer for each column
+    for (size_t i = 0; i < columns_.size(); ++i) {
+      column_t &c = columns_[i];
+      c.data.assign(c.width * row_array_size_, 0);
+      c.len.assign(row_array_size_, 0);
+      SQLRETURN ret = SQLBindCol(stmt_, (SQLUSMALLINT)(i + 1), c.ctype, &c.data[0], c.width, &c.len[0]);
+      throw_error(ret, SQL_HANDLE_STMT, stmt_, "mssql", "couldn't bind column");
+    }
+    SQLRETURN ret = SQLSetStmtAttr(stmt_, SQL_ATTR_ROW_BIND_TYPE, (SQLPOINTER)SQL_BIND_BY_COLUMN, 0);
+    throw_error(ret, SQL_HANDLE_STMT, stmt_, "mssql", "couldn't set row bind type");
+    ret = SQLSetStmtAttr(stmt_, SQL_ATTR_ROW_ARRAY_SIZE, (SQLPOINTER)row_array_size_, 0);
+    throw_error(ret, SQL_HANDLE_STMT, stmt_, "mssql", "couldn't set row array size");
+    ret = SQLSetStmtAttr(stmt_, SQL_ATTR_ROWS_FETCHED_PTR, &rows_fetched_, 0);
+    throw_error(ret, SQL_HANDLE_STMT, stmt_, "mssql", "couldn't set rows fetched pointer");
+    row_ = rows_fetched_ = 0;
+  }
+
+  if (++row_ >= rows_fetched_) {
+    // fetch the next rowset
+    SQLRETURN ret = SQLFetch(stmt_);
+    if (ret == SQL_NO_DATA) {
+      return false;
+    }
+    throw_error(ret, SQL_HANDLE_STMT, stmt_, "mssql", "error on fetching next rowset");
+    row_ = 0;
+    if (rows_fetched_ == 0) {
+      return false;
+    }
+  }
+
+  get(o);
+
+  return true;
+}
+
+const char* mssql_result::column(int ctype, SQLLEN width, SQLLEN &len)
+{
+  size_t index = result_index++ - 1;
+  if (binding_) {
+    column_t c;
+    c.ctype = ctype;
+    c.width = width;
+    columns_.push_back(c);
+    return 0;
+  }
+  column_t &c = columns_.at(index);
+  len = c.len[row_];
+  if (len == SQL_NULL_DATA) {
+    return 0;
+  }
+  // character data may have been truncated
+  if (len == SQL_NO_TOTAL || len >= c.width) {
+    len = c.width - 1;
+  }
+  return &c.data[row_ * c.width];
+}
+
 mssql_result::size_type mssql_result::affected_rows() const
 {
   return affected_rows_;
@@ -155,6 +235,14 @@ void mssql_result::read(const char *id, double &x)
 void mssql_result::read(const char * /*id*/, char *x, int s)
 {
   SQLLEN info = 0;
+  if (row_array_size_ > 1) {
+    const char *data = column(SQL_C_CHAR, s, info);
+    if (data) {
+      memcpy(x, data, info);
+      x[info] = '\0';
+    }
+    return;
+  }
   SQLRETURN ret = SQLGetData(stmt_, result_index++, SQL_C_CHAR, x, s, &info);
   if (ret == SQL_SUCCESS) {
     return;
@@ -188,6 +276,17 @@ void mssql_result::read_column(const char *, unsigned long &val)
 {
   char buf[NUMERIC_LEN];
   SQLLEN info = 0;
+  if (row_array_size_ > 1) {
+    const char *data = column(SQL_C_CHAR, NUMERIC_LEN, info);
+    if (data) {
+      memcpy(buf, data, info);
+      buf[info] = '\0';
+      if (sscanf(buf, "%lu", &val) != 1) {
+        throw_error("mssql", strerror(errno));
+      }
+    }
+    return;
+  }
   SQLRETURN ret = SQLGetData(stmt_, result_index++, SQL_C_CHAR, buf, NUMERIC_LEN, &info);
   if (ret == SQL_SUCCESS) {    
     if (sscanf(buf, "%lu", &val) != 1) {
@@ -200,9 +299,16 @@ void mssql_result::read_column(const char *, unsigned long &val)
 
 void mssql_result::read_column(const char *, std::string &val)
 {
-  char buf[1024];
   SQLLEN info = 0;
-  SQLRETURN ret = SQLGetData(stmt_, result_index++, SQL_C_CHAR, buf, 1024, &info);
+  if (row_array_size_ > 1) {
+    const char *data = column(SQL_C_CHAR, TEXT_LEN, info);
+    if (data) {
+      val.assign(data, info);
+    }
+    return;
+  }
+  char buf[TEXT_LEN];
+  SQLRETURN ret = SQLGetData(stmt_, result_index++, SQL_C_CHAR, buf, TEXT_LEN, &info);
   if (ret == SQL_SUCCESS) {
     val.assign(buf, info);
   } else {
@@ -212,6 +318,14 @@ void mssql_result::read_column(const char *, std::string &val)
 
 void mssql_result::read_column(const char *, varchar_base &val)
 {
+  if (row_array_size_ > 1) {
+    SQLLEN len = 0;
+    const char *data = column(SQL_C_CHAR, val.capacity() + 1, len);
+    if (data) {
+      val.assign(data, len);
+    }
+    return;
+  }
   char *buf = new char[val.capacity()];
   SQLLEN info = 0;
   SQLRETURN ret = SQLGetData(stmt_, result_index++, SQL_C_CHAR, buf, val.capacity(), &info);
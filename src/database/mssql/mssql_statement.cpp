@@ -36,6 +36,10 @@ namespace mssql {
 
 mssql_statement::mssql_statement(mssql_database &db)
   : db_(db)
+  , array_size_(db.array_size())
+  , rows_(0)
+  , processed_(0)
+  , bound_(false)
 {
   if (!db()) {
     throw_error("mssql", "no odbc connection established");
@@ -47,6 +51,10 @@ mssql_statement::mssql_statement(mssql_database &db)
 
 mssql_statement::mssql_statement(mssql_database &db, const sql &s)
   : db_(db)
+  , array_size_(db.array_size())
+  , rows_(0)
+  , processed_(0)
+  , bound_(false)
 {
   if (!db()) {
     throw_error("mssql", "no odbc connection established");
@@ -64,6 +72,11 @@ mssql_statement::~mssql_statement()
 void mssql_statement::prepare(const sql &s)
 {
   reset();
+
+  // parameter buffers of the previous statement
+  host_data_.clear();
+  rows_ = 0;
+  bound_ = false;
   
   str(s.prepare());
 
@@ -73,26 +86,60 @@ void mssql_statement::prepare(const sql &s)
 
 void mssql_statement::reset()
 {
-  while (!host_data_.empty()) {
-    delete host_data_.back();
-    host_data_.pop_back();
-  }
+  /*
+   * the parameter buffers are kept, they are
+   * overwritten by the next parameter set
+   */
 }
 
 void mssql_statement::clear()
 {
   reset();
+  host_data_.clear();
+  rows_ = 0;
   SQLFreeHandle(SQL_HANDLE_STMT, stmt_);
 }
 
 result* mssql_statement::execute()
 {
+  // execute all pending parameter sets including the current one
+  bind_parameters(rows_ + 1);
+  rows_ = 0;
+
   SQLRETURN ret = SQLExecute(stmt_);
 
   // check result
   throw_error(ret, SQL_HANDLE_STMT, stmt_, str(), "error on query execute");
 
-  return new mssql_result(stmt_, false);
+  return new mssql_result(stmt_, false, db_.array_size());
+}
+
+void mssql_statement::add_batch()
+{
+  if (++rows_ >= array_size_) {
+    execute_batch();
+  }
+}
+
+void mssql_statement::execute_batch()
+{
+  if (rows_ == 0) {
+    return;
+  }
+  SQLULEN rows = rows_;
+  bind_parameters(rows);
+  rows_ = 0;
+
+  SQLRETURN ret = SQLExecute(stmt_);
+  throw_error(ret, SQL_HANDLE_STMT, stmt_, str(), "error on batch execute");
+
+  // discard the row counts of the parameter sets
+  ret = SQLFreeStmt(stmt_, SQL_CLOSE);
+  throw_error(ret, SQL_HANDLE_STMT, stmt_, str(), "error on closing statement");
+
+  if (processed_ != rows) {
+    throw_error("mssql", "not all parameter sets were processed");
+  }
 }
 
 void mssql_statement::write(const char *, char x)
@@ -176,33 +223,85 @@ void mssql_statement::write(const char *, const object_container &)
 
 void mssql_statement::bind_value(unsigned long val, int index)
 {
-  value_t *v = new value_t(true, SQL_NTS);
-  v->data = new char[NUMERIC_LEN];
-  
-  host_data_.push_back(v);
+  value_t &v = host_value(index, SQL_C_CHAR, SQL_CHAR, NUMERIC_LEN);
+  if (v.size < NUMERIC_LEN - 1) {
+    v.size = NUMERIC_LEN - 1;
+    bound_ = false;
+  }
 
 #if defined(_MSC_VER)
-  size_t size = (int)_snprintf_s(static_cast<char*>(v->data), NUMERIC_LEN, NUMERIC_LEN, "%lu", val);
+  _snprintf_s(v.at(rows_), NUMERIC_LEN, NUMERIC_LEN, "%lu", val);
 #else
-  size_t size = (int)snprintf(static_cast<char*>(v->data), NUMERIC_LEN, "%lu", val);
+  snprintf(v.at(rows_), NUMERIC_LEN, "%lu", val);
 #endif
-
-  SQLRETURN ret = SQLBindParameter(stmt_, index, SQL_PARAM_INPUT, SQL_C_CHAR, SQL_CHAR, size, 0, v->data, 0, &v->len);
-  throw_error(ret, SQL_HANDLE_STMT, stmt_, "mssql", "couldn't bind parameter");
+  v.len[rows_] = SQL_NTS;
 }
 
 void mssql_statement::bind_value(const char *val, int /*size*/, int index)
 {
   size_t s = strlen(val);
-  value_t *v = new value_t(false, SQL_NTS);
-  v->data = new char[s+1];
-  v->data = strncpy((char*)v->data, val, s);
-  ((char*)v->data)[s++] = '\0';
+  value_t &v = host_value(index, SQL_C_CHAR, SQL_VARCHAR, s + 1);
+  if (v.size < s || v.size == 0) {
+    v.size = (s > 0 ? s : 1);
+    bound_ = false;
+  }
+  memcpy(v.at(rows_), val, s);
+  v.at(rows_)[s] = '\0';
+  v.len[rows_] = s;
+}
+
+void mssql_statement::value_t::resize(SQLLEN w, SQLULEN rows)
+{
+  // copy the already written parameter sets into the wider slots
+  std::vector<char> buf(w * rows, 0);
+  for (SQLULEN r = 0; r < rows && width > 0; ++r) {
+    memcpy(&buf[r * w], &data[r * width], width);
+  }
+  data.swap(buf);
+  width = w;
+  len.resize(rows, 0);
+}
+
+mssql_statement::value_t& mssql_statement::host_value(int index, int ctype, int type, SQLLEN width)
+{
+  if (host_data_.size() < (size_t)index) {
+    host_data_.resize(index);
+    bound_ = false;
+  }
+  value_t &v = host_data_[index - 1];
+  if (v.ctype != ctype || v.type != type) {
+    v.ctype = ctype;
+    v.type = type;
+    bound_ = false;
+  }
+  if (v.width < width) {
+    v.resize(width, array_size_);
+    bound_ = false;
+  }
+  return v;
+}
 
-  host_data_.push_back(v);
+void mssql_statement::bind_parameters(SQLULEN rows)
+{
+  SQLRETURN ret = SQLSetStmtAttr(stmt_, SQL_ATTR_PARAMSET_SIZE, (SQLPOINTER)rows, 0);
+  throw_error(ret, SQL_HANDLE_STMT, stmt_, "mssql", "couldn't set parameter set size");
 
-  SQLRETURN ret = SQLBindParameter(stmt_, index, SQL_PARAM_INPUT, SQL_C_CHAR, SQL_VARCHAR, s, 0, v->data, 0, &v->len);
-  throw_error(ret, SQL_HANDLE_STMT, stmt_, "mssql", "couldn't bind parameter");
+  if (bound_) {
+    return;
+  }
+
+  // bind the parameter buffers column wise
+  ret = SQLSetStmtAttr(stmt_, SQL_ATTR_PARAM_BIND_TYPE, (SQLPOINTER)SQL_PARAM_BIND_BY_COLUMN, 0);
+  throw_error(ret, SQL_HANDLE_STMT, stmt_, "mssql", "couldn't set parameter bind type");
+  ret = SQLSetStmtAttr(stmt_, SQL_ATTR_PARAMS_PROCESSED_PTR, &processed_, 0);
+  throw_error(ret, SQL_HANDLE_STMT, stmt_, "mssql", "couldn't set processed parameter pointer");
+
+  for (size_t i = 0; i < host_data_.size(); ++i) {
+    value_t &v = host_data_[i];
+    ret = SQLBindParameter(stmt_, (SQLUSMALLINT)(i + 1), SQL_PARAM_INPUT, v.ctype, v.type, v.size, 0, v.at(0), v.width, &v.len[0]);
+    throw_error(ret, SQL_HANDLE_STMT, stmt_, "mssql", "couldn't bind parameter");
+  }
+  bound_ = true;
 }
 
 database& mssql_statement::db()
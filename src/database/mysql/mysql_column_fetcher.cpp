@@ -25,18 +25,23 @@ void mysql_column_fetcher::fetch(object *o)
 
 void mysql_column_fetcher::read_value(const char *, std::string &x)
 {
-  if (info_[column_index_].length > 0) {
-    bind_[column_index_].buffer = new char[info_[column_index_].length];
-    bind_[column_index_].buffer_length = info_[column_index_].length;
+  mysql_prepared_result::result_info &info = info_[column_index_];
+  if (info.length > 0) {
+    // the fetch buffer grows with the longest value
+    if (info.buffer_length < info.length) {
+      delete [] info.buffer;
+      info.buffer = new char[info.length];
+      info.buffer_length = info.length;
+    }
+    bind_[column_index_].buffer = info.buffer;
+    bind_[column_index_].buffer_length = info.length;
     if (mysql_stmt_fetch_column(stmt_, &bind_[column_index_], column_index_, 0) != 0) {
       // an error occured
     } else {
-      char *data = (char*)bind_[column_index_].buffer;
-      unsigned long len = bind_[column_index_].buffer_length;
-      x.assign(data, len);
+      x.assign(info.buffer, info.length);
     }
-    delete [] (char*)bind_[column_index_].buffer;
     bind_[column_index_].buffer = 0;
+    bind_[column_index_].buffer_length = 0;
   }
   ++column_index_;
 }
@@ -32,6 +32,7 @@
 
 #include <stdexcept>
 #include <sstream>
+#include <cstdlib>
 
 #ifdef WIN32
 #include <functional>
@@ -48,6 +49,7 @@ namespace mysql {
 mysql_database::mysql_database(session *db)
   : database(db, new database_sequencer(*this))
   , is_open_(false)
+  , prefetch_rows_(0)
 {
 }
 
@@ -86,6 +88,28 @@ void mysql_database::on_open(const std::string &connection)
   std::string host = con.substr(0, pos);
   std::string db = con.substr(pos + 1);
 
+  // parse options [?key=value[&key=value]]
+  prefetch_rows_ = 0;
+  pos = db.find('?');
+  if (pos != std::string::npos) {
+    std::string options = db.substr(pos + 1);
+    db = db.substr(0, pos);
+    std::string::size_type first = 0;
+    while (first < options.size()) {
+      std::string::size_type last = options.find('&', first);
+      std::string option = options.substr(first, last == std::string::npos ? std::string::npos : last - first);
+      std::string::size_type eq = option.find('=');
+      if (eq == std::string::npos) {
+        throw_error("mysql:open", "invalid option: " + option);
+      }
+      apply_option(option.substr(0, eq), option.substr(eq + 1));
+      if (last == std::string::npos) {
+        break;
+      }
+      first = last + 1;
+    }
+  }
+
   if (mysql_init(&mysql_) == 0) {
     throw_error("mysql", "initialization failed");
   }
@@ -99,6 +123,25 @@ void mysql_database::on_open(const std::string &connection)
   is_open_ = true;
 }
 
+void mysql_database::apply_option(const std::string &key, const std::string &value)
+{
+  char *end = 0;
+  unsigned long number = strtoul(value.c_str(), &end, 10);
+  if (key == "prefetch") {
+    if (value.empty() || *end != '\0') {
+      throw_error("mysql:open", "invalid value for option " + key + ": " + value);
+    }
+    prefetch_rows_ = number;
+  } else {
+    throw_error("mysql:open", "unknown option: " + key);
+  }
+}
+
+unsigned long mysql_database::prefetch_rows() const
+{
+  return prefetch_rows_;
+}
+
 bool mysql_database::is_open() const
 {
   return is_open_;
@@ -157,6 +200,41 @@ void mysql_database::on_rollback()
   delete res;
 }
 
+std::string mysql_database::on_explain(const std::string &sql)
+{
+  std::string stmt("EXPLAIN " + sql);
+  if (mysql_query(&mysql_, stmt.c_str())) {
+    throw mysql_exception(&mysql_, "mysql_query", stmt);
+  }
+  MYSQL_RES *res = mysql_store_result(&mysql_);
+  if (!res) {
+    throw mysql_exception(&mysql_, "mysql_store_result", stmt);
+  }
+  /*
+   * write table, access type and
+   * chosen key of each plan row
+   */
+  unsigned int count = mysql_num_fields(res);
+  MYSQL_FIELD *fields = mysql_fetch_fields(res);
+  std::stringstream plan;
+  MYSQL_ROW row;
+  bool first = true;
+  while ((row = mysql_fetch_row(res)) != 0) {
+    if (!first) {
+      plan << "\n";
+    }
+    first = false;
+    for (unsigned int i = 0; i < count; ++i) {
+      std::string name(fields[i].name);
+      if (name == "table" || name == "type" || name == "key") {
+        plan << name << "=" << (row[i] ? row[i] : "NULL") << " ";
+      }
+    }
+  }
+  mysql_free_result(res);
+  return plan.str();
+}
+
 const char* mysql_database::type_string(data_type_t type) const
 {
   switch(type) {
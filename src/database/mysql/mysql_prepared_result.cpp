@@ -15,28 +15,19 @@ namespace oos {
 
 namespace mysql {
 
-mysql_prepared_result::mysql_prepared_result(MYSQL_STMT *s, int rs)
+mysql_prepared_result::mysql_prepared_result(MYSQL_STMT *s, int rs, MYSQL_BIND *bind, result_info *info)
   : affected_rows_((size_type)mysql_stmt_affected_rows(s))
   , rows((size_type)mysql_stmt_num_rows(s))
   , fields_(mysql_stmt_field_count(s))
   , stmt(s)
   , result_size(rs)
-  , bind_(new MYSQL_BIND[rs])
-  , info_(new result_info[rs])
+  , bind_(bind)
+  , info_(info)
 {
-    memset(bind_, 0, rs * sizeof(MYSQL_BIND));
-    memset(info_, 0, rs * sizeof(result_info));
 }
 
 mysql_prepared_result::~mysql_prepared_result()
 {
-  delete [] bind_;
-  for (int i = 0; i < result_size; ++i) {
-    if (info_[i].buffer != 0) {
-      delete [] info_[i].buffer;
-    }
-  }
-  delete [] info_;
 }
 
 const char* mysql_prepared_result::column(size_type ) const
@@ -234,7 +225,8 @@ void mysql_prepared_result::prepare_bind_column(int index, enum_field_types type
 
 void mysql_prepared_result::prepare_bind_column(int index, enum_field_types type, varchar_base &x)
 {
-  if (info_[index].buffer == 0) {
+  if (info_[index].buffer_length < (unsigned long)x.capacity()) {
+    delete [] info_[index].buffer;
     info_[index].buffer = new char[x.capacity()];
     memset(info_[index].buffer, 0, x.capacity());
     info_[index].buffer_length = x.capacity();
@@ -249,7 +241,8 @@ void mysql_prepared_result::prepare_bind_column(int index, enum_field_types type
 
 void mysql_prepared_result::prepare_bind_column(int index, enum_field_types type, object_base_ptr &)
 {
-  if (info_[index].buffer == 0) {
+  if (info_[index].buffer_length < sizeof(long)) {
+    delete [] info_[index].buffer;
     info_[index].buffer = new char[sizeof(long)];
     memset(info_[index].buffer, 0, sizeof(long));
     info_[index].buffer_length = sizeof(long);
@@ -38,6 +38,9 @@ mysql_statement::mysql_statement(mysql_database &db)
   , host_size(0)
   , stmt(mysql_stmt_init(db()))
   , host_array(0)
+  , result_array(0)
+  , info_array(0)
+  , cursor_(false)
 {
 }
 
@@ -47,6 +50,9 @@ mysql_statement::mysql_statement(mysql_database &db, const sql &s)
   , host_size(0)
   , stmt(mysql_stmt_init(db()))
   , host_array(0)
+  , result_array(0)
+  , info_array(0)
+  , cursor_(false)
 {
   prepare(s);
 }
@@ -60,7 +66,9 @@ mysql_statement::~mysql_statement()
 void mysql_statement::prepare(const sql &s)
 {
   reset();
-  
+  // release the binds of a previous statement
+  clear();
+
   str(s.prepare());
   // parse sql to create result and host arrays
   result_size = s.result_size();
@@ -69,12 +77,49 @@ void mysql_statement::prepare(const sql &s)
     host_array = new MYSQL_BIND[host_size];
     memset(host_array, 0, host_size * sizeof(MYSQL_BIND));
     length_vector.assign(host_size, 0);
+    /*
+     * allocate the host buffers once from the
+     * field descriptors, they are reused by
+     * every execution of the statement
+     */
+    for (sql::const_iterator i = s.host_begin(); i != s.host_end(); ++i) {
+      host_buffer(host_array[(*i)->index], sql::type_size((*i)->type));
+      host_array[(*i)->index].buffer_type = type_enum((*i)->type);
+    }
+  }
+  if (result_size) {
+    result_array = new MYSQL_BIND[result_size];
+    memset(result_array, 0, result_size * sizeof(MYSQL_BIND));
+    info_array = new mysql_prepared_result::result_info[result_size];
+    memset(info_array, 0, result_size * sizeof(mysql_prepared_result::result_info));
   }
   
   int res = mysql_stmt_prepare(stmt, str().c_str(), str().size());
   if (res > 0) {
     throw_stmt_error(res, stmt, "mysql", str());
   }
+
+  /*
+   * if a batch size is set, selects are
+   * streamed through a read only server
+   * side cursor instead of buffering the
+   * complete result on the client. the
+   * prefetch option overrides the number
+   * of rows read per round trip
+   */
+  unsigned long prefetch_rows = db_.prefetch_rows() > 0 ? db_.prefetch_rows() : db_.batch_size();
+  cursor_ = result_size > 0 && prefetch_rows > 0;
+  if (cursor_) {
+    unsigned long type = (unsigned long)CURSOR_TYPE_READ_ONLY;
+    res = mysql_stmt_attr_set(stmt, STMT_ATTR_CURSOR_TYPE, &type);
+    if (res > 0) {
+      throw_stmt_error(res, stmt, "mysql", str());
+    }
+    res = mysql_stmt_attr_set(stmt, STMT_ATTR_PREFETCH_ROWS, &prefetch_rows);
+    if (res > 0) {
+      throw_stmt_error(res, stmt, "mysql", str());
+    }
+  }
 }
 
 void mysql_statement::reset()
@@ -89,10 +134,20 @@ void mysql_statement::clear()
       delete [] static_cast<char*>(host_array[i].buffer);
     }
   }
+  for (int i = 0; i < result_size; ++i) {
+    if (info_array[i].buffer) {
+      delete [] info_array[i].buffer;
+    }
+  }
   result_size = 0;
   host_size = 0;
   mysql_stmt_free_result(stmt);
   delete [] host_array;
+  delete [] result_array;
+  delete [] info_array;
+  host_array = 0;
+  result_array = 0;
+  info_array = 0;
 }
 
 result* mysql_statement::execute()
@@ -107,11 +162,13 @@ result* mysql_statement::execute()
   if (res > 0) {
     throw_stmt_error(res, stmt, "mysql", str());
   }
-  res = mysql_stmt_store_result(stmt);
-  if (res > 0) {
-    throw_stmt_error(res, stmt, "mysql", str());
+  if (!cursor_) {
+    res = mysql_stmt_store_result(stmt);
+    if (res > 0) {
+      throw_stmt_error(res, stmt, "mysql", str());
+    }
   }
-  return new mysql_prepared_result(stmt, result_size);
+  return new mysql_prepared_result(stmt, result_size, result_array, info_array);
 }
 
 void mysql_statement::write(const char *, char x)
@@ -182,7 +239,12 @@ void mysql_statement::write(const char *, double x)
 
 void mysql_statement::write(const char *, const char *x, int s)
 {
-  bind_value(host_array[host_index], MYSQL_TYPE_VAR_STRING, x, s, host_index);
+  // only send the characters up to the terminating null
+  int len = 0;
+  while (len < s && x[len] != '\0') {
+    ++len;
+  }
+  bind_value(host_array[host_index], MYSQL_TYPE_VAR_STRING, x, len, host_index);
   ++host_index;
 }
 
@@ -265,20 +327,24 @@ void mysql_statement::bind_value(MYSQL_BIND &bind, enum_field_types type, int in
   bind.is_null = 0;
 }
 
-void mysql_statement::bind_value(MYSQL_BIND &bind, enum_field_types type, const char *value, int size, int /*index*/)
+void mysql_statement::bind_value(MYSQL_BIND &bind, enum_field_types type, const char *value, int size, int index)
+{
+  memcpy(host_buffer(bind, size), value, size);
+  // the buffer may be larger than the value
+  length_vector.at(index) = size;
+  bind.length = &length_vector.at(index);
+  bind.buffer_type = type;
+  bind.is_null = 0;
+}
+
+void* mysql_statement::host_buffer(MYSQL_BIND &bind, unsigned long size)
 {
-  if (bind.buffer == 0) {
-    // allocating memory
+  if (bind.buffer == 0 || bind.buffer_length < size) {
+    delete [] static_cast<char*>(bind.buffer);
     bind.buffer = new char[size];
     bind.buffer_length = size;
   }
-#ifdef WIN32
-    strncpy_s(static_cast<char*>(bind.buffer), size, value, _TRUNCATE);
-#else
-    strncpy(static_cast<char*>(bind.buffer), value, size);
-#endif
-  bind.buffer_type = type;
-  bind.is_null = 0;
+  return bind.buffer;
 }
 
 void mysql_statement::bind_value(MYSQL_BIND &bind, enum_field_types type, const object_base_ptr &value, int index)
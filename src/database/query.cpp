@@ -16,6 +16,7 @@
  */
 
 #include "database/query.hpp"
+#include "database/sql_clause.hpp"
 #include "database/query_create.hpp"
 #include "database/query_insert.hpp"
 #include "database/query_update.hpp"
@@ -68,6 +69,16 @@ query& query::create(const std::string &name, object_atomizable *o)
   return *this;
 }
 
+query& query::create_index(const std::string &table, const std::string &column)
+{
+  throw_invalid(QUERY_CREATE, state);
+
+  sql_.append(std::string("CREATE INDEX ") + table + "_" + column + "_idx ON " + table + " (" + column + ")");
+
+  state = QUERY_CREATE;
+  return *this;
+}
+
 query& query::drop(const prototype_node &node)
 {
   return drop(node.type);
@@ -192,6 +203,17 @@ query& query::where(const condition &c)
   return *this;
 }
 
+query& query::where(const sql_clause &clause)
+{
+  throw_invalid(QUERY_COND_WHERE, state);
+
+  sql_.append(std::string(" WHERE "));
+  clause.apply(sql_);
+
+  state = QUERY_COND_WHERE;
+  return *this;
+}
+
 query& query::and_(const condition &c)
 {
   throw_invalid(QUERY_AND, state);
@@ -226,9 +248,12 @@ query& query::order_by(const std::string &by)
 }
 query& query::limit(int l)
 {
-  std::stringstream limval;
-  limval << " LIMIT(" << l << ")";
-  sql_.append(limval.str());
+  throw_invalid(QUERY_LIMIT, state);
+
+  sql_.append(db_.limit(l));
+
+  state = QUERY_LIMIT;
+
   return *this;
 }
 query& query::group_by(const std::string &fld)
@@ -365,6 +390,36 @@ void query::throw_invalid(query::state_t next, query::state_t current) const
         throw std::logic_error(msg.str());
       }
       break;
+    case query::QUERY_ORDERBY:
+    case query::QUERY_GROUPBY:
+      if (current != query::QUERY_SELECT &&
+          current != query::QUERY_COLUMN &&
+          current != query::QUERY_OBJECT_SELECT &&
+          current != query::QUERY_WHERE &&
+          current != query::QUERY_COND_WHERE &&
+          current != query::QUERY_AND &&
+          current != query::QUERY_OR &&
+          current != query::QUERY_GROUPBY)
+      {
+        msg << "invalid next state: [" << next << "] (current: " << current << ")";
+        throw std::logic_error(msg.str());
+      }
+      break;
+    case query::QUERY_LIMIT:
+      if (current != query::QUERY_SELECT &&
+          current != query::QUERY_COLUMN &&
+          current != query::QUERY_OBJECT_SELECT &&
+          current != query::QUERY_WHERE &&
+          current != query::QUERY_COND_WHERE &&
+          current != query::QUERY_AND &&
+          current != query::QUERY_OR &&
+          current != query::QUERY_ORDERBY &&
+          current != query::QUERY_GROUPBY)
+      {
+        msg << "invalid next state: [" << next << "] (current: " << current << ")";
+        throw std::logic_error(msg.str());
+      }
+      break;
     case query::QUERY_SET:
       if (current != query::QUERY_UPDATE &&
           current != query::QUERY_SET)
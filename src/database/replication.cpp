@@ -0,0 +1,419 @@
+/*
+ * This file is part of OpenObjectStore OOS.
+ *
+ * OpenObjectStore OOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenObjectStore OOS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenObjectStore OOS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "database/replication.hpp"
+#include "database/database_exception.hpp"
+#include "database/action.hpp"
+
+#include "object/object.hpp"
+#include "object/object_store.hpp"
+#include "object/object_proxy.hpp"
+
+#include <cstring>
+
+namespace oos {
+
+/// @cond OOS_DEV
+
+namespace {
+
+/*
+ * a batch starts with the magic number,
+ * the sequence number and the length of
+ * its records
+ */
+const unsigned int BATCH_MAGIC = 0x4f4f5352;
+const std::size_t BATCH_HEADER = 4 + 8 + 4;
+
+enum record_op {
+  insert_record = 1,
+  update_record,
+  delete_record
+};
+
+struct batch_header
+{
+  unsigned int magic;
+  unsigned long long sequence;
+  unsigned int size;
+};
+
+struct record
+{
+  unsigned char op;
+  std::string type;
+  long id;
+  const char *image;
+  unsigned int size;
+};
+
+void write_header(char *buf, const batch_header &header)
+{
+  std::memcpy(buf, &header.magic, 4);
+  std::memcpy(buf + 4, &header.sequence, 8);
+  std::memcpy(buf + 12, &header.size, 4);
+}
+
+void read_header(const char *buf, batch_header &header)
+{
+  std::memcpy(&header.magic, buf, 4);
+  std::memcpy(&header.sequence, buf + 4, 8);
+  std::memcpy(&header.size, buf + 12, 4);
+  if (header.magic != BATCH_MAGIC) {
+    throw database_exception("replication", "invalid batch header");
+  }
+}
+
+/*
+ * reads the fields of a record
+ * from a complete batch
+ */
+class record_reader
+{
+public:
+  record_reader(const char *first, const char *last)
+    : pos_(first)
+    , last_(last)
+  {}
+
+  bool done() const { return pos_ == last_; }
+
+  const char* take(std::size_t size)
+  {
+    if ((std::size_t)(last_ - pos_) < size) {
+      throw database_exception("replication", "truncated record");
+    }
+    const char *p = pos_;
+    pos_ += size;
+    return p;
+  }
+
+  template < class T >
+  T read()
+  {
+    T val;
+    std::memcpy(&val, take(sizeof(T)), sizeof(T));
+    return val;
+  }
+
+private:
+  const char *pos_;
+  const char *last_;
+};
+
+}
+
+/*
+ * appends a record for each
+ * object of the visited actions
+ */
+class record_writer : public action_visitor
+{
+public:
+  explicit record_writer(replication_writer &writer)
+    : writer_(writer)
+  {}
+  virtual ~record_writer() {}
+
+  virtual void visit(create_action *) {}
+
+  // the type is taken from the action, snapshots
+  // of asynchronous commits aren't in a store
+  virtual void visit(insert_action *a)
+  {
+    std::string type(a->type());
+    for (insert_action::const_iterator i = a->begin(); i != a->end(); ++i) {
+      writer_.append_record(insert_record, type.c_str(), (*i)->id(), *i);
+    }
+  }
+
+  virtual void visit(update_action *a)
+  {
+    std::string type(a->type());
+    writer_.append_record(update_record, type.c_str(), a->obj()->id(), a->obj());
+  }
+
+  virtual void visit(delete_action *a)
+  {
+    writer_.append_record(delete_record, a->classname(), a->id(), 0);
+  }
+
+  virtual void visit(drop_action *) {}
+
+private:
+  replication_writer &writer_;
+};
+
+/// @endcond
+
+replication_writer::replication_writer(const std::string &path)
+  : file_(std::fopen(path.c_str(), "a+b"))
+  , owner_(true)
+  , broken_(false)
+  , sequence_(0)
+{
+  if (!file_) {
+    throw database_exception("replication", "couldn't open log file");
+  }
+  try {
+    resume();
+  } catch (...) {
+    std::fclose(file_);
+    throw;
+  }
+}
+
+replication_writer::replication_writer(std::FILE *file)
+  : file_(file)
+  , owner_(false)
+  , broken_(false)
+  , sequence_(0)
+{}
+
+replication_writer::~replication_writer()
+{
+  if (owner_) {
+    std::fclose(file_);
+  }
+}
+
+unsigned long long replication_writer::write(const action_list_t &actions)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  if (broken_) {
+    // the log ends with a partial batch
+    throw database_exception("replication", "log is broken by a failed batch");
+  }
+
+  payload_.clear();
+  record_writer writer(*this);
+  for (action_list_t::const_iterator i = actions.begin(); i != actions.end(); ++i) {
+    (*i)->accept(&writer);
+  }
+
+  batch_header header;
+  header.magic = BATCH_MAGIC;
+  header.sequence = sequence_ + 1;
+  header.size = (unsigned int)payload_.size();
+
+  char buf[BATCH_HEADER];
+  write_header(buf, header);
+  if (std::fwrite(buf, 1, BATCH_HEADER, file_) != BATCH_HEADER ||
+      payload_.write(file_) != payload_.size() ||
+      std::fflush(file_) != 0)
+  {
+    payload_.clear();
+    broken_ = true;
+    throw database_exception("replication", "couldn't write batch");
+  }
+  payload_.clear();
+  return ++sequence_;
+}
+
+unsigned long long replication_writer::sequence() const
+{
+  return sequence_;
+}
+
+void replication_writer::resume()
+{
+  // continue the sequence of an existing log
+  std::fseek(file_, 0, SEEK_SET);
+  char buf[BATCH_HEADER];
+  std::size_t n = 0;
+  while ((n = std::fread(buf, 1, BATCH_HEADER, file_)) == BATCH_HEADER) {
+    batch_header header;
+    read_header(buf, header);
+    if (std::fseek(file_, header.size, SEEK_CUR) != 0) {
+      break;
+    }
+    sequence_ = header.sequence;
+  }
+  long end = std::ftell(file_);
+  std::fseek(file_, 0, SEEK_END);
+  if (n != 0 || end != std::ftell(file_)) {
+    // appending would corrupt the log
+    throw database_exception("replication", "log ends with an incomplete batch");
+  }
+}
+
+void replication_writer::append(const void *bytes, std::size_t size)
+{
+  payload_.append(bytes, size);
+}
+
+void replication_writer::append_record(unsigned char op, const char *type, long id, const object *o)
+{
+  append(&op, 1);
+  unsigned int len = (unsigned int)std::strlen(type);
+  append(&len, sizeof(len));
+  append(type, len);
+  long long oid = id;
+  append(&oid, sizeof(oid));
+
+  unsigned int size = 0;
+  if (!o) {
+    append(&size, sizeof(size));
+    return;
+  }
+  image_.clear();
+  serializer_.serialize(o, image_);
+  size = (unsigned int)image_.size();
+  append(&size, sizeof(size));
+  // move the image chunk by chunk
+  byte_buffer::view vec[4];
+  while (image_.size() > 0) {
+    byte_buffer::size_type count = image_.views(vec, 4, image_.size());
+    byte_buffer::size_type moved = 0;
+    for (byte_buffer::size_type i = 0; i < count; ++i) {
+      append(vec[i].data, vec[i].size);
+      moved += vec[i].size;
+    }
+    image_.discard(moved);
+  }
+}
+
+replication_follower::replication_follower(object_store &ostore, const std::string &path)
+  : ostore_(ostore)
+  , file_(std::fopen(path.c_str(), "rb"))
+  , owner_(true)
+  , sequence_(0)
+  , applied_(0)
+{
+  if (!file_) {
+    throw database_exception("replication", "couldn't open log file");
+  }
+}
+
+replication_follower::replication_follower(object_store &ostore, std::FILE *file)
+  : ostore_(ostore)
+  , file_(file)
+  , owner_(false)
+  , sequence_(0)
+  , applied_(0)
+{}
+
+replication_follower::~replication_follower()
+{
+  if (owner_) {
+    std::fclose(file_);
+  }
+}
+
+unsigned long replication_follower::poll()
+{
+  // read everything written since the last poll
+  char buf[4096];
+  std::size_t n = 0;
+  while ((n = std::fread(buf, 1, sizeof(buf), file_)) > 0) {
+    pending_.insert(pending_.end(), buf, buf + n);
+    if (n < sizeof(buf)) {
+      break;
+    }
+  }
+  // the leader may append more later
+  std::clearerr(file_);
+
+  unsigned long applied = 0;
+  std::size_t pos = 0;
+  while (pending_.size() - pos >= BATCH_HEADER) {
+    batch_header header;
+    read_header(&pending_[pos], header);
+    if (pending_.size() - pos - BATCH_HEADER < header.size) {
+      // wait for the rest of the batch
+      break;
+    }
+    const char *first = &pending_[pos] + BATCH_HEADER;
+    if (header.sequence > sequence_) {
+      apply(first, first + header.size);
+      sequence_ = header.sequence;
+      applied_ = 0;
+      ++applied;
+    }
+    pos += BATCH_HEADER + header.size;
+  }
+  pending_.erase(pending_.begin(), pending_.begin() + pos);
+  return applied;
+}
+
+unsigned long long replication_follower::sequence() const
+{
+  return sequence_;
+}
+
+void replication_follower::apply(const char *first, const char *last)
+{
+  // read the whole batch before the store is changed
+  std::vector<record> records;
+  record_reader reader(first, last);
+  while (!reader.done()) {
+    record rec;
+    rec.op = reader.read<unsigned char>();
+    if (rec.op < insert_record || rec.op > delete_record) {
+      throw database_exception("replication", "invalid record");
+    }
+    unsigned int len = reader.read<unsigned int>();
+    rec.type.assign(reader.take(len), len);
+    rec.id = (long)reader.read<long long>();
+    rec.size = reader.read<unsigned int>();
+    rec.image = reader.take(rec.size);
+    records.push_back(rec);
+  }
+
+  object_store::write_lock_t lock(ostore_.write_lock());
+
+  // continue after the records applied by a failed call
+  for (; applied_ < records.size(); ++applied_) {
+    unsigned char op = records[applied_].op;
+    const std::string &type = records[applied_].type;
+    long id = records[applied_].id;
+    unsigned int size = records[applied_].size;
+    const char *image = records[applied_].image;
+
+    object_proxy *oproxy = ostore_.find_proxy(id);
+    if (op == delete_record) {
+      if (oproxy && oproxy->obj && oproxy->linked()) {
+        ostore_.remove_object(oproxy->obj, true);
+      }
+      continue;
+    }
+    image_.clear();
+    image_.append(image, size);
+    if (op == update_record && oproxy && oproxy->obj && oproxy->linked()) {
+      // notify before the object changes
+      ostore_.mark_modified(oproxy);
+      serializer_.deserialize(oproxy->obj, image_, &ostore_);
+      ostore_.mark_updated(oproxy);
+    } else {
+      // the same way objects are loaded
+      object *o = ostore_.create(type.c_str());
+      if (!o) {
+        throw database_exception("replication", "unknown object type");
+      }
+      try {
+        serializer_.deserialize(o, image_, &ostore_);
+        ostore_.insert_object(o, true);
+      } catch (...) {
+        delete o;
+        throw;
+      }
+    }
+  }
+}
+
+}
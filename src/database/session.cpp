@@ -22,21 +22,86 @@
 #include "database/action.hpp"
 #include "database/transaction.hpp"
 #include "database/memory_database.hpp"
+#include "database/replication.hpp"
 
 #include "object/object.hpp"
 #include "object/object_store.hpp"
+#include "object/object_serializer.hpp"
 #include "object/prototype_node.hpp"
 
+#include "tools/byte_buffer.hpp"
+
 #include "database/sqlite/sqlite_database.hpp"
 
 #include <stdexcept>
+#include <chrono>
 
 using namespace std;
 
 namespace oos {
 
+/*
+ * copies the actions of a transaction. the
+ * copied actions refer to detached snapshots
+ * of the objects, so they can be written while
+ * the objects are changed again
+ */
+class snapshot_visitor : public action_visitor
+{
+public:
+  snapshot_visitor(object_store &ostore, commit_pipeline::action_list_t &actions, commit_pipeline::object_list_t &objects)
+    : ostore_(ostore)
+    , actions_(actions)
+    , objects_(objects)
+  {}
+  virtual ~snapshot_visitor() {}
+
+  virtual void visit(create_action *) {}
+
+  virtual void visit(insert_action *a)
+  {
+    insert_action *copy = new insert_action(a->type());
+    actions_.push_back(copy);
+    for (insert_action::const_iterator i = a->begin(); i != a->end(); ++i) {
+      copy->push_back(snapshot(*i));
+    }
+  }
+
+  virtual void visit(update_action *a)
+  {
+    actions_.push_back(new update_action(a->type(), snapshot(a->obj())));
+  }
+
+  virtual void visit(delete_action *a)
+  {
+    actions_.push_back(new delete_action(a->classname(), a->id()));
+  }
+
+  virtual void visit(drop_action *) {}
+
+private:
+  object* snapshot(const object *o)
+  {
+    object *copy = ostore_.create(o->classname());
+    objects_.push_back(copy);
+    buffer_.clear();
+    serializer_.serialize(o, buffer_);
+    serializer_.deserialize(copy, buffer_, NULL);
+    return copy;
+  }
+
+private:
+  object_store &ostore_;
+  commit_pipeline::action_list_t &actions_;
+  commit_pipeline::object_list_t &objects_;
+  object_serializer serializer_;
+  byte_buffer buffer_;
+};
+
 session::session(object_store &ostore, const std::string &dbstring)
-  : ostore_(ostore)
+  : pipeline_(0)
+  , replication_(0)
+  , ostore_(ostore)
 {
   // parse dbstring
   std::string::size_type pos = dbstring.find(':');
@@ -59,6 +124,14 @@ session::session(object_store &ostore, const std::string &dbstring)
 
 session::~session()
 {
+  try {
+    async_commit(false);
+  } catch (...) {
+    // the error can't be reported any more,
+    // flush() before to get it
+  }
+  // waits for the leased readers
+  destroy_readers();
   if (impl_) {
     if (type_ == "memory") {
       delete impl_;
@@ -70,7 +143,13 @@ session::~session()
 
 void session::open()
 {
+  db_lock_t lock(db_lock());
   impl_->open(connection_);
+
+  const std::vector<database*> &readers = readers_.connections();
+  for (std::vector<database*>::const_iterator i = readers.begin(); i != readers.end(); ++i) {
+    (*i)->open_reader(connection_);
+  }
 }
 
 bool session::is_open() const
@@ -80,24 +159,49 @@ bool session::is_open() const
 
 void session::create()
 {
+  db_lock_t lock(db_lock());
   impl_->create();
 }
 
 void session::drop()
 {
+  flush();
+  db_lock_t lock(db_lock());
   impl_->drop();
 }
 
 void session::close()
 {
+  flush();
+  db_lock_t lock(db_lock());
+  const std::vector<database*> &readers = readers_.connections();
+  for (std::vector<database*>::const_iterator i = readers.begin(); i != readers.end(); ++i) {
+    (*i)->close();
+  }
+
   impl_->close();
 }
 
 bool session::load()
 {
+  flush();
+  db_lock_t lock(db_lock());
   // load sequencer
   impl_->seq()->load();
 
+  if (readers_.empty()) {
+    load(*impl_);
+  } else {
+    // load all tables via one reader
+    connection_pool::lease reader(readers_);
+    reader->copy_settings(*impl_);
+    load(*reader);
+  }
+  return true;
+}
+
+void session::load(database &db)
+{
   prototype_iterator first = ostore_.begin();
   prototype_iterator last = ostore_.end();
   while (first != last) {
@@ -105,18 +209,20 @@ bool session::load()
     if (node.abstract) {
       continue;
     }
-    impl_->load(node);
+    db.load(node);
   }
-  return true;
 }
 
 result* session::execute(const std::string &sql)
 {
+  flush();
+  db_lock_t lock(db_lock());
   return impl_->execute(sql);
 }
 
 void session::update(const object_base_ptr &optr)
 {
+  db_lock_t lock(db_lock());
   impl_->update(optr.ptr());
 }
 
@@ -144,19 +250,41 @@ const object_store& session::ostore() const
 
 void session::push_transaction(transaction *tr)
 {
-  if (!transaction_stack_.empty()) {
-    ostore_.unregister_observer(transaction_stack_.top());
-  }
   transaction_stack_.push(tr);
+  // a read only transaction only observes the
+  // store to reject changes if it stands alone
+  if (tr->mode() == transaction::read_only) {
+    if (observer_stack_.empty()) {
+      ostore_.register_observer(tr);
+    }
+    return;
+  }
+  if (!observer_stack_.empty()) {
+    ostore_.unregister_observer(observer_stack_.top());
+  }
+  observer_stack_.push(tr);
   ostore_.register_observer(tr);
+  // modified fields are recorded unless nothing is backed up
+  ostore_.undo(tr->mode() == transaction::insert_only ? 0 : &tr->undo_log_);
 }
 
 void session::pop_transaction()
 {
-  ostore_.unregister_observer(transaction_stack_.top());
+  transaction *tr = transaction_stack_.top();
   transaction_stack_.pop();
-  if (!transaction_stack_.empty()) {
-    ostore_.register_observer(transaction_stack_.top());
+  if (tr->mode() == transaction::read_only) {
+    if (observer_stack_.empty()) {
+      ostore_.unregister_observer(tr);
+    }
+    return;
+  }
+  ostore_.unregister_observer(tr);
+  observer_stack_.pop();
+  ostore_.undo(0);
+  if (!observer_stack_.empty()) {
+    tr = observer_stack_.top();
+    ostore_.register_observer(tr);
+    ostore_.undo(tr->mode() == transaction::insert_only ? 0 : &tr->undo_log_);
   }
 }
 
@@ -165,28 +293,262 @@ object* session::load(const std::string &/*type*/, int /*id*/)
   return 0;
 }
 
+void session::load(const prototype_node &node, const sql_clause &clause)
+{
+  flush();
+  db_lock_t lock(db_lock());
+  if (readers_.empty()) {
+    load(*impl_, node, clause);
+  } else {
+    connection_pool::lease reader(readers_);
+    reader->copy_settings(*impl_);
+    load(*reader, node, clause);
+  }
+}
+
+void session::load(database &db, const prototype_node &node, const sql_clause &clause)
+{
+  if (clause.empty()) {
+    db.load(node);
+  } else {
+    db.load(node, clause);
+  }
+}
+
+void session::reader_pool_size(unsigned int size)
+{
+  if (type_ == "memory") {
+    throw std::logic_error("session: memory database has no readers");
+  }
+
+  destroy_readers();
+
+  database_factory &df = database_factory::instance();
+  for (unsigned int i = 0; i < size; ++i) {
+    database *reader = df.create(type_, this);
+    if (impl_->is_open()) {
+      try {
+        reader->open_reader(connection_);
+      } catch (...) {
+        df.destroy(type_, reader);
+        throw;
+      }
+    }
+    readers_.add(reader);
+  }
+}
+
+connection_pool& session::readers()
+{
+  return readers_;
+}
+
+void session::destroy_readers()
+{
+  std::vector<database*> readers(readers_.connections());
+  readers_.clear();
+  for (std::vector<database*>::iterator i = readers.begin(); i != readers.end(); ++i) {
+    (*i)->close();
+    database_factory::instance().destroy(type_, *i);
+  }
+}
+
+void session::async_commit(bool enable, unsigned int max_batch)
+{
+  std::exception_ptr error;
+  if (pipeline_) {
+    // writes all pending commits
+    try {
+      flush();
+    } catch (...) {
+      error = std::current_exception();
+    }
+    delete pipeline_;
+    pipeline_ = 0;
+  }
+  if (enable) {
+    pipeline_ = new commit_pipeline(*impl_, db_mutex_, max_batch);
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+bool session::async_commit() const
+{
+  return pipeline_ != 0;
+}
+
+void session::flush()
+{
+  if (pipeline_) {
+    publish_versions(true);
+    pipeline_->flush();
+  }
+  if (replication_error_) {
+    std::exception_ptr error = replication_error_;
+    replication_error_ = std::exception_ptr();
+    std::rethrow_exception(error);
+  }
+}
+
+const commit_pipeline* session::pipeline() const
+{
+  return pipeline_;
+}
+
+void session::replicate(replication_writer *writer)
+{
+  // pending commits ship to the previous writer
+  flush();
+  replication_ = writer;
+}
+
+replication_writer* session::replication() const
+{
+  return replication_;
+}
+
 void session::begin(transaction &tr)
 {
   push_transaction(&tr);
+  if (tr.mode() == transaction::read_only) {
+    // nothing to back up
+    return;
+  }
+  db_lock_t lock(db_lock());
   impl_->prepare();
 }
 
-void session::commit(transaction &tr)
+commit_pipeline::future_type session::commit(transaction &tr)
 {
-  impl_->begin();
+  if (tr.mode() == transaction::read_only) {
+    std::promise<void> written;
+    written.set_value();
+    return written.get_future().share();
+  }
+  if (pipeline_) {
+    publish_versions(false);
+    // snapshot the changes and hand them to the writer,
+    // the versions are published once they are written
+    version_batch *versions = ostore_.stage_versions();
+    commit_pipeline::action_list_t actions;
+    commit_pipeline::object_list_t objects;
+    snapshot_visitor sv(ostore_, actions, objects);
+    try {
+      transaction::const_iterator first = tr.action_list_.begin();
+      transaction::const_iterator last = tr.action_list_.end();
+      while (first != last) {
+        (*first++)->accept(&sv);
+      }
+    } catch (...) {
+      for (commit_pipeline::action_list_t::iterator i = actions.begin(); i != actions.end(); ++i) {
+        delete *i;
+      }
+      for (commit_pipeline::object_list_t::iterator i = objects.begin(); i != objects.end(); ++i) {
+        delete *i;
+      }
+      ostore_.discard_versions(versions);
+      throw;
+    }
+    // the writer ships the snapshots once they are committed
+    commit_pipeline::future_type written;
+    try {
+      written = pipeline_->push(actions, objects, replication_);
+    } catch (...) {
+      // an earlier batch failed
+      for (commit_pipeline::action_list_t::iterator i = actions.begin(); i != actions.end(); ++i) {
+        delete *i;
+      }
+      for (commit_pipeline::object_list_t::iterator i = objects.begin(); i != objects.end(); ++i) {
+        delete *i;
+      }
+      ostore_.discard_versions(versions);
+      throw;
+    }
+    if (versions) {
+      staged_.push_back(std::make_pair(written, versions));
+    }
+    return written;
+  }
 
-  transaction::const_iterator first = tr.action_list_.begin();
-  transaction::const_iterator last = tr.action_list_.end();
-  while (first != last) {
-    (*first++)->accept(impl_);
+  try {
+    impl_->begin();
+
+    transaction::const_iterator first = tr.action_list_.begin();
+    transaction::const_iterator last = tr.action_list_.end();
+    while (first != last) {
+      (*first++)->accept(impl_);
+    }
+
+    impl_->commit();
+  } catch (...) {
+    if (ostore_.versioning()) {
+      // readers keep seeing the committed state
+      ostore_.discard_versions();
+    }
+    throw;
+  }
+
+  if (ostore_.versioning()) {
+    // readers see the committed changes
+    ostore_.commit_versions();
+  }
+
+  if (replication_) {
+    // the transaction is committed even if shipping fails
+    try {
+      replication_->write(tr.action_list_);
+    } catch (...) {
+      replication_error_ = std::current_exception();
+    }
   }
 
-  impl_->commit();
+  std::promise<void> written;
+  written.set_value();
+  return written.get_future().share();
 }
 
 void session::rollback()
 {
+  db_lock_t lock(db_lock());
   impl_->rollback();
+  if (ostore_.versioning()) {
+    // the restored objects equal their committed versions
+    ostore_.discard_versions();
+  }
+}
+
+void session::publish_versions(bool wait)
+{
+  // in commit order, a failed commit is never published
+  while (!staged_.empty()) {
+    commit_pipeline::future_type &written = staged_.front().first;
+    if (!wait && written.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+      return;
+    }
+    bool committed = true;
+    try {
+      written.get();
+    } catch (...) {
+      committed = false;
+    }
+    if (committed) {
+      ostore_.commit_versions(staged_.front().second);
+    } else {
+      ostore_.discard_versions(staged_.front().second);
+    }
+    staged_.pop_front();
+  }
+}
+
+session::db_lock_t session::db_lock()
+{
+  if (pipeline_) {
+    return db_lock_t(db_mutex_);
+  } else {
+    return db_lock_t(db_mutex_, std::defer_lock);
+  }
 }
 
 statement* session::create_statement() const
@@ -0,0 +1,90 @@
+/*
+ * This file is part of OpenObjectStore OOS.
+ *
+ * OpenObjectStore OOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenObjectStore OOS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenObjectStore OOS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "database/sql_clause.hpp"
+#include "database/sql.hpp"
+
+namespace oos {
+
+sql_clause::sql_clause()
+{}
+
+sql_clause::sql_clause(const std::string &str)
+{
+  append(str);
+}
+
+sql_clause::~sql_clause()
+{}
+
+void sql_clause::append(const std::string &str)
+{
+  parts_.push_back(part(str));
+}
+
+std::string sql_clause::str() const
+{
+  std::string str;
+  for (std::vector<part>::const_iterator i = parts_.begin(); i != parts_.end(); ++i) {
+    if (i->param) {
+      str += "?";
+    } else {
+      str += i->text;
+    }
+  }
+  return str;
+}
+
+std::size_t sql_clause::size() const
+{
+  std::size_t count = 0;
+  for (std::vector<part>::const_iterator i = parts_.begin(); i != parts_.end(); ++i) {
+    if (i->param) {
+      ++count;
+    }
+  }
+  return count;
+}
+
+bool sql_clause::empty() const
+{
+  return parts_.empty();
+}
+
+void sql_clause::apply(sql &s) const
+{
+  for (std::vector<part>::const_iterator i = parts_.begin(); i != parts_.end(); ++i) {
+    if (i->param) {
+      s.append(i->param->column.c_str(), i->param->type, "?");
+    } else {
+      s.append(i->text);
+    }
+  }
+}
+
+int sql_clause::bind(statement &stmt) const
+{
+  int index = 0;
+  for (std::vector<part>::const_iterator i = parts_.begin(); i != parts_.end(); ++i) {
+    if (i->param) {
+      index = i->param->bind(stmt, index);
+    }
+  }
+  return index;
+}
+
+}
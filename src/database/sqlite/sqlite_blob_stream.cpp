@@ -0,0 +1,73 @@
+/*
+ * This file is part of OpenObjectStore OOS.
+ *
+ * OpenObjectStore OOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenObjectStore OOS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenObjectStore OOS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "database/sqlite/sqlite_blob_stream.hpp"
+#include "database/sqlite/sqlite_database.hpp"
+#include "database/sqlite/sqlite_exception.hpp"
+
+#include <sqlite3.h>
+
+namespace oos {
+
+namespace sqlite {
+
+void throw_error(int ec, sqlite3 *db, const std::string &source);
+
+sqlite_blob_stream::sqlite_blob_stream(sqlite_database &db, const std::string &table, const std::string &column, long id, bool writable)
+  : db_(db)
+  , blob_(0)
+{
+  int ret = sqlite3_blob_open(db_(), "main", table.c_str(), column.c_str(), id, (writable ? 1 : 0), &blob_);
+  if (ret != SQLITE_OK) {
+    // the handle must be closed even on failure
+    sqlite3_blob_close(blob_);
+    blob_ = 0;
+  }
+  throw_error(ret, db_(), "sqlite3_blob_open");
+}
+
+sqlite_blob_stream::~sqlite_blob_stream()
+{
+  sqlite3_blob_close(blob_);
+}
+
+sqlite_blob_stream::size_type sqlite_blob_stream::size() const
+{
+  return sqlite3_blob_bytes(blob_);
+}
+
+void sqlite_blob_stream::read(size_type offset, char *buf, size_type size)
+{
+  int ret = sqlite3_blob_read(blob_, buf, (int)size, (int)offset);
+  throw_error(ret, db_(), "sqlite3_blob_read");
+}
+
+void sqlite_blob_stream::write(size_type offset, const char *buf, size_type size)
+{
+  int ret = sqlite3_blob_write(blob_, buf, (int)size, (int)offset);
+  throw_error(ret, db_(), "sqlite3_blob_write");
+}
+
+void sqlite_blob_stream::reopen(long id)
+{
+  int ret = sqlite3_blob_reopen(blob_, id);
+  throw_error(ret, db_(), "sqlite3_blob_reopen");
+}
+
+}
+
+}
@@ -20,6 +20,7 @@
 #include "database/sqlite/sqlite_result.hpp"
 #include "database/sqlite/sqlite_types.hpp"
 #include "database/sqlite/sqlite_exception.hpp"
+#include "database/sqlite/sqlite_blob_stream.hpp"
 
 #include "database/session.hpp"
 #include "database/transaction.hpp"
@@ -30,6 +31,7 @@
 #include <stdexcept>
 #include <sqlite3.h>
 #include <sstream>
+#include <cstdlib>
 
 #ifdef WIN32
 #include <functional>
@@ -65,12 +67,106 @@ sqlite_database::~sqlite_database()
 }
 
 
-void sqlite_database::on_open(const std::string &db)
+void sqlite_database::on_open(const std::string &connection)
 {
+  // parse file[?key=value[&key=value]]
+  std::string::size_type pos = connection.find('?');
+  std::string db = connection.substr(0, pos);
+
   int ret = sqlite3_open(db.c_str(), &sqlite_db_);
   if (ret != SQLITE_OK) {
     throw sqlite_exception("couldn't open database: " + db);
   }
+
+  if (pos == std::string::npos) {
+    return;
+  }
+
+  std::string options = connection.substr(pos + 1);
+  try {
+    std::string::size_type first = 0;
+    while (first < options.size()) {
+      std::string::size_type last = options.find('&', first);
+      std::string option = options.substr(first, last == std::string::npos ? std::string::npos : last - first);
+      std::string::size_type eq = option.find('=');
+      if (eq == std::string::npos) {
+        throw sqlite_exception("invalid option: " + option);
+      }
+      apply_option(option.substr(0, eq), option.substr(eq + 1));
+      if (last == std::string::npos) {
+        break;
+      }
+      first = last + 1;
+    }
+  } catch (...) {
+    sqlite3_close(sqlite_db_);
+    sqlite_db_ = 0;
+    throw;
+  }
+}
+
+const char* sqlite_database::keyword(const std::string &key, const std::string &value, const char **keywords)
+{
+  // only known keywords become part of the pragma
+  for (; *keywords; ++keywords) {
+    if (value == *keywords) {
+      return *keywords;
+    }
+  }
+  throw sqlite_exception("invalid value for option " + key + ": " + value);
+}
+
+void sqlite_database::apply_option(const std::string &key, const std::string &value)
+{
+  char *end = 0;
+  long long number = strtoll(value.c_str(), &end, 10);
+  bool is_number = !value.empty() && end != value.c_str();
+
+  static const char *journal_modes[] = { "delete", "truncate", "persist", "memory", "wal", "off", 0 };
+  static const char *sync_modes[] = { "off", "normal", "full", "extra", 0 };
+
+  std::stringstream pragma;
+  if (key == "journal") {
+    pragma << "PRAGMA journal_mode=" << keyword(key, value, journal_modes) << ";";
+  } else if (key == "sync") {
+    pragma << "PRAGMA synchronous=" << keyword(key, value, sync_modes) << ";";
+  } else if (key == "cache" && is_number && *end == '\0') {
+    pragma << "PRAGMA cache_size=" << number << ";";
+  } else if (key == "mmap" && is_number) {
+    // allow size suffixes
+    switch (*end) {
+      case 'G':
+      case 'g':
+        number *= 1024;
+        // fall through
+      case 'M':
+      case 'm':
+        number *= 1024;
+        // fall through
+      case 'K':
+      case 'k':
+        number *= 1024;
+        ++end;
+        break;
+      default:
+        break;
+    }
+    if (*end != '\0') {
+      throw sqlite_exception("invalid value for option " + key + ": " + value);
+    }
+    pragma << "PRAGMA mmap_size=" << number << ";";
+  } else if (key == "busy" && is_number && *end == '\0') {
+    int ret = sqlite3_busy_timeout(sqlite_db_, (int)number);
+    throw_error(ret, sqlite_db_, "sqlite3_busy_timeout");
+    return;
+  } else if (key == "cache" || key == "mmap" || key == "busy") {
+    throw sqlite_exception("invalid value for option " + key + ": " + value);
+  } else {
+    throw sqlite_exception("unknown option: " + key);
+  }
+
+  result *res = on_execute(pragma.str());
+  delete res;
 }
 
 bool sqlite_database::is_open() const
@@ -132,6 +228,55 @@ void sqlite_database::on_rollback()
   delete res;
 }
 
+std::string sqlite_database::on_explain(const std::string &sql)
+{
+  std::string stmt("EXPLAIN QUERY PLAN " + sql);
+  sqlite3_stmt *explain = 0;
+  int ret = sqlite3_prepare_v2(sqlite_db_, stmt.c_str(), stmt.size(), &explain, 0);
+  throw_error(ret, sqlite_db_, "sqlite3_prepare_v2");
+
+  std::string plan;
+  while (sqlite3_step(explain) == SQLITE_ROW) {
+    // the last column holds the plan detail
+    const unsigned char *detail = sqlite3_column_text(explain, sqlite3_column_count(explain) - 1);
+    if (!plan.empty()) {
+      plan += "\n";
+    }
+    if (detail) {
+      plan += reinterpret_cast<const char*>(detail);
+    }
+  }
+  sqlite3_finalize(explain);
+  return plan;
+}
+
+blob_stream* sqlite_database::on_open_blob(const std::string &table, const std::string &column, long id, bool writable)
+{
+  return new sqlite_blob_stream(*this, table, column, id, writable);
+}
+
+void sqlite_database::on_reserve_blob(const std::string &table, const std::string &column, long id, unsigned long size)
+{
+  std::stringstream sql;
+  sql << "UPDATE " << quote_identifier(table) << " SET " << quote_identifier(column) << "=zeroblob(" << size << ") WHERE id=" << id << ";";
+  result *res = on_execute(sql.str());
+  delete res;
+}
+
+std::string sqlite_database::quote_identifier(const std::string &name)
+{
+  // a quoted identifier can't end the statement
+  std::string quoted("\"");
+  for (std::string::size_type i = 0; i < name.size(); ++i) {
+    if (name[i] == '"') {
+      quoted += '"';
+    }
+    quoted += name[i];
+  }
+  quoted += '"';
+  return quoted;
+}
+
 int sqlite_database::parse_result(void* param, int column_count, char** values, char** /*columns*/)
 {
   sqlite_result *result = static_cast<sqlite_result*>(param);
@@ -184,6 +329,8 @@ const char* sqlite_database::type_string(data_type_t type) const
       return "VARCHAR";
     case type_text:
       return "TEXT";
+    case type_blob:
+      return "BLOB";
     default:
       {
         std::stringstream msg;
@@ -64,7 +64,10 @@ result* sqlite_statement::execute()
 {
   // get next row
   int ret = sqlite3_step(stmt_);
-  
+  if (ret != SQLITE_ROW && ret != SQLITE_DONE) {
+    throw_error(ret, db_(), "sqlite3_step", str());
+  }
+
   return new sqlite_prepared_result(stmt_, ret);
 }
 
@@ -94,8 +97,9 @@ void sqlite_statement::clear()
   if (!stmt_) {
     return;
   }
-  int ret = sqlite3_finalize(stmt_);
-  throw_error(ret, db_(), "sqlite3_finalize");
+  // finalize returns the error of a failed step
+  // again, execute() has already thrown it
+  sqlite3_finalize(stmt_);
   stmt_ = 0;
   return;
 }
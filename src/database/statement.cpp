@@ -16,6 +16,7 @@
  */
 
 #include "database/statement.hpp"
+#include "database/result.hpp"
 
 #include "object/object_atomizable.hpp"
 
@@ -32,6 +33,14 @@ namespace oos {
 statement::~statement()
 {}
 
+void statement::add_batch()
+{
+  delete execute();
+}
+
+void statement::execute_batch()
+{}
+
 int statement::bind(object_atomizable *o)
 {
   reset();
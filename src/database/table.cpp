@@ -17,6 +17,7 @@
 
 #include "database/table.hpp"
 #include "database/database.hpp"
+#include "database/sql_clause.hpp"
 #include "database/result.hpp"
 #include "database/query.hpp"
 #include "database/condition.hpp"
@@ -25,6 +26,8 @@
 #include "object/object_store.hpp"
 #include "object/prototype_node.hpp"
 
+#include <cstring>
+
 namespace oos {
 
 class relation_filler : public generic_object_reader<relation_filler>
@@ -82,6 +85,123 @@ private:
   object *object_;
 };
 
+/*
+ * collects the names of all columns
+ * holding a reference to another object
+ */
+class reference_column_collector : public generic_object_writer<reference_column_collector>
+{
+public:
+  reference_column_collector(std::set<std::string> &columns)
+    : generic_object_writer<reference_column_collector>(this)
+    , columns_(columns)
+  {}
+  virtual ~reference_column_collector() {}
+
+  template < class T >
+  void write_value(const char*, const T&) {}
+
+  void write_value(const char*, const char*, int) {}
+
+  void write_value(const char *id, const object_base_ptr &)
+  {
+    columns_.insert(id);
+  }
+
+private:
+  std::set<std::string> &columns_;
+};
+
+/*
+ * finds the column of an item referencing
+ * the given container type and checks
+ * whether the item has an index column.
+ * the container reference of a join table
+ * item is typed with the container base
+ * class, so it is found by its name
+ */
+class relation_column_finder : public generic_object_writer<relation_column_finder>
+{
+public:
+  relation_column_finder(object_store &ostore, const std::string &type)
+    : generic_object_writer<relation_column_finder>(this)
+    , ostore_(ostore)
+    , type_(type)
+    , has_index_(false)
+  {}
+  virtual ~relation_column_finder() {}
+
+  template < class T >
+  void write_value(const char *id, const T&)
+  {
+    if (strcmp(id, "item_index") == 0) {
+      has_index_ = true;
+    }
+  }
+
+  void write_value(const char*, const char*, int) {}
+
+  void write_value(const char *id, const object_base_ptr &x)
+  {
+    if (!column_.empty()) {
+      return;
+    }
+    prototype_iterator node = ostore_.find_prototype(x.type());
+    if (node != ostore_.end() && node->type == type_) {
+      column_ = id;
+    } else if (node == ostore_.end() && strcmp(id, "container") == 0) {
+      column_ = id;
+    }
+  }
+
+  const std::string& column() const { return column_; }
+  bool has_index() const { return has_index_; }
+
+private:
+  object_store &ostore_;
+  std::string type_;
+  std::string column_;
+  bool has_index_;
+};
+
+/*
+ * locates the object container
+ * identified by the given field
+ */
+class container_locator : public generic_object_reader<container_locator>
+{
+public:
+  container_locator(const std::string &field)
+    : generic_object_reader<container_locator>(this)
+    , field_(field)
+    , container_(0)
+  {}
+  virtual ~container_locator() {}
+
+  object_container* locate(object *o)
+  {
+    container_ = 0;
+    o->deserialize(*this);
+    return container_;
+  }
+
+  template < class T >
+  void read_value(const char*, T&) {}
+
+  void read_value(const char*, char*, int) {}
+
+  void read_value(const char *id, object_container &x)
+  {
+    if (field_ == id) {
+      container_ = &x;
+    }
+  }
+
+private:
+  std::string field_;
+  object_container *container_;
+};
+
 table::table(database &db, const prototype_node &node)
   : generic_object_reader<table>(this)
   , db_(db)
@@ -91,10 +211,14 @@ table::table(database &db, const prototype_node &node)
   , update_(0)
   , delete_(0)
   , select_(0)
+  , select_batch_size_(0)
+  , loaded_batches_(0)
   , object_(0)
   , ostore_(0)
   , prepared_(false)
   , is_loaded_(false)
+  , loaded_by_relation_(false)
+  , relation_id_(0)
 {}
 
 table::~table()
@@ -120,12 +244,32 @@ void table::prepare()
   insert_ = q.insert(o, node_.type).prepare();
   update_ = q.reset().update(node_.type, o).where(cond("id").equal(0)).prepare();
   delete_ = q.reset().remove(node_).where(cond("id").equal(0)).prepare();
-  select_ = q.reset().select(node_).prepare();
   delete o;
 
+  prepare_select();
+
   prepared_ = true;
 }
 
+void table::prepare_select()
+{
+  delete select_;
+
+  select_batch_size_ = db_.batch_size();
+
+  query q(db_);
+  if (select_batch_size_ > 0) {
+    /*
+     * load the table in chunks ordered by id
+     * each chunk continues after the last
+     * loaded id (keyset pagination)
+     */
+    select_ = q.select(node_).where(cond("id").greater(0)).order_by("id").limit(select_batch_size_).prepare();
+  } else {
+    select_ = q.select(node_).prepare();
+  }
+}
+
 void table::create()
 {
   query q(db_);
@@ -134,61 +278,173 @@ void table::create()
   
   delete res;
 
+  /*
+   * create an index for each reference
+   * column and each column declared
+   * in the prototype
+   */
+  std::set<std::string> columns(node_.indexes);
+  object *o = node_.producer->create();
+  reference_column_collector collector(columns);
+  o->serialize(collector);
+  delete o;
+
+  std::set<std::string>::const_iterator first = columns.begin();
+  std::set<std::string>::const_iterator last = columns.end();
+  while (first != last) {
+    res = q.reset().create_index(node_.type, *first++).execute();
+    delete res;
+  }
+
   // prepare CRUD statements
   prepare();
 }
 
 void table::load(object_store &ostore)
 {
+  if (loaded_by_relation_) {
+    // table was already loaded eager with its container
+    loaded_by_relation_ = false;
+    return;
+  }
+
   if (!prepared_) {
     prepare();
   }
 
+  if (select_batch_size_ != db_.batch_size()) {
+    prepare_select();
+  }
+
   ostore_ = &ostore;
 
-  // check result  
-  // create object
-  result *res(select_->execute());
+  long last_id = 0;
+  unsigned long rows = 0;
+  loaded_batches_ = 0;
+  do {
+    if (select_batch_size_ > 0) {
+      select_->reset();
+      select_->bind(0, last_id);
+    }
+    // check result  
+    // create object
+    result *res(select_->execute());
+    rows = read(res, last_id);
+    delete res;
+    ++loaded_batches_;
+    // a full chunk means there may be more rows
+  } while (select_batch_size_ > 0 && rows == select_batch_size_);
+  
+  ostore_ = 0;
+
+  fill_relations();
+
+  is_loaded_ = true;
+
+  load_eager_relations(ostore);
+}
+
+void table::load(object_store &ostore, const sql_clause &clause)
+{
+  if (!prepared_) {
+    prepare();
+  }
+
+  ostore_ = &ostore;
+
+  query q(db_);
+  statement *stmt = q.select(node_).where(clause).prepare();
+  clause.bind(*stmt);
+  result *res(stmt->execute());
+  long last_id = 0;
+  read(res, last_id);
+  delete res;
+  delete stmt;
+
+  ostore_ = 0;
+
+  /*
+   * only a part of the table was
+   * loaded, so the table isn't
+   * marked as loaded
+   */
+  fill_relations();
+}
+
+void table::load_relation(object_store &ostore, const prototype_node &parent, const std::string &field)
+{
+  if (!prepared_) {
+    prepare();
+  }
+
+  object *o = node_.producer->create();
+  relation_column_finder finder(ostore, parent.type);
+  o->serialize(finder);
+  delete o;
+
+  if (finder.column().empty()) {
+    // no column references the container
+    load(ostore);
+    loaded_by_relation_ = true;
+    return;
+  }
+
+  /*
+   * select all items ordered by their
+   * container so that each container is
+   * filled in one pass
+   */
+  std::string order(finder.column());
+  order += (finder.has_index() ? ", item_index" : ", id");
+
+  query q(db_);
+  statement *stmt = q.select(node_).order_by(order).prepare();
+  result *res(stmt->execute());
+
+  ostore_ = &ostore;
+  relation_column_ = finder.column();
+
+  long container_id = 0;
+  object_container *container = 0;
+  container_locator locator(field);
+
   object_ = node_.producer->create();
   column_ = 0;
   while (res->fetch(object_)) {
-  
+    relation_id_ = 0;
+
     object_->deserialize(*this);
 
-    ostore.insert(object_);
+    ostore_->insert(object_);
+
+    if (relation_id_ != container_id) {
+      // next container
+      container_id = relation_id_;
+      object_proxy *proxy = ostore_->find_proxy(container_id);
+      container = (proxy && proxy->obj ? locator.locate(proxy->obj) : 0);
+    }
+    if (container) {
+      container->append_proxy(object_->proxy_);
+    }
 
     column_ = 0;
-    
     object_ = node_.producer->create();
   }
   delete object_;
-  delete res;
-  
+  object_ = 0;
+
+  relation_column_.clear();
   ostore_ = 0;
 
-  /*
-   * after all tables were loaded fill
-   * all object containers appearing
-   * in certain object types
-   */
-  prototype_node::field_prototype_map_t::const_iterator first = node_.relations.begin();
-  prototype_node::field_prototype_map_t::const_iterator last = node_.relations.end();
-  while (first != last) {
-    database::table_map_t::iterator i = db().table_map_.find(first->first);
-    if (i == db().table_map_.end()) {
-//      throw std::out_of_range("unknown key");
-    } else {
-      database::table_ptr tbl = i->second;
-      if (tbl->is_loaded()) {
-        relation_filler filler(tbl);
-        filler.fill();
-      }
-    }
+  delete res;
+  delete stmt;
 
-    ++first;
-  }
+  fill_relations();
 
   is_loaded_ = true;
+  loaded_by_relation_ = true;
+
+  load_eager_relations(ostore);
 }
 
 void table::insert(object *obj)
@@ -199,6 +455,16 @@ void table::insert(object *obj)
   delete res;
 }
 
+void table::insert(object_list_t::const_iterator first, object_list_t::const_iterator last)
+{
+  // send the objects in batches if the backend supports it
+  while (first != last) {
+    insert_->bind(*first++);
+    insert_->add_batch();
+  }
+  insert_->execute_batch();
+}
+
 void table::update(object *obj)
 {
   int pos = update_->bind(obj);
@@ -235,12 +501,94 @@ bool table::is_loaded() const
   return is_loaded_;
 }
 
+unsigned long table::loaded_batches() const
+{
+  return loaded_batches_;
+}
+
 const prototype_node& table::node() const
 {
   return node_;
 }
 
-void table::read_value(const char *, object_base_ptr &x)
+unsigned long table::read(result *res, long &last_id)
+{
+  unsigned long rows = 0;
+  object_ = node_.producer->create();
+  column_ = 0;
+  while (res->fetch(object_)) {
+
+    last_id = object_->id();
+    column_ = 0;
+    ++rows;
+
+    object_proxy *oproxy = ostore_->find_proxy(last_id);
+    if (oproxy && oproxy->obj) {
+      /*
+       * the object is already loaded, inserting
+       * would replace it and drop its changes
+       */
+      continue;
+    }
+
+    object_->deserialize(*this);
+
+    ostore_->insert(object_);
+
+    object_ = node_.producer->create();
+  }
+  delete object_;
+  object_ = 0;
+  return rows;
+}
+
+void table::fill_relations()
+{
+  /*
+   * after all tables were loaded fill
+   * all object containers appearing
+   * in certain object types
+   */
+  prototype_node::field_prototype_map_t::const_iterator first = node_.relations.begin();
+  prototype_node::field_prototype_map_t::const_iterator last = node_.relations.end();
+  while (first != last) {
+    database::table_map_t::iterator i = db().table_map_.find(first->first);
+    if (i == db().table_map_.end()) {
+//      throw std::out_of_range("unknown key");
+    } else {
+      database::table_ptr tbl = i->second;
+      if (tbl->is_loaded()) {
+        relation_filler filler(tbl);
+        filler.fill();
+      }
+    }
+
+    ++first;
+  }
+}
+
+void table::load_eager_relations(object_store &ostore)
+{
+  /*
+   * load the items of all relations
+   * of this table marked as eager
+   */
+  prototype_iterator first = ostore.begin();
+  prototype_iterator last = ostore.end();
+  while (first != last) {
+    const prototype_node &node = (*first++);
+    prototype_node::field_prototype_map_t::const_iterator i = node.relations.find(node_.type);
+    if (i == node.relations.end() || db_.fetch_strategy(node_.type, i->second.second) != database::FETCH_EAGER) {
+      continue;
+    }
+    database::table_map_t::iterator j = db_.table_map_.find(node.type);
+    if (j != db_.table_map_.end() && !j->second->is_loaded()) {
+      j->second->load_relation(ostore, node_, i->second.second);
+    }
+  }
+}
+
+void table::read_value(const char *id, object_base_ptr &x)
 {
   long oid = x.id();
   
@@ -248,6 +596,20 @@ void table::read_value(const char *, object_base_ptr &x)
     return;
   }
 
+  if (!relation_column_.empty() && relation_column_ == id) {
+    /*
+     * the container is filled directly
+     * while loading the relation eager
+     */
+    relation_id_ = oid;
+    object_proxy *oproxy = ostore_->find_proxy(oid);
+    if (!oproxy) {
+      oproxy = ostore_->create_proxy(oid);
+    }
+    x.reset(oproxy->obj);
+    return;
+  }
+
   /*
    * find object proxy with given id
    */
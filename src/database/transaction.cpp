@@ -21,10 +21,9 @@
 #include "database/database.hpp"
 #include "database/database_exception.hpp"
 
-#include "tools/byte_buffer.hpp"
-
 #include "object/object_store.hpp"
 #include "object/object.hpp"
+#include "object/object_exception.hpp"
 
 using namespace std;
 
@@ -40,6 +39,10 @@ void transaction::on_insert(object *o)
    * store
    * 
    *****************/
+  if (mode_ == read_only) {
+    reject("insert");
+    return;
+  }
   id_iterator_map_t::iterator i = id_map_.find(o->id());
   if (i == id_map_.end()) {
     // create insert action and insert object
@@ -49,6 +52,7 @@ void transaction::on_insert(object *o)
       // should not happen
     } else {
       id_map_.insert(std::make_pair(o->id(), j));
+      undo_log_.push_insert(o->id());
     }
   } else {
     // ERROR: an object with that id already exists
@@ -65,8 +69,17 @@ void transaction::on_update(object *o)
    * is restored to old values
    * 
    *****************/
+  if (mode_ != read_write) {
+    reject("modify");
+    return;
+  }
+  if (!undo_log_.recorded(o->id())) {
+    // modified without object::modify(),
+    // keep an image of the whole object
+    undo_log_.push_image(o);
+  }
   if (id_map_.find(o->id()) == id_map_.end()) {
-    backup(new update_action(o), o);
+    append(new update_action(o), o);
   } else {
     // An object with that id already exists
     // do nothing because the object is already
@@ -84,26 +97,38 @@ void transaction::on_delete(object *o)
    * object store
    * 
    *****************/
+  if (mode_ != read_write) {
+    reject("delete");
+    return;
+  }
 
   id_iterator_map_t::iterator i = id_map_.find(o->id());
   if (i == id_map_.end()) {
-    backup(new delete_action(o->classname(), o->id()), o);
+    backup(o);
+    append(new delete_action(o->classname(), o->id()), o);
   } else {
     action_remover ar(action_list_);
-    ar.remove(i->second, o);
+    if (ar.remove(i->second, o)) {
+      // the object existed before the transaction
+      backup(o);
+    } else {
+      // the insert action may be gone
+      id_map_.erase(i);
+    }
   }
 }
 
-transaction::transaction(session &db)
+transaction::transaction(session &db, mode_t mode)
   : db_(db)
   , id_(0)
+  , mode_(mode)
 {}
 
 transaction::~transaction()
 {
 }
 
-long transaction::id_counter = 0;
+std::atomic<long> transaction::id_counter(0);
 
 long
 transaction::id() const
@@ -111,6 +136,12 @@ transaction::id() const
   return id_;
 }
 
+transaction::mode_t
+transaction::mode() const
+{
+  return mode_;
+}
+
 void
 transaction::begin()
 {
@@ -127,16 +158,17 @@ transaction::begin()
   db_.begin(*this);
 }
 
-void
+commit_pipeline::future_type
 transaction::commit()
 {
   if (!db_.current_transaction() || db_.current_transaction() != this) {
     throw database_exception("transaction", "transaction isn't current transaction");
   } else {
     // commit all transaction actions
-    db_.commit(*this);
+    commit_pipeline::future_type written = db_.commit(*this);
     // clear actions
     cleanup();
+    return written;
   }
 }
 
@@ -149,20 +181,18 @@ transaction::rollback()
     /**************
      *
      * rollback transaction
-     * restore objects
+     * restore objects in reverse
+     * order of their changes
      * and finally pop transaction
      * clear insert action map
      *
      **************/
 
-    while (!action_list_.empty()) {
-      iterator i = action_list_.begin();
-      std::auto_ptr<action> a(*i);
-      action_list_.erase(i);
-      restore(a.get());
-    }
+    undo_log_.rollback(db_.ostore());
 
-    db_.rollback();
+    if (mode_ != read_only) {
+      db_.rollback();
+    }
 
     // clear container
     cleanup();
@@ -182,24 +212,29 @@ transaction::db() const
 }
 
 void
-transaction::backup(action *a, const object *o)
+transaction::append(action *a, const object *o)
 {
-  /*************
-   * 
-   * try to find object with
-   * id in action map
-   * 
-   *************/
-  backup_visitor bv;
-  bv.backup(a, o, &object_buffer_);
   iterator i = action_list_.insert(action_list_.end(), a);
   id_map_.insert(std::make_pair(o->id(), i));
 }
 
-void transaction::restore(action *a)
+void transaction::backup(const object *o)
 {
-  restore_visitor rv;
-  rv.restore(a, &object_buffer_, &db_.ostore());
+  undo_log_.push_removal(o);
+}
+
+void transaction::reject(const char *change) const
+{
+  // a read only transaction only sees changes
+  // if there is no enclosing transaction
+  if (db_.current_transaction() == this) {
+    std::string msg("transaction: ");
+    msg += (mode_ == read_only ? "read only" : "insert only");
+    msg += " transaction can't ";
+    msg += change;
+    msg += " objects";
+    throw object_exception(msg.c_str());
+  }
 }
 
 void transaction::cleanup()
@@ -210,7 +245,7 @@ void transaction::cleanup()
     action_list_.pop_front();
   }
 
-  object_buffer_.clear();
+  undo_log_.clear();
   id_map_.clear();
   db_.pop_transaction();
 }
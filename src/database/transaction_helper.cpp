@@ -22,79 +22,6 @@
 
 namespace oos {
 
-bool backup_visitor::backup(action *act, const object *o, byte_buffer *buffer)
-{
-  buffer_ = buffer;
-  object_ = o;
-  act->accept(this);
-  object_ = 0;
-  buffer_ = NULL;
-  return true;
-}
-
-void backup_visitor::visit(insert_action *)
-{
-  // nothing to do
-}
-
-void backup_visitor::visit(update_action*)
-{
-  // serialize object
-  serializer_.serialize(object_, *buffer_);
-}
-
-void backup_visitor::visit(delete_action*)
-{
-  // serialize object
-  serializer_.serialize(object_, *buffer_);
-}
-
-bool restore_visitor::restore(action *act, byte_buffer *buffer, object_store *ostore)
-{
-  ostore_ = ostore;
-  buffer_ = buffer;
-  act->accept(this);
-  buffer_ = NULL;
-  ostore_ = NULL;
-  return true;
-}
-
-void restore_visitor::visit(insert_action *a)
-{
-  // remove object from object store
-  for (insert_action::iterator i = a->begin(); i != a->end(); ++i) {
-    ostore_->remove_object(*i, false);
-  }
-}
-
-void restore_visitor::visit(update_action *a)
-{
-  // deserialize data from buffer into object
-  serializer_.deserialize(a->obj(), *buffer_, ostore_);
-}
-
-void restore_visitor::visit(delete_action *a)
-{
-  // check if there is an object with id in
-  // object store
-  object_proxy *oproxy = ostore_->find_proxy(a->id());
-  if (!oproxy) {
-    // create proxy
-    oproxy = ostore_->create_proxy(a->id());
-  }
-  if (!oproxy->obj) {
-    // create object with id and deserialize
-    oproxy->obj = ostore_->create(a->classname());
-    // data from buffer into object
-    serializer_.deserialize(oproxy->obj, *buffer_, ostore_);
-    // insert object
-    ostore_->insert_object(oproxy->obj, false);
-  } else {
-    // data from buffer into object
-    serializer_.deserialize(oproxy->obj, *buffer_, ostore_);
-  }
-}
-
 transaction::iterator action_inserter::insert(object *o)
 {
   obj_ = o;
@@ -143,10 +70,12 @@ void action_inserter::visit(delete_action *)
 bool action_remover::remove(transaction::iterator i, object *o)
 {
   obj_ = o;
+  id_ = o->id();
   iter_ = i;
+  replaced_ = false;
   (*i)->accept(this);
   obj_ = 0;
-  return true;
+  return replaced_;
 }
 
 void action_remover::visit(insert_action *a)
@@ -182,6 +111,7 @@ void action_remover::visit(update_action *a)
   if (a->obj()->id() == id_) {
     *iter_ = new delete_action(obj_->classname(), obj_->id());
     delete a;
+    replaced_ = true;
   }
 }
 
@@ -0,0 +1,255 @@
+/*
+ * This file is part of OpenObjectStore OOS.
+ *
+ * OpenObjectStore OOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenObjectStore OOS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenObjectStore OOS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "json/json_object_reader.hpp"
+
+#include "object/object.hpp"
+#include "object/object_store.hpp"
+#include "object/object_ptr.hpp"
+#include "object/object_proxy.hpp"
+#include "object/object_container.hpp"
+#include "object/object_exception.hpp"
+
+#include "tools/varchar.hpp"
+
+#include <stdexcept>
+#include <string.h>
+
+namespace oos {
+
+json_object_reader::json_object_reader(object_store &ostore)
+  : generic_json_parser<json_object_reader>(this)
+  , generic_object_reader<json_object_reader>(this)
+  , ostore_(ostore)
+  , depth_(0)
+  , count_(0)
+{}
+
+json_object_reader::~json_object_reader()
+{}
+
+std::size_t json_object_reader::deserialize(std::istream &in)
+{
+  depth_ = 0;
+  count_ = 0;
+  type_.clear();
+  fields_.clear();
+
+  parse_json(in);
+
+  return count_;
+}
+
+void json_object_reader::on_begin_object()
+{
+  if (depth_ == 0) {
+    depth_ = 1;
+  } else if (depth_ == 2) {
+    // a new object of the current prototype
+    fields_.clear();
+    depth_ = 3;
+  } else {
+    throw std::logic_error("unexpected json object");
+  }
+}
+
+void json_object_reader::on_object_key(const std::string &key)
+{
+  if (depth_ == 1) {
+    type_ = key;
+  } else {
+    key_ = key;
+  }
+}
+
+void json_object_reader::on_end_object()
+{
+  if (depth_ == 3) {
+    read_object();
+  }
+  --depth_;
+}
+
+void json_object_reader::on_begin_array()
+{
+  if (depth_ == 1) {
+    if (ostore_.find_prototype(type_.c_str()) == ostore_.end()) {
+      throw object_exception("couldn't find prototype");
+    }
+    depth_ = 2;
+  } else if (depth_ == 3) {
+    // the ids of a container
+    current_field(array_field).ids.clear();
+    depth_ = 4;
+  } else {
+    throw std::logic_error("unexpected json array");
+  }
+}
+
+void json_object_reader::on_end_array()
+{
+  --depth_;
+}
+
+void json_object_reader::on_string(const std::string &value)
+{
+  current_field(string_field).str = value;
+}
+
+void json_object_reader::on_number(double value)
+{
+  if (depth_ == 4) {
+    fields_[key_].ids.push_back((long)value);
+  } else {
+    current_field(number_field).number = value;
+  }
+}
+
+void json_object_reader::on_bool(bool value)
+{
+  current_field(bool_field).flag = value;
+}
+
+void json_object_reader::on_null()
+{
+  current_field(null_field);
+}
+
+void json_object_reader::read_value(const char *id, bool &x)
+{
+  const field *f = find_field(id);
+  if (f && f->kind == bool_field) {
+    x = f->flag;
+  }
+}
+
+void json_object_reader::read_value(const char *id, char *x, int s)
+{
+  const field *f = find_field(id);
+  if (!f || f->kind != string_field || s <= 0) {
+    return;
+  }
+  std::size_t len = f->str.size() < (std::size_t)s ? f->str.size() : (std::size_t)s - 1;
+  memcpy(x, f->str.c_str(), len);
+  x[len] = '\0';
+}
+
+void json_object_reader::read_value(const char *id, std::string &x)
+{
+  const field *f = find_field(id);
+  if (f && f->kind == string_field) {
+    x = f->str;
+  }
+}
+
+void json_object_reader::read_value(const char *id, varchar_base &x)
+{
+  const field *f = find_field(id);
+  if (f && f->kind == string_field) {
+    x.assign(f->str.c_str(), f->str.size());
+  }
+}
+
+void json_object_reader::read_value(const char *id, object_base_ptr &x)
+{
+  const field *f = find_field(id);
+  if (!f) {
+    return;
+  }
+  long oid = (f->kind == number_field ? (long)f->number : 0);
+  if (oid == 0) {
+    x.reset();
+    return;
+  }
+  object_proxy *oproxy = ostore_.find_proxy(oid);
+  if (!oproxy) {
+    oproxy = ostore_.create_proxy(oid);
+  }
+  /*
+   * the object may not be read yet. the
+   * pointer holds the proxy and sees the
+   * object once it is inserted
+   */
+  if (x.is_reference_) {
+    x = object_ref<object>(oproxy);
+  } else {
+    x = object_ptr<object>(oproxy);
+  }
+}
+
+void json_object_reader::read_value(const char *id, object_container &x)
+{
+  const field *f = find_field(id);
+  if (!f || f->kind != array_field) {
+    return;
+  }
+  x.reset();
+  for (std::vector<long>::const_iterator i = f->ids.begin(); i != f->ids.end(); ++i) {
+    object_proxy *oproxy = ostore_.find_proxy(*i);
+    if (!oproxy) {
+      oproxy = ostore_.create_proxy(*i);
+    }
+    x.append_proxy(oproxy);
+  }
+}
+
+json_object_reader::field& json_object_reader::current_field(field_kind kind)
+{
+  if (depth_ != 3) {
+    throw std::logic_error("unexpected json value");
+  }
+  field &f = fields_[key_];
+  f.kind = kind;
+  return f;
+}
+
+const json_object_reader::field* json_object_reader::find_field(const char *id) const
+{
+  t_field_map::const_iterator i = fields_.find(id);
+  return (i == fields_.end() ? 0 : &i->second);
+}
+
+void json_object_reader::read_object()
+{
+  const field *f = find_field("id");
+  long id = (f && f->kind == number_field ? (long)f->number : 0);
+
+  object_store::write_lock_t lock(ostore_.write_lock());
+
+  object_proxy *oproxy = (id ? ostore_.find_proxy(id) : 0);
+  if (oproxy && oproxy->obj && oproxy->linked()) {
+    // notify before the object changes
+    ostore_.mark_modified(oproxy);
+    oproxy->obj->deserialize(*this);
+    ostore_.mark_updated(oproxy);
+  } else {
+    object *o = ostore_.create(type_.c_str());
+    if (!o) {
+      throw object_exception("unknown object type");
+    }
+    try {
+      o->deserialize(*this);
+      ostore_.insert_object(o, true);
+    } catch (...) {
+      delete o;
+      throw;
+    }
+  }
+  ++count_;
+}
+
+}
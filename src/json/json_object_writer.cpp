@@ -0,0 +1,252 @@
+/*
+ * This file is part of OpenObjectStore OOS.
+ *
+ * OpenObjectStore OOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenObjectStore OOS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenObjectStore OOS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "json/json_object_writer.hpp"
+
+#include "object/object.hpp"
+#include "object/object_store.hpp"
+#include "object/object_ptr.hpp"
+#include "object/object_container.hpp"
+#include "object/object_exception.hpp"
+#include "object/object_proxy.hpp"
+#include "object/prototype_node.hpp"
+
+#include "tools/varchar.hpp"
+
+#include <cmath>
+#include <limits>
+#include <string.h>
+
+using namespace std::tr1::placeholders;
+
+namespace oos {
+
+json_object_writer::json_object_writer(std::ostream &out)
+  : generic_object_writer<json_object_writer>(this)
+  , out_(out)
+  , first_(true)
+{}
+
+json_object_writer::~json_object_writer()
+{}
+
+void json_object_writer::serialize(const object *o)
+{
+  out_ << "{";
+  first_ = true;
+  o->serialize(*this);
+  out_ << "}";
+}
+
+void json_object_writer::serialize(const object_store &ostore)
+{
+  bool first = true;
+  out_ << "{";
+  for (prototype_iterator i = ostore.begin(); i != ostore.end(); ++i) {
+    write_prototype(&*i, first);
+  }
+  out_ << "}\n";
+}
+
+void json_object_writer::serialize(const object_store &ostore, const char *type)
+{
+  prototype_iterator i = ostore.find_prototype(type);
+  if (i == ostore.end()) {
+    throw object_exception("couldn't find prototype");
+  }
+  const prototype_node *node = &*i;
+  bool first = true;
+  out_ << "{";
+  // the prototype and all derived prototypes
+  for (const prototype_node *n = node; n && (n == node || n->is_child_of(node)); n = n->next_node()) {
+    write_prototype(n, first);
+  }
+  out_ << "}\n";
+}
+
+void json_object_writer::write_value(const char *id, char x)
+{
+  write_key(id);
+  out_ << (int)x;
+}
+
+void json_object_writer::write_value(const char *id, unsigned char x)
+{
+  write_key(id);
+  out_ << (unsigned int)x;
+}
+
+void json_object_writer::write_value(const char *id, float x)
+{
+  write_key(id);
+  write_number(x);
+}
+
+void json_object_writer::write_value(const char *id, double x)
+{
+  write_key(id);
+  write_number(x);
+}
+
+void json_object_writer::write_value(const char *id, bool x)
+{
+  write_key(id);
+  out_ << (x ? "true" : "false");
+}
+
+void json_object_writer::write_value(const char *id, const char *x, int s)
+{
+  write_key(id);
+  std::size_t len = 0;
+  while ((int)len < s && x[len] != '\0') {
+    ++len;
+  }
+  write_string(x, len);
+}
+
+void json_object_writer::write_value(const char *id, const std::string &x)
+{
+  write_key(id);
+  write_string(x.c_str(), x.size());
+}
+
+void json_object_writer::write_value(const char *id, const varchar_base &x)
+{
+  write_key(id);
+  write_string(x.c_str(), x.size());
+}
+
+void json_object_writer::write_value(const char *id, const object_base_ptr &x)
+{
+  write_key(id);
+  if (x.id() == 0) {
+    out_ << "null";
+  } else {
+    out_ << x.id();
+  }
+}
+
+void json_object_writer::write_value(const char *id, const object_container &x)
+{
+  write_key(id);
+  out_ << "[";
+  // the items are written with their own prototype
+  first_ = true;
+  x.for_each(std::tr1::bind(&json_object_writer::write_container_item, this, _1));
+  out_ << "]";
+  first_ = false;
+}
+
+void json_object_writer::write_container_item(const object *o)
+{
+  if (!first_) {
+    out_ << ",";
+  }
+  first_ = false;
+  out_ << o->id();
+}
+
+void json_object_writer::write_key(const char *id)
+{
+  if (!first_) {
+    out_ << ",";
+  }
+  first_ = false;
+  write_string(id, strlen(id));
+  out_ << ":";
+}
+
+void json_object_writer::write_string(const char *str, std::size_t len)
+{
+  static const char *hex = "0123456789abcdef";
+
+  out_ << '"';
+  for (std::size_t i = 0; i < len; ++i) {
+    char c = str[i];
+    switch (c) {
+      case '"':
+        out_ << "\\\"";
+        break;
+      case '\\':
+        out_ << "\\\\";
+        break;
+      case '\b':
+        out_ << "\\b";
+        break;
+      case '\f':
+        out_ << "\\f";
+        break;
+      case '\n':
+        out_ << "\\n";
+        break;
+      case '\r':
+        out_ << "\\r";
+        break;
+      case '\t':
+        out_ << "\\t";
+        break;
+      default:
+        if ((unsigned char)c < 0x20) {
+          out_ << "\\u00" << hex[(c >> 4) & 0xf] << hex[c & 0xf];
+        } else {
+          out_ << c;
+        }
+        break;
+    }
+  }
+  out_ << '"';
+}
+
+void json_object_writer::write_number(double x)
+{
+  if (!std::isfinite(x)) {
+    // not representable in json
+    out_ << "null";
+    return;
+  }
+  std::streamsize precision = out_.precision(std::numeric_limits<double>::max_digits10);
+  out_ << x;
+  out_.precision(precision);
+}
+
+void json_object_writer::write_prototype(const prototype_node *node, bool &first)
+{
+  if (node->op_first == 0 || node->op_first->next == node->op_marker) {
+    // no own objects
+    return;
+  }
+  if (!first) {
+    out_ << ",\n";
+  }
+  first = false;
+  write_string(node->type.c_str(), node->type.size());
+  out_ << ":[\n";
+  bool first_object = true;
+  for (const object_proxy *oproxy = node->op_first->next; oproxy != node->op_marker; oproxy = oproxy->next) {
+    if (!oproxy->obj) {
+      continue;
+    }
+    if (!first_object) {
+      out_ << ",\n";
+    }
+    first_object = false;
+    serialize(oproxy->obj);
+  }
+  out_ << "\n]";
+}
+
+}
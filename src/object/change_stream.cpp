@@ -0,0 +1,153 @@
+/*
+ * This file is part of OpenObjectStore OOS.
+ *
+ * OpenObjectStore OOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenObjectStore OOS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenObjectStore OOS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "object/change_stream.hpp"
+#include "object/object.hpp"
+#include "object/object_proxy.hpp"
+#include "object/object_serializer.hpp"
+#include "object/prototype_node.hpp"
+
+#include "tools/byte_buffer.hpp"
+
+namespace oos {
+
+change_stream::change_stream(size_t capacity, bool capture_images)
+  : cells_(0)
+  , mask_(0)
+  , capture_images_(capture_images)
+  , dropped_(0)
+  , head_(0)
+  , tail_(0)
+{
+  size_t size = 2;
+  while (size < capacity) {
+    size <<= 1;
+  }
+  cells_ = new cell[size];
+  for (size_t i = 0; i < size; ++i) {
+    cells_[i].turn.store(i, std::memory_order_relaxed);
+  }
+  mask_ = size - 1;
+}
+
+change_stream::~change_stream()
+{
+  delete [] cells_;
+}
+
+void change_stream::on_insert(object *o)
+{
+  push(o, change_record::insert_op);
+}
+
+void change_stream::on_update(object *)
+{
+  // the record is taken once the new values are assigned
+}
+
+void change_stream::on_updated(object *o)
+{
+  push(o, change_record::update_op);
+}
+
+void change_stream::on_delete(object *o)
+{
+  push(o, change_record::delete_op);
+}
+
+bool change_stream::pop(change_record &rec)
+{
+  size_t pos = tail_.load(std::memory_order_relaxed);
+  for (;;) {
+    cell &c = cells_[pos & mask_];
+    size_t turn = c.turn.load(std::memory_order_acquire);
+    long diff = (long)turn - (long)(pos + 1);
+    if (diff == 0) {
+      if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+        rec.sequence = c.record.sequence;
+        rec.type_id = c.record.type_id;
+        rec.object_id = c.record.object_id;
+        rec.op = c.record.op;
+        rec.image.swap(c.record.image);
+        c.record.image.clear();
+        // free the cell for the producer of the next round
+        c.turn.store(pos + mask_ + 1, std::memory_order_release);
+        return true;
+      }
+    } else if (diff < 0) {
+      // empty
+      return false;
+    } else {
+      pos = tail_.load(std::memory_order_relaxed);
+    }
+  }
+}
+
+size_t change_stream::capacity() const
+{
+  return mask_ + 1;
+}
+
+unsigned long long change_stream::dropped() const
+{
+  return dropped_.load(std::memory_order_relaxed);
+}
+
+bool change_stream::capture_images() const
+{
+  return capture_images_;
+}
+
+void change_stream::push(object *o, change_record::op_t op)
+{
+  size_t pos = head_.load(std::memory_order_relaxed);
+  cell *c = 0;
+  for (;;) {
+    c = &cells_[pos & mask_];
+    size_t turn = c->turn.load(std::memory_order_acquire);
+    long diff = (long)turn - (long)pos;
+    if (diff == 0) {
+      if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {
+      // full, never block the writer
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    } else {
+      pos = head_.load(std::memory_order_relaxed);
+    }
+  }
+
+  // the claimed position numbers the change
+  c->record.sequence = pos + 1;
+  c->record.type_id = (o->proxy_ && o->proxy_->node ? o->proxy_->node->id : 0);
+  c->record.object_id = o->id();
+  c->record.op = op;
+  if (capture_images_) {
+    object_serializer serializer;
+    byte_buffer buffer;
+    serializer.serialize(o, buffer);
+    c->record.image.resize(buffer.size());
+    if (!c->record.image.empty()) {
+      buffer.release(&c->record.image[0], c->record.image.size());
+    }
+  }
+  c->turn.store(pos + 1, std::memory_order_release);
+}
+
+}
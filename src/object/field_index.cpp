@@ -0,0 +1,139 @@
+/*
+ * This file is part of OpenObjectStore OOS.
+ *
+ * OpenObjectStore OOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenObjectStore OOS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenObjectStore OOS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "object/field_index.hpp"
+#include "object/object.hpp"
+#include "object/object_atomizer.hpp"
+
+#include "tools/varchar.hpp"
+
+namespace oos {
+
+namespace {
+
+/*
+ * visits the fields of an object through
+ * deserialize without modifying them and
+ * records name, type and address of each
+ * field
+ */
+class field_collector : public generic_object_reader<field_collector>
+{
+public:
+  field_collector(object *o, size_t object_size, field_index::field_vector_t &fields)
+    : generic_object_reader<field_collector>(this)
+    , base_(reinterpret_cast<char*>(o))
+    , start_(static_cast<char*>(dynamic_cast<void*>(o)))
+    , object_size_(object_size)
+    , fields_(fields)
+  {}
+  virtual ~field_collector() {}
+
+  void read_value(const char *id, char &x) { add(id, field_index::type_char, &x, sizeof(x)); }
+  void read_value(const char *id, float &x) { add(id, field_index::type_float, &x, sizeof(x)); }
+  void read_value(const char *id, double &x) { add(id, field_index::type_double, &x, sizeof(x)); }
+  void read_value(const char *id, short &x) { add(id, field_index::type_short, &x, sizeof(x)); }
+  void read_value(const char *id, int &x) { add(id, field_index::type_int, &x, sizeof(x)); }
+  void read_value(const char *id, long &x) { add(id, field_index::type_long, &x, sizeof(x)); }
+  void read_value(const char *id, unsigned char &x) { add(id, field_index::type_unsigned_char, &x, sizeof(x)); }
+  void read_value(const char *id, unsigned short &x) { add(id, field_index::type_unsigned_short, &x, sizeof(x)); }
+  void read_value(const char *id, unsigned int &x) { add(id, field_index::type_unsigned_int, &x, sizeof(x)); }
+  void read_value(const char *id, unsigned long &x) { add(id, field_index::type_unsigned_long, &x, sizeof(x)); }
+  void read_value(const char *id, bool &x) { add(id, field_index::type_bool, &x, sizeof(x)); }
+  void read_value(const char *id, char *x, int s) { add(id, field_index::type_char_array, x, s); }
+  void read_value(const char *id, std::string &x) { add(id, field_index::type_string, &x, sizeof(x)); }
+  void read_value(const char *id, varchar_base &x) { add(id, field_index::type_varchar, &x, sizeof(x)); }
+  void read_value(const char *id, object_base_ptr &x) { add(id, field_index::type_object_ptr, &x, sizeof(x)); }
+  void read_value(const char *id, object_container &x) { add(id, field_index::type_object_container, &x, 0); }
+
+private:
+  void add(const char *id, field_index::field_type type, void *addr, size_t size)
+  {
+    field_index::field f;
+    f.name = id;
+    f.ordinal = (unsigned int)fields_.size();
+    f.type = type;
+    f.size = (int)size;
+    char *ptr = static_cast<char*>(addr);
+    f.offset = (long)(ptr - base_);
+    // fields outside of the most derived object
+    // (i.e. temporaries) can't be accessed directly
+    f.inside = (ptr >= start_ && (size_t)(ptr - start_) + size <= object_size_);
+    fields_.push_back(f);
+  }
+
+private:
+  char *base_;
+  char *start_;
+  size_t object_size_;
+  field_index::field_vector_t &fields_;
+};
+
+}
+
+field_index::field_index()
+  : built_(false)
+{}
+
+field_index::~field_index()
+{}
+
+void field_index::build(object *o, size_t object_size)
+{
+  std::call_once(once_, &field_index::collect, this, o, object_size);
+}
+
+bool field_index::built() const
+{
+  return built_;
+}
+
+const field_index::field* field_index::find(const std::string &name) const
+{
+  name_map_t::const_iterator i = name_map_.find(name);
+  if (i == name_map_.end()) {
+    return 0;
+  }
+  return &fields_[i->second];
+}
+
+field_index::size_type field_index::size() const
+{
+  return fields_.size();
+}
+
+field_index::const_iterator field_index::begin() const
+{
+  return fields_.begin();
+}
+
+field_index::const_iterator field_index::end() const
+{
+  return fields_.end();
+}
+
+void field_index::collect(object *o, size_t object_size)
+{
+  field_collector collector(o, object_size, fields_);
+  o->deserialize(collector);
+  for (size_type i = 0; i < fields_.size(); ++i) {
+    name_map_.insert(std::make_pair(fields_[i].name, i));
+  }
+  built_ = true;
+}
+
+}
@@ -55,6 +55,33 @@ object_store* object::ostore() const
   return proxy_ ? proxy_->ostore : 0;
 }
 
+const field_index::field* object::find_field(const std::string &name)
+{
+  if (!proxy_ || !proxy_->node || !proxy_->node->producer) {
+    return 0;
+  }
+  field_index &fields = proxy_->node->fields;
+  fields.build(this, proxy_->node->producer->object_size());
+  const field_index::field *f = fields.find(name);
+  return (f && f->addressable() ? f : 0);
+}
+
+undo_log* object::undo(const void *attr, std::size_t size, std::ptrdiff_t &offset) const
+{
+  if (!proxy_ || !proxy_->ostore || !proxy_->ostore->undo()) {
+    return 0;
+  }
+  if (!proxy_->node || !proxy_->node->producer) {
+    return 0;
+  }
+  offset = static_cast<const char*>(attr) - reinterpret_cast<const char*>(this);
+  if (offset < 0 || static_cast<std::size_t>(offset) + size > proxy_->node->producer->object_size()) {
+    // not a field of this object, the transaction keeps an image
+    return 0;
+  }
+  return proxy_->ostore->undo();
+}
+
 void object::mark_modified()
 {
   if (!proxy_ || !proxy_->ostore) {
@@ -64,6 +91,14 @@ void object::mark_modified()
   proxy_->ostore->mark_modified(proxy_);
 }
 
+void object::mark_updated()
+{
+  if (!proxy_ || !proxy_->ostore) {
+    return;
+  }
+  proxy_->ostore->mark_updated(proxy_);
+}
+
 std::ostream& operator <<(std::ostream &os, const object &o)
 {
   os << "object " << typeid(o).name() << " (" << &o << ") [" << o.id_ << "]";
@@ -19,10 +19,48 @@
 #include "object/object.hpp"
 #include "object/object_store.hpp"
 
+#include <atomic>
+#include <mutex>
+
 using namespace std;
 
 namespace oos {
 
+namespace {
+
+/*
+ * in concurrency mode object pointers are
+ * copied by many threads. the pointer set
+ * and the counters of a proxy are guarded
+ * by one of a fixed number of locks
+ */
+const size_t LOCK_COUNT = 64;
+std::mutex proxy_locks[LOCK_COUNT];
+
+class proxy_lock
+{
+public:
+  explicit proxy_lock(const object_proxy *proxy)
+    : mutex_(0)
+  {
+    if (proxy->ostore && proxy->ostore->concurrent()) {
+      mutex_ = &proxy_locks[(reinterpret_cast<size_t>(proxy) / sizeof(object_proxy)) % LOCK_COUNT];
+      mutex_->lock();
+    }
+  }
+  ~proxy_lock()
+  {
+    if (mutex_) {
+      mutex_->unlock();
+    }
+  }
+
+private:
+  std::mutex *mutex_;
+};
+
+}
+
 object_proxy::object_proxy(object_store *os)
   : prev(0)
   , next(0)
@@ -32,6 +70,7 @@ object_proxy::object_proxy(object_store *os)
   , ptr_count(0)
   , ostore(os)
   , node(0)
+  , version(0)
 {}
 
 object_proxy::object_proxy(long i, object_store *os)
@@ -43,6 +82,7 @@ object_proxy::object_proxy(long i, object_store *os)
   , ptr_count(0)
   , ostore(os)
   , node(0)
+  , version(0)
 {}
 
 object_proxy::object_proxy(object *o, object_store *os)
@@ -54,6 +94,7 @@ object_proxy::object_proxy(object *o, object_store *os)
   , ptr_count(0)
   , ostore(os)
   , node(0)
+  , version(0)
 {}
 
 object_proxy::~object_proxy()
@@ -74,29 +115,34 @@ object_proxy::~object_proxy()
 void object_proxy::link(object_proxy *successor)
 {
   // link oproxy before this node
-  prev = successor->prev;
-  next = successor;
-  if (successor->prev) {
-    successor->prev->next = this;
+  object_proxy *predecessor = successor->prev.load(std::memory_order_relaxed);
+  prev.store(predecessor, std::memory_order_relaxed);
+  next.store(successor, std::memory_order_relaxed);
+  // the release stores publish the proxy with its links
+  if (predecessor) {
+    predecessor->next.store(this, std::memory_order_release);
   }
-  successor->prev = this;
+  successor->prev.store(this, std::memory_order_release);
 }
 
 void object_proxy::unlink()
 {
-  if (prev) {
-    prev->next = next;
+  object_proxy *predecessor = prev.load(std::memory_order_relaxed);
+  object_proxy *successor = next.load(std::memory_order_relaxed);
+  if (predecessor) {
+    predecessor->next.store(successor, std::memory_order_release);
   }
-  if (next) {
-    next->prev = prev;
+  if (successor) {
+    successor->prev.store(predecessor, std::memory_order_release);
   }
-  prev = 0;
-  next = 0;
+  prev.store(0, std::memory_order_relaxed);
+  next.store(0, std::memory_order_relaxed);
   node = 0;
 }
 
 void object_proxy::link_ref()
 {
+  proxy_lock lock(this);
   if (obj) {
     ++ref_count;
   }
@@ -104,6 +150,7 @@ void object_proxy::link_ref()
 
 void object_proxy::unlink_ref()
 {
+  proxy_lock lock(this);
   if (obj) {
     --ref_count;
   }
@@ -111,6 +158,7 @@ void object_proxy::unlink_ref()
 
 void object_proxy::link_ptr()
 {
+  proxy_lock lock(this);
   if (obj) {
     ++ptr_count;
   }
@@ -118,11 +166,18 @@ void object_proxy::link_ptr()
 
 void object_proxy::unlink_ptr()
 {
+  proxy_lock lock(this);
   if (obj) {
     --ptr_count;
   }
 }
 
+bool object_proxy::marker() const
+{
+  // objects always get an id before they are linked
+  return id == 0;
+}
+
 bool object_proxy::linked() const
 {
   return node != 0;
@@ -139,11 +194,13 @@ void object_proxy::reset(object *o)
 
 void object_proxy::add(object_base_ptr *ptr)
 {
+  proxy_lock lock(this);
   ptr_set_.insert(ptr);
 }
 
 bool object_proxy::remove(object_base_ptr *ptr)
 {
+  proxy_lock lock(this);
   return ptr_set_.erase(ptr) == 1;
 }
 
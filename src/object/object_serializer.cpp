@@ -22,6 +22,8 @@
 #include "object/object_list.hpp"
 #include "object/object_vector.hpp"
 #include "object/object_container.hpp"
+#include "object/object_exception.hpp"
+#include "object/prototype_node.hpp"
 
 #include "tools/byte_buffer.hpp"
 #include "tools/varchar.hpp"
@@ -39,8 +41,16 @@ object_serializer::~object_serializer()
 bool object_serializer::serialize(const object *o, byte_buffer &buffer)
 {
   buffer_ = &buffer;
+  encoding_ = version_;
+  unsigned char version = (unsigned char)version_;
+  buffer_->append(&version, sizeof(version));
 //  o->write_to(this);
-  o->serialize(*this);
+  // the producer of an inserted object knows its
+  // concrete type and may walk the fields directly
+  const object_base_producer *producer = (o->proxy_ && o->proxy_->node ? o->proxy_->node->producer : 0);
+  if (!producer || !producer->serialize(o, *this)) {
+    o->serialize(*this);
+  }
   buffer_ = NULL;
   return true;
 }
@@ -49,18 +59,35 @@ bool object_serializer::deserialize(object *o, byte_buffer &buffer, object_store
 {
   ostore_ = ostore;
   buffer_ = &buffer;
+  unsigned char version = 0;
+  buffer_->release(&version, sizeof(version));
+  if (version != fixed && version != compact) {
+    buffer_ = NULL;
+    ostore_ = NULL;
+    throw object_exception("object_serializer: unknown encoding");
+  }
+  encoding_ = (version_t)version;
 //  o->read_from(this);
-  o->deserialize(*this);
+  const object_base_producer *producer = (o->proxy_ && o->proxy_->node ? o->proxy_->node->producer : 0);
+  if (!producer || !producer->deserialize(o, *this)) {
+    o->deserialize(*this);
+  }
+  encoding_ = version_;
   buffer_ = NULL;
   ostore_ = NULL;
   return true;
 }
 
+object_serializer::version_t object_serializer::version() const
+{
+  return version_;
+}
+
 void object_serializer::write_value(const char*, const char *c, int s)
 {
   size_t len = s;
   
-  buffer_->append(&len, sizeof(len));
+  write_length(len);
   buffer_->append(c, len);
 }
 
@@ -68,7 +95,7 @@ void object_serializer::write_value(const char*, const std::string &s)
 {
   size_t len = s.size();
   
-  buffer_->append(&len, sizeof(len));
+  write_length(len);
   buffer_->append(s.c_str(), len);
 }
 
@@ -76,16 +103,14 @@ void object_serializer::write_value(const char*, const varchar_base &s)
 {
   size_t len = s.size();
   
-  buffer_->append(&len, sizeof(len));
-  buffer_->append(s.str().c_str(), len);
+  write_length(len);
+  buffer_->append(s.c_str(), len);
 }
 
 void object_serializer::write_value(const char*, const object_base_ptr &x)
 {
   // write type and id into buffer
-  write(0, x.id());
-  write(0, x.type(), strlen(x.type()));
-//  write(0, x.classname(), strlen(x.classname()));
+  write_reference(x.id(), x.proxy_, x.type());
 }
 
 void object_serializer::write_value(const char*, const object_container &x)
@@ -98,30 +123,31 @@ void object_serializer::write_value(const char*, const object_container &x)
 
 void object_serializer::read_value(const char*, char *&c, int )
 {
-  size_t len = 0;
-  buffer_->release(&len, sizeof(len));
+  size_t len = read_length();
   // TODO: check size of buffer
   buffer_->release(c, len);
 }
 
 void object_serializer::read_value(const char*, std::string &s)
 {
-  size_t len = 0;
-  buffer_->release(&len, sizeof(len));
-  char *str = new char[len];
-  buffer_->release(str, len);
-  s.assign(str, len);
-  delete [] str;
+  size_t len = read_length();
+  s.clear();
+  read_string(s, len);
 }
 
 void object_serializer::read_value(const char*, varchar_base &s)
 {
-  size_t len = 0;
-  buffer_->release(&len, sizeof(len));
-  char *str = new char[len];
-  buffer_->release(str, len);
-  s.assign(str, len);
-  delete [] str;
+  size_t len = read_length();
+  byte_buffer::view vec;
+  if (buffer_->views(&vec, 1, len) == 1 && vec.size == len) {
+    // the string is inside one chunk
+    s.assign(vec.data, len);
+    buffer_->discard(len);
+  } else {
+    std::string str;
+    read_string(str, len);
+    s.assign(str.c_str(), len);
+  }
 }
 
 void object_serializer::read_value(const char*, object_base_ptr &x)
@@ -135,12 +161,9 @@ void object_serializer::read_value(const char*, object_base_ptr &x)
    * insert object into object store
    *
    ***************/
-  long id = 0;
-  read(0, id);
-  std::string type;
-  read(0, type);
+  long id = read_reference();
 
-  if (id > 0) {
+  if (id > 0 && ostore_) {
     object_proxy *oproxy = ostore_->find_proxy(id);
     if (!oproxy) {
       oproxy = ostore_->create_proxy(id);
@@ -157,12 +180,17 @@ void object_serializer::read_value(const char*, object_container &x)
   // get count of backuped list item
   object_container::size_type s(0);
   read(0, s);
-  x.reset();
-  string type;
   long id(0);
+  if (!ostore_) {
+    // detached, skip the items
+    for (unsigned int i = 0; i < s; ++i) {
+      read_reference();
+    }
+    return;
+  }
+  x.reset();
   for (unsigned int i = 0; i < s; ++i) {
-    read(0, id);
-    read(0, type);
+    id = read_reference();
     object_proxy *oproxy = ostore_->find_proxy(id);
     if (!oproxy) {
       oproxy = ostore_->create_proxy(id);
@@ -173,8 +201,100 @@ void object_serializer::read_value(const char*, object_container &x)
 
 void object_serializer::write_object_container_item(const object *o)
 {
-  write(0, o->id());
-  write(0, o->classname(), strlen(o->classname()));
+  write_reference(o->id(), o->proxy_, o->classname());
+}
+
+void object_serializer::read_string(std::string &s, size_t len)
+{
+  // append the bytes straight from the chunks
+  s.reserve(s.size() + len);
+  byte_buffer::view vec[4];
+  while (len > 0) {
+    size_t count = buffer_->views(vec, 4, len);
+    if (count == 0) {
+      break;
+    }
+    size_t consumed = 0;
+    for (size_t i = 0; i < count; ++i) {
+      s.append(vec[i].data, vec[i].size);
+      consumed += vec[i].size;
+    }
+    buffer_->discard(consumed);
+    len -= consumed;
+  }
+}
+
+void object_serializer::write_varint(unsigned long long x)
+{
+  unsigned char bytes[10];
+  size_t n = 0;
+  while (x >= 0x80) {
+    bytes[n++] = (unsigned char)(x | 0x80);
+    x >>= 7;
+  }
+  bytes[n++] = (unsigned char)x;
+  buffer_->append(bytes, n);
+}
+
+unsigned long long object_serializer::read_varint()
+{
+  unsigned long long x = 0;
+  unsigned char byte = 0;
+  for (unsigned int shift = 0; shift < 64; shift += 7) {
+    buffer_->release(&byte, 1);
+    x |= (unsigned long long)(byte & 0x7f) << shift;
+    if (!(byte & 0x80)) {
+      break;
+    }
+  }
+  return x;
+}
+
+void object_serializer::write_length(size_t len)
+{
+  if (encoding_ == fixed) {
+    buffer_->append(&len, sizeof(len));
+  } else {
+    write_varint(len);
+  }
+}
+
+size_t object_serializer::read_length()
+{
+  size_t len = 0;
+  if (encoding_ == fixed) {
+    buffer_->release(&len, sizeof(len));
+  } else {
+    len = (size_t)read_varint();
+  }
+  return len;
+}
+
+void object_serializer::write_reference(long id, const object_proxy *proxy, const char *type)
+{
+  write(0, id);
+  if (encoding_ == fixed) {
+    size_t len = (type ? strlen(type) : 0);
+    write_length(len);
+    buffer_->append(type, len);
+  } else {
+    // the prototype id replaces the type name
+    write_varint(proxy && proxy->node ? proxy->node->id : 0);
+  }
+}
+
+long object_serializer::read_reference()
+{
+  long id = 0;
+  read(0, id);
+  if (encoding_ == fixed) {
+    std::string type;
+    read(0, type);
+  } else {
+    // the type isn't needed to resolve the reference
+    read_varint();
+  }
+  return id;
 }
 
 }
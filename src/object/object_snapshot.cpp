@@ -0,0 +1,176 @@
+/*
+ * This file is part of OpenObjectStore OOS.
+ *
+ * OpenObjectStore OOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenObjectStore OOS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenObjectStore OOS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "object/object_snapshot.hpp"
+#include "object/object_store.hpp"
+#include "object/object_proxy.hpp"
+#include "object/prototype_node.hpp"
+
+#include <algorithm>
+
+namespace oos {
+
+object_snapshot::object_snapshot(const std::tr1::shared_ptr<snapshot_keeper> &keeper, object_proxy *first, object_proxy *last)
+  : keeper_(keeper)
+  , preserved_(0)
+  , valid_(true)
+{
+  // record all visible objects
+  for (object_proxy *op = first->next; op && op != last; op = op->next) {
+    if (op->obj) {
+      entries_.push_back(entry(op->obj->id(), op));
+    }
+  }
+  std::sort(entries_.begin(), entries_.end());
+}
+
+object_snapshot::~object_snapshot()
+{
+  keeper_->detach(this);
+  for (std::vector<entry>::iterator i = entries_.begin(); i != entries_.end(); ++i) {
+    if (i->img) {
+      delete i->img->copy;
+      delete i->img;
+    }
+  }
+}
+
+object_snapshot::size_type object_snapshot::size() const
+{
+  return entries_.size();
+}
+
+object_snapshot::size_type object_snapshot::preserved() const
+{
+  return preserved_;
+}
+
+std::mutex& object_snapshot::mutex_of(long id) const
+{
+  return mutexes_[static_cast<unsigned long>(id) % MUTEX_COUNT];
+}
+
+const object_snapshot::entry* object_snapshot::lookup(long id) const
+{
+  std::vector<entry>::const_iterator i = std::lower_bound(entries_.begin(), entries_.end(), entry(id, 0));
+  if (i == entries_.end() || i->id != id) {
+    return 0;
+  }
+  return &*i;
+}
+
+const object* object_snapshot::read(const entry &e) const
+{
+  if (!valid_) {
+    throw object_exception("snapshot invalidated by clearing the object store");
+  }
+  image *img = e.img;
+  if (!img) {
+    // not changed since the snapshot
+    return e.proxy->obj;
+  }
+  if (!img->copy) {
+    // restore the old state once
+    object *copy = img->node->producer->create();
+    object_serializer restorer;
+    restorer.deserialize(copy, img->buffer, 0);
+    img->copy = copy;
+  }
+  return img->copy;
+}
+
+void object_snapshot::preserve(object *o)
+{
+  std::vector<entry>::iterator i = std::lower_bound(entries_.begin(), entries_.end(), entry(o->id(), 0));
+  if (i == entries_.end() || i->id != o->id()) {
+    // inserted after the snapshot
+    return;
+  }
+  // only the writer sets images
+  if (i->img || !valid_ || i->proxy->obj != o) {
+    return;
+  }
+  image *img = new image(i->proxy->node);
+  serializer_.serialize(o, img->buffer);
+
+  // waits only for readers of the same lock
+  std::lock_guard<std::mutex> lock(mutex_of(i->id));
+  i->img = img;
+  ++preserved_;
+}
+
+void object_snapshot::invalidate()
+{
+  for (int i = 0; i < MUTEX_COUNT; ++i) {
+    mutexes_[i].lock();
+  }
+  valid_ = false;
+  for (int i = 0; i < MUTEX_COUNT; ++i) {
+    mutexes_[i].unlock();
+  }
+}
+
+snapshot_keeper::snapshot_keeper()
+  : count_(0)
+{}
+
+void snapshot_keeper::on_update(object *o)
+{
+  if (count_ == 0) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (std::vector<object_snapshot*>::iterator i = snapshots_.begin(); i != snapshots_.end(); ++i) {
+    (*i)->preserve(o);
+  }
+}
+
+void snapshot_keeper::on_delete(object *o)
+{
+  // keep the object before it is gone
+  on_update(o);
+}
+
+void snapshot_keeper::attach(object_snapshot *s)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  snapshots_.push_back(s);
+  ++count_;
+}
+
+void snapshot_keeper::invalidate()
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (std::vector<object_snapshot*>::iterator i = snapshots_.begin(); i != snapshots_.end(); ++i) {
+    (*i)->invalidate();
+  }
+  // nothing to preserve anymore
+  snapshots_.clear();
+  count_ = 0;
+}
+
+void snapshot_keeper::detach(object_snapshot *s)
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<object_snapshot*>::iterator i = std::find(snapshots_.begin(), snapshots_.end(), s);
+  if (i != snapshots_.end()) {
+    snapshots_.erase(i);
+    --count_;
+  }
+}
+
+}
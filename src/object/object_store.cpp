@@ -18,6 +18,8 @@
 #include "object/object.hpp"
 #include "object/object_proxy.hpp"
 #include "object/object_store.hpp"
+#include "object/object_snapshot.hpp"
+#include "object/object_version.hpp"
 #include "object/object_observer.hpp"
 #include "object/object_list.hpp"
 #include "object/object_vector.hpp"
@@ -25,8 +27,11 @@
 #include "object/object_creator.hpp"
 #include "object/object_deleter.hpp"
 #include "object/object_exception.hpp"
+#include "object/object_serializer.hpp"
 #include "object/prototype_node.hpp"
 
+#include "tools/byte_buffer.hpp"
+
 #ifdef WIN32
 #include <functional>
 #include <memory>
@@ -180,27 +185,45 @@ void prototype_iterator::decrement()
 
 object_store::object_store()
   : root_(new prototype_node(new object_producer<object>, "object", true))
-  , first_(new object_proxy(this))
-  , last_(new object_proxy(this))
+  , last_prototype_id_(0)
+  , first_(0)
+  , last_(0)
   , object_deleter_(new object_deleter)
+  , undo_log_(0)
+  , concurrent_(false)
+  , epoch_(0)
+  , sharded_(false)
+  , shard_block_size_(0)
+  , shard_serial_(0)
+  , shard_reserved_(0)
+  , versioning_(false)
+  , committed_(0)
+  , next_ticket_(0)
+  , records_(new version_record(0))
+  , last_record_(records_)
+  , version_count_(0)
 {
+  for (int i = 0; i < 3; ++i) {
+    readers_[i] = 0;
+  }
   prototype_map_.insert(std::make_pair("object", root_));
   typeid_prototype_map_[root_->producer->classname()]["object"] = root_;
-  // set marker for root element
-  root_->op_first = first_;
-  root_->op_marker = last_;
-  root_->op_last = last_;
-  root_->op_first->next = root_->op_last;
-  root_->op_last->prev = root_->op_first;
+  // the markers of the root bound the object list
+  root_->link_markers(0);
+  first_ = root_->op_first;
+  last_ = root_->op_last;
 }
 
 object_store::~object_store()
 {
+  versioning(false);
+  reclaim_proxies(true);
+  sharded(false);
   clear(true);
-  delete last_;
-  delete first_;
+  // deletes the first and last marker
   delete root_;
   delete object_deleter_;
+  delete records_;
 }
 
 prototype_iterator
@@ -259,6 +282,9 @@ object_store::insert_prototype(object_base_producer *producer, const char *type,
     throw object_exception("prototype already inserted");
   }
 
+  // number the prototype, i.e. for compact serialization
+  node->id = ++last_prototype_id_;
+
   // append as child to parent prototype node
   parent_node->insert(node);
   // store prototype in map
@@ -281,6 +307,8 @@ bool object_store::clear_prototype(const char *type, bool recursive)
     //throw new object_exception("couldn't find prototype");
     return false;
   }
+  // the snapshots refer to the deleted objects
+  invalidate_snapshots();
   if (recursive) {
     // clear all objects from child nodes
     // for each child call clear_prototype(child, recursive);
@@ -296,6 +324,16 @@ bool object_store::clear_prototype(const char *type, bool recursive)
   return true;
 }
 
+bool object_store::insert_index(const char *type, const std::string &column)
+{
+  prototype_node *node = get_prototype(type);
+  if (!node) {
+    return false;
+  }
+  node->indexes.insert(column);
+  return true;
+}
+
 bool object_store::remove_prototype(const char *type)
 {
   prototype_node *node = get_prototype(type);
@@ -303,6 +341,8 @@ bool object_store::remove_prototype(const char *type)
     //throw new object_exception("couldn't find prototype");
     return false;
   }
+  // the snapshots refer to the deleted objects
+  invalidate_snapshots();
 
   // remove (and delete) from tree (deletes subsequently all child nodes
   // for each child call remove_prototype(child);
@@ -389,6 +429,11 @@ prototype_iterator object_store::end() const
 
 void object_store::clear(bool full)
 {
+  write_lock_t lock(write_lock());
+  if (versioning_) {
+    drop_versions();
+  }
+  reclaim_proxies(true);
   if (full) {
     // clear objects and prototypes
     while (root_->first->next != root_->last) {
@@ -398,12 +443,33 @@ void object_store::clear(bool full)
     // only delete objects
     clear_prototype(root_->type.c_str(), true);
   }
-  object_map_.clear();
+  for (int i = 0; i < PROXY_MAP_COUNT; ++i) {
+    object_map_[i].proxies.clear();
+  }
+}
+
+object_store::snapshot_ptr object_store::snapshot()
+{
+  write_lock_t lock(write_lock());
+  if (!snapshot_keeper_) {
+    snapshot_keeper_.reset(new snapshot_keeper);
+    register_observer(snapshot_keeper_.get());
+  }
+  object_snapshot *s = new object_snapshot(snapshot_keeper_, first_, last_);
+  snapshot_keeper_->attach(s);
+  return snapshot_ptr(s);
+}
+
+void object_store::invalidate_snapshots()
+{
+  if (snapshot_keeper_) {
+    snapshot_keeper_->invalidate();
+  }
 }
 
 bool object_store::empty() const
 {
-  return first_->next == last_;
+  return root_->empty(false);
 }
 
 int depth(prototype_node *node)
@@ -440,7 +506,7 @@ void object_store::dump_objects(std::ostream &out) const
   while (op) {
     out << "[" << op << "] (";
     if (op->obj) {
-      out << *op->obj << " prev [" << op->prev->obj << "] next [" << op->next->obj << "])\n";
+      out << *op->obj << " prev [" << op->prev.load()->obj << "] next [" << op->next.load()->obj << "])\n";
     } else {
       out << "object 0)\n";
     }
@@ -460,11 +526,21 @@ object* object_store::create(const char *type) const
 
 void object_store::mark_modified(object_proxy *oproxy)
 {
+  // an observer may reject the modification
   std::for_each(observer_list_.begin(), observer_list_.end(), std::tr1::bind(&object_observer::on_update, _1, oproxy->obj));
+  if (versioning_) {
+    pend_version(oproxy);
+  }
+}
+
+void object_store::mark_updated(object_proxy *oproxy)
+{
+  std::for_each(observer_list_.begin(), observer_list_.end(), std::tr1::bind(&object_observer::on_updated, _1, oproxy->obj));
 }
 
 void object_store::register_observer(object_observer *observer)
 {
+  write_lock_t lock(write_lock());
   if (std::find(observer_list_.begin(), observer_list_.end(), observer) == observer_list_.end()) {
     observer_list_.push_back(observer);
   }
@@ -472,12 +548,23 @@ void object_store::register_observer(object_observer *observer)
 
 void object_store::unregister_observer(object_observer *observer)
 {
+  write_lock_t lock(write_lock());
   t_observer_list::iterator i = std::find(observer_list_.begin(), observer_list_.end(), observer);
   if (i != observer_list_.end()) {
     observer_list_.erase(i);
   }
 }
 
+void object_store::undo(undo_log *log)
+{
+  undo_log_ = log;
+}
+
+undo_log* object_store::undo() const
+{
+  return undo_log_;
+}
+
 void object_store::insert(object_container &oc)
 {
   oc.install(this);
@@ -491,6 +578,7 @@ object_store::insert_object(object *o, bool notify)
     // throw exception
     return NULL;
   }
+  write_lock_t lock(insert_lock());
   // find prototype node
   prototype_node *node = get_prototype(typeid(*o).name());
   if (!node) {
@@ -501,6 +589,9 @@ object_store::insert_object(object *o, bool notify)
   // retrieve and set new unique number into object
   object_proxy *oproxy = find_proxy(o->id());
   if (oproxy) {
+    // the proxy may be created before the
+    // object is read, i.e. by a pointer to it
+    update_id(o->id());
     if (oproxy->linked()) {
       // an object exists in map.
       // replace it with new object
@@ -516,9 +607,9 @@ object_store::insert_object(object *o, bool notify)
      * nique id
      */
     if (o->id() == 0) {
-      o->id(seq_.next());
+      o->id(next_id(node));
     } else {
-      seq_.update(o->id());
+      update_id(o->id());
     }
     oproxy = create_proxy(o->id());
     if (!oproxy) {
@@ -527,6 +618,9 @@ object_store::insert_object(object *o, bool notify)
     }
     oproxy->obj = o;
   }
+  // set this into persistent object
+  // before the proxy gets visible
+  o->proxy_ = oproxy;
   // insert new element node
   insert_proxy(node, oproxy);
   // create object
@@ -534,14 +628,24 @@ object_store::insert_object(object *o, bool notify)
   o->deserialize(oc);
   // set corresponding prototype node
   oproxy->node = node;
-  // set this into persistent object
-  o->proxy_ = oproxy;
+  if (versioning_) {
+    // visible with the next commit
+    pend_version(oproxy);
+  }
   // notify observer
   if (notify) {
-    std::for_each(observer_list_.begin(), observer_list_.end(), std::tr1::bind(&object_observer::on_insert, _1, o));
+    try {
+      std::for_each(observer_list_.begin(), observer_list_.end(), std::tr1::bind(&object_observer::on_insert, _1, o));
+    } catch (...) {
+      // an observer rejected the object
+      remove_object(o, false);
+      throw;
+    }
   }
   // insert element into hash map for fast lookup
-  object_map_[o->id()] = oproxy;
+  proxy_map &pmap = proxy_map_of(o->id());
+  lock_t map_lock(concurrent_lock(pmap.mutex));
+  pmap.proxies[o->id()] = oproxy;
   // return new object
   return o;
 }
@@ -560,6 +664,7 @@ object_store::remove(object_base_ptr &o)
 void
 object_store::remove(object *o)
 {
+  write_lock_t lock(write_lock());
   // check if object tree is deletable
   if (!object_deleter_->is_deletable(o)) {
     throw object_exception("object is not removable");
@@ -588,28 +693,43 @@ object_store::remove_object(object *o, bool notify)
   if (!node) {
     throw object_exception("couldn't find node for object");
   }
+
+  if (notify) {
+    // notify observer, one may reject the deletion
+    std::for_each(observer_list_.begin(), observer_list_.end(), std::tr1::bind(&object_observer::on_delete, _1, o));
+  }
   
-  if (object_map_.erase(o->id()) != 1) {
-    // couldn't remove object
-    // throw exception
-    throw object_exception("couldn't remove object");
+  {
+    proxy_map &pmap = proxy_map_of(o->id());
+    lock_t map_lock(concurrent_lock(pmap.mutex));
+    if (pmap.proxies.erase(o->id()) != 1) {
+      // couldn't remove object
+      // throw exception
+      throw object_exception("couldn't remove object");
+    }
   }
 
   remove_proxy(node, o->proxy_);
 
-  if (notify) {
-    // notify observer
-    std::for_each(observer_list_.begin(), observer_list_.end(), std::tr1::bind(&object_observer::on_delete, _1, o));
+  if (versioning_) {
+    remove_version(o->proxy_);
   }
+
   // set object in object_proxy to null
   object_proxy *op = o->proxy_;
-  // delete node
-  delete op;
+  if (concurrent_) {
+    // readers may still see the proxy
+    retire_proxy(op);
+  } else {
+    // delete node
+    delete op;
+  }
 }
 
 void
 object_store::remove(object_container &oc)
 {
+  write_lock_t lock(write_lock());
   /**************
    * 
    * remove all objects from container
@@ -638,22 +758,27 @@ void
 object_store::link_proxy(object_proxy *base, object_proxy *prev_proxy)
 {
   // link oproxy before this node
-  prev_proxy->prev = base->prev;
-  prev_proxy->next = base;
-  if (base->prev) {
-    base->prev->next = prev_proxy;
-  }
-  base->prev = prev_proxy;
+  prev_proxy->link(base);
 }
 
 void
 object_store::unlink_proxy(object_proxy *proxy)
 {
-  if (proxy->prev) {
-    proxy->prev->next = proxy->next;
+  object_proxy *predecessor = proxy->prev.load(std::memory_order_relaxed);
+  object_proxy *successor = proxy->next.load(std::memory_order_relaxed);
+  if (predecessor) {
+    predecessor->next.store(successor, std::memory_order_release);
+  }
+  if (successor) {
+    successor->prev.store(predecessor, std::memory_order_release);
   }
-  if (proxy->next) {
-    proxy->next->prev = proxy->prev;
+  if (concurrent_) {
+    /*
+     * a reader may stand on the proxy
+     * so it keeps its links until
+     * it is reclaimed
+     */
+    return;
   }
   proxy->prev = NULL;
   proxy->next = NULL;
@@ -661,8 +786,10 @@ object_store::unlink_proxy(object_proxy *proxy)
 
 object_proxy* object_store::find_proxy(long id) const
 {
-  t_object_proxy_map::const_iterator i = object_map_.find(id);
-  if (i == object_map_.end()) {
+  proxy_map &pmap = proxy_map_of(id);
+  lock_t map_lock(concurrent_lock(pmap.mutex));
+  t_object_proxy_map::const_iterator i = pmap.proxies.find(id);
+  if (i == pmap.proxies.end()) {
     return NULL;
   } else {
     return i->second;
@@ -675,9 +802,11 @@ object_proxy* object_store::create_proxy(long id)
     return NULL;
   }
   
-  t_object_proxy_map::iterator i = object_map_.find(id);
-  if (i == object_map_.end()) {
-    return object_map_.insert(std::make_pair(id, new object_proxy(id, this))).first->second;
+  proxy_map &pmap = proxy_map_of(id);
+  lock_t map_lock(concurrent_lock(pmap.mutex));
+  t_object_proxy_map::iterator i = pmap.proxies.find(id);
+  if (i == pmap.proxies.end()) {
+    return pmap.proxies.insert(std::make_pair(id, new object_proxy(id, this))).first->second;
   } else {
     return 0;
   }
@@ -685,65 +814,42 @@ object_proxy* object_store::create_proxy(long id)
 
 bool object_store::delete_proxy(long id)
 {
-  t_object_proxy_map::iterator i = object_map_.find(id);
-  if (i == object_map_.end()) {
+  proxy_map &pmap = proxy_map_of(id);
+  lock_t map_lock(concurrent_lock(pmap.mutex));
+  t_object_proxy_map::iterator i = pmap.proxies.find(id);
+  if (i == pmap.proxies.end()) {
     return false;
   } else if (i->second->linked()) {
     return false;
   } else {
-    object_map_.erase(i);
+    pmap.proxies.erase(i);
     return true;
   }
 }
 
 void object_store::insert_proxy(prototype_node *node, object_proxy *oproxy)
 {
-  // check count of object in subtree
-  if (node->count >= 2) {
-    /*************
-     *
-     * there are more than two objects (normal case)
-     * insert before last last
-     *
-     *************/
-    oproxy->link(node->op_marker->prev);
-  } else if (node->count == 1) {
-    /*************
-     *
-     * there is one object in subtree
-     * insert as first; adjust "left" marker
-     *
-     *************/
-    oproxy->link(node->op_marker->prev);
-    node->adjust_left_marker(oproxy->next, oproxy);
-  } else /* if (node->count == 0) */ {
-    /*************
-     *
-     * there is no object in subtree
-     * insert as last; adjust "right" marker
-     *
-     *************/
+  lock_t list_lock(concurrent_lock(list_mutex_));
+  // set prototype node before the proxy gets visible
+  oproxy->node = node;
+  object_proxy *last = node->op_marker->prev;
+  if (last == node->op_first) {
+    // first object of the node
     oproxy->link(node->op_marker);
-    node->adjust_left_marker(oproxy->next, oproxy);
-    node->adjust_right_marker(oproxy->prev, oproxy);
+  } else {
+    // keeps the order of the views, the
+    // first object stays the last one
+    oproxy->link(last);
   }
-  // set prototype node
-  oproxy->node = node;
   // adjust size
   ++node->count;
 }
 
 void object_store::remove_proxy(prototype_node *node, object_proxy *oproxy)
 {
-  if (oproxy == node->op_first->next) {
-    // adjust left marker
-    node->adjust_left_marker(node->op_first->next, node->op_first->next->next);
-  }
-  if (oproxy == node->op_marker->prev) {
-    // adjust right marker
-    node->adjust_right_marker(oproxy, node->op_marker->prev->prev);
-  }
-  // unlink object_proxy
+  lock_t list_lock(concurrent_lock(list_mutex_));
+  // a marker is never unlinked, so readers
+  // always find the end of their views
   unlink_proxy(oproxy);
   // adjust object count for node
   --node->count;
@@ -751,7 +857,526 @@ void object_store::remove_proxy(prototype_node *node, object_proxy *oproxy)
 
 sequencer_impl_ptr object_store::exchange_sequencer(const sequencer_impl_ptr &seq)
 {
+  // reserved id blocks belong to the old sequencer
+  for (t_shard_map::iterator i = shard_map_.begin(); i != shard_map_.end(); ++i) {
+    i->second->next_id = 1;
+    i->second->last_id = 0;
+  }
+  shard_reserved_ = 0;
   return seq_.exchange_sequencer(seq);
 }
 
+object_store::read_guard::read_guard(const object_store &ostore)
+  : ostore_(ostore)
+  , epoch_(ostore.enter_epoch())
+{}
+
+object_store::read_guard::~read_guard()
+{
+  ostore_.leave_epoch(epoch_);
+}
+
+void object_store::concurrent(bool enable)
+{
+  if (!enable) {
+    versioning(false);
+    sharded(false);
+    reclaim_proxies(true);
+  }
+  concurrent_ = enable;
+}
+
+bool object_store::concurrent() const
+{
+  return concurrent_;
+}
+
+unsigned long object_store::enter_epoch() const
+{
+  if (!concurrent_) {
+    return 0;
+  }
+  /*
+   * register as reader of the current epoch.
+   * if the epoch advanced meanwhile retry
+   */
+  while (true) {
+    unsigned long epoch = epoch_.load();
+    ++readers_[epoch % 3];
+    if (epoch_.load() == epoch) {
+      return epoch;
+    }
+    --readers_[epoch % 3];
+  }
+}
+
+void object_store::leave_epoch(unsigned long epoch) const
+{
+  if (!concurrent_) {
+    return;
+  }
+  --readers_[epoch % 3];
+}
+
+void object_store::retire_proxy(object_proxy *oproxy)
+{
+  retired_[epoch_.load() % 3].push_back(oproxy);
+  reclaim_proxies(false);
+}
+
+void object_store::reclaim_proxies(bool all)
+{
+  if (all) {
+    // no reader may be active
+    for (int i = 0; i < 3; ++i) {
+      for (std::vector<object_proxy*>::iterator j = retired_[i].begin(); j != retired_[i].end(); ++j) {
+        delete *j;
+      }
+      retired_[i].clear();
+    }
+    return;
+  }
+  /*
+   * advance the epoch if no reader of the
+   * previous epoch is left. then the proxies
+   * retired two epochs ago can't be reached
+   * by any reader
+   */
+  unsigned long epoch = epoch_.load();
+  if (readers_[(epoch + 2) % 3].load() != 0) {
+    return;
+  }
+  std::vector<object_proxy*> &retired = retired_[(epoch + 1) % 3];
+  for (std::vector<object_proxy*>::iterator i = retired.begin(); i != retired.end(); ++i) {
+    delete *i;
+  }
+  retired.clear();
+  epoch_.store(epoch + 1);
+}
+
+object_store::write_lock_t object_store::write_lock() const
+{
+  if (concurrent_) {
+    return write_lock_t(write_mutex_);
+  } else {
+    return write_lock_t(write_mutex_, std::defer_lock);
+  }
+}
+
+object_store::write_lock_t object_store::insert_lock() const
+{
+  if (sharded_) {
+    // inserts only lock the parts they touch
+    return write_lock_t(write_mutex_, std::defer_lock);
+  } else {
+    return write_lock();
+  }
+}
+
+object_store::lock_t object_store::concurrent_lock(std::mutex &m) const
+{
+  if (concurrent_) {
+    return lock_t(m);
+  } else {
+    return lock_t(m, std::defer_lock);
+  }
+}
+
+object_store::proxy_map& object_store::proxy_map_of(long id) const
+{
+  return object_map_[static_cast<unsigned long>(id) % PROXY_MAP_COUNT];
+}
+
+void object_store::sharded(bool enable, long block_size)
+{
+  for (t_shard_map::iterator i = shard_map_.begin(); i != shard_map_.end(); ++i) {
+    delete i->second;
+  }
+  shard_map_.clear();
+  shard_reserved_ = 0;
+  sharded_ = enable;
+  if (!enable) {
+    return;
+  }
+  concurrent(true);
+  shard_block_size_ = block_size > 0 ? block_size : 1;
+  // each direct child of the root is a shard
+  prototype_node *node = root_->first->next;
+  while (node != root_->last) {
+    shard_map_.insert(std::make_pair(node, new shard));
+    node = node->next;
+  }
+}
+
+bool object_store::sharded() const
+{
+  return sharded_;
+}
+
+object_store::read_token::read_token(const object_store &ostore)
+  : ostore_(ostore)
+  , guard_(ostore)
+  , sequence_(0)
+  , ticket_(0)
+{
+  std::lock_guard<std::mutex> lock(ostore_.version_mutex_);
+  sequence_ = ostore_.committed_.load();
+  ticket_ = ostore_.next_ticket_++;
+  ostore_.token_sequences_.insert(sequence_);
+  ostore_.token_tickets_.insert(ticket_);
+}
+
+object_store::read_token::~read_token()
+{
+  std::lock_guard<std::mutex> lock(ostore_.version_mutex_);
+  ostore_.token_sequences_.erase(ostore_.token_sequences_.find(sequence_));
+  ostore_.token_tickets_.erase(ostore_.token_tickets_.find(ticket_));
+}
+
+unsigned long long object_store::read_token::sequence() const
+{
+  return sequence_;
+}
+
+const object* object_store::read_token::find(long id) const
+{
+  object_proxy *oproxy = ostore_.find_proxy(id);
+  const version_record *r = oproxy ? oproxy->version.load(std::memory_order_acquire) : 0;
+  const object *o = r ? r->visible(sequence_) : 0;
+  if (o) {
+    return o;
+  }
+  // the object may be removed after the token was taken
+  std::lock_guard<std::mutex> lock(ostore_.version_mutex_);
+  std::pair<t_record_map::const_iterator, t_record_map::const_iterator> range = ostore_.removed_records_.equal_range(id);
+  for (t_record_map::const_iterator i = range.first; i != range.second; ++i) {
+    o = i->second->visible(sequence_);
+    if (o) {
+      return o;
+    }
+  }
+  return 0;
+}
+
+const version_record* object_store::read_token::first() const
+{
+  return ostore_.records_->next.load(std::memory_order_acquire);
+}
+
+const version_record* object_store::read_token::next(const version_record *r) const
+{
+  return r->next.load(std::memory_order_acquire);
+}
+
+const object* object_store::read_token::visible(const version_record *r) const
+{
+  return r->visible(sequence_);
+}
+
+void object_store::versioning(bool enable)
+{
+  if (enable == versioning_) {
+    return;
+  }
+  if (!enable) {
+    drop_versions();
+    versioning_ = false;
+    return;
+  }
+  concurrent(true);
+  versioning_ = true;
+  // the current state is the first version
+  for (object_proxy *oproxy = first_->next; oproxy != last_; oproxy = oproxy->next) {
+    if (oproxy->obj) {
+      pending_.insert(oproxy);
+    }
+  }
+  commit_versions();
+}
+
+bool object_store::versioning() const
+{
+  return versioning_;
+}
+
+unsigned long long object_store::commit_versions()
+{
+  write_lock_t lock(write_lock());
+  return commit_versions(stage_versions());
+}
+
+version_batch* object_store::stage_versions()
+{
+  write_lock_t lock(write_lock());
+  if (!versioning_) {
+    return 0;
+  }
+  version_batch *batch = new version_batch;
+
+  t_proxy_set pending;
+  {
+    std::lock_guard<std::mutex> vlock(version_mutex_);
+    pending.swap(pending_);
+    batch->removals.swap(pending_removals_);
+  }
+
+  object_serializer serializer;
+  byte_buffer buffer;
+  for (t_proxy_set::iterator i = pending.begin(); i != pending.end(); ++i) {
+    object_proxy *oproxy = *i;
+    if (!oproxy->obj || !oproxy->node) {
+      continue;
+    }
+    // the version is a detached copy of the object
+    object *copy = oproxy->node->producer->create();
+    buffer.clear();
+    serializer.serialize(oproxy->obj, buffer);
+    serializer.deserialize(copy, buffer, 0);
+
+    version_record *r = oproxy->version.load();
+    if (!r) {
+      // tokens skip the record until a version is installed
+      r = new version_record(oproxy->obj->id());
+      r->prev = last_record_;
+      last_record_->next.store(r, std::memory_order_release);
+      last_record_ = r;
+      oproxy->version.store(r, std::memory_order_release);
+    }
+    batch->versions.push_back(std::make_pair(r, copy));
+  }
+  return batch;
+}
+
+unsigned long long object_store::commit_versions(version_batch *batch)
+{
+  write_lock_t lock(write_lock());
+  if (!batch) {
+    return committed_;
+  }
+  unsigned long long seq = committed_ + 1;
+
+  for (version_batch::t_version_vector::iterator i = batch->versions.begin(); i != batch->versions.end(); ++i) {
+    version_record *r = i->first;
+    r->install(seq, i->second);
+    ++version_count_;
+    if (r->count > 1) {
+      versioned_.insert(r);
+    }
+  }
+  // the copies are owned by the records now
+  batch->versions.clear();
+  for (std::vector<version_record*>::iterator i = batch->removals.begin(); i != batch->removals.end(); ++i) {
+    (*i)->removed = seq;
+  }
+  delete batch;
+
+  unsigned long long oldest, ticket;
+  {
+    std::lock_guard<std::mutex> vlock(version_mutex_);
+    committed_ = seq;
+    oldest = token_sequences_.empty() ? seq : *token_sequences_.begin();
+    ticket = token_tickets_.empty() ? next_ticket_ : *token_tickets_.begin();
+  }
+  collect_versions(oldest, ticket);
+  return seq;
+}
+
+unsigned long long object_store::committed_version() const
+{
+  return committed_;
+}
+
+std::size_t object_store::version_count() const
+{
+  return version_count_;
+}
+
+void object_store::discard_versions(version_batch *batch)
+{
+  if (!batch) {
+    return;
+  }
+  write_lock_t lock(write_lock());
+  restore_removals(batch->removals);
+  delete batch;
+}
+
+void object_store::discard_versions()
+{
+  write_lock_t lock(write_lock());
+  std::vector<version_record*> removals;
+  {
+    std::lock_guard<std::mutex> vlock(version_mutex_);
+    pending_.clear();
+    removals.swap(pending_removals_);
+  }
+  restore_removals(removals);
+}
+
+void object_store::restore_removals(std::vector<version_record*> &removals)
+{
+  std::lock_guard<std::mutex> lock(version_mutex_);
+  for (std::vector<version_record*>::iterator i = removals.begin(); i != removals.end(); ++i) {
+    version_record *r = *i;
+    object_proxy *oproxy = find_proxy(r->id);
+    if (!oproxy || !oproxy->obj || oproxy->version.load()) {
+      // still removed, shown with the next commit
+      pending_removals_.push_back(r);
+      continue;
+    }
+    // the object is back, it keeps its versions
+    std::pair<t_record_map::iterator, t_record_map::iterator> range = removed_records_.equal_range(r->id);
+    for (t_record_map::iterator j = range.first; j != range.second; ++j) {
+      if (j->second == r) {
+        removed_records_.erase(j);
+        break;
+      }
+    }
+    oproxy->version.store(r, std::memory_order_release);
+  }
+}
+
+void object_store::pend_version(object_proxy *oproxy)
+{
+  // sharded inserts may run in parallel
+  std::lock_guard<std::mutex> lock(version_mutex_);
+  pending_.insert(oproxy);
+}
+
+void object_store::remove_version(object_proxy *oproxy)
+{
+  std::lock_guard<std::mutex> lock(version_mutex_);
+  pending_.erase(oproxy);
+  version_record *r = oproxy->version.load();
+  if (!r) {
+    return;
+  }
+  // the record stays visible until the removal is committed
+  removed_records_.insert(std::make_pair(r->id, r));
+  pending_removals_.push_back(r);
+  oproxy->version.store(0);
+}
+
+void object_store::collect_versions(unsigned long long oldest, unsigned long long ticket)
+{
+  // drop versions no token can see
+  t_record_set::iterator i = versioned_.begin();
+  while (i != versioned_.end()) {
+    version_record *r = *i;
+    std::size_t count = r->count;
+    r->prune(oldest);
+    version_count_ -= count - r->count;
+    if (r->count <= 1) {
+      i = versioned_.erase(i);
+    } else {
+      ++i;
+    }
+  }
+
+  // unlink records of removals all tokens see
+  {
+    std::lock_guard<std::mutex> lock(version_mutex_);
+    t_record_map::iterator k = removed_records_.begin();
+    while (k != removed_records_.end()) {
+      version_record *r = k->second;
+      if (r->removed > oldest) {
+        ++k;
+        continue;
+      }
+      version_record *next = r->next.load();
+      r->prev->next.store(next, std::memory_order_release);
+      if (next) {
+        next->prev = r->prev;
+      } else {
+        last_record_ = r->prev;
+      }
+      // tokens taken from now on can't reach the record
+      r->retired = next_ticket_;
+      retired_records_.push_back(r);
+      versioned_.erase(r);
+      k = removed_records_.erase(k);
+    }
+  }
+
+  // free unlinked records no token may stand on any more
+  std::vector<version_record*>::iterator j = retired_records_.begin();
+  while (j != retired_records_.end()) {
+    if ((*j)->retired <= ticket) {
+      version_count_ -= (*j)->count;
+      delete *j;
+      j = retired_records_.erase(j);
+    } else {
+      ++j;
+    }
+  }
+}
+
+void object_store::drop_versions()
+{
+  for (object_proxy *oproxy = first_->next; oproxy != last_; oproxy = oproxy->next) {
+    oproxy->version.store(0);
+  }
+  version_record *r = records_->next.load();
+  while (r) {
+    version_record *next = r->next.load();
+    delete r;
+    r = next;
+  }
+  for (std::vector<version_record*>::iterator i = retired_records_.begin(); i != retired_records_.end(); ++i) {
+    delete *i;
+  }
+  records_->next.store(0);
+  last_record_ = records_;
+  retired_records_.clear();
+  removed_records_.clear();
+  versioned_.clear();
+  pending_.clear();
+  pending_removals_.clear();
+  version_count_ = 0;
+}
+
+long object_store::next_id(const prototype_node *node)
+{
+  if (!sharded_) {
+    return seq_.next();
+  }
+  // find the shard of the node
+  while (node->parent && node->parent != root_) {
+    node = node->parent;
+  }
+  t_shard_map::iterator i = shard_map_.find(node);
+  if (i == shard_map_.end()) {
+    lock_t seq_lock(seq_mutex_);
+    return seq_.next();
+  }
+  shard *s = i->second;
+  lock_t shard_lock(s->mutex);
+  while (true) {
+    if (s->serial != shard_serial_.load() || s->next_id > s->last_id) {
+      // reserve a new block of ids
+      lock_t seq_lock(seq_mutex_);
+      s->serial = shard_serial_.load();
+      s->next_id = seq_.current() + 1;
+      s->last_id = seq_.update(seq_.current() + shard_block_size_);
+    }
+    long id = s->next_id++;
+    // update_id may have taken the id meanwhile
+    if (s->serial == shard_serial_.load()) {
+      return id;
+    }
+  }
+}
+
+void object_store::update_id(long id)
+{
+  lock_t seq_lock(concurrent_lock(seq_mutex_));
+  long current = seq_.current();
+  if (sharded_ && id > shard_reserved_ && id <= current) {
+    // the id may lie within a reserved block
+    shard_serial_.store(shard_serial_.load() + 1);
+    shard_reserved_ = current;
+  }
+  seq_.update(id);
+}
+
 }
@@ -0,0 +1,108 @@
+/*
+ * This file is part of OpenObjectStore OOS.
+ *
+ * OpenObjectStore OOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenObjectStore OOS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenObjectStore OOS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "object/object_version.hpp"
+#include "object/object.hpp"
+
+#include <limits>
+
+namespace oos {
+
+object_version::~object_version()
+{
+  delete copy;
+}
+
+version_record::version_record(long i)
+  : id(i)
+  , versions(0)
+  , removed(std::numeric_limits<unsigned long long>::max())
+  , next(0)
+  , prev(0)
+  , retired(0)
+  , count(0)
+{}
+
+version_record::~version_record()
+{
+  object_version *v = versions.load();
+  while (v) {
+    object_version *older = v->next;
+    delete v;
+    v = older;
+  }
+}
+
+const object* version_record::visible(unsigned long long seq) const
+{
+  if (removed.load() <= seq) {
+    return 0;
+  }
+  /*
+   * the first version committed at or before
+   * seq. the walk never goes beyond it, so
+   * older versions may be dropped meanwhile
+   */
+  for (const object_version *v = versions.load(std::memory_order_acquire); v; v = v->next) {
+    if (v->begin <= seq) {
+      return v->copy;
+    }
+  }
+  return 0;
+}
+
+void version_record::install(unsigned long long seq, object *copy)
+{
+  object_version *v = new object_version(seq, copy);
+  v->next = versions.load();
+  versions.store(v, std::memory_order_release);
+  ++count;
+}
+
+void version_record::prune(unsigned long long oldest)
+{
+  object_version *v = versions.load();
+  std::size_t kept = 0;
+  while (v) {
+    ++kept;
+    if (v->begin <= oldest) {
+      break;
+    }
+    v = v->next;
+  }
+  if (!v) {
+    return;
+  }
+  object_version *older = v->next;
+  v->next = 0;
+  count = kept;
+  while (older) {
+    object_version *o = older->next;
+    delete older;
+    older = o;
+  }
+}
+
+version_batch::~version_batch()
+{
+  // copies which weren't installed
+  for (t_version_vector::iterator i = versions.begin(); i != versions.end(); ++i) {
+    delete i->second;
+  }
+}
+
+}
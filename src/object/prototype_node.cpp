@@ -35,6 +35,7 @@ prototype_node::prototype_node()
   , op_last(0)
   , depth(0)
   , count(0)
+  , id(0)
   , abstract(false)
   , initialized(false)
 {
@@ -53,6 +54,7 @@ prototype_node::prototype_node(object_base_producer *p, const char *t, bool a)
   , depth(0)
   , count(0)
   , type(t)
+  , id(0)
   , abstract(a)
   , initialized(false)
 {
@@ -76,6 +78,14 @@ void prototype_node::initialize(object_base_producer *p, const char *t, bool a)
 
 prototype_node::~prototype_node()
 {
+  // the objects are already removed
+  object_proxy *markers[3] = { op_first, op_marker, op_last };
+  for (int i = 0; i < 3; ++i) {
+    if (markers[i]) {
+      markers[i]->unlink();
+      delete markers[i];
+    }
+  }
   if (first) {
     delete first;
   }
@@ -94,11 +104,6 @@ prototype_node::clear()
     return;
   }
   // remove object proxies until first and marker are left
-  // adjust marker first
-  
-  adjust_left_marker(op_first->next, op_marker);
-  adjust_right_marker(op_marker->prev, op_first);
-
   while (op_first->next != op_marker) {
     object_proxy *op = op_first->next;
     // remove object proxy from list
@@ -112,7 +117,13 @@ prototype_node::clear()
 bool
 prototype_node::empty(bool self) const
 {
-  return op_first->next == (self ? op_marker : op_last);
+  object_proxy *last = (self ? op_marker : op_last);
+  object_proxy *op = op_first->next;
+  // skip the markers of the children
+  while (op != last && op->marker()) {
+    op = op->next;
+  }
+  return op == last;
 }
 
 unsigned long
@@ -131,20 +142,22 @@ prototype_node::insert(prototype_node *child)
   last->prev = child;
   // set depth
   child->depth = depth + 1;
-  // set object proxy pointer
-  // 1. first
-  if (op_first->next == op_last) {
-    // node hasn't any object (proxy)
-    child->op_first = op_first;
-  } else {
-    // node has some objects (proxy)
-    child->op_first = op_last->prev;
+  // the objects of the child follow
+  // the objects of all older children
+  child->link_markers(op_last);
+}
+
+void prototype_node::link_markers(object_proxy *successor)
+{
+  op_first = new object_proxy(static_cast<object_store*>(0));
+  op_marker = new object_proxy(static_cast<object_store*>(0));
+  op_last = new object_proxy(static_cast<object_store*>(0));
+  if (successor) {
+    op_last->link(successor);
   }
-  // 2. marker
-  child->op_marker = op_last;
-  // 3. last
-  child->op_last = op_last;
-}    
+  op_marker->link(op_last);
+  op_first->link(op_marker);
+}
 
 void prototype_node::remove()
 {
@@ -215,42 +228,6 @@ bool prototype_node::is_child_of(const prototype_node *parent) const
   return node == parent;
 }
 
-/*
- * adjust the marker of all predeccessor nodes
- * self and last marker
- */
-void prototype_node::adjust_left_marker(object_proxy *old_proxy, object_proxy *new_proxy)
-{
-  // store start node
-  prototype_node *node = this;
-  // get previous node
-  node = node->previous_node();
-  while (node) {
-    if (node->op_marker == old_proxy) {
-      node->op_marker = new_proxy;
-    }
-    if (node->depth >= depth && node->op_last == old_proxy) {
-      node->op_last = new_proxy;
-    }
-    node = node->previous_node();
-  }
-}
-
-void prototype_node::adjust_right_marker(object_proxy* old_proxy, object_proxy *new_proxy)
-{
-  // store start node
-  prototype_node *node = this;
-  // get previous node
-  node = node->next_node();
-  //bool first = true;
-  while (node) {
-    if (node->op_first == old_proxy) {
-      node->op_first = new_proxy;
-    }
-    node = node->next_node();
-  }
-}
-
 std::ostream& operator <<(std::ostream &os, const prototype_node &pn)
 {
   if (pn.parent) {
@@ -0,0 +1,241 @@
+/*
+ * This file is part of OpenObjectStore OOS.
+ *
+ * OpenObjectStore OOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenObjectStore OOS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenObjectStore OOS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "object/undo_log.hpp"
+#include "object/object.hpp"
+#include "object/object_ptr.hpp"
+#include "object/object_proxy.hpp"
+#include "object/object_store.hpp"
+#include "object/object_serializer.hpp"
+
+#include "tools/byte_buffer.hpp"
+#include "tools/varchar.hpp"
+
+#include <string.h>
+
+namespace oos {
+
+struct undo_log::string_entry : public undo_log::entry
+{
+  string_entry(long i, std::ptrdiff_t o, const char *attr)
+    : entry(i, o), value(attr)
+  {}
+
+  virtual void restore(void *attr, object_store &)
+  {
+    // the old value fitted into the array
+    memcpy(attr, value.c_str(), value.size() + 1);
+  }
+
+  std::string value;
+};
+
+struct undo_log::varchar_entry : public undo_log::entry
+{
+  varchar_entry(long i, std::ptrdiff_t o, const varchar_base &attr)
+    : entry(i, o), value(attr.c_str(), attr.size())
+  {}
+
+  virtual void restore(void *attr, object_store &)
+  {
+    static_cast<varchar_base*>(attr)->assign(value.c_str(), value.size());
+  }
+
+  std::string value;
+};
+
+struct undo_log::image_entry : public undo_log::entry
+{
+  explicit image_entry(const object *o)
+    : entry(o->id(), 0)
+  {
+    byte_buffer buffer;
+    object_serializer serializer;
+    serializer.serialize(o, buffer);
+    image.resize(buffer.size());
+    if (!image.empty()) {
+      buffer.release(&image[0], image.size());
+    }
+  }
+
+  virtual void undo(object_store &ostore)
+  {
+    object_proxy *oproxy = ostore.find_proxy(id);
+    if (oproxy && oproxy->obj) {
+      deserialize(oproxy->obj, ostore);
+    }
+  }
+
+  void deserialize(object *o, object_store &ostore)
+  {
+    byte_buffer buffer;
+    buffer.append(image.data(), image.size());
+    object_serializer serializer;
+    serializer.deserialize(o, buffer, &ostore);
+  }
+
+  std::string image;
+};
+
+struct undo_log::removal_entry : public undo_log::image_entry
+{
+  explicit removal_entry(const object *o)
+    : image_entry(o), classname(o->classname())
+  {}
+
+  virtual void undo(object_store &ostore)
+  {
+    object_proxy *oproxy = ostore.find_proxy(id);
+    if (!oproxy) {
+      oproxy = ostore.create_proxy(id);
+    }
+    if (!oproxy->obj) {
+      // recreate the object and insert it
+      oproxy->obj = ostore.create(classname.c_str());
+      deserialize(oproxy->obj, ostore);
+      ostore.insert_object(oproxy->obj, false);
+    } else {
+      deserialize(oproxy->obj, ostore);
+    }
+  }
+
+  std::string classname;
+};
+
+struct undo_log::insert_entry : public undo_log::entry
+{
+  explicit insert_entry(long i)
+    : entry(i, 0)
+  {}
+
+  virtual void undo(object_store &ostore)
+  {
+    object_proxy *oproxy = ostore.find_proxy(id);
+    if (oproxy && oproxy->obj) {
+      ostore.remove_object(oproxy->obj, false);
+    }
+  }
+};
+
+void undo_log::entry::undo(object_store &ostore)
+{
+  object_proxy *oproxy = ostore.find_proxy(id);
+  if (oproxy && oproxy->obj) {
+    restore(reinterpret_cast<char*>(oproxy->obj) + offset, ostore);
+  }
+}
+
+undo_log::undo_log()
+  : pending_(0)
+{}
+
+undo_log::~undo_log()
+{
+  clear();
+}
+
+void undo_log::push(long id, std::ptrdiff_t offset, const char *attr)
+{
+  if (record(id)) {
+    entries_.push_back(new string_entry(id, offset, attr));
+  }
+}
+
+void undo_log::push(long id, std::ptrdiff_t offset, const varchar_base &attr)
+{
+  if (record(id)) {
+    entries_.push_back(new varchar_entry(id, offset, attr));
+  }
+}
+
+void undo_log::push_image(const object *o)
+{
+  if (imaged_.insert(o->id()).second) {
+    entries_.push_back(new image_entry(o));
+  }
+}
+
+void undo_log::push_removal(const object *o)
+{
+  entries_.push_back(new removal_entry(o));
+}
+
+void undo_log::push_insert(long id)
+{
+  // the removal restores the object as a whole
+  imaged_.insert(id);
+  entries_.push_back(new insert_entry(id));
+}
+
+bool undo_log::recorded(long id)
+{
+  bool covered = (pending_ == id);
+  pending_ = 0;
+  return covered;
+}
+
+void undo_log::rollback(object_store &ostore)
+{
+  // the latest change first
+  for (std::vector<entry*>::reverse_iterator i = entries_.rbegin(); i != entries_.rend(); ++i) {
+    (*i)->undo(ostore);
+  }
+  clear();
+}
+
+void undo_log::clear()
+{
+  for (std::vector<entry*>::iterator i = entries_.begin(); i != entries_.end(); ++i) {
+    delete *i;
+  }
+  entries_.clear();
+  imaged_.clear();
+  pending_ = 0;
+}
+
+std::size_t undo_log::size() const
+{
+  return entries_.size();
+}
+
+bool undo_log::empty() const
+{
+  return entries_.empty();
+}
+
+bool undo_log::record(long id)
+{
+  pending_ = id;
+  // an earlier image restores the whole object
+  return imaged_.empty() || imaged_.find(id) == imaged_.end();
+}
+
+void undo_log::restore_ptr(object_base_ptr &x, long id, object_store &ostore)
+{
+  if (id == 0) {
+    x.reset();
+    return;
+  }
+  // the same way the serializer resolves pointers
+  object_proxy *oproxy = ostore.find_proxy(id);
+  if (!oproxy) {
+    oproxy = ostore.create_proxy(id);
+  }
+  x.reset(oproxy->obj);
+}
+
+}
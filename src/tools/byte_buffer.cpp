@@ -17,84 +17,327 @@
 
 #include "tools/byte_buffer.hpp"
 
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#ifndef WIN32
+#include <sys/uio.h>
+#include <unistd.h>
+#include <limits.h>
+#endif
+
 namespace oos {
 
-byte_buffer::byte_buffer()
+namespace {
+
+/*
+ * size classes of the chunks. a buffer
+ * starts with the smallest class and each
+ * additional chunk takes the next class
+ * until the largest one is reached
+ */
+enum { SIZE_CLASSES = 4, MAX_POOLED = 64, THREAD_POOLED = 8 };
+
+const byte_buffer::size_type chunk_size[SIZE_CLASSES] = { 1 << 8, 1 << 10, 1 << 12, 1 << 14 };
+
+/*
+ * the shared free chunks of all size classes.
+ * the pool is never destroyed so buffers living
+ * in static storage can still return their
+ * chunks at exit
+ */
+struct chunk_pool
 {
-  chunk_list_.push_back(buffer_chunk());
+  std::mutex mutex;
+  std::vector<void*> free[SIZE_CLASSES];
+};
+
+chunk_pool& pool()
+{
+  static chunk_pool *instance = new chunk_pool;
+  return *instance;
 }
 
-byte_buffer::~byte_buffer()
+/*
+ * each thread keeps a few free chunks per
+ * size class without a lock. only the overflow
+ * goes to the shared pool. at thread exit the
+ * cached chunks are handed to the shared pool
+ */
+struct thread_cache
+{
+  thread_cache();
+  ~thread_cache();
+
+  void *free[SIZE_CLASSES][THREAD_POOLED];
+  unsigned int count[SIZE_CLASSES];
+};
+
+thread_local bool thread_cache_closed = false;
+thread_local thread_cache local_cache;
+
+thread_cache::thread_cache()
+{
+  memset(count, 0, sizeof(count));
+}
+
+thread_cache::~thread_cache()
+{
+  chunk_pool &p = pool();
+  std::lock_guard<std::mutex> lock(p.mutex);
+  for (unsigned int i = 0; i < SIZE_CLASSES; ++i) {
+    while (count[i] > 0) {
+      void *mem = free[i][--count[i]];
+      if (p.free[i].size() < MAX_POOLED) {
+        p.free[i].push_back(mem);
+      } else {
+        ::free(mem);
+      }
+    }
+  }
+  // buffers destroyed later use the shared pool
+  thread_cache_closed = true;
+}
+
+thread_cache* cache()
+{
+  return thread_cache_closed ? 0 : &local_cache;
+}
+
+unsigned int size_class_of(byte_buffer::size_type capacity)
+{
+  unsigned int i = 0;
+  while (i < SIZE_CLASSES - 1 && chunk_size[i] != capacity) {
+    ++i;
+  }
+  return i;
+}
+
+}
+
+byte_buffer::byte_buffer()
+  : size_(0)
+  , size_class_(0)
 {}
 
+byte_buffer::~byte_buffer()
+{
+  clear();
+}
+
 void byte_buffer::append(const void *bytes, byte_buffer::size_type size)
 {
   const char *ptr = (const char*)bytes;
-  size_type bytes_written = 0;
-  while (chunk_list_.back().available() < size) {
-    buffer_chunk &chunk = chunk_list_.back();
-    // copy first part of bytes
-    std::copy(ptr+bytes_written, ptr+bytes_written+chunk.available(), &chunk.data[chunk.write_cursor]);
-    // adjust remaining size
-    size -= chunk.available();
-    // adjust written bytes
-    bytes_written += chunk.available();
-    // adjust cursor
-    chunk.write_cursor += chunk.available();
-    // append new buffer chunk
-    chunk_list_.push_back(buffer_chunk());
-  }
-  if (size > 0) {
-    buffer_chunk &chunk = chunk_list_.back();
-    // append remaining bytes
-    std::copy(ptr+bytes_written, ptr+bytes_written+size, &chunk.data[chunk.write_cursor]);
-    chunk.write_cursor += size;
+  size_ += size;
+  while (size > 0) {
+    if (chunk_list_.empty() || chunk_list_.back()->available() == 0) {
+      grow();
+    }
+    buffer_chunk *chunk = chunk_list_.back();
+    size_type n = (chunk->available() < size ? chunk->available() : size);
+    memcpy(chunk->data() + chunk->write_cursor, ptr, n);
+    chunk->write_cursor += n;
+    ptr += n;
+    size -= n;
   }
 }
 
 void byte_buffer::release(void *bytes, byte_buffer::size_type size)
 {
   char *ptr = (char*)bytes;
-  size_type bytes_read = 0;
-  while (!chunk_list_.empty() && chunk_list_.front().used() <= size) {
-    buffer_chunk &chunk = chunk_list_.front();
-    // available bytes are not enough
-    // copy first part
-    std::copy(chunk.data.begin()+chunk.read_cursor, chunk.data.begin()+chunk.read_cursor+chunk.used(), ptr+bytes_read);
-    // adjust remaining size
-    size -= chunk.used();
-    // adjust bytes read
-    bytes_read += chunk.used();
-    // pop back
-    chunk_list_.pop_front();
-    // get next chunk
+  while (size > 0 && !chunk_list_.empty()) {
+    buffer_chunk *chunk = chunk_list_.front();
+    size_type n = (chunk->used() < size ? chunk->used() : size);
+    memcpy(ptr, chunk->data() + chunk->read_cursor, n);
+    chunk->read_cursor += n;
+    size_ -= n;
+    ptr += n;
+    size -= n;
+    if (chunk->used() == 0) {
+      pop_front();
+    }
+  }
+}
+
+void byte_buffer::discard(byte_buffer::size_type size)
+{
+  while (size > 0 && !chunk_list_.empty()) {
+    buffer_chunk *chunk = chunk_list_.front();
+    size_type n = (chunk->used() < size ? chunk->used() : size);
+    chunk->read_cursor += n;
+    size_ -= n;
+    size -= n;
+    if (chunk->used() == 0) {
+      pop_front();
+    }
+  }
+}
+
+byte_buffer::size_type byte_buffer::views(view *vec, size_type count, size_type size) const
+{
+  size_type filled = 0;
+  t_chunk_list::const_iterator first = chunk_list_.begin();
+  t_chunk_list::const_iterator last = chunk_list_.end();
+  for (; first != last && filled < count && size > 0; ++first) {
+    const buffer_chunk *chunk = *first;
+    if (chunk->used() == 0) {
+      continue;
+    }
+    vec[filled].data = chunk->data() + chunk->read_cursor;
+    vec[filled].size = (chunk->used() < size ? chunk->used() : size);
+    size -= vec[filled].size;
+    ++filled;
   }
-  if (size > 0) {
-    buffer_chunk &chunk = chunk_list_.front();
-    // copy rest of bytes
-    std::copy(chunk.data.begin()+chunk.read_cursor, chunk.data.begin()+chunk.read_cursor+size, ptr+bytes_read);
-    // adjust read cursor
-    chunk.read_cursor += size;
+  return filled;
+}
+
+byte_buffer::size_type byte_buffer::write(std::FILE *file) const
+{
+  size_type written = 0;
+  t_chunk_list::const_iterator first = chunk_list_.begin();
+  t_chunk_list::const_iterator last = chunk_list_.end();
+  for (; first != last; ++first) {
+    const buffer_chunk *chunk = *first;
+    size_type n = fwrite(chunk->data() + chunk->read_cursor, 1, chunk->used(), file);
+    written += n;
+    if (n < chunk->used()) {
+      break;
+    }
   }
-  if (chunk_list_.empty()) {
-    chunk_list_.push_back(buffer_chunk());
+  return written;
+}
+
+#ifndef WIN32
+long byte_buffer::writev(int fd) const
+{
+  enum { MAX_IOV = 64 };
+  struct iovec iov[MAX_IOV];
+  long written = 0;
+  t_chunk_list::const_iterator first = chunk_list_.begin();
+  t_chunk_list::const_iterator last = chunk_list_.end();
+  while (first != last) {
+    int count = 0;
+    size_type expected = 0;
+    for (; first != last && count < MAX_IOV && count < IOV_MAX; ++first) {
+      const buffer_chunk *chunk = *first;
+      iov[count].iov_base = const_cast<char*>(chunk->data() + chunk->read_cursor);
+      iov[count].iov_len = chunk->used();
+      expected += chunk->used();
+      ++count;
+    }
+    int offset = 0;
+    while (expected > 0) {
+      ssize_t n = ::writev(fd, iov + offset, count - offset);
+      if (n < 0) {
+        return -1;
+      }
+      written += n;
+      expected -= n;
+      // skip the completely written vectors
+      while (offset < count && (size_t)n >= iov[offset].iov_len) {
+        n -= iov[offset].iov_len;
+        ++offset;
+      }
+      if (offset < count) {
+        iov[offset].iov_base = (char*)iov[offset].iov_base + n;
+        iov[offset].iov_len -= n;
+      }
+    }
   }
+  return written;
 }
+#endif
 
 byte_buffer::size_type byte_buffer::size() const
 {
-  return (chunk_list_.size() * BUF_SIZE) - chunk_list_.back().available() - chunk_list_.front().released();
-  if (chunk_list_.size() == 1) {
-    return BUF_SIZE - chunk_list_.front().available();
+  return size_;
+}
+
+void byte_buffer::clear()
+{
+  while (!chunk_list_.empty()) {
+    pop_front();
+  }
+  size_ = 0;
+  size_class_ = 0;
+}
+
+byte_buffer::size_type byte_buffer::pooled_chunks()
+{
+  size_type count = 0;
+  thread_cache *c = cache();
+  chunk_pool &p = pool();
+  std::lock_guard<std::mutex> lock(p.mutex);
+  for (unsigned int i = 0; i < SIZE_CLASSES; ++i) {
+    count += p.free[i].size();
+    if (c) {
+      count += c->count[i];
+    }
+  }
+  return count;
+}
+
+void byte_buffer::grow()
+{
+  chunk_list_.push_back(acquire(size_class_));
+  if (size_class_ < SIZE_CLASSES - 1) {
+    ++size_class_;
+  }
+}
+
+void byte_buffer::pop_front()
+{
+  recycle(chunk_list_.front());
+  chunk_list_.pop_front();
+}
+
+byte_buffer::buffer_chunk* byte_buffer::acquire(unsigned int size_class)
+{
+  void *mem = 0;
+  thread_cache *c = cache();
+  if (c && c->count[size_class] > 0) {
+    mem = c->free[size_class][--c->count[size_class]];
   } else {
-    return (chunk_list_.size() * BUF_SIZE) - chunk_list_.back().available();
+    chunk_pool &p = pool();
+    std::lock_guard<std::mutex> lock(p.mutex);
+    if (!p.free[size_class].empty()) {
+      mem = p.free[size_class].back();
+      p.free[size_class].pop_back();
+    }
   }
+  if (!mem) {
+    mem = malloc(sizeof(buffer_chunk) + chunk_size[size_class]);
+    if (!mem) {
+      throw std::bad_alloc();
+    }
+  }
+  buffer_chunk *chunk = static_cast<buffer_chunk*>(mem);
+  chunk->capacity = chunk_size[size_class];
+  chunk->read_cursor = 0;
+  chunk->write_cursor = 0;
+  return chunk;
 }
 
-void byte_buffer::clear()
+void byte_buffer::recycle(buffer_chunk *chunk)
 {
-  chunk_list_.clear();
-  chunk_list_.push_back(buffer_chunk());
+  unsigned int size_class = size_class_of(chunk->capacity);
+  thread_cache *c = cache();
+  if (c && c->count[size_class] < THREAD_POOLED) {
+    c->free[size_class][c->count[size_class]++] = chunk;
+    return;
+  }
+  {
+    chunk_pool &p = pool();
+    std::lock_guard<std::mutex> lock(p.mutex);
+    if (p.free[size_class].size() < MAX_POOLED) {
+      p.free[size_class].push_back(chunk);
+      return;
+    }
+  }
+  free(chunk);
 }
 
 }
@@ -17,6 +17,14 @@
 
 #include "tools/sequencer.hpp"
 
+#ifdef WIN32
+#include <unordered_map>
+#include <unordered_set>
+#else
+#include <tr1/unordered_map>
+#include <tr1/unordered_set>
+#endif
+
 namespace oos {
 
 default_sequencer::default_sequencer()
@@ -55,6 +63,184 @@ long default_sequencer::update(long id)
   return number_;
 }
 
+namespace {
+
+/*
+ * each sequencer, reset and invalidating
+ * update gets a unique serial, so a thread
+ * detects an outdated block
+ */
+std::atomic<unsigned long> serial_counter(0);
+
+struct id_block
+{
+  id_block() : serial(0), next(1), last(0) {}
+  unsigned long serial;
+  long next;
+  long last;
+};
+
+/*
+ * each thread keeps one block per
+ * sequencer identity
+ */
+typedef std::tr1::unordered_map<unsigned long, id_block> t_id_block_map;
+
+struct thread_block_map
+{
+  thread_block_map() : sweep_at(16) {}
+  t_id_block_map blocks;
+  t_id_block_map::size_type sweep_at;
+};
+
+thread_local thread_block_map thread_blocks;
+
+/*
+ * the identities of all living sequencers,
+ * never destroyed because sequencers may
+ * outlive the static objects
+ */
+typedef std::tr1::unordered_set<unsigned long> t_identity_set;
+
+std::mutex& living_mutex()
+{
+  static std::mutex *m = new std::mutex;
+  return *m;
+}
+
+t_identity_set& living_sequencers()
+{
+  static t_identity_set *s = new t_identity_set;
+  return *s;
+}
+
+/*
+ * a thread drops the blocks of destroyed
+ * sequencers whenever its map doubled
+ */
+void sweep_blocks(thread_block_map &m)
+{
+  if (m.blocks.size() < m.sweep_at) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(living_mutex());
+    t_identity_set &living = living_sequencers();
+    t_id_block_map::iterator i = m.blocks.begin();
+    while (i != m.blocks.end()) {
+      if (living.find(i->first) == living.end()) {
+        i = m.blocks.erase(i);
+      } else {
+        ++i;
+      }
+    }
+  }
+  m.sweep_at = m.blocks.size() * 2 > 16 ? m.blocks.size() * 2 : 16;
+}
+
+}
+
+atomic_sequencer::atomic_sequencer(long block_size)
+  : number_(0)
+  , serial_(++serial_counter)
+  , identity_(serial_.load())
+  , block_size_(block_size > 1 ? block_size : 1)
+  , reserved_(0)
+{
+  std::lock_guard<std::mutex> lock(living_mutex());
+  living_sequencers().insert(identity_);
+}
+
+atomic_sequencer::~atomic_sequencer()
+{
+  {
+    std::lock_guard<std::mutex> lock(living_mutex());
+    living_sequencers().erase(identity_);
+  }
+  // the blocks of other threads are swept by them
+  thread_blocks.blocks.erase(identity_);
+}
+
+long atomic_sequencer::init()
+{
+  return number_.load();
+}
+
+long atomic_sequencer::reset(long id)
+{
+  // publish the new serial and number together
+  std::lock_guard<std::mutex> lock(mutex_);
+  // invalidate all reserved blocks
+  serial_.store(++serial_counter);
+  number_.store(id);
+  reserved_ = id;
+  return id;
+}
+
+long atomic_sequencer::next()
+{
+  if (block_size_ == 1) {
+    return number_.fetch_add(1) + 1;
+  }
+  t_id_block_map::iterator i = thread_blocks.blocks.find(identity_);
+  if (i == thread_blocks.blocks.end()) {
+    sweep_blocks(thread_blocks);
+    i = thread_blocks.blocks.insert(std::make_pair(identity_, id_block())).first;
+  }
+  id_block &block = i->second;
+  while (true) {
+    if (block.serial != serial_.load() || block.next > block.last) {
+      // reserve a new block
+      std::lock_guard<std::mutex> lock(mutex_);
+      long first = number_.fetch_add(block_size_) + 1;
+      block.serial = serial_.load();
+      block.next = first;
+      block.last = first + block_size_ - 1;
+    }
+    long id = block.next++;
+    // update may have taken the id meanwhile
+    if (block.serial == serial_.load()) {
+      return id;
+    }
+  }
+}
+
+long atomic_sequencer::current() const
+{
+  return number_.load();
+}
+
+long atomic_sequencer::update(long id)
+{
+  if (block_size_ == 1) {
+    long number = number_.load();
+    while (id > number) {
+      if (number_.compare_exchange_weak(number, id)) {
+        return id;
+      }
+    }
+    return number;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  long number = number_.load();
+  if (id > number) {
+    // beyond all reserved blocks
+    number_.store(id);
+    return id;
+  }
+  if (id > reserved_) {
+    // the id may lie within a reserved block
+    serial_.store(++serial_counter);
+    reserved_ = number;
+  }
+  return number;
+}
+
+long atomic_sequencer::block_size() const
+{
+  return block_size_;
+}
+
 sequencer::sequencer(const sequencer_impl_ptr &impl)
   : impl_(impl)
 {
@@ -20,6 +20,7 @@
 
 #include "object/object.hpp"
 #include "object/object_atomizer.hpp"
+#include "object/object_fields.hpp"
 #include "object/object_list.hpp"
 #include "object/object_vector.hpp"
 #include "object/linked_object_list.hpp"
@@ -182,6 +183,81 @@ class ItemA : public Item {};
 class ItemB : public Item {};
 class ItemC : public Item {};
 
+class DescribedItem : public oos::object
+{
+public:
+  typedef DescribedItem described_type;
+  typedef oos::object_ptr<Item> item_ptr;
+
+  DescribedItem()
+    : int_(0)
+    , long_(0)
+    , double_(0)
+    , bool_(false)
+  {
+    memset(cstr_, 0, CSTR_LEN);
+  }
+  DescribedItem(const std::string &str, int i)
+    : int_(i)
+    , long_(-1280000)
+    , double_(1.1414)
+    , bool_(true)
+    , string_(str)
+    , varchar_("Erde")
+  {
+    memset(cstr_, 0, CSTR_LEN);
+  }
+  virtual ~DescribedItem() {}
+
+  template < class F >
+  static void describe(F &f)
+  {
+    oos::object::describe(f);
+    f("val_int", &DescribedItem::int_);
+    f("val_long", &DescribedItem::long_);
+    f("val_double", &DescribedItem::double_);
+    f("val_bool", &DescribedItem::bool_);
+    f("val_cstr", &DescribedItem::cstr_);
+    f("val_string", &DescribedItem::string_);
+    f("val_varchar", &DescribedItem::varchar_);
+    f("ptr", &DescribedItem::ptr_);
+  }
+
+  virtual void deserialize(oos::object_reader &deserializer)
+  {
+    oos::read_fields(*this, deserializer);
+  }
+  virtual void serialize(oos::object_writer &serializer) const
+  {
+    oos::write_fields(*this, serializer);
+  }
+
+  void set_int(int x) { modify(int_, x); }
+  void set_cstr(const char *x, int size) { modify(cstr_, CSTR_LEN, x, size); }
+  void ptr(const item_ptr &x) { modify(ptr_, x); }
+
+  int get_int() const { return int_; }
+  long get_long() const { return long_; }
+  double get_double() const { return double_; }
+  bool get_bool() const { return bool_; }
+  const char* get_cstr() const { return cstr_; }
+  std::string get_string() const { return string_; }
+  oos::varchar_base get_varchar() const { return varchar_; }
+  item_ptr ptr() const { return ptr_; }
+
+private:
+  enum { CSTR_LEN=16 };
+
+  int int_;
+  long long_;
+  double double_;
+  bool bool_;
+  char cstr_[CSTR_LEN];
+  std::string string_;
+  oos::varchar<32> varchar_;
+  item_ptr ptr_;
+};
+
 template < class T >
 class ObjectItem : public Item
 {
@@ -0,0 +1,123 @@
+/*
+ * This file is part of OpenObjectStore OOS.
+ *
+ * OpenObjectStore OOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenObjectStore OOS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenObjectStore OOS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * measures the execution rate of a reused
+ * prepared insert statement and the load
+ * throughput of the mysql backend for
+ * several prefetch row counts
+ *
+ * usage: bench_mysql_statement [rows] [connection]
+ */
+
+#include "../Item.hpp"
+
+#include "object/object_store.hpp"
+#include "object/object_view.hpp"
+
+#include "database/session.hpp"
+#include "database/transaction.hpp"
+#include "database/database.hpp"
+#include "database/database_exception.hpp"
+
+#include "connections.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+
+using namespace oos;
+
+namespace {
+
+const char* const options[] = {
+  "",
+  "?prefetch=1",
+  "?prefetch=100",
+  "?prefetch=1000"
+};
+
+double elapsed_ms(const std::chrono::steady_clock::time_point &start)
+{
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+  int rows = (argc > 1 ? atoi(argv[1]) : 100000);
+  std::string dns = (argc > 2 ? argv[2] : connection::mysql);
+
+  object_store ostore;
+  ostore.insert_prototype<Item>("item");
+
+  try {
+    {
+      session db(ostore, dns);
+      db.create();
+
+      // one execution of the insert statement per row
+      transaction tr(db);
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      tr.begin();
+      for (int i = 0; i < rows; ++i) {
+        std::stringstream name;
+        name << "Item " << i;
+        ostore.insert(new Item(name.str(), i));
+      }
+      tr.commit();
+      double insert = elapsed_ms(start);
+
+      std::cout << "insert: " << std::fixed << std::setprecision(0) << (rows / insert * 1000.0) << " rows/s\n";
+
+      db.close();
+    }
+
+    std::cout << std::left << std::setw(20) << "load"
+              << std::right << std::setw(12) << "rows/s" << "\n";
+
+    for (unsigned int i = 0; i < sizeof(options)/sizeof(options[0]); ++i) {
+      ostore.clear();
+
+      session db(ostore, dns + options[i]);
+      // a server side cursor is only used with a batch size
+      db.db().batch_size(options[i][0] ? rows : 0);
+
+      std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+      db.load();
+      double load = elapsed_ms(start);
+
+      typedef object_view<Item> item_view_t;
+      item_view_t view(ostore);
+
+      std::cout << std::left << std::setw(20) << (options[i][0] ? options[i] : "(buffered)")
+                << std::right << std::setw(12) << std::fixed << std::setprecision(0) << (view.size() / load * 1000.0) << "\n";
+
+      if (i + 1 == sizeof(options)/sizeof(options[0])) {
+        db.drop();
+      }
+      db.close();
+    }
+  } catch (database_exception &ex) {
+    std::cerr << "caught database exception: " << ex.what() << "\n";
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,85 @@
+/*
+ * This file is part of OpenObjectStore OOS.
+ *
+ * OpenObjectStore OOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenObjectStore OOS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenObjectStore OOS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * measures object::get and object::set by
+ * field name for an early and a late
+ * field of an Item. objects outside of the
+ * store are accessed through the visitor,
+ * inserted objects through the field index
+ * of their prototype
+ *
+ * usage: bench_object_field_access [iterations]
+ */
+
+#include "../Item.hpp"
+
+#include "object/object_store.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <string>
+
+using namespace oos;
+
+namespace {
+
+template < class T >
+void run(const char *mode, Item *item, const std::string &field, const T &value, int iterations)
+{
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  size_t sum = 0;
+  for (int i = 0; i < iterations; ++i) {
+    T val;
+    item->set(field, value);
+    item->get(field, val);
+    sum += sizeof(val);
+  }
+
+  double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  std::cout << std::setw(10) << mode
+            << std::setw(20) << field
+            << std::setw(16) << std::fixed << std::setprecision(0) << (iterations / sec)
+            << (sum == 0 ? " " : "") << "\n";
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+  int iterations = (argc > 1 ? atoi(argv[1]) : 1000000);
+
+  object_store ostore;
+  ostore.insert_prototype<Item>("item");
+
+  Item detached("detached", 1);
+  object_ptr<Item> inserted = ostore.insert(new Item("inserted", 1));
+
+  std::cout << std::setw(10) << "mode" << std::setw(20) << "field"
+            << std::setw(16) << "set+get/s" << "\n";
+
+  run("visitor", &detached, "val_int", 4711, iterations);
+  run("visitor", &detached, "val_string", std::string("value"), iterations);
+  run("index", inserted.get(), "val_int", 4711, iterations);
+  run("index", inserted.get(), "val_string", std::string("value"), iterations);
+
+  return 0;
+}
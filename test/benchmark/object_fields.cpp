@@ -0,0 +1,162 @@
+/*
+ * This file is part of OpenObjectStore OOS.
+ *
+ * OpenObjectStore OOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenObjectStore OOS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenObjectStore OOS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * compares the object_serializer round trip
+ * of two classes with the same fields. the
+ * first one walks its fields through the
+ * virtual serialize methods, the second one
+ * has a static field description
+ *
+ * usage: bench_object_fields [objects]
+ */
+
+#include "object/object.hpp"
+#include "object/object_fields.hpp"
+#include "object/object_store.hpp"
+#include "object/object_serializer.hpp"
+
+#include "tools/byte_buffer.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+using namespace oos;
+
+namespace {
+
+class visited : public object
+{
+public:
+  visited() : a_(1), b_(2), c_(3), d_(4), e_(5.0), f_(6.0), g_(true), h_("h") {}
+  virtual ~visited() {}
+
+  virtual void deserialize(object_reader &deserializer)
+  {
+    object::deserialize(deserializer);
+    deserializer.read("a", a_);
+    deserializer.read("b", b_);
+    deserializer.read("c", c_);
+    deserializer.read("d", d_);
+    deserializer.read("e", e_);
+    deserializer.read("f", f_);
+    deserializer.read("g", g_);
+    deserializer.read("h", h_);
+  }
+  virtual void serialize(object_writer &serializer) const
+  {
+    object::serialize(serializer);
+    serializer.write("a", a_);
+    serializer.write("b", b_);
+    serializer.write("c", c_);
+    serializer.write("d", d_);
+    serializer.write("e", e_);
+    serializer.write("f", f_);
+    serializer.write("g", g_);
+    serializer.write("h", h_);
+  }
+
+private:
+  int a_;
+  int b_;
+  long c_;
+  long d_;
+  double e_;
+  double f_;
+  bool g_;
+  std::string h_;
+};
+
+class described : public object
+{
+public:
+  typedef described described_type;
+
+  described() : a_(1), b_(2), c_(3), d_(4), e_(5.0), f_(6.0), g_(true), h_("h") {}
+  virtual ~described() {}
+
+  template < class F >
+  static void describe(F &f)
+  {
+    object::describe(f);
+    f("a", &described::a_);
+    f("b", &described::b_);
+    f("c", &described::c_);
+    f("d", &described::d_);
+    f("e", &described::e_);
+    f("f", &described::f_);
+    f("g", &described::g_);
+    f("h", &described::h_);
+  }
+
+  virtual void deserialize(object_reader &deserializer) { read_fields(*this, deserializer); }
+  virtual void serialize(object_writer &serializer) const { write_fields(*this, serializer); }
+
+private:
+  int a_;
+  int b_;
+  long c_;
+  long d_;
+  double e_;
+  double f_;
+  bool g_;
+  std::string h_;
+};
+
+template < class T >
+void run(const char *name, int objects)
+{
+  object_store ostore;
+  ostore.insert_prototype<T>(name);
+
+  std::vector<object_ptr<T> > items;
+  for (int i = 0; i < objects; ++i) {
+    items.push_back(ostore.insert(new T));
+  }
+
+  object_serializer serializer;
+  byte_buffer buffer;
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  for (size_t i = 0; i < items.size(); ++i) {
+    serializer.serialize(items[i].get(), buffer);
+    serializer.deserialize(items[i].get(), buffer, &ostore);
+  }
+
+  double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  std::cout << std::setw(12) << name
+            << std::setw(16) << std::fixed << std::setprecision(0) << (items.size() / sec) << "\n";
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+  int objects = (argc > 1 ? atoi(argv[1]) : 200000);
+
+  std::cout << std::setw(12) << "walk" << std::setw(16) << "round trips/s" << "\n";
+
+  run<visited>("visited", objects);
+  run<described>("described", objects);
+
+  return 0;
+}
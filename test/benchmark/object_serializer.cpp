@@ -0,0 +1,94 @@
+/*
+ * This file is part of OpenObjectStore OOS.
+ *
+ * OpenObjectStore OOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenObjectStore OOS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenObjectStore OOS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * compares the encoded size and the
+ * serialize/deserialize throughput of the
+ * fixed and the compact object_serializer
+ * encoding for objects with a reference
+ *
+ * usage: bench_object_serializer [objects]
+ */
+
+#include "../Item.hpp"
+
+#include "object/object_store.hpp"
+#include "object/object_serializer.hpp"
+
+#include "tools/byte_buffer.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+
+using namespace oos;
+
+namespace {
+
+typedef object_ptr<Item> item_ptr;
+typedef object_ptr<ObjectItem<Item> > object_item_ptr;
+
+void run(object_store &ostore, const std::vector<object_item_ptr> &items, object_serializer::version_t version)
+{
+  object_serializer serializer(version);
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  byte_buffer::size_type bytes = 0;
+  for (size_t i = 0; i < items.size(); ++i) {
+    byte_buffer buffer;
+    serializer.serialize(items[i].get(), buffer);
+    bytes += buffer.size();
+    ObjectItem<Item> restored;
+    serializer.deserialize(&restored, buffer, &ostore);
+  }
+
+  double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  std::cout << std::setw(10) << (version == object_serializer::fixed ? "fixed" : "compact")
+            << std::setw(14) << std::fixed << std::setprecision(1) << ((double)bytes / items.size())
+            << std::setw(16) << std::setprecision(0) << (items.size() / sec) << "\n";
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+  int objects = (argc > 1 ? atoi(argv[1]) : 100000);
+
+  object_store ostore;
+  ostore.insert_prototype<Item>("item");
+  ostore.insert_prototype<ObjectItem<Item> >("object_item");
+
+  std::vector<object_item_ptr> items;
+  for (int i = 0; i < objects; ++i) {
+    item_ptr item = ostore.insert(new Item("item", i));
+    ObjectItem<Item> *oi = new ObjectItem<Item>("object_item", i);
+    oi->ptr(item);
+    items.push_back(ostore.insert(oi));
+  }
+
+  std::cout << std::setw(10) << "encoding" << std::setw(14) << "bytes/object"
+            << std::setw(16) << "round trips/s" << "\n";
+
+  run(ostore, items, object_serializer::fixed);
+  run(ostore, items, object_serializer::compact);
+
+  return 0;
+}
@@ -0,0 +1,134 @@
+/*
+ * This file is part of OpenObjectStore OOS.
+ *
+ * OpenObjectStore OOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenObjectStore OOS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenObjectStore OOS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * measures the read throughput of a
+ * concurrent object_store with a growing
+ * number of reader threads while one
+ * writer inserts and removes objects
+ *
+ * usage: bench_object_store_concurrent [objects] [milliseconds]
+ */
+
+#include "../Item.hpp"
+
+#include "object/object_store.hpp"
+#include "object/object_view.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+
+using namespace oos;
+
+namespace {
+
+typedef object_view<Item> item_view_t;
+
+void read(const object_store &ostore, const std::atomic<bool> &stop, unsigned long *visited)
+{
+  unsigned long count = 0;
+  while (!stop) {
+    object_store::read_guard guard(ostore);
+    item_view_t oview(ostore);
+    for (item_view_t::iterator i = oview.begin(); i != oview.end(); ++i) {
+      if ((*i)->get_int() >= 0) {
+        ++count;
+      }
+    }
+  }
+  *visited = count;
+}
+
+void write(object_store &ostore, const std::atomic<bool> &stop, unsigned long *written)
+{
+  unsigned long count = 0;
+  while (!stop) {
+    object_ptr<Item> item = ostore.insert(new Item("Writer", 1));
+    ostore.remove(item);
+    ++count;
+  }
+  *written = count;
+}
+
+void run(object_store &ostore, unsigned int reader_count, bool with_writer, int ms)
+{
+  std::atomic<bool> stop(false);
+  std::vector<unsigned long> visited(reader_count, 0);
+  unsigned long written = 0;
+
+  std::vector<std::thread> threads;
+  for (unsigned int i = 0; i < reader_count; ++i) {
+    threads.push_back(std::thread(read, std::cref(ostore), std::cref(stop), &visited[i]));
+  }
+  if (with_writer) {
+    threads.push_back(std::thread(write, std::ref(ostore), std::cref(stop), &written));
+  }
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+  stop = true;
+  for (size_t i = 0; i < threads.size(); ++i) {
+    threads[i].join();
+  }
+
+  unsigned long total = 0;
+  for (unsigned int i = 0; i < reader_count; ++i) {
+    total += visited[i];
+  }
+
+  std::cout << std::setw(8) << reader_count
+            << std::setw(8) << (with_writer ? "yes" : "no")
+            << std::setw(16) << std::fixed << std::setprecision(0) << (total / (ms / 1000.0))
+            << std::setw(16) << (written / (ms / 1000.0)) << "\n";
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+  int objects = (argc > 1 ? atoi(argv[1]) : 10000);
+  int ms = (argc > 2 ? atoi(argv[2]) : 1000);
+
+  object_store ostore;
+  ostore.insert_prototype<Item>("item");
+
+  for (int i = 0; i < objects; ++i) {
+    ostore.insert(new Item("Item", i));
+  }
+
+  ostore.concurrent(true);
+
+  std::cout << std::setw(8) << "readers" << std::setw(8) << "writer"
+            << std::setw(16) << "objects/s" << std::setw(16) << "writes/s" << "\n";
+
+  unsigned int max_readers = std::thread::hardware_concurrency();
+  if (max_readers < 2) {
+    max_readers = 2;
+  }
+  for (unsigned int readers = 1; readers <= max_readers; readers *= 2) {
+    run(ostore, readers, false, ms);
+    run(ostore, readers, true, ms);
+  }
+
+  ostore.concurrent(false);
+
+  return 0;
+}
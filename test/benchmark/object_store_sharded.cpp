@@ -0,0 +1,106 @@
+/*
+ * This file is part of OpenObjectStore OOS.
+ *
+ * OpenObjectStore OOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenObjectStore OOS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenObjectStore OOS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * measures the insert throughput of an
+ * object_store with a growing number of
+ * writer threads, each inserting objects
+ * of its own type. the concurrent mode
+ * (one writer lock) is compared with the
+ * sharded mode
+ *
+ * usage: bench_object_store_sharded [objects per thread]
+ */
+
+#include "../Item.hpp"
+
+#include "object/object_store.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <vector>
+
+using namespace oos;
+
+namespace {
+
+template < class T >
+void insert(object_store &ostore, int objects)
+{
+  for (int i = 0; i < objects; ++i) {
+    T *item = new T;
+    item->set_int(i);
+    ostore.insert(item);
+  }
+}
+
+typedef void (*insert_func)(object_store&, int);
+
+void run(unsigned int writer_count, bool sharded, int objects)
+{
+  object_store ostore;
+  ostore.insert_prototype<Item>("item");
+  ostore.insert_prototype<ItemA>("item_a");
+  ostore.insert_prototype<ItemB>("item_b");
+  ostore.insert_prototype<ItemC>("item_c");
+
+  if (sharded) {
+    ostore.sharded(true);
+  } else {
+    ostore.concurrent(true);
+  }
+
+  insert_func funcs[] = { &insert<Item>, &insert<ItemA>, &insert<ItemB>, &insert<ItemC> };
+
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  std::vector<std::thread> threads;
+  for (unsigned int i = 0; i < writer_count; ++i) {
+    threads.push_back(std::thread(funcs[i % 4], std::ref(ostore), objects));
+  }
+  for (size_t i = 0; i < threads.size(); ++i) {
+    threads[i].join();
+  }
+
+  double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  std::cout << std::setw(8) << writer_count
+            << std::setw(12) << (sharded ? "sharded" : "concurrent")
+            << std::setw(16) << std::fixed << std::setprecision(0) << (writer_count * objects / sec) << "\n";
+
+  ostore.concurrent(false);
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+  int objects = (argc > 1 ? atoi(argv[1]) : 100000);
+
+  std::cout << std::setw(8) << "writers" << std::setw(12) << "mode"
+            << std::setw(16) << "inserts/s" << "\n";
+
+  for (unsigned int writers = 1; writers <= 4; writers *= 2) {
+    run(writers, false, objects);
+    run(writers, true, objects);
+  }
+
+  return 0;
+}
@@ -0,0 +1,121 @@
+/*
+ * This file is part of OpenObjectStore OOS.
+ *
+ * OpenObjectStore OOS is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * OpenObjectStore OOS is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with OpenObjectStore OOS. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * measures insert and commit throughput of
+ * the sqlite backend for several connection
+ * profiles
+ *
+ * usage: bench_sqlite_profile [rows] [commits]
+ */
+
+#include "../Item.hpp"
+
+#include "object/object_store.hpp"
+
+#include "database/session.hpp"
+#include "database/transaction.hpp"
+#include "database/database_exception.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+
+using namespace oos;
+
+namespace {
+
+const char* const profiles[] = {
+  "",
+  "?journal=wal",
+  "?journal=wal&sync=normal",
+  "?journal=wal&sync=normal&mmap=256M&cache=-200000&busy=5000",
+  "?journal=memory&sync=off"
+};
+
+double elapsed_ms(const std::chrono::steady_clock::time_point &start)
+{
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void run(object_store &ostore, const std::string &options, int rows, int commits)
+{
+  std::remove("bench.sqlite");
+
+  session db(ostore, "sqlite://bench.sqlite" + options);
+  db.create();
+
+  transaction tr(db);
+
+  // bulk insert in one transaction
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  tr.begin();
+  for (int i = 0; i < rows; ++i) {
+    std::stringstream name;
+    name << "Item " << i;
+    ostore.insert(new Item(name.str(), i));
+  }
+  tr.commit();
+  double bulk = elapsed_ms(start);
+
+  // one transaction per insert
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < commits; ++i) {
+    tr.begin();
+    ostore.insert(new Item("Single", i));
+    tr.commit();
+  }
+  double single = elapsed_ms(start);
+
+  std::cout << std::left << std::setw(62) << (options.empty() ? "(default)" : options)
+            << std::right << std::setw(12) << std::fixed << std::setprecision(0) << (rows / bulk * 1000.0)
+            << std::setw(14) << std::setprecision(3) << (single / commits) << "\n";
+
+  db.drop();
+  db.close();
+
+  ostore.clear();
+
+  std::remove("bench.sqlite");
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+  int rows = (argc > 1 ? atoi(argv[1]) : 10000);
+  int commits = (argc > 2 ? atoi(argv[2]) : 200);
+
+  object_store ostore;
+  ostore.insert_prototype<Item>("item");
+
+  std::cout << std::left << std::setw(62) << "profile"
+            << std::right << std::setw(12) << "rows/s" << std::setw(14) << "ms/commit" << "\n";
+
+  try {
+    for (unsigned int i = 0; i < sizeof(profiles)/sizeof(profiles[0]); ++i) {
+      run(ostore, profiles[i], rows, commits);
+    }
+  } catch (database_exception &ex) {
+    std::cerr << "caught database exception: " << ex.what() << "\n";
+    return 1;
+  }
+  return 0;
+}
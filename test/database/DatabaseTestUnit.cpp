@@ -21,14 +21,28 @@
 
 #include "object/object_view.hpp"
 #include "object/object_list.hpp"
+#include "object/object_expression.hpp"
 
 #include "database/session.hpp"
+#include "database/database.hpp"
 #include "database/transaction.hpp"
 #include "database/database_exception.hpp"
+#include "database/database_sequencer.hpp"
+#include "database/result.hpp"
+#include "database/replication.hpp"
 
 #include <iostream>
 #include <fstream>
 #include <cstdio>
+#include <vector>
+#include <thread>
+#include <chrono>
+
+#ifndef WIN32
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 using namespace oos;
 using namespace std;
@@ -52,6 +66,19 @@ DatabaseTestUnit::DatabaseTestUnit(const std::string &name, const std::string &m
   add_test("reload_simple", std::tr1::bind(&DatabaseTestUnit::test_reload_simple, this), "simple reload database test");
   add_test("reload", std::tr1::bind(&DatabaseTestUnit::test_reload, this), "reload database test");
   add_test("reload_container", std::tr1::bind(&DatabaseTestUnit::test_reload_container, this), "reload object list database test");
+  add_test("reload_batch", std::tr1::bind(&DatabaseTestUnit::test_reload_batch, this), "reload database in batches test");
+  add_test("load_expression", std::tr1::bind(&DatabaseTestUnit::test_load_expression, this), "load objects matching an expression test");
+  add_test("index", std::tr1::bind(&DatabaseTestUnit::test_index, this), "create index database test");
+  add_test("sequence_block", std::tr1::bind(&DatabaseTestUnit::test_sequence_block, this), "reserve sequence blocks database test");
+  add_test("eager_container", std::tr1::bind(&DatabaseTestUnit::test_eager_container, this), "load containers eager database test");
+  add_test("async_commit", std::tr1::bind(&DatabaseTestUnit::test_async_commit, this), "asynchronous commit database test");
+  add_test("async_failure", std::tr1::bind(&DatabaseTestUnit::test_async_failure, this), "failed asynchronous commit database test");
+  add_test("commit_versions", std::tr1::bind(&DatabaseTestUnit::test_commit_versions, this), "publish object versions of written commits test");
+  add_test("bulk_insert", std::tr1::bind(&DatabaseTestUnit::test_bulk_insert, this), "bulk insert database test");
+  add_test("transaction_modes", std::tr1::bind(&DatabaseTestUnit::test_transaction_modes, this), "read only and insert only transaction test");
+  add_test("rollback", std::tr1::bind(&DatabaseTestUnit::test_rollback, this), "rollback modified, deleted and inserted objects test");
+  add_test("replication", std::tr1::bind(&DatabaseTestUnit::test_replication, this), "replicate committed transactions to a follower test");
+  add_test("replication_process", std::tr1::bind(&DatabaseTestUnit::test_replication_process, this), "replicate committed transactions to a follower process test");
 }
 
 DatabaseTestUnit::~DatabaseTestUnit()
@@ -1035,6 +1062,133 @@ DatabaseTestUnit::test_reload_container()
   delete db;
 }
 
+void
+DatabaseTestUnit::test_eager_container()
+{
+  typedef object_ptr<album> album_ptr;
+  typedef object_ptr<track> track_ptr;
+  typedef object_ptr<ItemPtrVector> itemvector_ptr;
+  typedef ItemPtrVector::value_type item_ptr;
+
+  // create database and make object store known to the database
+  session *db = create_session();
+
+  // load data
+  db->create();
+
+  // load db
+  db->load();
+
+  // create new transaction
+  transaction tr(*db);
+  try {
+    // begin transaction
+    tr.begin();
+
+    album_ptr alb1 = ostore_.insert(new album("My Album"));
+    album_ptr alb2 = ostore_.insert(new album("Empty Album"));
+    album_ptr alb3 = ostore_.insert(new album("Your Album"));
+    itemvector_ptr itemvector = ostore_.insert(new ItemPtrVector);
+
+    for (int i = 0; i < 5; ++i) {
+      stringstream name;
+      name << "Track " << i+1;
+      alb1->add(ostore_.insert(new track(name.str())));
+      // interleave the tracks of both albums
+      alb3->add(ostore_.insert(new track(name.str())));
+    }
+    for (int i = 0; i < 3; ++i) {
+      stringstream name;
+      name << "Item " << i+1;
+      itemvector->push_back(ostore_.insert(new Item(name.str())));
+    }
+
+    UNIT_ASSERT_TRUE(alb2->empty(), "album must be empty");
+
+    tr.commit();
+  } catch (database_exception &ex) {
+    // error, abort transaction
+    UNIT_WARN("caught database exception: " << ex.what() << " (start rollback)");
+    tr.rollback();
+  } catch (object_exception &ex) {
+    // error, abort transaction
+    UNIT_WARN("caught object exception: " << ex.what() << " (start rollback)");
+    tr.rollback();
+  }
+
+  // close db
+  db->close();
+
+  // clear object store
+  ostore_.clear();
+
+  db->open();
+
+  // load both relations eager
+  db->db().fetch_strategy("album", "tracks", database::FETCH_EAGER);
+  db->db().fetch_strategy("item_ptr_vector", "ptr_vector", database::FETCH_EAGER);
+
+  UNIT_ASSERT_EQUAL(db->db().fetch_strategy("album", "tracks"), database::FETCH_EAGER, "invalid fetch strategy");
+  UNIT_ASSERT_EQUAL(db->db().fetch_strategy("item_ptr_list", "ptr_list"), database::FETCH_LAZY, "invalid fetch strategy");
+  // the strategy belongs to the prototype, not to the field name
+  UNIT_ASSERT_EQUAL(db->db().fetch_strategy("item_ptr_list", "ptr_vector"), database::FETCH_LAZY, "invalid fetch strategy");
+
+  // load data
+  db->load();
+
+  typedef object_view<album> album_view_t;
+  album_view_t oview(ostore_);
+
+  int albums = 0;
+  album_view_t::iterator first = oview.begin();
+  album_view_t::iterator last = oview.end();
+  while (first != last) {
+    album_ptr alb = *first++;
+    ++albums;
+    if (alb->name() == "Empty Album") {
+      UNIT_ASSERT_TRUE(alb->empty(), "album must be empty");
+      continue;
+    }
+    UNIT_ASSERT_EQUAL((int)alb->size(), 5, "invalid album size");
+    int i = 0;
+    album::const_iterator tfirst = alb->begin();
+    album::const_iterator tlast = alb->end();
+    while (tfirst != tlast) {
+      track_ptr trk = *tfirst++;
+      stringstream name;
+      name << "Track " << ++i;
+      UNIT_ASSERT_EQUAL(trk->title(), name.str(), "invalid track order");
+      UNIT_ASSERT_EQUAL(trk->alb()->id(), alb->id(), "invalid album of track");
+    }
+  }
+  UNIT_ASSERT_EQUAL(albums, 3, "invalid number of albums");
+
+  typedef object_view<ItemPtrVector> itemvector_view_t;
+  itemvector_view_t vview(ostore_);
+
+  UNIT_ASSERT_TRUE(vview.begin() != vview.end(), "item vector view must not be empty");
+
+  itemvector_ptr itemvector = *vview.begin();
+
+  UNIT_ASSERT_EQUAL((int)itemvector->size(), 3, "invalid item vector size");
+
+  int i = 0;
+  ItemPtrVector::iterator ifirst = itemvector->begin();
+  ItemPtrVector::iterator ilast = itemvector->end();
+  while (ifirst != ilast) {
+    item_ptr item = (*ifirst++)->value();
+    stringstream name;
+    name << "Item " << ++i;
+    UNIT_ASSERT_EQUAL(item->get_string(), name.str(), "invalid item order");
+  }
+
+  db->drop();
+  // close db
+  db->close();
+
+  delete db;
+}
+
 session* DatabaseTestUnit::create_session()
 {
   return new session(ostore_, db_);
@@ -1049,3 +1203,1161 @@ const oos::object_store& DatabaseTestUnit::ostore() const
 {
   return ostore_;
 }
+
+void
+DatabaseTestUnit::test_reload_batch()
+{
+  typedef object_ptr<Item> item_ptr;
+  typedef object_view<Item> oview_t;
+
+  // create database and make object store known to the database
+  session *db = create_session();
+
+  try {
+    // load data
+    db->create();
+
+    // load data
+    db->load();
+  } catch (exception &ex) {
+    UNIT_FAIL("couldn't create and load database: " << ex.what());
+  }
+
+  // create new transaction    
+  transaction tr(*db);
+  try {
+    // begin transaction
+    tr.begin();
+    // insert more items than fit into one batch
+    for (int i = 0; i < 25; ++i) {
+      stringstream name;
+      name << "Item " << i+1;
+      item_ptr item = ostore_.insert(new Item(name.str(), i));
+
+      UNIT_ASSERT_GREATER(item->id(), 0, "invalid object item");
+    }
+    tr.commit();
+  } catch (database_exception &ex) {
+    // error, abort transaction
+    UNIT_WARN("caught database exception: " << ex.what() << " (start rollback)");
+    tr.rollback();
+  } catch (object_exception &ex) {
+    // error, abort transaction
+    UNIT_WARN("caught object exception: " << ex.what() << " (start rollback)");
+    tr.rollback();
+  }
+  // close db
+  db->close();
+
+  // clear object store
+  ostore_.clear();
+
+  db->open();
+
+  // load data in chunks of ten rows
+  db->db().batch_size(10);
+  db->load();
+
+  oview_t oview(ostore_);
+  UNIT_ASSERT_EQUAL((int)oview.size(), 25, "object view size must be 25");
+  UNIT_ASSERT_EQUAL(db->db().loaded_batches("item"), 3UL, "items must be loaded in three batches");
+
+  oview_t::iterator first = oview.begin();
+  oview_t::iterator last = oview.end();
+  while (first != last) {
+    item_ptr item = *first++;
+    UNIT_ASSERT_EQUAL(item->get_int(), (int)item->id() - 1, "invalid item int value");
+  }
+
+  db->drop();
+  // close db
+  db->close();
+  
+  delete db;
+}
+
+void
+DatabaseTestUnit::test_load_expression()
+{
+  typedef object_view<Item> oview_t;
+
+  // create database and make object store known to the database
+  session *db = create_session();
+
+  try {
+    // load data
+    db->create();
+
+    // load data
+    db->load();
+  } catch (exception &ex) {
+    UNIT_FAIL("couldn't create and load database: " << ex.what());
+  }
+
+  // create new transaction    
+  transaction tr(*db);
+  try {
+    // begin transaction
+    tr.begin();
+    for (int i = 0; i < 10; ++i) {
+      stringstream name;
+      name << "Item " << i+1;
+      Item *item = new Item(name.str(), i);
+      item->set_double(1.2345678 + i);
+      UNIT_ASSERT_GREATER(ostore_.insert(item)->id(), 0, "invalid object item");
+    }
+    tr.commit();
+  } catch (database_exception &ex) {
+    // error, abort transaction
+    UNIT_WARN("caught database exception: " << ex.what() << " (start rollback)");
+    tr.rollback();
+  } catch (object_exception &ex) {
+    // error, abort transaction
+    UNIT_WARN("caught object exception: " << ex.what() << " (start rollback)");
+    tr.rollback();
+  }
+  // close db
+  db->close();
+
+  // clear object store
+  ostore_.clear();
+
+  db->open();
+
+  variable<int> x(make_var(&Item::get_int, "val_int"));
+  variable<std::string> str(make_var(&Item::get_string, "val_string"));
+
+  sql_clause clause;
+  UNIT_ASSERT_TRUE(make_sql_expression(x > 6 || str == std::string("Item 1"), clause), "expression must be translatable");
+  UNIT_ASSERT_EQUAL(clause.str(), "(val_int > ?) OR (val_string = ?)", "invalid where clause");
+  UNIT_ASSERT_EQUAL(clause.size(), (std::size_t)2, "values must be bound");
+
+  // load only matching items
+  UNIT_ASSERT_TRUE(db->load<Item>(x > 6 || str == std::string("Item 1")), "expression must be evaluated by database");
+
+  oview_t oview(ostore_);
+  UNIT_ASSERT_EQUAL((int)oview.size(), 4, "object view size must be 4");
+
+  // loading again keeps the objects in memory
+  Item *loaded = oview.front().get();
+  loaded->set_string("Unsaved");
+  UNIT_ASSERT_TRUE(db->load<Item>(x > 6 || str == std::string("Item 1")), "expression must be evaluated by database");
+  UNIT_ASSERT_EQUAL((int)oview.size(), 4, "object view size must be 4");
+  UNIT_ASSERT_TRUE(oview.front().get() == loaded, "loaded object must not be replaced");
+  UNIT_ASSERT_EQUAL(loaded->get_string(), std::string("Unsaved"), "unsaved change must be kept");
+
+  ostore_.clear();
+
+  // values are bound with full precision
+  variable<double> d(make_var(&Item::get_double, "val_double"));
+  UNIT_ASSERT_TRUE(db->load<Item>(d == 1.2345678 + 3), "expression must be evaluated by database");
+  UNIT_ASSERT_EQUAL((int)oview.size(), 1, "object view size must be 1");
+
+  ostore_.clear();
+
+  // values never become part of the sql text
+  UNIT_ASSERT_TRUE(db->load<Item>(str == std::string("Item 1' OR '1'='1")), "expression must be evaluated by database");
+  UNIT_ASSERT_TRUE(oview.empty(), "object view must be empty");
+
+  // a variable without column falls back to a full load
+  variable<int> y(make_var(&Item::get_int));
+
+  UNIT_ASSERT_FALSE(db->load<Item>(y > 6), "expression must not be evaluated by database");
+
+  UNIT_ASSERT_EQUAL((int)oview.size(), 10, "object view size must be 10");
+  UNIT_ASSERT_EQUAL(std::count_if(oview.begin(), oview.end(), y > 6), 3, "expected three matching items");
+
+  db->drop();
+  // close db
+  db->close();
+  
+  delete db;
+}
+
+void
+DatabaseTestUnit::test_index()
+{
+  // declare an additional index
+  ostore_.insert_index<Item>("val_int");
+
+  // create database and make object store known to the database
+  session *db = create_session();
+
+  try {
+    db->create();
+  } catch (exception &ex) {
+    UNIT_FAIL("couldn't create database: " << ex.what());
+  }
+
+  // reference column is indexed automatically
+  std::string plan = db->db().explain("SELECT id FROM track WHERE album=1");
+  UNIT_ASSERT_TRUE(plan.find("track_album_idx") != std::string::npos, "query must use index on reference column");
+
+  // declared column is indexed
+  plan = db->db().explain("SELECT id FROM item WHERE val_int=42");
+  UNIT_ASSERT_TRUE(plan.find("item_val_int_idx") != std::string::npos, "query must use declared index");
+
+  db->drop();
+  // close db
+  db->close();
+  
+  delete db;
+}
+
+namespace {
+
+long stored_sequence(session *db)
+{
+  long number = 0;
+  result *res = db->execute("SELECT name, number FROM oos_sequence WHERE name='object'");
+  if (res->fetch()) {
+    res->get(1, number);
+  }
+  delete res;
+  return number;
+}
+
+}
+
+void
+DatabaseTestUnit::test_sequence_block()
+{
+  typedef object_ptr<Item> item_ptr;
+
+  // create database and make object store known to the database
+  session *db = create_session();
+
+  try {
+    db->create();
+    db->load();
+  } catch (exception &ex) {
+    UNIT_FAIL("couldn't create and load database: " << ex.what());
+  }
+
+  db->db().seq()->block_size(10);
+
+  UNIT_ASSERT_EQUAL(stored_sequence(db), 0, "sequence must be zero");
+
+  // first commit reserves a block
+  item_ptr item = db->insert(new Item("Item 1", 1));
+  UNIT_ASSERT_EQUAL(item->id(), 1, "invalid item id");
+  UNIT_ASSERT_EQUAL(stored_sequence(db), 11, "block must be reserved");
+
+  // commits inside the block don't touch the sequence table
+  for (int i = 2; i <= 11; ++i) {
+    db->insert(new Item("Item", i));
+    UNIT_ASSERT_EQUAL(stored_sequence(db), 11, "sequence must not change");
+  }
+
+  // exhausted block reserves the next one
+  item = db->insert(new Item("Item 12", 12));
+  UNIT_ASSERT_EQUAL(item->id(), 12, "invalid item id");
+  UNIT_ASSERT_EQUAL(stored_sequence(db), 22, "next block must be reserved");
+
+  // reload continues after the reserved block
+  db->close();
+  ostore_.clear();
+  db->open();
+  db->load();
+
+  item = db->insert(new Item("Item 23", 23));
+  UNIT_ASSERT_EQUAL(item->id(), 23, "id must follow reserved block");
+
+  db->drop();
+  // close db
+  db->close();
+  
+  delete db;
+}
+
+void
+DatabaseTestUnit::test_async_commit()
+{
+  typedef object_ptr<Item> item_ptr;
+  typedef object_ptr<ObjectItem<Item> > object_item_ptr;
+  typedef object_view<Item> item_view_t;
+
+  session *db = create_session();
+
+  try {
+    db->create();
+    db->load();
+  } catch (exception &ex) {
+    UNIT_FAIL("couldn't create and load database: " << ex.what());
+  }
+
+  db->async_commit(true, 8);
+
+  UNIT_ASSERT_TRUE(db->async_commit(), "session must commit asynchronous");
+
+  std::vector<commit_pipeline::future_type> written;
+  std::vector<item_ptr> items;
+  for (int i = 0; i < 50; ++i) {
+    transaction tr(*db);
+    tr.begin();
+    items.push_back(ostore_.insert(new Item("Item", i)));
+    written.push_back(tr.commit());
+  }
+
+  // object with a pointer to another object
+  object_item_ptr oitem;
+  {
+    transaction tr(*db);
+    tr.begin();
+    ObjectItem<Item> *oi = new ObjectItem<Item>("ObjectItem", 99);
+    oi->ptr(items[7]);
+    oitem = ostore_.insert(oi);
+    written.push_back(tr.commit());
+  }
+
+  // change an object again right after the commit
+  {
+    transaction tr(*db);
+    tr.begin();
+    items[3]->set_int(333);
+    written.push_back(tr.commit());
+  }
+  items[3]->set_int(444);
+
+  // delete one object
+  {
+    transaction tr(*db);
+    tr.begin();
+    ostore_.remove(items[4]);
+    written.push_back(tr.commit());
+  }
+
+  db->flush();
+
+  for (size_t i = 0; i < written.size(); ++i) {
+    UNIT_ASSERT_TRUE(written[i].wait_for(std::chrono::seconds(0)) == std::future_status::ready, "commit must be written");
+    written[i].get();
+  }
+  UNIT_ASSERT_EQUAL(db->pipeline()->commits(), (unsigned long)written.size(), "invalid number of written commits");
+  UNIT_ASSERT_TRUE(db->pipeline()->batches() <= db->pipeline()->commits(), "invalid number of batches");
+
+  long updated_id = items[3]->id();
+  long pointed_id = items[7]->id();
+  long object_item_id = oitem->id();
+  items.clear();
+  oitem = object_item_ptr();
+
+  db->async_commit(false);
+
+  UNIT_ASSERT_FALSE(db->async_commit(), "session must commit synchronous");
+
+  // reload and check the written state
+  db->close();
+  ostore_.clear();
+  db->open();
+  db->load();
+
+  item_view_t oview(ostore_);
+  // 49 items and the object item
+  UNIT_ASSERT_EQUAL((int)oview.size(), 50, "invalid number of items");
+
+  for (item_view_t::iterator i = oview.begin(); i != oview.end(); ++i) {
+    if ((*i)->id() == updated_id) {
+      // the change after the commit isn't written
+      UNIT_ASSERT_EQUAL((*i)->get_int(), 333, "invalid updated value");
+    }
+  }
+
+  object_view<ObjectItem<Item> > object_items(ostore_);
+  UNIT_ASSERT_EQUAL((int)object_items.size(), 1, "invalid number of object items");
+  oitem = object_items.front();
+  UNIT_ASSERT_EQUAL(oitem->id(), object_item_id, "invalid object item");
+  UNIT_ASSERT_EQUAL(oitem->ptr()->id(), pointed_id, "invalid pointer");
+  oitem = object_item_ptr();
+
+  db->drop();
+  db->close();
+
+  delete db;
+}
+
+void
+DatabaseTestUnit::test_async_failure()
+{
+  typedef object_ptr<Item> item_ptr;
+
+  session *db = create_session();
+
+  db->create();
+
+  db->async_commit(true, 8);
+
+  // let the writer fail
+  delete db->execute("ALTER TABLE item RENAME TO item_away;");
+
+  std::vector<commit_pipeline::future_type> written;
+  long last_id = 0;
+  for (int i = 0; i < 5; ++i) {
+    transaction tr(*db);
+    tr.begin();
+    long id = ostore_.insert(new Item("Item", i))->id();
+    try {
+      written.push_back(tr.commit());
+      last_id = id;
+    } catch (database_exception &) {
+      // the writer already failed
+      tr.rollback();
+      break;
+    }
+  }
+
+  // wait for the failed batch
+  for (size_t i = 0; i < written.size(); ++i) {
+    written[i].wait();
+  }
+
+  // nothing is written after the failed batch until flush
+  bool caught = false;
+  {
+    transaction tr(*db);
+    tr.begin();
+    ostore_.insert(new Item("Rejected", 42));
+    try {
+      tr.commit();
+    } catch (database_exception &) {
+      caught = true;
+    }
+    tr.rollback();
+  }
+  UNIT_ASSERT_TRUE(caught, "commit after failed batch must throw");
+
+  caught = false;
+  try {
+    db->flush();
+  } catch (exception &) {
+    caught = true;
+  }
+  UNIT_ASSERT_TRUE(caught, "flush must rethrow the write error");
+
+  for (size_t i = 0; i < written.size(); ++i) {
+    caught = false;
+    try {
+      written[i].get();
+    } catch (exception &) {
+      caught = true;
+    }
+    UNIT_ASSERT_TRUE(caught, "every transaction of a failed batch must fail");
+  }
+
+  delete db->execute("ALTER TABLE item_away RENAME TO item;");
+
+  // the failed batch doesn't rewind the ids
+  item_ptr item;
+  {
+    transaction tr(*db);
+    tr.begin();
+    try {
+      item = ostore_.insert(new Item("Item", 99));
+    } catch (exception &ex) {
+      UNIT_FAIL("couldn't insert item after failed batch: " << ex.what());
+    }
+    tr.commit().get();
+  }
+  UNIT_ASSERT_TRUE(item->id() > last_id, "id handed out twice");
+
+  // disabling reports an error flush hasn't reported
+  delete db->execute("ALTER TABLE item RENAME TO item_away;");
+  {
+    transaction tr(*db);
+    tr.begin();
+    ostore_.insert(new Item("Item", 100));
+    tr.commit().wait();
+  }
+  caught = false;
+  try {
+    db->async_commit(false);
+  } catch (exception &) {
+    caught = true;
+  }
+  UNIT_ASSERT_TRUE(caught, "async_commit(false) must rethrow the write error");
+  UNIT_ASSERT_FALSE(db->async_commit(), "asynchronous commits still enabled");
+
+  delete db->execute("ALTER TABLE item_away RENAME TO item;");
+
+  db->drop();
+  db->close();
+
+  delete db;
+}
+
+void
+DatabaseTestUnit::test_commit_versions()
+{
+  typedef object_ptr<Item> item_ptr;
+
+  session *db = create_session();
+
+  db->create();
+
+  ostore_.versioning(true);
+
+  item_ptr item, removed;
+  {
+    transaction tr(*db);
+    tr.begin();
+    item = ostore_.insert(new Item("Item", 1));
+    removed = ostore_.insert(new Item("Removed", 2));
+    tr.commit();
+  }
+  long item_id = item->id();
+  long removed_id = removed->id();
+
+  // a failed commit isn't published
+  delete db->execute("ALTER TABLE item RENAME TO item_away;");
+  {
+    transaction tr(*db);
+    tr.begin();
+    item->set_int(10);
+    ostore_.remove(removed);
+    bool caught = false;
+    try {
+      tr.commit();
+    } catch (exception &) {
+      caught = true;
+    }
+    UNIT_ASSERT_TRUE(caught, "commit must fail");
+    {
+      object_store::read_token token(ostore_);
+      UNIT_ASSERT_EQUAL(token.find<Item>(item_id)->get_int(), 1, "failed commit must not be visible");
+      UNIT_ASSERT_NOT_NULL(token.find(removed_id), "failed removal must not be visible");
+    }
+    tr.rollback();
+  }
+  delete db->execute("ALTER TABLE item_away RENAME TO item;");
+
+  // the rolled back removal isn't published later
+  {
+    transaction tr(*db);
+    tr.begin();
+    item->set_int(3);
+    tr.commit();
+  }
+  {
+    object_store::read_token token(ostore_);
+    UNIT_ASSERT_EQUAL(token.find<Item>(item_id)->get_int(), 3, "committed change must be visible");
+    UNIT_ASSERT_NOT_NULL(token.find(removed_id), "rolled back removal must not be visible");
+  }
+
+  // asynchronous commits are published once written
+  db->async_commit(true);
+  {
+    transaction tr(*db);
+    tr.begin();
+    item->set_int(4);
+    tr.commit();
+  }
+  db->flush();
+  {
+    object_store::read_token token(ostore_);
+    UNIT_ASSERT_EQUAL(token.find<Item>(item_id)->get_int(), 4, "written commit must be visible");
+  }
+  delete db->execute("ALTER TABLE item RENAME TO item_away;");
+  {
+    transaction tr(*db);
+    tr.begin();
+    item->set_int(5);
+    tr.commit();
+  }
+  bool caught = false;
+  try {
+    db->flush();
+  } catch (exception &) {
+    caught = true;
+  }
+  UNIT_ASSERT_TRUE(caught, "asynchronous commit must fail");
+  {
+    object_store::read_token token(ostore_);
+    UNIT_ASSERT_EQUAL(token.find<Item>(item_id)->get_int(), 4, "failed commit must not be visible");
+  }
+  delete db->execute("ALTER TABLE item_away RENAME TO item;");
+  db->async_commit(false);
+
+  ostore_.versioning(false);
+  ostore_.concurrent(false);
+
+  db->drop();
+  db->close();
+
+  delete db;
+}
+
+void
+DatabaseTestUnit::test_bulk_insert()
+{
+  typedef object_ptr<Item> item_ptr;
+  typedef object_view<Item> oview_t;
+
+  session *db = create_session();
+
+  db->create();
+
+  transaction tr(*db);
+  try {
+    tr.begin();
+    // names grow in length to resize the parameter buffers
+    for (int i = 0; i < 250; ++i) {
+      stringstream name;
+      name << "Item " << std::string(i % 50, 'x') << i;
+      ostore_.insert(new Item(name.str(), i));
+    }
+    tr.commit();
+  } catch (database_exception &ex) {
+    UNIT_WARN("caught database exception: " << ex.what() << " (start rollback)");
+    tr.rollback();
+  }
+
+  db->close();
+
+  ostore_.clear();
+
+  db->open();
+  db->load();
+
+  oview_t oview(ostore_);
+  UNIT_ASSERT_EQUAL((int)oview.size(), 250, "object view size must be 250");
+
+  oview_t::iterator first = oview.begin();
+  oview_t::iterator last = oview.end();
+  while (first != last) {
+    item_ptr item = *first++;
+    int i = item->get_int();
+    stringstream name;
+    name << "Item " << std::string(i % 50, 'x') << i;
+    UNIT_ASSERT_EQUAL(item->get_string(), name.str(), "invalid item name");
+  }
+
+  db->drop();
+  db->close();
+
+  delete db;
+}
+
+void
+DatabaseTestUnit::test_transaction_modes()
+{
+  typedef object_ptr<Item> item_ptr;
+  typedef object_view<Item> oview_t;
+
+  session *db = create_session();
+
+  db->create();
+
+  oview_t oview(ostore_);
+
+  // a read only transaction doesn't record anything
+  transaction tr(*db);
+  transaction ro(*db, transaction::read_only);
+  tr.begin();
+  ro.begin();
+  UNIT_ASSERT_TRUE(db->current_transaction() == &ro, "read only transaction must be current");
+  // the insertion belongs to the enclosing transaction
+  ostore_.insert(new Item("Item", 1));
+  ro.commit();
+  UNIT_ASSERT_TRUE(db->current_transaction() == &tr, "enclosing transaction must be current");
+  tr.rollback();
+
+  UNIT_ASSERT_EQUAL((int)oview.size(), 0, "object view must be empty");
+
+  // rollback of an insert only transaction removes the inserted objects
+  transaction io(*db, transaction::insert_only);
+  io.begin();
+  for (int i = 0; i < 10; ++i) {
+    ostore_.insert(new Item("Item", i));
+  }
+  io.rollback();
+
+  UNIT_ASSERT_EQUAL((int)oview.size(), 0, "object view must be empty");
+
+  io.begin();
+  for (int i = 0; i < 10; ++i) {
+    ostore_.insert(new Item("Item", i));
+  }
+  io.commit();
+
+  // an insert only transaction rejects modifications and deletions
+  item_ptr item = oview.front();
+  int value = item->get_int();
+  io.begin();
+  bool caught = false;
+  try {
+    item->set_int(100);
+  } catch (object_exception &) {
+    caught = true;
+  }
+  UNIT_ASSERT_TRUE(caught, "insert only transaction must reject modifications");
+  UNIT_ASSERT_EQUAL(item->get_int(), value, "rejected value must not be set");
+  caught = false;
+  try {
+    ostore_.remove(item);
+  } catch (object_exception &) {
+    caught = true;
+  }
+  UNIT_ASSERT_TRUE(caught, "insert only transaction must reject deletions");
+  UNIT_ASSERT_EQUAL((int)oview.size(), 10, "rejected object must not be removed");
+  io.rollback();
+
+  // a read only transaction without enclosing transaction rejects changes
+  ro.begin();
+  caught = false;
+  try {
+    item->set_int(100);
+  } catch (object_exception &) {
+    caught = true;
+  }
+  UNIT_ASSERT_TRUE(caught, "read only transaction must reject modifications");
+  caught = false;
+  try {
+    ostore_.insert(new Item("Item", 11));
+  } catch (object_exception &) {
+    caught = true;
+  }
+  UNIT_ASSERT_TRUE(caught, "read only transaction must reject insertions");
+  UNIT_ASSERT_EQUAL((int)oview.size(), 10, "rejected object must not be inserted");
+  ro.commit();
+
+  item = item_ptr();
+
+  db->close();
+
+  ostore_.clear();
+
+  db->open();
+  db->load();
+
+  UNIT_ASSERT_EQUAL((int)oview.size(), 10, "object view size must be 10");
+
+  item = oview.front();
+  UNIT_ASSERT_EQUAL(item->get_int(), value, "database value must not be modified");
+
+  item = item_ptr();
+
+  db->drop();
+  db->close();
+
+  delete db;
+}
+
+void
+DatabaseTestUnit::test_rollback()
+{
+  typedef object_ptr<Item> item_ptr;
+  typedef object_ptr<ObjectItem<Item> > object_item_ptr;
+  typedef object_view<Item> oview_t;
+
+  session *db = create_session();
+
+  db->create();
+
+  oview_t oview(ostore_);
+
+  std::vector<item_ptr> items;
+  object_item_ptr oitem;
+  {
+    transaction tr(*db);
+    tr.begin();
+    for (int i = 0; i < 5; ++i) {
+      items.push_back(ostore_.insert(new Item("Item", i)));
+    }
+    ObjectItem<Item> *oi = new ObjectItem<Item>("ObjectItem", 42);
+    oi->ptr(items[0]);
+    oitem = ostore_.insert(oi);
+    tr.commit();
+  }
+
+  std::size_t count = oview.size();
+
+  transaction tr(*db);
+  tr.begin();
+
+  // only the changed fields are recorded
+  items[1]->set_int(100);
+  items[1]->set_string("changed");
+  items[1]->set_int(200);
+
+  UNIT_ASSERT_TRUE(ostore_.undo() != 0, "store must record changed fields");
+  UNIT_ASSERT_EQUAL(ostore_.undo()->size(), (std::size_t)3, "undo log must contain three fields");
+
+  items[1]->set_cstr("cstr", 5);
+  items[1]->set_varchar(varchar<64>("varchar"));
+  oitem->ptr(items[2]);
+
+  // updated and deleted
+  long id = items[3]->id();
+  items[3]->set_int(300);
+  ostore_.remove(items[3]);
+  items[3] = item_ptr();
+
+  // deleted only
+  long id4 = items[4]->id();
+  ostore_.remove(items[4]);
+  items[4] = item_ptr();
+
+  item_ptr inserted = ostore_.insert(new Item("Inserted", 7));
+  inserted->set_int(8);
+  long inserted_id = inserted->id();
+  inserted = item_ptr();
+
+  tr.rollback();
+
+  UNIT_ASSERT_TRUE(ostore_.undo() == 0, "store must not record after rollback");
+  UNIT_ASSERT_EQUAL(oview.size(), count, "object view size must be restored");
+
+  UNIT_ASSERT_EQUAL(items[1]->get_int(), 1, "int must be restored");
+  UNIT_ASSERT_EQUAL(items[1]->get_string(), std::string("Item"), "string must be restored");
+  UNIT_ASSERT_EQUAL(std::string(items[1]->get_cstr()), std::string("Hallo"), "cstr must be restored");
+  UNIT_ASSERT_EQUAL(items[1]->get_varchar().str(), std::string("Erde"), "varchar must be restored");
+  UNIT_ASSERT_EQUAL(oitem->ptr()->id(), items[0]->id(), "object pointer must be restored");
+
+  UNIT_ASSERT_TRUE(ostore_.find_proxy(inserted_id) == 0, "inserted item must be removed");
+
+  bool found = false, found4 = false;
+  for (oview_t::iterator i = oview.begin(); i != oview.end(); ++i) {
+    if ((*i)->id() == id) {
+      found = true;
+      UNIT_ASSERT_EQUAL((*i)->get_int(), 3, "deleted item must be restored with old value");
+    } else if ((*i)->id() == id4) {
+      found4 = true;
+      UNIT_ASSERT_EQUAL((*i)->get_int(), 4, "deleted item must be restored");
+    }
+  }
+  UNIT_ASSERT_TRUE(found, "updated and deleted item must be restored");
+  UNIT_ASSERT_TRUE(found4, "deleted item must be restored");
+
+  items.clear();
+  oitem = object_item_ptr();
+
+  db->drop();
+  db->close();
+
+  delete db;
+}
+
+void
+DatabaseTestUnit::test_replication()
+{
+  typedef object_ptr<Item> item_ptr;
+  typedef object_ptr<ObjectItem<Item> > object_item_ptr;
+  typedef object_view<Item> item_view_t;
+
+  std::remove("replication.log");
+
+  session *db = create_session();
+  db->create();
+
+  replication_writer writer("replication.log");
+  db->replicate(&writer);
+
+  UNIT_ASSERT_TRUE(db->replication() == &writer, "session must replicate");
+
+  object_store follower_store;
+  follower_store.insert_prototype<Item>("item");
+  follower_store.insert_prototype<ObjectItem<Item>, Item>("object_item");
+  replication_follower follower(follower_store, "replication.log");
+
+  UNIT_ASSERT_EQUAL(follower.poll(), 0UL, "empty log must not apply anything");
+
+  std::vector<item_ptr> items;
+  {
+    transaction tr(*db);
+    tr.begin();
+    for (int i = 0; i < 10; ++i) {
+      items.push_back(ostore_.insert(new Item("Item", i)));
+    }
+    tr.commit();
+  }
+  object_item_ptr oitem;
+  {
+    transaction tr(*db);
+    tr.begin();
+    ObjectItem<Item> *oi = new ObjectItem<Item>("ObjectItem", 99);
+    oi->ptr(items[7]);
+    oitem = ostore_.insert(oi);
+    tr.commit();
+  }
+
+  UNIT_ASSERT_EQUAL(follower.poll(), 2UL, "invalid number of applied batches");
+  UNIT_ASSERT_EQUAL(follower.sequence(), writer.sequence(), "follower must be current");
+
+  item_view_t fview(follower_store);
+  UNIT_ASSERT_EQUAL((int)fview.size(), 11, "invalid number of replicated items");
+
+  object_view<ObjectItem<Item> > fobject_items(follower_store);
+  UNIT_ASSERT_EQUAL((int)fobject_items.size(), 1, "invalid number of replicated object items");
+  UNIT_ASSERT_EQUAL(fobject_items.front()->id(), oitem->id(), "invalid replicated object item");
+  UNIT_ASSERT_EQUAL(fobject_items.front()->ptr()->id(), items[7]->id(), "invalid replicated pointer");
+
+  // a rolled back transaction isn't shipped
+  {
+    transaction tr(*db);
+    tr.begin();
+    items[2]->set_int(222);
+    tr.rollback();
+  }
+  UNIT_ASSERT_EQUAL(follower.poll(), 0UL, "rolled back transaction must not be shipped");
+
+  // a failed commit isn't shipped
+  delete db->execute("ALTER TABLE item RENAME TO item_away;");
+  {
+    transaction tr(*db);
+    tr.begin();
+    ostore_.insert(new Item("Item", 77));
+    bool caught = false;
+    try {
+      tr.commit();
+    } catch (exception &) {
+      caught = true;
+    }
+    UNIT_ASSERT_TRUE(caught, "commit must fail");
+    tr.rollback();
+  }
+  db->async_commit(true);
+  {
+    transaction tr(*db);
+    tr.begin();
+    items[2]->set_int(222);
+    tr.commit();
+  }
+  bool caught = false;
+  try {
+    db->flush();
+  } catch (exception &) {
+    caught = true;
+  }
+  UNIT_ASSERT_TRUE(caught, "asynchronous commit must fail");
+  db->async_commit(false);
+  delete db->execute("ALTER TABLE item_away RENAME TO item;");
+  UNIT_ASSERT_EQUAL(follower.poll(), 0UL, "failed transaction must not be shipped");
+
+  // a transaction stays committed if shipping fails
+  std::FILE *read_only = std::fopen("replication.log", "rb");
+  {
+    replication_writer broken(read_only);
+    db->replicate(&broken);
+    transaction tr(*db);
+    tr.begin();
+    items[6]->set_int(666);
+    try {
+      tr.commit().get();
+    } catch (exception &ex) {
+      UNIT_FAIL("shipping must not fail the commit: " << ex.what());
+    }
+    caught = false;
+    try {
+      db->flush();
+    } catch (exception &) {
+      caught = true;
+    }
+    UNIT_ASSERT_TRUE(caught, "flush must rethrow the shipping error");
+    db->replicate(&writer);
+
+    // the failed batch may be partially written
+    UNIT_ASSERT_TRUE(std::freopen("replication_broken.log", "ab", read_only) != 0, "couldn't reopen log");
+    replication_writer::action_list_t no_actions;
+    caught = false;
+    try {
+      broken.write(no_actions);
+    } catch (database_exception &) {
+      caught = true;
+    }
+    UNIT_ASSERT_TRUE(caught, "broken writer must refuse further batches");
+    UNIT_ASSERT_EQUAL(broken.sequence(), 0ULL, "invalid sequence of broken writer");
+  }
+  std::fclose(read_only);
+  UNIT_ASSERT_EQUAL(follower.poll(), 0UL, "unshipped transaction must not be applied");
+
+  // update and delete, the second asynchronous
+  {
+    transaction tr(*db);
+    tr.begin();
+    items[3]->set_int(333);
+    tr.commit();
+  }
+  long updated_id = items[3]->id();
+  long deleted_id = items[4]->id();
+  db->async_commit(true);
+  {
+    transaction tr(*db);
+    tr.begin();
+    items[3]->set_string("Changed");
+    ostore_.remove(items[4]);
+    tr.commit();
+  }
+  db->async_commit(false);
+
+  UNIT_ASSERT_EQUAL(follower.poll(), 2UL, "invalid number of applied batches");
+  UNIT_ASSERT_EQUAL((int)fview.size(), 10, "invalid number of replicated items");
+
+  for (item_view_t::iterator i = fview.begin(); i != fview.end(); ++i) {
+    UNIT_ASSERT_TRUE((*i)->id() != deleted_id, "deleted item must be removed");
+    if ((*i)->id() == updated_id) {
+      UNIT_ASSERT_EQUAL((*i)->get_int(), 333, "invalid replicated value");
+      UNIT_ASSERT_EQUAL((*i)->get_string(), "Changed", "invalid replicated string");
+    }
+  }
+
+  // an incomplete batch is applied once complete
+  std::FILE *log = std::fopen("replication.log", "rb");
+  std::fseek(log, 0, SEEK_END);
+  long size = std::ftell(log);
+  std::fclose(log);
+
+  {
+    transaction tr(*db);
+    tr.begin();
+    items[5]->set_int(555);
+    tr.commit();
+  }
+  std::vector<char> last_batch;
+  log = std::fopen("replication.log", "rb");
+  std::fseek(log, size, SEEK_SET);
+  int c = 0;
+  while ((c = std::fgetc(log)) != EOF) {
+    last_batch.push_back((char)c);
+  }
+  std::fclose(log);
+
+  std::FILE *partial = std::fopen("replication_partial.log", "wb");
+  replication_follower partial_follower(follower_store, "replication_partial.log");
+  std::fwrite(&last_batch[0], 1, last_batch.size() / 2, partial);
+  std::fflush(partial);
+  UNIT_ASSERT_EQUAL(partial_follower.poll(), 0UL, "incomplete batch must not be applied");
+  std::fwrite(&last_batch[last_batch.size() / 2], 1, last_batch.size() - last_batch.size() / 2, partial);
+  std::fflush(partial);
+  UNIT_ASSERT_EQUAL(partial_follower.poll(), 1UL, "completed batch must be applied");
+  std::fclose(partial);
+
+  UNIT_ASSERT_EQUAL(follower.poll(), 1UL, "invalid number of applied batches");
+  UNIT_ASSERT_EQUAL(follower.sequence(), writer.sequence(), "follower must be current");
+
+  // a new writer continues the sequence
+  db->replicate(0);
+  replication_writer resumed("replication.log");
+  UNIT_ASSERT_EQUAL(resumed.sequence(), writer.sequence(), "writer must continue the sequence");
+
+  // a failed batch continues after its applied records
+  std::remove("replication_records.log");
+  replication_writer records_writer("replication_records.log");
+  db->replicate(&records_writer);
+  {
+    transaction tr(*db);
+    tr.begin();
+    item_ptr item = ostore_.insert(new Item("Item", 1));
+    ObjectItem<Item> *oi = new ObjectItem<Item>("ObjectItem", 2);
+    oi->ptr(item);
+    ostore_.insert(oi);
+    tr.commit();
+  }
+  db->replicate(0);
+
+  object_store records_store;
+  records_store.insert_prototype<Item>("item");
+  replication_follower records_follower(records_store, "replication_records.log");
+  caught = false;
+  try {
+    records_follower.poll();
+  } catch (database_exception &) {
+    caught = true;
+  }
+  UNIT_ASSERT_TRUE(caught, "unknown type must fail the batch");
+  UNIT_ASSERT_EQUAL(records_follower.sequence(), 0ULL, "failed batch must not be applied");
+  item_view_t rview(records_store);
+  UNIT_ASSERT_EQUAL((int)rview.size(), 1, "invalid number of applied records");
+  const Item *applied = rview.front().get();
+
+  records_store.insert_prototype<ObjectItem<Item>, Item>("object_item");
+  UNIT_ASSERT_EQUAL(records_follower.poll(), 1UL, "failed batch must be completed");
+  // the object item is an item too
+  UNIT_ASSERT_EQUAL((int)rview.size(), 2, "applied record applied twice");
+  UNIT_ASSERT_TRUE(rview.front().get() == applied, "applied record applied twice");
+  UNIT_ASSERT_EQUAL((int)object_view<ObjectItem<Item> >(records_store).size(), 1, "invalid number of applied records");
+
+  items.clear();
+  oitem = object_item_ptr();
+
+  db->drop();
+  db->close();
+
+  delete db;
+
+  std::remove("replication.log");
+  std::remove("replication_partial.log");
+  std::remove("replication_broken.log");
+  std::remove("replication_records.log");
+}
+
+void
+DatabaseTestUnit::test_replication_process()
+{
+#ifndef WIN32
+  typedef object_ptr<Item> item_ptr;
+  typedef object_view<Item> item_view_t;
+
+  std::remove("replication.log");
+
+  session *db = create_session();
+  db->create();
+
+  replication_writer writer("replication.log");
+  db->replicate(&writer);
+
+  pid_t pid = fork();
+  if (pid == 0) {
+    // the follower process tails the log
+    object_store follower_store;
+    follower_store.insert_prototype<Item>("item");
+    follower_store.insert_prototype<ObjectItem<Item>, Item>("object_item");
+    replication_follower follower(follower_store, "replication.log");
+    int result = 1;
+    for (int i = 0; i < 10000 && follower.sequence() < 21; ++i) {
+      follower.poll();
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    if (follower.sequence() == 21) {
+      item_view_t fview(follower_store);
+      int updated = 0;
+      for (item_view_t::iterator i = fview.begin(); i != fview.end(); ++i) {
+        updated += ((*i)->get_int() == 1000 ? 1 : 0);
+      }
+      result = (fview.size() == 19 && updated == 1 ? 0 : 2);
+    }
+    _exit(result);
+  }
+  UNIT_ASSERT_TRUE(pid > 0, "couldn't fork follower process");
+
+  std::vector<item_ptr> items;
+  for (int i = 0; i < 20; ++i) {
+    transaction tr(*db);
+    tr.begin();
+    items.push_back(ostore_.insert(new Item("Item", i)));
+    tr.commit();
+  }
+  {
+    transaction tr(*db);
+    tr.begin();
+    items[0]->set_int(1000);
+    ostore_.remove(items[19]);
+    tr.commit();
+  }
+
+  int status = 0;
+  waitpid(pid, &status, 0);
+
+  UNIT_ASSERT_TRUE(WIFEXITED(status), "follower process must exit");
+  UNIT_ASSERT_EQUAL(WEXITSTATUS(status), 0, "follower process couldn't replicate");
+
+  items.clear();
+
+  db->replicate(0);
+  db->drop();
+  db->close();
+
+  delete db;
+
+  std::remove("replication.log");
+#endif
+}
@@ -52,6 +52,19 @@ public:
   void test_reload_simple();
   void test_reload();
   void test_reload_container();
+  void test_reload_batch();
+  void test_load_expression();
+  void test_index();
+  void test_sequence_block();
+  void test_eager_container();
+  void test_async_commit();
+  void test_async_failure();
+  void test_commit_versions();
+  void test_bulk_insert();
+  void test_transaction_modes();
+  void test_rollback();
+  void test_replication();
+  void test_replication_process();
 
 protected:
   oos::session* create_session();
@@ -2,12 +2,312 @@
 
 #include "connections.hpp"
 
+#include "../Item.hpp"
+
+#include "database/session.hpp"
+#include "database/result.hpp"
+#include "database/database.hpp"
+#include "database/transaction.hpp"
+#include "database/blob_stream.hpp"
+#include "database/connection_pool.hpp"
+
+#include "object/object_view.hpp"
+#include "database/database_exception.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <thread>
+#include <vector>
+
 using namespace oos;
 using namespace std;
 
 SQLiteDatabaseTestUnit::SQLiteDatabaseTestUnit()
   : DatabaseTestUnit("sqlite", "sqlite database test unit", connection::sqlite)
-{}
+{
+  add_test("profile", std::tr1::bind(&SQLiteDatabaseTestUnit::test_profile, this), "sqlite connection options test");
+  add_test("blob_stream", std::tr1::bind(&SQLiteDatabaseTestUnit::test_blob_stream, this), "sqlite incremental blob i/o test");
+  add_test("reader_pool", std::tr1::bind(&SQLiteDatabaseTestUnit::test_reader_pool, this), "sqlite reader connection pool test");
+}
 
 SQLiteDatabaseTestUnit::~SQLiteDatabaseTestUnit()
 {}
+
+void SQLiteDatabaseTestUnit::test_profile()
+{
+  session *db = new session(ostore(), "sqlite://profile.sqlite?journal=wal&sync=normal&mmap=1M&cache=-2000&busy=5000");
+
+  UNIT_ASSERT_TRUE(db->is_open(), "couldn't open database database");
+
+  result *res = db->execute("PRAGMA journal_mode;");
+  UNIT_ASSERT_TRUE(res->fetch(), "journal mode expected");
+  std::string mode;
+  res->get(0, mode);
+  delete res;
+  UNIT_ASSERT_EQUAL(mode, "wal", "invalid journal mode");
+
+  res = db->execute("PRAGMA synchronous;");
+  UNIT_ASSERT_TRUE(res->fetch(), "synchronous mode expected");
+  int sync = 0;
+  res->get(0, sync);
+  delete res;
+  // NORMAL
+  UNIT_ASSERT_EQUAL(sync, 1, "invalid synchronous mode");
+
+  res = db->execute("PRAGMA cache_size;");
+  UNIT_ASSERT_TRUE(res->fetch(), "cache size expected");
+  int cache = 0;
+  res->get(0, cache);
+  delete res;
+  UNIT_ASSERT_EQUAL(cache, -2000, "invalid cache size");
+
+  db->close();
+  delete db;
+
+  std::remove("profile.sqlite");
+
+  // unknown options are rejected
+  bool caught = false;
+  try {
+    db = new session(ostore(), "sqlite://profile.sqlite?journal=wal&fast=1");
+    delete db;
+  } catch (database_exception &) {
+    caught = true;
+  }
+  UNIT_ASSERT_TRUE(caught, "unknown option must throw");
+
+  std::remove("profile.sqlite");
+
+  // only documented values are passed to the pragma
+  caught = false;
+  try {
+    db = new session(ostore(), "sqlite://profile.sqlite?journal=wal;DROP TABLE item");
+    delete db;
+  } catch (database_exception &) {
+    caught = true;
+  }
+  UNIT_ASSERT_TRUE(caught, "invalid journal mode must throw");
+
+  caught = false;
+  try {
+    db = new session(ostore(), "sqlite://profile.sqlite?sync=2");
+    delete db;
+  } catch (database_exception &) {
+    caught = true;
+  }
+  UNIT_ASSERT_TRUE(caught, "invalid synchronous mode must throw");
+
+  std::remove("profile.sqlite");
+}
+
+void SQLiteDatabaseTestUnit::test_blob_stream()
+{
+  typedef object_ptr<Item> item_ptr;
+
+  session *db = create_session();
+
+  db->create();
+
+  // a text value larger than one chunk
+  std::string text;
+  for (int i = 0; i < 10000; ++i) {
+    text += (char)('a' + i % 26);
+  }
+
+  transaction tr(*db);
+  tr.begin();
+  item_ptr item = ostore().insert(new Item(text, 7));
+  item_ptr other = ostore().insert(new Item("small", 8));
+  tr.commit();
+
+  // read the text in chunks
+  blob_stream *stream = db->db().open_blob("item", "val_string", item->id());
+  UNIT_ASSERT_EQUAL((int)stream->size(), 10000, "invalid blob size");
+
+  char buf[1024];
+  std::string result;
+  blob_stream::size_type offset = 0;
+  while (offset < stream->size()) {
+    blob_stream::size_type len = stream->size() - offset;
+    if (len > sizeof(buf)) {
+      len = sizeof(buf);
+    }
+    stream->read(offset, buf, len);
+    result.append(buf, len);
+    offset += len;
+  }
+  UNIT_ASSERT_EQUAL(result, text, "invalid blob value");
+
+  // move to the next row
+  stream->reopen(other->id());
+  UNIT_ASSERT_EQUAL((int)stream->size(), 5, "invalid blob size");
+  stream->read(0, buf, 5);
+  UNIT_ASSERT_EQUAL(std::string(buf, 5), "small", "invalid blob value");
+
+  // reading behind the end fails
+  bool caught = false;
+  try {
+    stream->read(0, buf, 6);
+  } catch (database_exception &) {
+    caught = true;
+  }
+  UNIT_ASSERT_TRUE(caught, "read behind the end must throw");
+  delete stream;
+
+  // write a new value in chunks
+  stream = db->db().create_blob("item", "val_string", other->id(), 3000);
+  UNIT_ASSERT_EQUAL((int)stream->size(), 3000, "invalid blob size");
+  memset(buf, 'x', sizeof(buf));
+  stream->write(0, buf, 1000);
+  stream->write(2000, buf, 1000);
+  delete stream;
+
+  stream = db->db().open_blob("item", "val_string", other->id());
+  stream->read(0, buf, 1);
+  UNIT_ASSERT_EQUAL(buf[0], 'x', "invalid blob value");
+  stream->read(1500, buf, 1);
+  UNIT_ASSERT_EQUAL(buf[0], '\0', "invalid blob value");
+  stream->read(2999, buf, 1);
+  UNIT_ASSERT_EQUAL(buf[0], 'x', "invalid blob value");
+  delete stream;
+
+  // names are quoted, an unknown column can't alter the statement
+  caught = false;
+  try {
+    stream = db->db().create_blob("item", "val_string=NULL; DROP TABLE item; --", other->id(), 10);
+    delete stream;
+  } catch (database_exception &) {
+    caught = true;
+  }
+  UNIT_ASSERT_TRUE(caught, "unknown column must throw");
+
+  oos::result *res = db->execute("SELECT COUNT(*) FROM item;");
+  UNIT_ASSERT_TRUE(res->fetch(), "item table must exist");
+  delete res;
+
+  db->drop();
+  db->close();
+
+  delete db;
+}
+
+static void count_items(session *db, int *counts)
+{
+  for (int j = 0; j < 10; ++j) {
+    connection_pool::lease reader(db->readers());
+    result *res = reader->execute("SELECT COUNT(*) FROM item;");
+    if (res->fetch()) {
+      int count = 0;
+      res->get(0, count);
+      *counts += count;
+    }
+    delete res;
+  }
+}
+
+static void lease_reader(session *db, std::atomic<bool> *granted)
+{
+  connection_pool::lease reader(db->readers());
+  *granted = true;
+}
+
+static void release_reader(connection_pool *pool, database *reader, std::atomic<bool> *released)
+{
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  *released = true;
+  pool->release(reader);
+}
+
+void SQLiteDatabaseTestUnit::test_reader_pool()
+{
+  typedef object_view<Item> item_view_t;
+
+  session *db = new session(ostore(), "sqlite://pool.sqlite?journal=wal&busy=5000");
+
+  db->reader_pool_size(2);
+
+  UNIT_ASSERT_EQUAL((int)db->readers().size(), 2, "invalid reader pool size");
+
+  db->create();
+
+  transaction tr(*db);
+  tr.begin();
+  for (int i = 0; i < 20; ++i) {
+    std::stringstream name;
+    name << "Item " << i+1;
+    ostore().insert(new Item(name.str(), i));
+  }
+  tr.commit();
+
+  db->close();
+
+  ostore().clear();
+
+  db->open();
+
+  // load via a reader
+  db->load();
+
+  UNIT_ASSERT_EQUAL((int)db->readers().available(), 2, "all readers must be released");
+
+  item_view_t oview(ostore());
+  UNIT_ASSERT_EQUAL((int)oview.size(), 20, "invalid number of loaded items");
+
+  // query concurrently
+  const int thread_count = 4;
+  std::vector<int> counts(thread_count, 0);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < thread_count; ++i) {
+    threads.push_back(std::thread(count_items, db, &counts[i]));
+  }
+  for (int i = 0; i < thread_count; ++i) {
+    threads[i].join();
+  }
+
+  for (int i = 0; i < thread_count; ++i) {
+    UNIT_ASSERT_EQUAL(counts[i], 200, "invalid count");
+  }
+
+  connection_pool::statistics stats = db->readers().stats();
+  // one checkout while loading
+  UNIT_ASSERT_EQUAL((int)stats.acquired, thread_count * 10 + 1, "invalid number of checkouts");
+
+  // a blocked checkout is granted on release
+  db->readers().reset_stats();
+  database *first = db->readers().acquire();
+  database *second = db->readers().acquire();
+  UNIT_ASSERT_EQUAL((int)db->readers().available(), 0, "all readers must be leased");
+
+  std::atomic<bool> granted(false);
+  std::thread waiter(lease_reader, db, &granted);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  UNIT_ASSERT_FALSE(granted, "checkout must block while all readers are leased");
+
+  db->readers().release(first);
+  waiter.join();
+  UNIT_ASSERT_TRUE(granted, "checkout must be granted on release");
+  db->readers().release(second);
+
+  stats = db->readers().stats();
+  UNIT_ASSERT_EQUAL((int)stats.waited, 1, "invalid number of waits");
+  UNIT_ASSERT_TRUE(stats.max_wait_ms >= 40, "invalid wait time");
+  UNIT_ASSERT_EQUAL((int)db->readers().available(), 2, "all readers must be released");
+
+  db->drop();
+  db->close();
+
+  // destroying the session waits for leased readers
+  database *leased = db->readers().acquire();
+  std::atomic<bool> released(false);
+  std::thread holder(release_reader, &db->readers(), leased, &released);
+
+  delete db;
+
+  UNIT_ASSERT_TRUE(released, "session must wait for leased readers");
+  holder.join();
+
+  std::remove("pool.sqlite");
+}
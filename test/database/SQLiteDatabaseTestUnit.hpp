@@ -8,6 +8,10 @@ class SQLiteDatabaseTestUnit : public DatabaseTestUnit
 public:
   SQLiteDatabaseTestUnit();
   virtual ~SQLiteDatabaseTestUnit();
+
+  void test_profile();
+  void test_blob_stream();
+  void test_reader_pool();
 };
 
 #endif /* SQLITE_DATABASE_TEST_UNIT_HPP */
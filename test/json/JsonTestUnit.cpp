@@ -1,6 +1,16 @@
 #include "JsonTestUnit.hpp"
 
+#include "../Item.hpp"
+
 #include "json/json.hpp"
+#include "json/json_parser.hpp"
+#include "json/json_exception.hpp"
+#include "json/json_object_writer.hpp"
+#include "json/json_object_reader.hpp"
+
+#include "object/object_store.hpp"
+#include "object/object_view.hpp"
+#include "object/object_exception.hpp"
 
 #include <iostream>
 #include <sstream>
@@ -18,6 +28,8 @@ JsonTestUnit::JsonTestUnit()
   add_test("create", std::tr1::bind(&JsonTestUnit::create_test, this), "create json test");
   add_test("access", std::tr1::bind(&JsonTestUnit::access_test, this), "access json test");
   add_test("parser", std::tr1::bind(&JsonTestUnit::parser_test, this), "parser json test");
+  add_test("object_stream", std::tr1::bind(&JsonTestUnit::object_stream_test, this), "json object writer and reader test");
+  add_test("object_reference", std::tr1::bind(&JsonTestUnit::object_reference_test, this), "json object reader reference test");
 }
 
 JsonTestUnit::~JsonTestUnit()
@@ -42,6 +54,14 @@ void JsonTestUnit::simple_test()
   //cout << "\n" << obj << "\n";
 
   UNIT_ASSERT_EQUAL(out.str(), result, "result isn't as expected");
+
+  // the first key or value follows the bracket directly
+  istringstream compact("{\"array\":[1,[2],{\"a\":null}],\"text\":\"x\"}");
+  json_object cobj;
+  compact >> cobj;
+  stringstream compact_out;
+  compact_out << cobj;
+  UNIT_ASSERT_EQUAL(compact_out.str(), string("{ \"array\" : [ 1, [ 2 ], { \"a\" : null } ], \"text\" : \"x\" }"), "compact input isn't read as expected");
 }
 
 void JsonTestUnit::string_test()
@@ -59,6 +79,23 @@ void JsonTestUnit::string_test()
   json_string numb = obj["string"];
 
   UNIT_ASSERT_EQUAL(numb.value(), result, "values are not equal");
+
+  // escapes are decoded to utf-8
+  istringstream escaped("{\"string\":\"a\\u00e9\\u20ac\\ud83d\\ude00\"}");
+  json_object eobj;
+  escaped >> eobj;
+  json_string estr = eobj["string"];
+  UNIT_ASSERT_EQUAL(estr.value(), string("a\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80"), "escapes must be decoded");
+
+  bool caught = false;
+  try {
+    istringstream invalid("{\"string\":\"\\u00g0\"}");
+    json_object iobj;
+    invalid >> iobj;
+  } catch (json_error &) {
+    caught = true;
+  }
+  UNIT_ASSERT_TRUE(caught, "invalid hex digit must throw json_error");
 }
 
 
@@ -153,3 +190,151 @@ void JsonTestUnit::parser_test()
   
   UNIT_ASSERT_EQUAL(out.str(), result, "result isn't as expected");
 }
+
+void JsonTestUnit::object_stream_test()
+{
+  typedef object_ptr<Item> item_ptr;
+  typedef ObjectItem<Item> object_item;
+  typedef object_ptr<object_item> object_item_ptr;
+
+  object_store ostore;
+  ostore.insert_prototype<Item>("item");
+  ostore.insert_prototype<ItemA, Item>("item_a");
+  ostore.insert_prototype<object_item>("object_item");
+
+  for (int i = 0; i < 10; ++i) {
+    item_ptr item = ostore.insert(new Item("Item", i));
+    item->set_double(i / 3.0);
+  }
+  item_ptr special = ostore.insert(new Item("say \"hello\"\n\tto\\all\x01", 100));
+  special->set_char('x');
+  special->set_float(0.1f);
+  special->set_bool(false);
+  special->set_cstr("cstr", 5);
+  special->set_varchar(varchar<64>("varchar"));
+  special->set_unsigned_long(4000000000UL);
+  ostore.insert(new ItemA);
+  object_item_ptr oitem = ostore.insert(new object_item("ObjectItem", 200));
+  oitem->ref(special);
+  oitem->ptr(ostore.insert(new Item("Owned", 300)));
+
+  stringstream out;
+  json_object_writer writer(out);
+  writer.serialize(ostore);
+
+  // the output is valid json
+  json_parser parser;
+  std::string str = out.str();
+  parser.parse(str);
+
+  object_store restored;
+  restored.insert_prototype<Item>("item");
+  restored.insert_prototype<ItemA, Item>("item_a");
+  restored.insert_prototype<object_item>("object_item");
+
+  json_object_reader reader(restored);
+  istringstream in(str);
+  // the object_item created its own default item on insert
+  UNIT_ASSERT_EQUAL(reader.deserialize(in), (size_t)15, "invalid number of objects read");
+
+  typedef object_view<Item> item_view;
+  item_view items(restored);
+  UNIT_ASSERT_EQUAL(items.size(), object_view<Item>(ostore).size(), "invalid number of objects");
+
+  object_proxy *oproxy = restored.find_proxy(special->id());
+  UNIT_ASSERT_NOT_NULL(oproxy, "object must be restored");
+  const Item *item = static_cast<const Item*>(oproxy->obj);
+  UNIT_ASSERT_EQUAL(item->get_string(), special->get_string(), "invalid string");
+  UNIT_ASSERT_EQUAL(item->get_int(), 100, "invalid int");
+  UNIT_ASSERT_EQUAL(item->get_char(), 'x', "invalid char");
+  UNIT_ASSERT_EQUAL(item->get_float(), 0.1f, "invalid float");
+  UNIT_ASSERT_FALSE(item->get_bool(), "invalid bool");
+  UNIT_ASSERT_EQUAL(std::string(item->get_cstr()), std::string("cstr"), "invalid cstr");
+  UNIT_ASSERT_EQUAL(item->get_varchar().str(), std::string("varchar"), "invalid varchar");
+  UNIT_ASSERT_EQUAL(item->get_unsigned_long(), 4000000000UL, "invalid unsigned long");
+
+  for (item_view::iterator i = items.begin(); i != items.end(); ++i) {
+    oproxy = ostore.find_proxy((*i)->id());
+    UNIT_ASSERT_NOT_NULL(oproxy, "object must exist");
+    UNIT_ASSERT_EQUAL((*i)->get_double(), static_cast<Item*>(oproxy->obj)->get_double(), "invalid double");
+  }
+
+  UNIT_ASSERT_TRUE(restored.find_prototype("item_a")->size() == 1, "derived object must be restored");
+
+  object_view<object_item> oitems(restored);
+  UNIT_ASSERT_EQUAL(oitems.size(), (size_t)1, "invalid number of objects");
+  object_item_ptr restored_item = oitems.front();
+  UNIT_ASSERT_EQUAL(restored_item->ref().id(), special->id(), "invalid reference");
+  UNIT_ASSERT_EQUAL(restored_item->ref()->get_int(), 100, "invalid referenced object");
+  UNIT_ASSERT_EQUAL(restored_item->ptr()->get_string(), std::string("Owned"), "invalid owned object");
+
+  // one prototype with its derived prototypes
+  stringstream pout;
+  json_object_writer pwriter(pout);
+  pwriter.serialize(ostore, "item");
+  UNIT_ASSERT_TRUE(pout.str().find("\"item_a\":[") != std::string::npos, "derived prototype must be written");
+  UNIT_ASSERT_TRUE(pout.str().find("\"object_item\":[") == std::string::npos, "other prototype must not be written");
+
+  bool failed = false;
+  try {
+    pwriter.serialize(ostore, "unknown");
+  } catch (object_exception &) {
+    failed = true;
+  }
+  UNIT_ASSERT_TRUE(failed, "unknown prototype must fail");
+}
+
+void JsonTestUnit::object_reference_test()
+{
+  typedef ObjectItem<Item> object_item;
+  typedef object_ptr<object_item> object_item_ptr;
+
+  object_store ostore;
+  ostore.insert_prototype<Item>("item");
+  ostore.insert_prototype<object_item>("object_item");
+
+  // the referenced objects come after the referencing one
+  istringstream in("{\"object_item\":[{\"id\":1,\"val_string\":\"ObjectItem\",\"ref\":2,\"ptr\":3}],"
+                   "\"item\":[{\"id\":2,\"val_int\":2},{\"id\":3,\"val_int\":3}]}");
+
+  json_object_reader reader(ostore);
+  UNIT_ASSERT_EQUAL(reader.deserialize(in), (size_t)3, "invalid number of objects read");
+
+  object_view<object_item> oitems(ostore);
+  UNIT_ASSERT_EQUAL(oitems.size(), (size_t)1, "invalid number of objects");
+  object_item_ptr oitem = oitems.front();
+  UNIT_ASSERT_EQUAL(oitem->get_string(), std::string("ObjectItem"), "invalid string");
+  UNIT_ASSERT_EQUAL(oitem->ref().id(), 2L, "invalid reference");
+  UNIT_ASSERT_EQUAL(oitem->ref()->get_int(), 2, "reference must be resolved");
+  UNIT_ASSERT_EQUAL(oitem->ptr().id(), 3L, "invalid pointer");
+  UNIT_ASSERT_EQUAL(oitem->ptr()->get_int(), 3, "pointer must be resolved");
+
+  object_view<Item> items(ostore);
+  UNIT_ASSERT_EQUAL(items.size(), (size_t)2, "no object must be duplicated");
+
+  // new objects get ids after the read ones
+  object_ptr<Item> item;
+  try {
+    item = ostore.insert(new Item("Item", 4));
+  } catch (object_exception &ex) {
+    UNIT_FAIL("couldn't insert object after reading: " << ex.what());
+  }
+  UNIT_ASSERT_EQUAL(item->id(), 4L, "invalid id of new object");
+  ostore.remove(item);
+
+  // reading again updates the objects
+  istringstream update("{\"item\":[{\"id\":2,\"val_int\":20}]}");
+  UNIT_ASSERT_EQUAL(reader.deserialize(update), (size_t)1, "invalid number of objects read");
+  UNIT_ASSERT_EQUAL(oitem->ref()->get_int(), 20, "object must be updated");
+  UNIT_ASSERT_EQUAL(items.size(), (size_t)2, "no object must be duplicated");
+
+  // unknown prototypes are rejected
+  istringstream unknown("{\"unknown\":[{\"id\":5}]}");
+  bool failed = false;
+  try {
+    reader.deserialize(unknown);
+  } catch (object_exception &) {
+    failed = true;
+  }
+  UNIT_ASSERT_TRUE(failed, "unknown prototype must fail");
+}
@@ -15,6 +15,8 @@ public:
   void create_test();
   void access_test();
   void parser_test();
+  void object_stream_test();
+  void object_reference_test();
   /**
    * Initializes a test unit
    */
@@ -21,6 +21,7 @@ ObjectPrototypeTestUnit::ObjectPrototypeTestUnit()
   add_test("hierarchy", std::tr1::bind(&ObjectPrototypeTestUnit::prototype_hierachy, this), "prototype hierarchy");
   add_test("iterator", std::tr1::bind(&ObjectPrototypeTestUnit::prototype_traverse, this), "prototype iterator");
   add_test("relation", std::tr1::bind(&ObjectPrototypeTestUnit::prototype_relation, this), "prototype relation");
+  add_test("field_index", std::tr1::bind(&ObjectPrototypeTestUnit::prototype_field_index, this), "prototype field index");
 }
 
 ObjectPrototypeTestUnit::~ObjectPrototypeTestUnit()
@@ -156,3 +157,57 @@ ObjectPrototypeTestUnit::prototype_relation()
   
 //  ostore.clear(false);
 }
+
+void
+ObjectPrototypeTestUnit::prototype_field_index()
+{
+  object_store ostore;
+  ostore.insert_prototype<Item>("item");
+
+  typedef object_ptr<Item> item_ptr;
+  item_ptr item = ostore.insert(new Item("Item", 7));
+
+  prototype_iterator node = ostore.find_prototype<Item>();
+  UNIT_ASSERT_FALSE(node->fields.built(), "field index must be built on first access");
+
+  int ival = 0;
+  UNIT_ASSERT_TRUE(item->get("val_int", ival), "couldn't get int value");
+  UNIT_ASSERT_EQUAL(ival, 7, "invalid int value");
+
+  UNIT_ASSERT_TRUE(node->fields.built(), "field index must be built");
+  UNIT_ASSERT_EQUAL(node->fields.size(), (field_index::size_type)14, "invalid number of fields");
+
+  const field_index::field *f = node->fields.find("val_string");
+  UNIT_ASSERT_NOT_NULL(f, "couldn't find field");
+  UNIT_ASSERT_EQUAL(f->type, field_index::type_string, "invalid field type");
+  UNIT_ASSERT_TRUE(f->addressable(), "field must be addressable");
+  UNIT_ASSERT_EQUAL(f->ordinal, 12U, "invalid field ordinal");
+  UNIT_ASSERT_NULL(node->fields.find("unknown"), "field must not be found");
+
+  // set and get through the index with conversion
+  UNIT_ASSERT_TRUE(item->set("val_int", std::string("4711")), "couldn't set int value");
+  UNIT_ASSERT_EQUAL(item->get_int(), 4711, "invalid int value");
+  UNIT_ASSERT_TRUE(item->set("val_string", std::string("Hello")), "couldn't set string value");
+  UNIT_ASSERT_EQUAL(item->get_string(), "Hello", "invalid string value");
+  UNIT_ASSERT_TRUE(item->set("val_varchar", std::string("World")), "couldn't set varchar value");
+  UNIT_ASSERT_EQUAL(item->get_varchar().str(), "World", "invalid varchar value");
+  item->set_cstr("cstr", 5);
+
+  std::string str;
+  UNIT_ASSERT_TRUE(item->get("val_cstr", str), "couldn't get character array value");
+  UNIT_ASSERT_EQUAL(str, "cstr", "invalid character array value");
+  UNIT_ASSERT_TRUE(item->get("val_int", str), "couldn't get int value as string");
+  UNIT_ASSERT_EQUAL(str, "4711", "invalid int value");
+
+  item->set_double(1.23456);
+  UNIT_ASSERT_TRUE(item->get("val_double", str, 2), "couldn't get double value as string");
+  UNIT_ASSERT_EQUAL(str, "1.23", "invalid double value");
+
+  long id = 0;
+  UNIT_ASSERT_TRUE(item->get("id", id), "couldn't get id");
+  UNIT_ASSERT_EQUAL(id, item.id(), "invalid id");
+
+  // unknown fields are still searched by the visitor
+  UNIT_ASSERT_FALSE(item->get("unknown", ival), "unknown field must not be found");
+  UNIT_ASSERT_FALSE(item->set("unknown", ival), "unknown field must not be found");
+}
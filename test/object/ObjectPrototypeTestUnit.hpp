@@ -18,6 +18,7 @@ public:
   void prototype_hierachy();
   void prototype_traverse();
   void prototype_relation();
+  void prototype_field_index();
 };
 
 #endif /* OBJECT_PROTOTYPE_TESTUNIT_HPP */
@@ -4,6 +4,8 @@
 #include "object/object_expression.hpp"
 #include "object/object_serializer.hpp"
 #include "object/object_view.hpp"
+#include "object/change_stream.hpp"
+#include "object/object_snapshot.hpp"
 
 #include "tools/byte_buffer.hpp"
 #include "tools/algorithm.hpp"
@@ -12,6 +14,11 @@
 
 #include <algorithm>
 #include <iostream>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <set>
+#include <mutex>
 
 using namespace oos;
 using namespace std;
@@ -24,6 +31,8 @@ ObjectStoreTestUnit::ObjectStoreTestUnit()
   add_test("set", std::tr1::bind(&ObjectStoreTestUnit::set_test, this), "access object values via set interface");
   add_test("get", std::tr1::bind(&ObjectStoreTestUnit::get_test, this), "access object values via get interface");
   add_test("serializer", std::tr1::bind(&ObjectStoreTestUnit::serializer, this), "serializer test");
+  add_test("serializer_versions", std::tr1::bind(&ObjectStoreTestUnit::serializer_versions, this), "fixed and compact serializer encoding test");
+  add_test("fields", std::tr1::bind(&ObjectStoreTestUnit::fields_test, this), "static field description test");
   add_test("ref_ptr_counter", std::tr1::bind(&ObjectStoreTestUnit::ref_ptr_counter, this), "ref and ptr counter test");
   add_test("simple", std::tr1::bind(&ObjectStoreTestUnit::simple_object, this), "create and delete one object");
   add_test("with_sub", std::tr1::bind(&ObjectStoreTestUnit::object_with_sub_object, this), "create and delete object with sub object");
@@ -35,6 +44,15 @@ ObjectStoreTestUnit::ObjectStoreTestUnit()
   add_test("view", std::tr1::bind(&ObjectStoreTestUnit::view_test, this), "object view test");
   add_test("clear", std::tr1::bind(&ObjectStoreTestUnit::clear_test, this), "object store clear test");
   add_test("generic", std::tr1::bind(&ObjectStoreTestUnit::generic_test, this), "generic object access test");
+  add_test("concurrent", std::tr1::bind(&ObjectStoreTestUnit::concurrent_test, this), "concurrent readers and one writer test");
+  add_test("concurrent_markers", std::tr1::bind(&ObjectStoreTestUnit::concurrent_markers, this), "concurrent readers and one writer removing neighbour objects test");
+  add_test("sharded", std::tr1::bind(&ObjectStoreTestUnit::sharded_test, this), "parallel inserting writers test");
+  add_test("change_stream", std::tr1::bind(&ObjectStoreTestUnit::change_stream_test, this), "change data capture test");
+  add_test("change_stream_threads", std::tr1::bind(&ObjectStoreTestUnit::change_stream_threads, this), "change data capture with consumer threads test");
+  add_test("snapshot", std::tr1::bind(&ObjectStoreTestUnit::snapshot_test, this), "copy on write snapshot test");
+  add_test("snapshot_threads", std::tr1::bind(&ObjectStoreTestUnit::snapshot_threads, this), "snapshot readers and one writer test");
+  add_test("versioning", std::tr1::bind(&ObjectStoreTestUnit::versioning_test, this), "multi version read token test");
+  add_test("versioning_threads", std::tr1::bind(&ObjectStoreTestUnit::versioning_threads, this), "multi version readers and one writer test");
 //  add_test("structure", std::tr1::bind(&ObjectStoreTestUnit::test_structure, this), "object structure test");
 }
 
@@ -214,6 +232,98 @@ ObjectStoreTestUnit::serializer()
   delete item;
 }
 
+void
+ObjectStoreTestUnit::serializer_versions()
+{
+  typedef object_ptr<Item> item_ptr;
+  typedef object_ptr<ObjectItem<Item> > object_item_ptr;
+
+  item_ptr item = ostore_.insert(new Item("Item", 7));
+  ObjectItem<Item> *oi = new ObjectItem<Item>("ObjectItem", -4711);
+  oi->ptr(item);
+  object_item_ptr object_item = ostore_.insert(oi);
+
+  object_serializer fixed_serializer(object_serializer::fixed);
+  object_serializer compact_serializer;
+
+  UNIT_ASSERT_EQUAL(compact_serializer.version(), object_serializer::compact, "default version must be compact");
+
+  byte_buffer fixed_buffer;
+  fixed_serializer.serialize(object_item.get(), fixed_buffer);
+  byte_buffer compact_buffer;
+  compact_serializer.serialize(object_item.get(), compact_buffer);
+
+  UNIT_ASSERT_LESS(compact_buffer.size(), fixed_buffer.size(), "compact encoding must be smaller than fixed encoding");
+
+  // each serializer reads the encoding it finds in the buffer
+  ObjectItem<Item> from_fixed;
+  compact_serializer.deserialize(&from_fixed, fixed_buffer, &ostore_);
+  ObjectItem<Item> from_compact;
+  fixed_serializer.deserialize(&from_compact, compact_buffer, &ostore_);
+
+  UNIT_ASSERT_EQUAL(from_fixed.get_int(), -4711, "restored int is not equal to the original int");
+  UNIT_ASSERT_EQUAL(from_compact.get_int(), -4711, "restored int is not equal to the original int");
+  UNIT_ASSERT_EQUAL(from_fixed.get_string(), "ObjectItem", "restored string is not equal to the original string");
+  UNIT_ASSERT_EQUAL(from_compact.get_string(), "ObjectItem", "restored string is not equal to the original string");
+  UNIT_ASSERT_EQUAL(from_fixed.ptr().id(), item.id(), "restored reference is not equal to the original reference");
+  UNIT_ASSERT_EQUAL(from_compact.ptr().id(), item.id(), "restored reference is not equal to the original reference");
+  UNIT_ASSERT_EQUAL(compact_buffer.size(), (byte_buffer::size_type)0, "compact buffer must be consumed");
+  UNIT_ASSERT_EQUAL(fixed_buffer.size(), (byte_buffer::size_type)0, "fixed buffer must be consumed");
+}
+
+void
+ObjectStoreTestUnit::fields_test()
+{
+  UNIT_ASSERT_TRUE(has_fields<DescribedItem>::value, "DescribedItem must have a field description");
+  UNIT_ASSERT_FALSE(has_fields<Item>::value, "Item must not have a field description");
+  UNIT_ASSERT_FALSE(has_fields<object>::value, "object must not have a field description");
+
+  object_store ostore;
+  ostore.insert_prototype<Item>("item");
+  ostore.insert_prototype<DescribedItem>("described_item");
+
+  typedef object_ptr<Item> item_ptr;
+  typedef object_ptr<DescribedItem> described_item_ptr;
+
+  item_ptr item = ostore.insert(new Item("Item", 7));
+  DescribedItem *di = new DescribedItem("Described", 42);
+  di->set_cstr("cstr", 5);
+  di->ptr(item);
+  described_item_ptr described = ostore.insert(di);
+
+  // inserted: static walk, detached: virtual walk
+  object_serializer serializer;
+  byte_buffer buffer;
+  serializer.serialize(described.get(), buffer);
+  DescribedItem restored;
+  serializer.deserialize(&restored, buffer, &ostore);
+
+  UNIT_ASSERT_EQUAL(restored.id(), described.id(), "restored id is not equal to the original id");
+  UNIT_ASSERT_EQUAL(restored.get_int(), 42, "restored int is not equal to the original int");
+  UNIT_ASSERT_EQUAL(restored.get_long(), described->get_long(), "restored long is not equal to the original long");
+  UNIT_ASSERT_EQUAL(restored.get_double(), described->get_double(), "restored double is not equal to the original double");
+  UNIT_ASSERT_TRUE(restored.get_bool(), "restored bool is not equal to the original bool");
+  UNIT_ASSERT_EQUAL(std::string(restored.get_cstr()), "cstr", "restored character array is not equal to the original");
+  UNIT_ASSERT_EQUAL(restored.get_string(), "Described", "restored string is not equal to the original string");
+  UNIT_ASSERT_EQUAL(restored.get_varchar().str(), "Erde", "restored varchar is not equal to the original varchar");
+  UNIT_ASSERT_EQUAL(restored.ptr().id(), item.id(), "restored reference is not equal to the original reference");
+  UNIT_ASSERT_EQUAL(buffer.size(), (byte_buffer::size_type)0, "buffer must be consumed");
+
+  // and back into the inserted object
+  restored.set_int(4711);
+  serializer.serialize(&restored, buffer);
+  serializer.deserialize(described.get(), buffer, &ostore);
+  UNIT_ASSERT_EQUAL(described->get_int(), 4711, "restored int is not equal to the original int");
+  UNIT_ASSERT_EQUAL(described->get_string(), "Described", "restored string is not equal to the original string");
+
+  // the generic attribute access uses the same description
+  std::string str;
+  UNIT_ASSERT_TRUE(restored.get("val_string", str), "couldn't get string value");
+  UNIT_ASSERT_EQUAL(str, "Described", "invalid string value");
+  UNIT_ASSERT_TRUE(restored.set("val_int", 17), "couldn't set int value");
+  UNIT_ASSERT_EQUAL(restored.get_int(), 17, "invalid int value");
+}
+
 void
 ObjectStoreTestUnit::ref_ptr_counter()
 {
@@ -662,3 +772,865 @@ void ObjectStoreTestUnit::test_structure()
   
   object_item_ptr optr = ostore_.insert(oi);
 }
+
+struct concurrent_reader
+{
+  concurrent_reader(const object_store &ostore, const std::atomic<bool> &stop)
+    : ostore_(ostore), stop_(stop), rounds(0), errors(0)
+  {}
+
+  void operator()()
+  {
+    typedef object_view<Item> item_view_t;
+    while (!stop_) {
+      object_store::read_guard guard(ostore_);
+      item_view_t oview(ostore_);
+      int count = 0;
+      for (item_view_t::iterator i = oview.begin(); i != oview.end(); ++i) {
+        object_ptr<Item> item = *i;
+        if (item->get_int() < 0 || item->get_int() >= 2000) {
+          ++errors;
+        }
+        ++count;
+      }
+      if (count < 100 || count > 101) {
+        ++errors;
+      }
+      ++rounds;
+    }
+  }
+
+  const object_store &ostore_;
+  const std::atomic<bool> &stop_;
+  long rounds;
+  long errors;
+};
+
+void
+ObjectStoreTestUnit::concurrent_test()
+{
+  typedef object_ptr<Item> item_ptr;
+
+  ostore_.concurrent(true);
+
+  UNIT_ASSERT_TRUE(ostore_.concurrent(), "store must be concurrent");
+
+  for (int i = 0; i < 100; ++i) {
+    ostore_.insert(new Item("Item", i));
+  }
+
+  std::atomic<bool> stop(false);
+  std::vector<concurrent_reader> readers(4, concurrent_reader(ostore_, stop));
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < readers.size(); ++i) {
+    threads.push_back(std::thread(std::ref(readers[i])));
+  }
+
+  // one writer inserts and removes
+  for (int i = 0; i < 1000; ++i) {
+    item_ptr item = ostore_.insert(new Item("Writer", 1000 + i));
+    ostore_.remove(item);
+  }
+
+  stop = true;
+  for (size_t i = 0; i < threads.size(); ++i) {
+    threads[i].join();
+  }
+
+  for (size_t i = 0; i < readers.size(); ++i) {
+    UNIT_ASSERT_EQUAL(readers[i].errors, 0L, "reader saw an invalid state");
+  }
+
+  typedef object_view<Item> item_view_t;
+  item_view_t oview(ostore_);
+  UNIT_ASSERT_EQUAL((int)oview.size(), 100, "invalid number of items");
+
+  ostore_.concurrent(false);
+
+  UNIT_ASSERT_FALSE(ostore_.concurrent(), "store must not be concurrent");
+}
+
+struct marker_reader
+{
+  marker_reader(const object_store &ostore, const std::atomic<bool> &stop)
+    : ostore_(ostore), stop_(stop), rounds(0), errors(0)
+  {}
+
+  void operator()()
+  {
+    while (!stop_) {
+      object_store::read_guard guard(ostore_);
+      // the view must end before the objects of the next type
+      object_view<ItemA> aview(ostore_);
+      // the end is taken once, it must stay reachable
+      object_view<ItemA>::iterator last = aview.end();
+      int count = 0;
+      for (object_view<ItemA>::iterator i = aview.begin(); i != last; ++i) {
+        object_ptr<ItemA> item = *i;
+        if (!dynamic_cast<ItemA*>(item.ptr()) || item->get_int() < 0 || item->get_int() >= 100) {
+          ++errors;
+        }
+        ++count;
+        // let the writer move the neighbours
+        std::this_thread::yield();
+      }
+      if (count != 100) {
+        ++errors;
+      }
+      // the subtree view skips the markers of the children
+      object_view<Item> view(ostore_);
+      object_view<Item>::iterator view_last = view.end();
+      count = 0;
+      for (object_view<Item>::iterator i = view.begin(); i != view_last; ++i) {
+        if (!i.optr().ptr()) {
+          ++errors;
+        }
+        ++count;
+      }
+      if (count < 200 || count > 302) {
+        ++errors;
+      }
+      ++rounds;
+    }
+  }
+
+  const object_store &ostore_;
+  const std::atomic<bool> &stop_;
+  long rounds;
+  long errors;
+};
+
+void
+ObjectStoreTestUnit::concurrent_markers()
+{
+  object_store ostore;
+  ostore.insert_prototype<Item>("item");
+  ostore.insert_prototype<ItemA, Item>("item_a");
+  ostore.insert_prototype<ItemB, Item>("item_b");
+
+  ostore.concurrent(true);
+
+  for (int i = 0; i < 100; ++i) {
+    ostore.insert(new Item("Item", i));
+    ItemA *a = new ItemA;
+    a->set_int(i);
+    ostore.insert(a);
+  }
+
+  std::atomic<bool> stop(false);
+  std::vector<marker_reader> readers(2, marker_reader(ostore, stop));
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < readers.size(); ++i) {
+    threads.push_back(std::thread(std::ref(readers[i])));
+  }
+
+  /*
+   * the writer empties and refills the node
+   * following the objects of ItemA and removes
+   * the first and last objects of each node
+   */
+  std::vector<object_ptr<ItemB> > bitems;
+  for (int round = 0; round < 200; ++round) {
+    for (int i = 0; i < 100; ++i) {
+      bitems.push_back(ostore.insert(new ItemB));
+    }
+    object_ptr<Item> item = ostore.insert(new Item("Item", 100));
+    ostore.remove(item);
+    ItemA *a = new ItemA;
+    a->set_int(50);
+    object_ptr<ItemA> aitem = ostore.insert(a);
+    ostore.remove(aitem);
+    while (!bitems.empty()) {
+      ostore.remove(bitems.back());
+      bitems.pop_back();
+      if (!bitems.empty()) {
+        ostore.remove(bitems.front());
+        bitems.erase(bitems.begin());
+      }
+    }
+  }
+
+  stop = true;
+  for (size_t i = 0; i < threads.size(); ++i) {
+    threads[i].join();
+  }
+
+  for (size_t i = 0; i < readers.size(); ++i) {
+    UNIT_ASSERT_GREATER(readers[i].rounds, 0L, "reader must read");
+    UNIT_ASSERT_EQUAL(readers[i].errors, 0L, "reader walked beyond its view");
+  }
+
+  UNIT_ASSERT_EQUAL((int)object_view<ItemA>(ostore).size(), 100, "invalid number of items");
+  UNIT_ASSERT_TRUE(object_view<ItemB>(ostore).empty(), "items must be removed");
+
+  ostore.concurrent(false);
+}
+
+template < class T >
+struct sharded_writer
+{
+  sharded_writer(object_store &ostore, int offset)
+    : ostore_(ostore), offset_(offset)
+  {}
+
+  void operator()()
+  {
+    for (int i = 0; i < 500; ++i) {
+      T *item = new T;
+      item->set_int(offset_ + i);
+      ostore_.insert(item);
+    }
+  }
+
+  object_store &ostore_;
+  int offset_;
+};
+
+template < class T >
+void collect_items(object_store &ostore, std::set<long> &ids, std::vector<int> &values)
+{
+  object_view<T> oview(ostore);
+  for (typename object_view<T>::iterator i = oview.begin(); i != oview.end(); ++i) {
+    ids.insert((*i)->id());
+    ++values[(*i)->get_int()];
+  }
+}
+
+void
+ObjectStoreTestUnit::sharded_test()
+{
+  // two unrelated types, each one a shard
+  ostore_.insert_prototype<ItemA>("ITEM_A");
+  ostore_.insert_prototype<ItemB>("ITEM_B");
+
+  ostore_.sharded(true, 64);
+
+  UNIT_ASSERT_TRUE(ostore_.sharded(), "store must be sharded");
+  UNIT_ASSERT_TRUE(ostore_.concurrent(), "store must be concurrent");
+
+  std::vector<std::thread> threads;
+  threads.push_back(std::thread(sharded_writer<ItemA>(ostore_, 0)));
+  threads.push_back(std::thread(sharded_writer<ItemA>(ostore_, 500)));
+  threads.push_back(std::thread(sharded_writer<ItemB>(ostore_, 0)));
+  threads.push_back(std::thread(sharded_writer<ItemB>(ostore_, 500)));
+  for (size_t i = 0; i < threads.size(); ++i) {
+    threads[i].join();
+  }
+
+  UNIT_ASSERT_EQUAL((int)object_view<ItemA>(ostore_).size(), 1000, "invalid number of items");
+  UNIT_ASSERT_EQUAL((int)object_view<ItemB>(ostore_).size(), 1000, "invalid number of items");
+
+  // all ids must be unique and all values present
+  std::set<long> ids;
+  std::vector<int> avalues(1000, 0);
+  std::vector<int> bvalues(1000, 0);
+  collect_items<ItemA>(ostore_, ids, avalues);
+  collect_items<ItemB>(ostore_, ids, bvalues);
+
+  UNIT_ASSERT_EQUAL((int)ids.size(), 2000, "ids aren't unique");
+  UNIT_ASSERT_EQUAL((int)std::count(avalues.begin(), avalues.end(), 1), 1000, "missing items");
+  UNIT_ASSERT_EQUAL((int)std::count(bvalues.begin(), bvalues.end(), 1), 1000, "missing items");
+
+  // a single thread still works
+  object_ptr<Item> item = ostore_.insert(new Item("Item", 7));
+  UNIT_ASSERT_TRUE(ids.find(item->id()) == ids.end(), "id already used");
+
+  // an id imported from the reserved block drops the block
+  Item *imported = new Item("Imported", 8);
+  imported->id(item->id() + 1);
+  object_ptr<Item> imported_item = ostore_.insert(imported);
+  object_ptr<Item> next = ostore_.insert(new Item("Item", 9));
+  UNIT_ASSERT_TRUE(next->id() > imported_item->id(), "imported id handed out again");
+  ostore_.remove(next);
+  ostore_.remove(imported_item);
+  ostore_.remove(item);
+
+  ostore_.sharded(false);
+
+  UNIT_ASSERT_FALSE(ostore_.sharded(), "store must not be sharded");
+
+  ostore_.concurrent(false);
+}
+
+void
+ObjectStoreTestUnit::change_stream_test()
+{
+  typedef object_ptr<Item> item_ptr;
+
+  oos::change_stream changes(4, true);
+  UNIT_ASSERT_EQUAL(changes.capacity(), (size_t)4, "invalid capacity");
+
+  ostore_.register_observer(&changes);
+
+  item_ptr item = ostore_.insert(new Item("Item", 7));
+  item->set_int(8);
+  ostore_.remove(item);
+
+  change_record rec;
+  UNIT_ASSERT_TRUE(changes.pop(rec), "expected insert record");
+  UNIT_ASSERT_EQUAL(rec.op, change_record::insert_op, "invalid operation");
+  UNIT_ASSERT_EQUAL(rec.sequence, 1ULL, "invalid sequence");
+  UNIT_ASSERT_EQUAL(rec.type_id, ostore_.find_prototype<Item>()->id, "invalid type id");
+  UNIT_ASSERT_GREATER(rec.object_id, 0L, "invalid object id");
+  UNIT_ASSERT_FALSE(rec.image.empty(), "image must be captured");
+
+  // the image holds the inserted object
+  byte_buffer buffer;
+  buffer.append(&rec.image[0], rec.image.size());
+  Item restored;
+  object_serializer serializer;
+  serializer.deserialize(&restored, buffer, 0);
+  UNIT_ASSERT_EQUAL(restored.get_int(), 7, "invalid image");
+  UNIT_ASSERT_EQUAL(restored.id(), rec.object_id, "invalid image");
+
+  long id = rec.object_id;
+  UNIT_ASSERT_TRUE(changes.pop(rec), "expected update record");
+  UNIT_ASSERT_EQUAL(rec.op, change_record::update_op, "invalid operation");
+  UNIT_ASSERT_EQUAL(rec.object_id, id, "invalid object id");
+  UNIT_ASSERT_EQUAL(rec.sequence, 2ULL, "invalid sequence");
+
+  // the image holds the object after the change
+  buffer.clear();
+  buffer.append(&rec.image[0], rec.image.size());
+  serializer.deserialize(&restored, buffer, 0);
+  UNIT_ASSERT_EQUAL(restored.get_int(), 8, "update image must hold the new value");
+  UNIT_ASSERT_TRUE(changes.pop(rec), "expected delete record");
+  UNIT_ASSERT_EQUAL(rec.op, change_record::delete_op, "invalid operation");
+  UNIT_ASSERT_EQUAL(rec.sequence, 3ULL, "invalid sequence");
+  UNIT_ASSERT_FALSE(changes.pop(rec), "stream must be empty");
+
+  // a full stream drops changes instead of blocking
+  for (int i = 0; i < 6; ++i) {
+    ostore_.insert(new Item("Item", i));
+  }
+  ostore_.unregister_observer(&changes);
+
+  UNIT_ASSERT_EQUAL(changes.dropped(), 2ULL, "two changes must be dropped");
+  unsigned long long last = 3;
+  int count = 0;
+  while (changes.pop(rec)) {
+    UNIT_ASSERT_EQUAL(rec.sequence, last + 1, "invalid sequence");
+    last = rec.sequence;
+    ++count;
+  }
+  UNIT_ASSERT_EQUAL(count, 4, "invalid number of records");
+}
+
+namespace {
+
+struct change_consumer
+{
+  change_consumer(oos::change_stream &c, std::atomic<bool> &d, std::vector<unsigned long long> &s)
+    : changes(c), done(d), sequences(s)
+  {}
+
+  void operator()()
+  {
+    change_record rec;
+    for (;;) {
+      if (changes.pop(rec)) {
+        sequences.push_back(rec.sequence);
+      } else if (done) {
+        // drain the rest
+        while (changes.pop(rec)) {
+          sequences.push_back(rec.sequence);
+        }
+        return;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+  }
+
+  oos::change_stream &changes;
+  std::atomic<bool> &done;
+  std::vector<unsigned long long> &sequences;
+};
+
+}
+
+void
+ObjectStoreTestUnit::change_stream_threads()
+{
+  typedef object_ptr<Item> item_ptr;
+
+  object_store ostore;
+  ostore.insert_prototype<Item>("item");
+
+  oos::change_stream changes(256);
+  ostore.register_observer(&changes);
+
+  std::atomic<bool> done(false);
+  std::vector<unsigned long long> first, second;
+  std::thread consumer1((change_consumer(changes, done, first)));
+  std::thread consumer2((change_consumer(changes, done, second)));
+
+  const int count = 5000;
+  for (int i = 0; i < count; ++i) {
+    item_ptr item = ostore.insert(new Item("Item", i));
+    item->set_int(i + 1);
+  }
+  done = true;
+  consumer1.join();
+  consumer2.join();
+
+  ostore.unregister_observer(&changes);
+
+  std::set<unsigned long long> seen(first.begin(), first.end());
+  seen.insert(second.begin(), second.end());
+
+  UNIT_ASSERT_EQUAL(seen.size(), first.size() + second.size(), "record consumed twice");
+  UNIT_ASSERT_EQUAL((unsigned long long)seen.size() + changes.dropped(), (unsigned long long)(2 * count), "records lost");
+  UNIT_ASSERT_TRUE(std::is_sorted(first.begin(), first.end()), "records out of order");
+  UNIT_ASSERT_TRUE(std::is_sorted(second.begin(), second.end()), "records out of order");
+}
+
+namespace {
+
+struct item_sum
+{
+  item_sum(int &s, int &c) : sum(s), count(c) {}
+
+  void operator()(const Item &item)
+  {
+    sum += item.get_int();
+    ++count;
+  }
+
+  int &sum;
+  int &count;
+};
+
+struct item_value
+{
+  explicit item_value(int &v) : value(v) {}
+
+  void operator()(const object &o)
+  {
+    value = static_cast<const Item&>(o).get_int();
+  }
+
+  int &value;
+};
+
+}
+
+void
+ObjectStoreTestUnit::snapshot_test()
+{
+  typedef object_ptr<Item> item_ptr;
+
+  std::vector<item_ptr> items;
+  for (int i = 0; i < 10; ++i) {
+    items.push_back(ostore_.insert(new Item("Item", i)));
+  }
+
+  object_store::snapshot_ptr snap = ostore_.snapshot();
+
+  UNIT_ASSERT_EQUAL(snap->size(), (size_t)10, "invalid snapshot size");
+  UNIT_ASSERT_EQUAL(snap->preserved(), (size_t)0, "nothing must be preserved");
+
+  // change, insert and remove after the snapshot
+  items[2]->set_int(200);
+  items[2]->set_int(2000);
+  items[3]->set_string("Changed");
+  ostore_.insert(new Item("New", 100));
+  long removed_id = items[5]->id();
+  ostore_.remove(items[5]);
+  items.erase(items.begin() + 5);
+
+  UNIT_ASSERT_EQUAL(snap->preserved(), (size_t)3, "invalid number of preserved objects");
+
+  int sum = 0, count = 0;
+  snap->for_each<Item>(item_sum(sum, count));
+  UNIT_ASSERT_EQUAL(count, 10, "invalid number of snapshot objects");
+  UNIT_ASSERT_EQUAL(sum, 45, "snapshot must show the old values");
+
+  int value = -1;
+  UNIT_ASSERT_TRUE(snap->find(items[2]->id(), item_value(value)), "changed object must be visible");
+  UNIT_ASSERT_EQUAL(value, 2, "invalid old value");
+  UNIT_ASSERT_EQUAL(items[2]->get_int(), 2000, "invalid current value");
+  UNIT_ASSERT_TRUE(snap->find(removed_id, item_value(value)), "removed object must be visible");
+  UNIT_ASSERT_EQUAL(value, 5, "invalid removed value");
+  UNIT_ASSERT_FALSE(snap->find(100000, item_value(value)), "unknown object must not be visible");
+
+  // a second snapshot sees the current state
+  object_store::snapshot_ptr current = ostore_.snapshot();
+  UNIT_ASSERT_EQUAL(current->size(), (size_t)10, "invalid snapshot size");
+  sum = count = 0;
+  current->for_each<Item>(item_sum(sum, count));
+  UNIT_ASSERT_EQUAL(sum, 45 - 2 + 2000 - 5 + 100, "snapshot must show the current values");
+
+  // released snapshots don't preserve anything
+  snap.reset();
+  items[4]->set_int(400);
+  UNIT_ASSERT_EQUAL(current->preserved(), (size_t)1, "invalid number of preserved objects");
+  current.reset();
+  items[4]->set_int(4000);
+
+  // clearing the store invalidates the snapshots
+  object_store::snapshot_ptr outliving;
+  {
+    object_store ostore;
+    ostore.insert_prototype<Item>("item");
+    long id = ostore.insert(new Item("Item", 1))->id();
+
+    object_store::snapshot_ptr cleared = ostore.snapshot();
+    ostore.clear();
+    bool caught = false;
+    try {
+      cleared->find(id, item_value(value));
+    } catch (object_exception &) {
+      caught = true;
+    }
+    UNIT_ASSERT_TRUE(caught, "cleared snapshot must not be read");
+
+    id = ostore.insert(new Item("Item", 2))->id();
+    outliving = ostore.snapshot();
+    UNIT_ASSERT_TRUE(outliving->find(id, item_value(value)), "inserted object must be visible");
+    UNIT_ASSERT_EQUAL(value, 2, "invalid value");
+  }
+  bool caught = false;
+  try {
+    sum = count = 0;
+    outliving->for_each<Item>(item_sum(sum, count));
+  } catch (object_exception &) {
+    caught = true;
+  }
+  UNIT_ASSERT_TRUE(caught, "snapshot of destroyed store must not be read");
+  outliving.reset();
+}
+
+namespace {
+
+struct snapshot_reader
+{
+  snapshot_reader(std::mutex &m, object_store::snapshot_ptr &c, std::atomic<bool> &d, std::atomic<int> &s, std::atomic<int> &e)
+    : mutex(m), current(c), done(d), scans(s), errors(e)
+  {}
+
+  void operator()()
+  {
+    while (!done) {
+      object_store::snapshot_ptr snap;
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        snap = current;
+      }
+      int first = scan(*snap);
+      // the same snapshot always shows the same state
+      if (first < 0 || scan(*snap) != first) {
+        ++errors;
+      }
+      ++scans;
+    }
+  }
+
+  int scan(const object_snapshot &snap)
+  {
+    int sum = 0;
+    int torn = 0;
+    snap.for_each<Item>(item_check(sum, torn));
+    return (torn ? -1 : sum);
+  }
+
+  struct item_check
+  {
+    item_check(int &s, int &t) : sum(s), torn(t) {}
+
+    void operator()(const Item &item)
+    {
+      // int and long are changed together
+      if ((long)item.get_int() != item.get_long()) {
+        ++torn;
+      }
+      sum += item.get_int();
+    }
+
+    int &sum;
+    int &torn;
+  };
+
+  std::mutex &mutex;
+  object_store::snapshot_ptr &current;
+  std::atomic<bool> &done;
+  std::atomic<int> &scans;
+  std::atomic<int> &errors;
+};
+
+}
+
+void
+ObjectStoreTestUnit::snapshot_threads()
+{
+  typedef object_ptr<Item> item_ptr;
+
+  object_store ostore;
+  ostore.insert_prototype<Item>("item");
+
+  std::vector<item_ptr> items;
+  for (int i = 0; i < 100; ++i) {
+    Item *item = new Item("Item", i);
+    item->set_long(i);
+    items.push_back(ostore.insert(item));
+  }
+
+  std::mutex mutex;
+  object_store::snapshot_ptr current = ostore.snapshot();
+  std::atomic<bool> done(false);
+  std::atomic<int> scans(0);
+  std::atomic<int> errors(0);
+
+  std::thread reader1((snapshot_reader(mutex, current, done, scans, errors)));
+  std::thread reader2((snapshot_reader(mutex, current, done, scans, errors)));
+
+  for (int i = 0; i < 20000; ++i) {
+    {
+      item_ptr item = items[i % items.size()];
+      item->set_int(item->get_int() + 1);
+      item->set_long(item->get_long() + 1);
+    }
+    if (i % 100 == 0) {
+      // replace one object
+      ostore.remove(items[0]);
+      items.erase(items.begin());
+      Item *o = new Item("Item", i);
+      o->set_long(i);
+      items.push_back(ostore.insert(o));
+    }
+    if (i % 1000 == 0) {
+      object_store::snapshot_ptr snap = ostore.snapshot();
+      std::lock_guard<std::mutex> lock(mutex);
+      current = snap;
+    }
+  }
+  done = true;
+  reader1.join();
+  reader2.join();
+
+  UNIT_ASSERT_GREATER(scans.load(), 0, "readers must scan");
+  UNIT_ASSERT_EQUAL(errors.load(), 0, "readers must see consistent snapshots");
+
+  current.reset();
+}
+
+void
+ObjectStoreTestUnit::versioning_test()
+{
+  typedef object_ptr<Item> item_ptr;
+
+  std::vector<item_ptr> items;
+  for (int i = 0; i < 10; ++i) {
+    items.push_back(ostore_.insert(new Item("Item", i)));
+  }
+
+  ostore_.versioning(true);
+
+  UNIT_ASSERT_TRUE(ostore_.versioning(), "store must keep versions");
+  UNIT_ASSERT_TRUE(ostore_.concurrent(), "store must be concurrent");
+  UNIT_ASSERT_EQUAL(ostore_.committed_version(), 1ULL, "invalid commit sequence");
+  UNIT_ASSERT_EQUAL(ostore_.version_count(), (size_t)10, "invalid number of versions");
+
+  long removed_id = items[5]->id();
+  long changed_id = items[2]->id();
+  int sum = 0, count = 0;
+  {
+    object_store::read_token first(ostore_);
+
+    // change, insert and remove after the token was taken
+    items[2]->set_int(200);
+    items[3]->set_string("Changed");
+    long inserted_id = ostore_.insert(new Item("New", 100)).id();
+    ostore_.remove(items[5]);
+    items.erase(items.begin() + 5);
+
+    // nothing is visible before the commit
+    object_store::read_token uncommitted(ostore_);
+    uncommitted.for_each<Item>(item_sum(sum, count));
+    UNIT_ASSERT_EQUAL(count, 10, "invalid number of visible objects");
+    UNIT_ASSERT_EQUAL(sum, 45, "uncommitted changes must not be visible");
+    UNIT_ASSERT_NULL(uncommitted.find(inserted_id), "uncommitted insert must not be visible");
+
+    UNIT_ASSERT_EQUAL(ostore_.commit_versions(), 2ULL, "invalid commit sequence");
+
+    sum = count = 0;
+    first.for_each<Item>(item_sum(sum, count));
+    UNIT_ASSERT_EQUAL(count, 10, "invalid number of visible objects");
+    UNIT_ASSERT_EQUAL(sum, 45, "token must show the old values");
+    const Item *item = first.find<Item>(removed_id);
+    UNIT_ASSERT_NOT_NULL(item, "removed object must be visible to older token");
+    UNIT_ASSERT_EQUAL(item->get_int(), 5, "invalid removed value");
+    item = first.find<Item>(changed_id);
+    UNIT_ASSERT_NOT_NULL(item, "changed object must be visible");
+    UNIT_ASSERT_EQUAL(item->get_int(), 2, "invalid old value");
+    UNIT_ASSERT_EQUAL(first.sequence(), 1ULL, "invalid token sequence");
+
+    object_store::read_token current(ostore_);
+    sum = count = 0;
+    current.for_each<Item>(item_sum(sum, count));
+    UNIT_ASSERT_EQUAL(count, 10, "invalid number of visible objects");
+    UNIT_ASSERT_EQUAL(sum, 45 - 2 + 200 - 5 + 100, "token must show the committed values");
+    UNIT_ASSERT_NULL(current.find(removed_id), "removed object must not be visible");
+    item = current.find<Item>(inserted_id);
+    UNIT_ASSERT_NOT_NULL(item, "inserted object must be visible");
+    UNIT_ASSERT_EQUAL(item->get_int(), 100, "invalid inserted value");
+    UNIT_ASSERT_EQUAL(item->get_string(), std::string("New"), "invalid inserted value");
+
+    // one new version for the change, the string change and the insert
+    UNIT_ASSERT_EQUAL(ostore_.version_count(), (size_t)13, "invalid number of versions");
+  }
+
+  // released tokens don't keep versions
+  ostore_.commit_versions();
+  UNIT_ASSERT_EQUAL(ostore_.version_count(), (size_t)10, "old versions must be dropped");
+
+  {
+    object_store::read_token token(ostore_);
+    ostore_.remove(items[0]);
+    items.erase(items.begin());
+    ostore_.commit_versions();
+    sum = count = 0;
+    token.for_each<Item>(item_sum(sum, count));
+    UNIT_ASSERT_EQUAL(count, 10, "removed object must be visible to older token");
+    // still kept for the token
+    ostore_.commit_versions();
+    UNIT_ASSERT_EQUAL(ostore_.version_count(), (size_t)10, "visible versions must be kept");
+  }
+  ostore_.commit_versions();
+  UNIT_ASSERT_EQUAL(ostore_.version_count(), (size_t)9, "removed object versions must be dropped");
+
+  // staged changes are visible once committed
+  item_ptr staged = items.back();
+  long staged_id = staged->id();
+  int staged_value = staged->get_int();
+  staged->set_int(staged_value + 1);
+  version_batch *batch = ostore_.stage_versions();
+  staged->set_int(staged_value + 2);
+  {
+    object_store::read_token token(ostore_);
+    UNIT_ASSERT_EQUAL(token.find<Item>(staged_id)->get_int(), staged_value, "staged change must not be visible");
+  }
+  ostore_.commit_versions(batch);
+  ostore_.discard_versions();
+  ostore_.commit_versions();
+  {
+    object_store::read_token token(ostore_);
+    UNIT_ASSERT_EQUAL(token.find<Item>(staged_id)->get_int(), staged_value + 1, "only the staged change must be visible");
+  }
+
+  // a discarded removal becomes visible with the next commit
+  ostore_.remove(staged);
+  items.pop_back();
+  ostore_.discard_versions(ostore_.stage_versions());
+  {
+    object_store::read_token token(ostore_);
+    UNIT_ASSERT_NOT_NULL(token.find(staged_id), "discarded removal must not be visible");
+  }
+  ostore_.commit_versions();
+  {
+    object_store::read_token token(ostore_);
+    UNIT_ASSERT_NULL(token.find(staged_id), "removed object must not be visible");
+  }
+
+  ostore_.versioning(false);
+  UNIT_ASSERT_FALSE(ostore_.versioning(), "store must not keep versions");
+  UNIT_ASSERT_EQUAL(ostore_.version_count(), (size_t)0, "versions must be dropped");
+  ostore_.concurrent(false);
+}
+
+namespace {
+
+struct version_reader
+{
+  version_reader(const object_store &o, int t, std::atomic<bool> &d, std::atomic<int> &s, std::atomic<int> &e)
+    : ostore(o), total(t), done(d), scans(s), errors(e)
+  {}
+
+  void operator()()
+  {
+    while (!done) {
+      object_store::read_token token(ostore);
+      int first = scan(token);
+      // the same token always shows the same state
+      if (first != total || scan(token) != first) {
+        ++errors;
+      }
+      ++scans;
+    }
+  }
+
+  int scan(const object_store::read_token &token)
+  {
+    int sum = 0;
+    int torn = 0;
+    token.for_each<Item>(snapshot_reader::item_check(sum, torn));
+    return (torn ? -1 : sum);
+  }
+
+  const object_store &ostore;
+  int total;
+  std::atomic<bool> &done;
+  std::atomic<int> &scans;
+  std::atomic<int> &errors;
+};
+
+}
+
+void
+ObjectStoreTestUnit::versioning_threads()
+{
+  typedef object_ptr<Item> item_ptr;
+
+  object_store ostore;
+  ostore.insert_prototype<Item>("item");
+
+  int total = 0;
+  std::vector<item_ptr> items;
+  for (int i = 0; i < 100; ++i) {
+    Item *item = new Item("Item", i);
+    item->set_long(i);
+    items.push_back(ostore.insert(item));
+    total += i;
+  }
+
+  ostore.versioning(true);
+
+  std::atomic<bool> done(false);
+  std::atomic<int> scans(0);
+  std::atomic<int> errors(0);
+
+  std::thread reader1((version_reader(ostore, total, done, scans, errors)));
+  std::thread reader2((version_reader(ostore, total, done, scans, errors)));
+
+  for (int i = 0; i < 20000; ++i) {
+    {
+      // move one from one object to another
+      item_ptr from = items[i % items.size()];
+      item_ptr to = items[(i * 7 + 3) % items.size()];
+      from->set_int(from->get_int() - 1);
+      from->set_long(from->get_long() - 1);
+      to->set_int(to->get_int() + 1);
+      to->set_long(to->get_long() + 1);
+    }
+    if (i % 100 == 0) {
+      // replace one object by an equal one
+      Item *o = new Item("Item", items[0]->get_int());
+      o->set_long(items[0]->get_long());
+      ostore.remove(items[0]);
+      items.erase(items.begin());
+      items.push_back(ostore.insert(o));
+    }
+    if (i % 10 == 0) {
+      ostore.commit_versions();
+    }
+  }
+  done = true;
+  reader1.join();
+  reader2.join();
+
+  UNIT_ASSERT_GREATER(scans.load(), 0, "readers must scan");
+  UNIT_ASSERT_EQUAL(errors.load(), 0, "readers must see consistent versions");
+
+  ostore.commit_versions();
+  UNIT_ASSERT_EQUAL(ostore.version_count(), items.size(), "old versions must be dropped");
+}
@@ -24,6 +24,8 @@ public:
   void set_test();
   void get_test();
   void serializer();
+  void serializer_versions();
+  void fields_test();
   void ref_ptr_counter();
   void simple_object();
   void object_with_sub_object();
@@ -36,6 +38,15 @@ public:
   void clear_test();
   void generic_test();
   void test_structure();
+  void concurrent_test();
+  void concurrent_markers();
+  void sharded_test();
+  void change_stream_test();
+  void change_stream_threads();
+  void snapshot_test();
+  void snapshot_threads();
+  void versioning_test();
+  void versioning_threads();
 
 private:
   oos::object_store ostore_;
@@ -22,6 +22,8 @@
 #include "tools/BlobTestUnit.hpp"
 #include "tools/VarCharTestUnit.hpp"
 #include "tools/FactoryTestUnit.hpp"
+#include "tools/SequencerTestUnit.hpp"
+#include "tools/ByteBufferTestUnit.hpp"
 
 #include "object/ObjectStoreTestUnit.hpp"
 #include "object/ObjectPrototypeTestUnit.hpp"
@@ -49,6 +51,8 @@ int main(int argc, char *argv[])
   test_suite::instance().register_unit(new BlobTestUnit());
   test_suite::instance().register_unit(new VarCharTestUnit());
   test_suite::instance().register_unit(new FactoryTestUnit());
+  test_suite::instance().register_unit(new SequencerTestUnit());
+  test_suite::instance().register_unit(new ByteBufferTestUnit());
 
   test_suite::instance().register_unit(new ObjectPrototypeTestUnit());
   test_suite::instance().register_unit(new ObjectStoreTestUnit());
@@ -0,0 +1,173 @@
+#include "ByteBufferTestUnit.hpp"
+
+#include "tools/byte_buffer.hpp"
+
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace oos;
+
+ByteBufferTestUnit::ByteBufferTestUnit()
+  : unit_test("byte_buffer", "byte buffer test unit")
+{
+  add_test("append_release", std::tr1::bind(&ByteBufferTestUnit::append_release, this), "append and release bytes across chunks");
+  add_test("views", std::tr1::bind(&ByteBufferTestUnit::views, this), "read bytes through chunk views");
+  add_test("pool", std::tr1::bind(&ByteBufferTestUnit::pool, this), "reuse pooled chunks");
+  add_test("write", std::tr1::bind(&ByteBufferTestUnit::write, this), "write buffer to a file");
+}
+
+ByteBufferTestUnit::~ByteBufferTestUnit()
+{}
+
+namespace {
+
+std::vector<char> make_bytes(size_t size)
+{
+  std::vector<char> bytes(size);
+  for (size_t i = 0; i < size; ++i) {
+    bytes[i] = (char)(i % 251);
+  }
+  return bytes;
+}
+
+}
+
+void
+ByteBufferTestUnit::append_release()
+{
+  byte_buffer buffer;
+
+  UNIT_ASSERT_EQUAL(buffer.size(), (byte_buffer::size_type)0, "new buffer must be empty");
+
+  // spans all size classes
+  std::vector<char> in = make_bytes(50000);
+  buffer.append(&in[0], 100);
+  buffer.append(&in[100], in.size() - 100);
+
+  UNIT_ASSERT_EQUAL(buffer.size(), (byte_buffer::size_type)in.size(), "invalid buffer size");
+
+  std::vector<char> out(in.size());
+  buffer.release(&out[0], 7);
+  UNIT_ASSERT_EQUAL(buffer.size(), (byte_buffer::size_type)(in.size() - 7), "invalid buffer size");
+  buffer.release(&out[7], out.size() - 7);
+
+  UNIT_ASSERT_EQUAL(buffer.size(), (byte_buffer::size_type)0, "buffer must be empty");
+  UNIT_ASSERT_TRUE(in == out, "released bytes are not equal to the appended bytes");
+
+  // buffer is usable after being drained
+  int val = 4711;
+  buffer.append(&val, sizeof(val));
+  val = 0;
+  buffer.release(&val, sizeof(val));
+  UNIT_ASSERT_EQUAL(val, 4711, "invalid released value");
+}
+
+void
+ByteBufferTestUnit::views()
+{
+  byte_buffer buffer;
+
+  std::vector<char> in = make_bytes(2000);
+  buffer.append(&in[0], in.size());
+
+  byte_buffer::view vec[8];
+  byte_buffer::size_type count = buffer.views(vec, 8, in.size());
+
+  UNIT_ASSERT_GREATER(count, (byte_buffer::size_type)1, "bytes must span more than one chunk");
+
+  std::string str;
+  for (byte_buffer::size_type i = 0; i < count; ++i) {
+    str.append(vec[i].data, vec[i].size);
+  }
+  UNIT_ASSERT_TRUE(str == std::string(in.begin(), in.end()), "viewed bytes are not equal to the appended bytes");
+  UNIT_ASSERT_EQUAL(buffer.size(), (byte_buffer::size_type)in.size(), "views must not release bytes");
+
+  // limited view
+  count = buffer.views(vec, 8, 10);
+  UNIT_ASSERT_EQUAL(count, (byte_buffer::size_type)1, "expected one view");
+  UNIT_ASSERT_EQUAL(vec[0].size, (byte_buffer::size_type)10, "invalid view size");
+
+  buffer.discard(10);
+  count = buffer.views(vec, 1, 1);
+  UNIT_ASSERT_EQUAL(count, (byte_buffer::size_type)1, "expected one view");
+  UNIT_ASSERT_EQUAL(vec[0].data[0], in[10], "invalid byte after discard");
+  UNIT_ASSERT_EQUAL(buffer.size(), (byte_buffer::size_type)(in.size() - 10), "invalid buffer size");
+}
+
+static void fill_buffer()
+{
+  byte_buffer buffer;
+  char c = 'z';
+  buffer.append(&c, 1);
+}
+
+void
+ByteBufferTestUnit::pool()
+{
+  {
+    byte_buffer buffer;
+    char c = 'x';
+    buffer.append(&c, 1);
+  }
+  byte_buffer::size_type pooled = byte_buffer::pooled_chunks();
+  UNIT_ASSERT_GREATER(pooled, (byte_buffer::size_type)0, "chunk must be returned to the pool");
+
+  {
+    byte_buffer buffer;
+    char c = 'y';
+    buffer.append(&c, 1);
+    UNIT_ASSERT_EQUAL(byte_buffer::pooled_chunks(), pooled - 1, "chunk must be taken from the pool");
+  }
+  UNIT_ASSERT_EQUAL(byte_buffer::pooled_chunks(), pooled, "chunk must be returned to the pool");
+
+  // more chunks than a thread caches overflow to the shared pool
+  {
+    std::vector<byte_buffer*> buffers;
+    for (int i = 0; i < 16; ++i) {
+      buffers.push_back(new byte_buffer);
+      char c = 'z';
+      buffers.back()->append(&c, 1);
+    }
+    for (size_t i = 0; i < buffers.size(); ++i) {
+      delete buffers[i];
+    }
+  }
+  pooled = byte_buffer::pooled_chunks();
+
+  // another thread takes a chunk from the shared pool
+  // and hands it back from its own cache at exit
+  std::thread t(fill_buffer);
+  t.join();
+  UNIT_ASSERT_EQUAL(byte_buffer::pooled_chunks(), pooled, "chunk of thread must be returned to the pool");
+}
+
+void
+ByteBufferTestUnit::write()
+{
+  byte_buffer buffer;
+
+  std::vector<char> in = make_bytes(30000);
+  buffer.append(&in[0], in.size());
+
+  std::FILE *file = tmpfile();
+  UNIT_ASSERT_TRUE(file != 0, "couldn't create temporary file");
+
+  UNIT_ASSERT_EQUAL(buffer.write(file), (byte_buffer::size_type)in.size(), "invalid number of written bytes");
+#ifndef WIN32
+  fflush(file);
+  UNIT_ASSERT_EQUAL(buffer.writev(fileno(file)), (long)in.size(), "invalid number of written bytes");
+#endif
+  UNIT_ASSERT_EQUAL(buffer.size(), (byte_buffer::size_type)in.size(), "writing must not release bytes");
+
+  rewind(file);
+  std::vector<char> out(in.size());
+  UNIT_ASSERT_EQUAL(fread(&out[0], 1, out.size(), file), out.size(), "couldn't read written bytes");
+  UNIT_ASSERT_TRUE(in == out, "written bytes are not equal to the appended bytes");
+#ifndef WIN32
+  UNIT_ASSERT_EQUAL(fread(&out[0], 1, out.size(), file), out.size(), "couldn't read gathered bytes");
+  UNIT_ASSERT_TRUE(in == out, "gathered bytes are not equal to the appended bytes");
+#endif
+  fclose(file);
+}
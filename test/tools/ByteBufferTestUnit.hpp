@@ -0,0 +1,24 @@
+#ifndef BYTEBUFFERTESTUNIT_HPP
+#define BYTEBUFFERTESTUNIT_HPP
+
+#include "unit/unit_test.hpp"
+
+class ByteBufferTestUnit : public oos::unit_test
+{
+public:
+  ByteBufferTestUnit();
+  ~ByteBufferTestUnit();
+
+  void append_release();
+  void views();
+  void pool();
+  void write();
+
+  /**
+   * Initializes a test unit
+   */
+  virtual void initialize() {}
+  virtual void finalize() {}
+};
+
+#endif /* BYTEBUFFERTESTUNIT_HPP */
@@ -0,0 +1,136 @@
+#include "SequencerTestUnit.hpp"
+
+#include "tools/sequencer.hpp"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+using namespace oos;
+
+SequencerTestUnit::SequencerTestUnit()
+  : unit_test("sequencer", "sequencer test unit")
+{
+  add_test("default", std::tr1::bind(&SequencerTestUnit::default_sequencer, this), "default sequencer");
+  add_test("atomic", std::tr1::bind(&SequencerTestUnit::atomic_sequencer, this), "atomic sequencer");
+  add_test("threads", std::tr1::bind(&SequencerTestUnit::atomic_threads, this), "atomic sequencer used by many threads");
+  add_test("blocks", std::tr1::bind(&SequencerTestUnit::atomic_blocks, this), "atomic sequencer with per thread blocks");
+}
+
+SequencerTestUnit::~SequencerTestUnit()
+{}
+
+void
+SequencerTestUnit::default_sequencer()
+{
+  sequencer seq;
+
+  UNIT_ASSERT_EQUAL(seq.init(), 0L, "invalid initial id");
+  UNIT_ASSERT_EQUAL(seq.next(), 1L, "invalid next id");
+  UNIT_ASSERT_EQUAL(seq.next(), 2L, "invalid next id");
+  UNIT_ASSERT_EQUAL(seq.update(10), 10L, "invalid updated id");
+  UNIT_ASSERT_EQUAL(seq.update(5), 10L, "update mustn't decrease id");
+  UNIT_ASSERT_EQUAL(seq.next(), 11L, "invalid next id");
+  UNIT_ASSERT_EQUAL(seq.reset(3), 3L, "invalid reset id");
+  UNIT_ASSERT_EQUAL(seq.current(), 3L, "invalid current id");
+}
+
+void
+SequencerTestUnit::atomic_sequencer()
+{
+  sequencer seq(sequencer_impl_ptr(new oos::atomic_sequencer));
+
+  UNIT_ASSERT_EQUAL(seq.init(), 0L, "invalid initial id");
+  UNIT_ASSERT_EQUAL(seq.next(), 1L, "invalid next id");
+  UNIT_ASSERT_EQUAL(seq.next(), 2L, "invalid next id");
+  UNIT_ASSERT_EQUAL(seq.update(10), 10L, "invalid updated id");
+  UNIT_ASSERT_EQUAL(seq.update(5), 10L, "update mustn't decrease id");
+  UNIT_ASSERT_EQUAL(seq.next(), 11L, "invalid next id");
+  UNIT_ASSERT_EQUAL(seq.reset(3), 3L, "invalid reset id");
+  UNIT_ASSERT_EQUAL(seq.current(), 3L, "invalid current id");
+}
+
+static void fetch_ids(sequencer *seq, std::vector<long> *ids)
+{
+  for (size_t i = 0; i < ids->size(); ++i) {
+    (*ids)[i] = seq->next();
+  }
+}
+
+static bool unique_ids(const std::vector<std::vector<long> > &ids)
+{
+  std::vector<long> all;
+  for (size_t i = 0; i < ids.size(); ++i) {
+    all.insert(all.end(), ids[i].begin(), ids[i].end());
+  }
+  std::sort(all.begin(), all.end());
+  return std::adjacent_find(all.begin(), all.end()) == all.end();
+}
+
+void
+SequencerTestUnit::atomic_threads()
+{
+  sequencer seq(sequencer_impl_ptr(new oos::atomic_sequencer));
+
+  std::vector<std::vector<long> > ids(4, std::vector<long>(10000));
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < ids.size(); ++i) {
+    threads.push_back(std::thread(fetch_ids, &seq, &ids[i]));
+  }
+  for (size_t i = 0; i < threads.size(); ++i) {
+    threads[i].join();
+  }
+
+  UNIT_ASSERT_TRUE(unique_ids(ids), "ids aren't unique");
+  UNIT_ASSERT_EQUAL(seq.current(), 40000L, "invalid current id");
+}
+
+void
+SequencerTestUnit::atomic_blocks()
+{
+  oos::atomic_sequencer *impl = new oos::atomic_sequencer(100);
+  sequencer seq((sequencer_impl_ptr(impl)));
+
+  UNIT_ASSERT_EQUAL(impl->block_size(), 100L, "invalid block size");
+
+  // one thread gets consecutive ids from its block
+  UNIT_ASSERT_EQUAL(seq.next(), 1L, "invalid next id");
+  UNIT_ASSERT_EQUAL(seq.next(), 2L, "invalid next id");
+  UNIT_ASSERT_EQUAL(seq.current(), 100L, "block not reserved");
+
+  std::vector<std::vector<long> > ids(4, std::vector<long>(1050));
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < ids.size(); ++i) {
+    threads.push_back(std::thread(fetch_ids, &seq, &ids[i]));
+  }
+  for (size_t i = 0; i < threads.size(); ++i) {
+    threads[i].join();
+  }
+
+  UNIT_ASSERT_TRUE(unique_ids(ids), "ids aren't unique");
+  // each thread reserved eleven blocks
+  UNIT_ASSERT_EQUAL(seq.current(), 4500L, "invalid current id");
+
+  // a reset drops the reserved block
+  seq.reset(10000);
+  UNIT_ASSERT_EQUAL(seq.next(), 10001L, "invalid id after reset");
+
+  // a second sequencer doesn't drop the block of the first one
+  sequencer other(sequencer_impl_ptr(new oos::atomic_sequencer(100)));
+  UNIT_ASSERT_EQUAL(other.next(), 1L, "invalid next id");
+  UNIT_ASSERT_EQUAL(seq.next(), 10002L, "block of first sequencer dropped");
+  UNIT_ASSERT_EQUAL(other.next(), 2L, "block of second sequencer dropped");
+  UNIT_ASSERT_EQUAL(seq.current(), 10100L, "invalid current id");
+  UNIT_ASSERT_EQUAL(other.current(), 100L, "invalid current id");
+
+  // an update within a reserved block drops the block
+  UNIT_ASSERT_EQUAL(seq.update(10050), 10100L, "update mustn't decrease id");
+  UNIT_ASSERT_EQUAL(seq.next(), 10101L, "id of updated block handed out");
+  UNIT_ASSERT_EQUAL(seq.update(10200), 10200L, "update mustn't decrease id");
+  UNIT_ASSERT_EQUAL(seq.next(), 10201L, "id of updated block handed out");
+
+  // an update beyond all blocks keeps them
+  UNIT_ASSERT_EQUAL(seq.update(20000), 20000L, "invalid updated id");
+  UNIT_ASSERT_EQUAL(seq.next(), 10202L, "block dropped");
+  UNIT_ASSERT_EQUAL(other.next(), 3L, "block of second sequencer dropped");
+}
@@ -0,0 +1,24 @@
+#ifndef SEQUENCERTESTUNIT_HPP
+#define SEQUENCERTESTUNIT_HPP
+
+#include "unit/unit_test.hpp"
+
+class SequencerTestUnit : public oos::unit_test
+{
+public:
+  SequencerTestUnit();
+  ~SequencerTestUnit();
+
+  void default_sequencer();
+  void atomic_sequencer();
+  void atomic_threads();
+  void atomic_blocks();
+
+  /**
+   * Initializes a test unit
+   */
+  virtual void initialize() {}
+  virtual void finalize() {}
+};
+
+#endif /* SEQUENCERTESTUNIT_HPP */